@@ -404,11 +404,13 @@ function send_benchmark_to_ods {
   QPS=$(grep $bench $file | awk '{print $5}')
   P50_MICROS=$(grep $bench $file -A 6 | grep "Percentiles" | awk '{print $3}' )
   P75_MICROS=$(grep $bench $file -A 6 | grep "Percentiles" | awk '{print $5}' )
-  P99_MICROS=$(grep $bench $file -A 6 | grep "Percentiles" | awk '{print $7}' )
+  P95_MICROS=$(grep $bench $file -A 6 | grep "Percentiles" | awk '{print $7}' )
+  P99_MICROS=$(grep $bench $file -A 6 | grep "Percentiles" | awk '{print $9}' )
 
   send_to_ods rocksdb.build.$bench_key.qps $QPS
   send_to_ods rocksdb.build.$bench_key.p50_micros $P50_MICROS
   send_to_ods rocksdb.build.$bench_key.p75_micros $P75_MICROS
+  send_to_ods rocksdb.build.$bench_key.p95_micros $P95_MICROS
   send_to_ods rocksdb.build.$bench_key.p99_micros $P99_MICROS
 }
 
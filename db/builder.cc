@@ -48,6 +48,8 @@ Status BuildTable(const std::string& dbname, Env* env,
   Status s;
   meta->fd.file_size = 0;
   meta->smallest_seqno = meta->largest_seqno = 0;
+  meta->num_entries = meta->num_deletions = 0;
+  meta->raw_key_size = meta->raw_value_size = 0;
   iter->SeekToFirst();
 
   // If the sequence number of the smallest entry in the memtable is
@@ -134,6 +136,7 @@ Status BuildTable(const std::string& dbname, Env* env,
               // Merge completed correctly.
               // Add the resulting merge key/value and continue to next
               builder->Add(merge.key(), merge.value());
+              meta->UpdateStats(merge.key(), merge.value());
               prev_key.assign(merge.key().data(), merge.key().size());
               ok = ParseInternalKey(Slice(prev_key), &prev_ikey);
               assert(ok);
@@ -151,6 +154,7 @@ Status BuildTable(const std::string& dbname, Env* env,
                    ++key_iter, ++value_iter) {
 
                 builder->Add(Slice(*key_iter), Slice(*value_iter));
+                meta->UpdateStats(Slice(*key_iter), Slice(*value_iter));
               }
 
               // Sanity check. Both iterators should end at the same time
@@ -163,6 +167,7 @@ Status BuildTable(const std::string& dbname, Env* env,
           } else {
             // Handle Put/Delete-type keys by simply writing them
             builder->Add(key, value);
+            meta->UpdateStats(key, value);
             prev_key.assign(key.data(), key.size());
             ok = ParseInternalKey(Slice(prev_key), &prev_ikey);
             assert(ok);
@@ -183,6 +188,7 @@ Status BuildTable(const std::string& dbname, Env* env,
         Slice key = iter->key();
         meta->largest.DecodeFrom(key);
         builder->Add(key, iter->value());
+        meta->UpdateStats(key, iter->value());
         SequenceNumber seqno = GetInternalKeySeqno(key);
         meta->smallest_seqno = std::min(meta->smallest_seqno, seqno);
         meta->largest_seqno = std::max(meta->largest_seqno, seqno);
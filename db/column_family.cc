@@ -248,6 +248,7 @@ ColumnFamilyData::ColumnFamilyData(
       prev_(nullptr),
       log_number_(0),
       column_family_set_(column_family_set),
+      write_stall_condition_(WriteStallCondition::kNormal),
       pending_flush_(false),
       pending_compaction_(false) {
   Ref();
@@ -359,6 +360,7 @@ void ColumnFamilyData::SetDropped() {
   assert(id_ != 0);
   dropped_ = true;
   write_controller_token_.reset();
+  write_stall_condition_ = WriteStallCondition::kNormal;
 
   // remove from column_family_set
   column_family_set_->RemoveColumnFamily(this);
@@ -375,6 +377,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
 
     if (imm()->size() >= mutable_cf_options.max_write_buffer_number) {
       write_controller_token_ = write_controller->GetStopToken();
+      write_stall_condition_ = WriteStallCondition::kStopped;
       internal_stats_->AddCFStats(InternalStats::MEMTABLE_COMPACTION, 1);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
           "[%s] Stopping writes because we have %d immutable memtables "
@@ -384,6 +387,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
     } else if (vstorage->NumLevelFiles(0) >=
                mutable_cf_options.level0_stop_writes_trigger) {
       write_controller_token_ = write_controller->GetStopToken();
+      write_stall_condition_ = WriteStallCondition::kStopped;
       internal_stats_->AddCFStats(InternalStats::LEVEL0_NUM_FILES, 1);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
           "[%s] Stopping writes because we have %d level-0 files",
@@ -396,6 +400,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
                          mutable_cf_options.level0_slowdown_writes_trigger,
                          mutable_cf_options.level0_stop_writes_trigger);
       write_controller_token_ = write_controller->GetDelayToken(slowdown);
+      write_stall_condition_ = WriteStallCondition::kDelayed;
       internal_stats_->AddCFStats(InternalStats::LEVEL0_SLOWDOWN, slowdown);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
           "[%s] Stalling writes because we have %d level-0 files (%" PRIu64
@@ -406,6 +411,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
       uint64_t kHardLimitSlowdown = 1000;
       write_controller_token_ =
           write_controller->GetDelayToken(kHardLimitSlowdown);
+      write_stall_condition_ = WriteStallCondition::kDelayed;
       internal_stats_->RecordLevelNSlowdown(max_level, kHardLimitSlowdown,
                                             false);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
@@ -418,6 +424,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
           mutable_cf_options.soft_rate_limit,
           mutable_cf_options.hard_rate_limit);
       write_controller_token_ = write_controller->GetDelayToken(slowdown);
+      write_stall_condition_ = WriteStallCondition::kDelayed;
       internal_stats_->RecordLevelNSlowdown(max_level, slowdown, true);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
           "[%s] Stalling writes because we hit soft limit on level %d (%" PRIu64
@@ -425,6 +432,7 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
           name_.c_str(), max_level, slowdown);
     } else {
       write_controller_token_.reset();
+      write_stall_condition_ = WriteStallCondition::kNormal;
     }
   }
 }
@@ -572,6 +580,27 @@ void ColumnFamilyData::NotifyOnFlushCompleted(
 #endif  // ROCKSDB_LITE
 }
 
+void ColumnFamilyData::NotifyOnTableFileCreated(
+    const std::string& db_name, const std::string& file_path,
+    uint64_t file_size, uint64_t num_entries,
+    TableFileCreationReason reason) {
+#ifndef ROCKSDB_LITE
+  if (ioptions()->listeners.empty()) {
+    return;
+  }
+  TableFileCreationInfo info;
+  info.db_name = db_name;
+  info.cf_name = GetName();
+  info.file_path = file_path;
+  info.file_size = file_size;
+  info.num_entries = num_entries;
+  info.reason = reason;
+  for (auto listener : ioptions()->listeners) {
+    listener->OnTableFileCreated(info);
+  }
+#endif  // ROCKSDB_LITE
+}
+
 SuperVersion* ColumnFamilyData::InstallSuperVersion(
     SuperVersion* new_superversion, port::Mutex* db_mutex) {
   db_mutex->AssertHeld();
@@ -17,6 +17,7 @@
 #include "rocksdb/options.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
+#include "rocksdb/listener.h"
 #include "db/memtable_list.h"
 #include "db/write_batch_internal.h"
 #include "db/write_controller.h"
@@ -262,6 +263,17 @@ class ColumnFamilyData {
       bool triggered_flush_slowdown,
       bool triggered_flush_stop);
 
+  void NotifyOnTableFileCreated(const std::string& db_name,
+                                const std::string& file_path,
+                                uint64_t file_size, uint64_t num_entries,
+                                TableFileCreationReason reason);
+
+  // Whether writes are currently delayed or stopped because of this
+  // column family. Protected by DB mutex
+  WriteStallCondition write_stall_condition() const {
+    return write_stall_condition_;
+  }
+
   // Protected by DB mutex
   void set_pending_flush(bool value) { pending_flush_ = value; }
   void set_pending_compaction(bool value) { pending_compaction_ = value; }
@@ -335,6 +347,7 @@ class ColumnFamilyData {
   ColumnFamilySet* column_family_set_;
 
   std::unique_ptr<WriteControllerToken> write_controller_token_;
+  WriteStallCondition write_stall_condition_;
 
   // If true --> this ColumnFamily is currently present in DBImpl::flush_queue_
   bool pending_flush_;
@@ -70,6 +70,8 @@ struct CompactionJob::CompactionState {
     uint64_t file_size;
     InternalKey smallest, largest;
     SequenceNumber smallest_seqno, largest_seqno;
+    // Data-entry stats, recorded in the MANIFEST
+    uint64_t num_entries, num_deletions, raw_key_size, raw_value_size;
   };
   std::vector<Output> outputs;
 
@@ -202,7 +204,8 @@ struct CompactionJob::CompactionState {
 };
 
 CompactionJob::CompactionJob(
-    Compaction* compaction, const DBOptions& db_options,
+    const std::string& dbname, Compaction* compaction,
+    const DBOptions& db_options,
     const MutableCFOptions& mutable_cf_options, const EnvOptions& env_options,
     VersionSet* versions, std::atomic<bool>* shutting_down,
     LogBuffer* log_buffer, Directory* db_directory, Statistics* stats,
@@ -211,6 +214,7 @@ CompactionJob::CompactionJob(
     std::function<uint64_t()> yield_callback)
     : compact_(new CompactionState(compaction)),
       compaction_stats_(1),
+      dbname_(dbname),
       db_options_(db_options),
       mutable_cf_options_(mutable_cf_options),
       env_options_(env_options),
@@ -780,6 +784,12 @@ Status CompactionJob::ProcessKeyValueCompaction(int64_t* imm_micros,
         }
         compact_->current_output()->largest.DecodeFrom(newkey);
         compact_->builder->Add(newkey, value);
+        compact_->current_output()->num_entries++;
+        if (ExtractValueType(newkey) == kTypeDeletion) {
+          compact_->current_output()->num_deletions++;
+        }
+        compact_->current_output()->raw_key_size += newkey.size();
+        compact_->current_output()->raw_value_size += value.size();
         compact_->num_output_records++,
             compact_->current_output()->largest_seqno =
                 std::max(compact_->current_output()->largest_seqno, seqno);
@@ -949,6 +959,11 @@ Status CompactionJob::FinishCompactionOutputFile(Iterator* input) {
           "[%s] Generated table #%" PRIu64 ": %" PRIu64
           " keys, %" PRIu64 " bytes", cfd->GetName().c_str(),
           output_number, current_entries, current_bytes);
+      cfd->NotifyOnTableFileCreated(
+          dbname_, TableFileName(db_options_.db_paths, output_number,
+                                 output_path_id),
+          current_bytes, current_entries,
+          TableFileCreationReason::kCompaction);
     }
   }
   return s;
@@ -984,10 +999,18 @@ Status CompactionJob::InstallCompactionResults(port::Mutex* db_mutex) {
   compact_->compaction->AddInputDeletions(compact_->compaction->edit());
   for (size_t i = 0; i < compact_->outputs.size(); i++) {
     const CompactionState::Output& out = compact_->outputs[i];
-    compact_->compaction->edit()->AddFile(
-        compact_->compaction->output_level(), out.number, out.path_id,
-        out.file_size, out.smallest, out.largest, out.smallest_seqno,
-        out.largest_seqno);
+    FileMetaData meta;
+    meta.fd = FileDescriptor(out.number, out.path_id, out.file_size);
+    meta.smallest = out.smallest;
+    meta.largest = out.largest;
+    meta.smallest_seqno = out.smallest_seqno;
+    meta.largest_seqno = out.largest_seqno;
+    meta.num_entries = out.num_entries;
+    meta.num_deletions = out.num_deletions;
+    meta.raw_key_size = out.raw_key_size;
+    meta.raw_value_size = out.raw_value_size;
+    compact_->compaction->edit()->AddFile(compact_->compaction->output_level(),
+                                          meta);
   }
   return versions_->LogAndApply(
       compact_->compaction->column_family_data(), mutable_cf_options_,
@@ -1055,6 +1078,8 @@ Status CompactionJob::OpenCompactionOutputFile() {
   out.smallest.Clear();
   out.largest.Clear();
   out.smallest_seqno = out.largest_seqno = 0;
+  out.num_entries = out.num_deletions = 0;
+  out.raw_key_size = out.raw_value_size = 0;
 
   compact_->outputs.push_back(out);
   compact_->outfile->SetIOPriority(Env::IO_LOW);
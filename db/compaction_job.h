@@ -53,7 +53,8 @@ class CompactionJob {
   // TODO(icanadi) make effort to reduce number of parameters here
   // IMPORTANT: mutable_cf_options needs to be alive while CompactionJob is
   // alive
-  CompactionJob(Compaction* compaction, const DBOptions& db_options,
+  CompactionJob(const std::string& dbname, Compaction* compaction,
+                const DBOptions& db_options,
                 const MutableCFOptions& mutable_cf_options,
                 const EnvOptions& env_options, VersionSet* versions,
                 std::atomic<bool>* shutting_down, LogBuffer* log_buffer,
@@ -77,6 +78,12 @@ class CompactionJob {
   // status is the return of Run()
   void Install(Status* status, port::Mutex* db_mutex);
 
+  // Returns what the compaction read and wrote.
+  // REQUIRED: Run() returned
+  const InternalStats::CompactionStats& compaction_stats() const {
+    return compaction_stats_;
+  }
+
  private:
   void AllocateCompactionOutputFileNumbers();
   // Call compaction filter if is_compaction_v2 is not true. Then iterate
@@ -106,6 +113,7 @@ class CompactionJob {
   InternalStats::CompactionStats compaction_stats_;
 
   // DBImpl state
+  const std::string& dbname_;
   const DBOptions& db_options_;
   const MutableCFOptions& mutable_cf_options_;
   const EnvOptions& env_options_;
@@ -29,6 +29,8 @@ int main() {
 #include <sys/types.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <cmath>
+#include <map>
 #include <gflags/gflags.h>
 #include "db/db_impl.h"
 #include "db/version_set.h"
@@ -42,6 +44,7 @@ int main() {
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/perf_context.h"
+#include "rocksdb/trace_reader_writer.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
 #include "util/crc32c.h"
@@ -52,6 +55,7 @@ int main() {
 #include "util/string_util.h"
 #include "util/statistics.h"
 #include "util/testutil.h"
+#include "util/trace_replay.h"
 #include "util/xxhash.h"
 #include "hdfs/env_hdfs.h"
 #include "utilities/merge_operators.h"
@@ -133,6 +137,11 @@ DEFINE_string(benchmarks,
               "\tacquireload   -- load N*1000 times\n"
               "\tfillseekseq   -- write N values in sequential key, then read "
               "them by seeking to each key\n"
+              "\treplay        -- replay the trace file given by "
+              "--trace_replay_file\n"
+              "\tmixgraph      -- N threads doing a mix of Get(), Put() and "
+              "Seek() with skewed keys and value sizes, see --key_dist, "
+              "--value_size_dist and --mix_get_ratio\n"
               "Meta operations:\n"
               "\tcompact     -- Compact the entire DB\n"
               "\tstats       -- Print DB stats\n"
@@ -198,6 +207,10 @@ DEFINE_double(compression_ratio, 0.5, "Arrange to generate values that shrink"
 
 DEFINE_bool(histogram, false, "Print histogram of operation timings");
 
+DEFINE_int32(histogram_significant_digits, rocksdb::kHistogramSignificantDigits,
+             "Precision of the --histogram ones, from 1 to 3 significant "
+             "decimal digits. More digits take more memory per histogram.");
+
 DEFINE_bool(enable_numa, false,
             "Make operations aware of NUMA architecture and bind memory "
             "and cpus corresponding to nodes together. In NUMA, memory "
@@ -306,7 +319,22 @@ DEFINE_int32(cache_remove_scan_count_limit, 32, "");
 DEFINE_bool(verify_checksum, false, "Verify checksum for every block read"
             " from storage");
 
+DEFINE_string(trace_file, "", "Record the requests issued to the DB into "
+              "this trace file, from the time the DB is last opened");
+
+DEFINE_string(trace_replay_file, "", "Trace file replayed by the replay "
+              "benchmark");
+
+DEFINE_double(trace_replay_fast_forward, 1.0, "Replay the trace this many "
+              "times as fast as it was recorded. 0 replays it as fast as "
+              "possible.");
+
+DEFINE_int32(trace_replay_threads, 1, "Number of threads replaying the "
+             "trace");
+
 DEFINE_bool(statistics, false, "Database statistics");
+DEFINE_int32(stats_level, rocksdb::kAll, "Stats level of --statistics: "
+             "0 = no timers, 1 = no detailed timers, 2 = all");
 static class std::shared_ptr<rocksdb::Statistics> dbstats;
 
 DEFINE_int64(writes, -1, "Number of write operations to do. If negative, do"
@@ -375,6 +403,69 @@ DEFINE_int32(deletepercent, 2, "Percentage of deletes out of reads/writes/"
              "deletepercent), so deletepercent must be smaller than (100 - "
              "FLAGS_readwritepercent)");
 
+DEFINE_string(key_dist, "uniform", "Distribution of the keys accessed by the"
+              " mixgraph benchmark: uniform, zipf, exponential or power. The"
+              " hottest keys are scattered over the key space.");
+
+DEFINE_double(key_dist_zipf_theta, 0.99, "Skew of --key_dist=zipf, in (0, 1)."
+              " The larger, the more accesses go to the hottest keys.");
+
+DEFINE_double(key_dist_exp_lambda, 10.0, "Rate of --key_dist=exponential. The"
+              " hottest 1/lambda of the keys get 63% of the accesses.");
+
+DEFINE_double(key_dist_a, 0.002312, "Parameter a of --key_dist=power, the "
+              "two-term power model where the keys of rank below x get a "
+              "fraction a * x^b of the accesses");
+
+DEFINE_double(key_dist_b, 0.3467, "Parameter b of --key_dist=power");
+
+DEFINE_string(prefix_dist, "", "If set, with --keys_per_prefix, mixgraph picks"
+              " the prefix of every key with this distribution, one of those "
+              "of --key_dist, then a key of the prefix uniformly, so that the"
+              " accesses concentrate on a few hot prefixes.");
+
+DEFINE_string(value_size_dist, "fixed", "Distribution of the sizes of the "
+              "values written by mixgraph and the fill benchmarks: fixed "
+              "(--value_size), uniform (between --value_size_min and "
+              "--value_size_max) or pareto (generalized Pareto with "
+              "--value_pareto_k, --value_pareto_sigma and --value_pareto_theta"
+              ", within --value_size_min and --value_size_max)");
+
+DEFINE_int32(value_size_min, 16, "Smallest value size of --value_size_dist");
+
+DEFINE_int32(value_size_max, 102400, "Largest value size of "
+             "--value_size_dist");
+
+DEFINE_double(value_pareto_k, 0.2615, "Shape of --value_size_dist=pareto. The"
+              " larger, the longer the tail of large values.");
+
+DEFINE_double(value_pareto_sigma, 25.45, "Scale of --value_size_dist=pareto");
+
+DEFINE_double(value_pareto_theta, 0.0, "Location of "
+              "--value_size_dist=pareto, added to every value size");
+
+DEFINE_double(mix_get_ratio, 0.8, "Weight of Get()s in the mixgraph "
+              "benchmark");
+
+DEFINE_double(mix_put_ratio, 0.15, "Weight of Put()s in the mixgraph "
+              "benchmark");
+
+DEFINE_double(mix_seek_ratio, 0.05, "Weight of iterator Seek()s in the "
+              "mixgraph benchmark, each followed by up to --mix_max_scan_len "
+              "Next()s");
+
+DEFINE_int64(mix_max_scan_len, 100, "Longest scan of the mixgraph benchmark");
+
+DEFINE_int64(mix_ops_per_second, 0, "Rate of the operations of the mixgraph "
+             "benchmark, over all its threads. No limit when <= 0.");
+
+DEFINE_double(mix_ops_sine_amplitude, 0.0, "If positive, the rate of mixgraph"
+              " varies as mix_ops_per_second * (1 + amplitude * "
+              "sin(2 * pi * t / mix_ops_sine_period)), to mimic daily cycles");
+
+DEFINE_int32(mix_ops_sine_period, 3600, "Period of the variation of the rate "
+             "of mixgraph, in seconds");
+
 DEFINE_uint64(delete_obsolete_files_period_micros, 0,
               "Ignored. Left here for backward compatibility");
 
@@ -524,6 +615,10 @@ DEFINE_uint64(bytes_per_sync,  rocksdb::Options().bytes_per_sync,
               "Allows OS to incrementally sync files to disk while they are"
               " being written, in the background. Issue one request for every"
               " bytes_per_sync written. 0 turns it off.");
+DEFINE_uint64(wal_bytes_per_sync,  rocksdb::Options().wal_bytes_per_sync,
+              "Allows OS to incrementally sync WAL files to disk while they"
+              " are being written, in the background. Issue one request for"
+              " every wal_bytes_per_sync written. 0 turns it off.");
 DEFINE_bool(filter_deletes, false, " On true, deletes use bloom-filter and drop"
             " the delete if key not present");
 
@@ -768,7 +863,8 @@ class RandomGenerator {
     // large enough to serve all typical value sizes we want to write.
     Random rnd(301);
     std::string piece;
-    while (data_.size() < (unsigned)std::max(1048576, FLAGS_value_size)) {
+    int max_value_size = std::max(FLAGS_value_size, FLAGS_value_size_max);
+    while (data_.size() < (unsigned)std::max(1048576, max_value_size)) {
       // Add a short fragment that is as compressible as specified
       // by FLAGS_compression_ratio.
       test::CompressibleString(&rnd, FLAGS_compression_ratio, 100, &piece);
@@ -787,6 +883,135 @@ class RandomGenerator {
   }
 };
 
+// Draws the ranks of the keys to access, in [0, num), from a skewed
+// distribution: rank 0 is the hottest key. The ranks are then scattered
+// over the key space, so that the hot keys are not all adjacent.
+class KeyDistribution {
+ public:
+  enum Type { kUniform, kZipf, kExponential, kPower };
+
+  // Returns false if "name" is not a known distribution
+  static bool ParseType(const std::string& name, Type* type) {
+    if (name == "uniform") {
+      *type = kUniform;
+    } else if (name == "zipf") {
+      *type = kZipf;
+    } else if (name == "exponential") {
+      *type = kExponential;
+    } else if (name == "power") {
+      *type = kPower;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  KeyDistribution(Type type, uint64_t num) : type_(type), num_(num) {
+    if (num_ == 0) {
+      num_ = 1;
+    }
+    // A prime that does not divide num_, so that rank -> rank * p % num_
+    // is a permutation of the ranks
+    scatter_ = num_ % 1000003 != 0 ? 1000003 : 999983;
+    if (type_ == kZipf) {
+      theta_ = FLAGS_key_dist_zipf_theta;
+      zeta_n_ = Zeta(num_, theta_);
+      double zeta_2 = Zeta(2, theta_);
+      alpha_ = 1.0 / (1.0 - theta_);
+      eta_ = (1.0 - std::pow(2.0 / num_, 1.0 - theta_)) /
+             (1.0 - zeta_2 / zeta_n_);
+    }
+  }
+
+  uint64_t Next(Random64* rand) {
+    // Uniform in [0, 1)
+    double u = (rand->Next() >> 11) * (1.0 / 9007199254740992.0);
+    uint64_t rank;
+    switch (type_) {
+      case kZipf:
+        rank = NextZipf(u);
+        break;
+      case kExponential: {
+        double lambda = FLAGS_key_dist_exp_lambda;
+        rank = static_cast<uint64_t>(
+            -std::log(1.0 - u * (1.0 - std::exp(-lambda))) / lambda * num_);
+        break;
+      }
+      case kPower:
+        // Inverse of the CDF a * x^b, wrapped around the key space
+        rank = static_cast<uint64_t>(
+            std::pow(u / FLAGS_key_dist_a, 1.0 / FLAGS_key_dist_b));
+        break;
+      default:
+        return rand->Next() % num_;
+    }
+    // Does not overflow below 2^44 keys
+    return (rank % num_) * scatter_ % num_;
+  }
+
+ private:
+  // Generalized harmonic number sum(1 / i^theta) for i in [1, n]. Above a
+  // million terms, the rest of the sum is approximated by an integral.
+  static double Zeta(uint64_t n, double theta) {
+    const uint64_t kExactTerms = 1000000;
+    double sum = 0;
+    for (uint64_t i = 1; i <= std::min(n, kExactTerms); i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    if (n > kExactTerms) {
+      double from = kExactTerms + 0.5;
+      double to = n + 0.5;
+      sum += (std::pow(to, 1.0 - theta) - std::pow(from, 1.0 - theta)) /
+             (1.0 - theta);
+    }
+    return sum;
+  }
+
+  // The approximation of Gray et al., "Quickly Generating Billion-Record
+  // Synthetic Databases", also used by YCSB
+  uint64_t NextZipf(double u) {
+    double uz = u * zeta_n_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    return static_cast<uint64_t>(num_ *
+                                 std::pow(eta_ * u - eta_ + 1.0, alpha_));
+  }
+
+  const Type type_;
+  uint64_t num_;
+  uint64_t scatter_;
+  double theta_;
+  double zeta_n_;
+  double alpha_;
+  double eta_;
+};
+
+// Returns the size of the next value to write, following --value_size_dist,
+// or "fixed_size" for --value_size_dist=fixed
+static int NextValueSize(Random64* rand, int fixed_size) {
+  if (FLAGS_value_size_dist == "uniform") {
+    return FLAGS_value_size_min +
+           static_cast<int>(rand->Next() % (FLAGS_value_size_max -
+                                            FLAGS_value_size_min + 1));
+  } else if (FLAGS_value_size_dist == "pareto") {
+    double u = (rand->Next() >> 11) * (1.0 / 9007199254740992.0);
+    double k = FLAGS_value_pareto_k;
+    double size =
+        k == 0 ? FLAGS_value_pareto_theta -
+                     FLAGS_value_pareto_sigma * std::log(1.0 - u)
+               : FLAGS_value_pareto_theta +
+                     FLAGS_value_pareto_sigma *
+                         (std::pow(1.0 - u, -k) - 1.0) / k;
+    return static_cast<int>(std::max<double>(
+        FLAGS_value_size_min, std::min<double>(FLAGS_value_size_max, size)));
+  }
+  return fixed_size;
+}
+
 static void AppendWithSpace(std::string* str, Slice msg) {
   if (msg.empty()) return;
   if (!str->empty()) {
@@ -844,6 +1069,36 @@ struct DBWithColumnFamilies {
   }
 };
 
+// The kinds of operations whose latencies are kept apart with --histogram
+enum OperationType : unsigned char {
+  kRead = 0,
+  kWrite,
+  kDelete,
+  kSeek,
+  kMerge,
+  kUpdate,
+  kOthers
+};
+
+static const char* OperationTypeName(OperationType type) {
+  switch (type) {
+    case kRead:
+      return "read";
+    case kWrite:
+      return "write";
+    case kDelete:
+      return "delete";
+    case kSeek:
+      return "seek";
+    case kMerge:
+      return "merge";
+    case kUpdate:
+      return "update";
+    default:
+      return "op";
+  }
+}
+
 class Stats {
  private:
   int id_;
@@ -856,7 +1111,7 @@ class Stats {
   int64_t bytes_;
   double last_op_finish_;
   double last_report_finish_;
-  HistogramImpl hist_;
+  std::map<OperationType, HistogramImpl> hist_;
   std::string message_;
   bool exclude_from_merge_;
 
@@ -867,7 +1122,7 @@ class Stats {
     id_ = id;
     next_report_ = FLAGS_stats_interval ? FLAGS_stats_interval : 100;
     last_op_finish_ = start_;
-    hist_.Clear();
+    hist_.clear();
     done_ = 0;
     last_report_done_ = 0;
     bytes_ = 0;
@@ -884,7 +1139,9 @@ class Stats {
     if (other.exclude_from_merge_)
       return;
 
-    hist_.Merge(other.hist_);
+    for (const auto& other_hist : other.hist_) {
+      Histogram(other_hist.first)->Merge(other_hist.second);
+    }
     done_ += other.done_;
     bytes_ += other.bytes_;
     seconds_ += other.seconds_;
@@ -907,11 +1164,21 @@ class Stats {
   void SetId(int id) { id_ = id; }
   void SetExcludeFromMerge() { exclude_from_merge_ = true; }
 
-  void FinishedOps(DBWithColumnFamilies* db_with_cfh, DB* db, int64_t num_ops) {
+  HistogramImpl* Histogram(OperationType op_type) {
+    auto it = hist_.find(op_type);
+    if (it == hist_.end()) {
+      it = hist_.insert(std::make_pair(
+          op_type, HistogramImpl(FLAGS_histogram_significant_digits))).first;
+    }
+    return &it->second;
+  }
+
+  void FinishedOps(DBWithColumnFamilies* db_with_cfh, DB* db, int64_t num_ops,
+                   OperationType op_type = kOthers) {
     if (FLAGS_histogram) {
       double now = FLAGS_env->NowMicros();
       double micros = now - last_op_finish_;
-      hist_.Add(micros);
+      Histogram(op_type)->Add(micros);
       if (micros > 20000 && !FLAGS_stats_interval) {
         fprintf(stderr, "long op: %.1f micros%30s\r", micros, "");
         fflush(stderr);
@@ -998,7 +1265,10 @@ class Stats {
             (extra.empty() ? "" : " "),
             extra.c_str());
     if (FLAGS_histogram) {
-      fprintf(stdout, "Microseconds per op:\n%s\n", hist_.ToString().c_str());
+      for (const auto& hist : hist_) {
+        fprintf(stdout, "Microseconds per %s:\n%s\n",
+                OperationTypeName(hist.first), hist.second.ToString().c_str());
+      }
     }
     if (FLAGS_report_file_operations) {
       ReportFileOpEnv* env = static_cast<ReportFileOpEnv*>(FLAGS_env);
@@ -1553,6 +1823,12 @@ class Benchmark {
         method = &Benchmark::RandomWithVerify;
       } else if (name == Slice("fillseekseq")) {
         method = &Benchmark::WriteSeqSeekSeq;
+      } else if (name == Slice("replay")) {
+        // The trace is replayed by the threads of the replayer
+        num_threads = 1;
+        method = &Benchmark::Replay;
+      } else if (name == Slice("mixgraph")) {
+        method = &Benchmark::MixGraph;
       } else if (name == Slice("compact")) {
         method = &Benchmark::Compact;
       } else if (name == Slice("crc32c")) {
@@ -2085,6 +2361,7 @@ class Benchmark {
     options.access_hint_on_compaction_start = FLAGS_compaction_fadvice_e;
     options.use_adaptive_mutex = FLAGS_use_adaptive_mutex;
     options.bytes_per_sync = FLAGS_bytes_per_sync;
+    options.wal_bytes_per_sync = FLAGS_wal_bytes_per_sync;
 
     // merge operator options
     options.merge_operator = MergeOperators::CreateFromStringId(
@@ -2120,6 +2397,9 @@ class Benchmark {
 
     if (FLAGS_num_multi_db <= 1) {
       OpenDb(options, FLAGS_db, &db_);
+      if (!FLAGS_trace_file.empty()) {
+        StartTrace(db_.db);
+      }
     } else {
       multi_dbs_.clear();
       multi_dbs_.resize(FLAGS_num_multi_db);
@@ -2300,20 +2580,21 @@ class Benchmark {
       for (int64_t j = 0; j < entries_per_batch_; j++) {
         int64_t rand_num = key_gens[id]->Next();
         GenerateKeyFromInt(rand_num, FLAGS_num, &key);
+        int value_size = NextValueSize(&thread->rand, value_size_);
         if (FLAGS_num_column_families <= 1) {
-          batch.Put(key, gen.Generate(value_size_));
+          batch.Put(key, gen.Generate(value_size));
         } else {
           // We use same rand_num as seed for key and column family so that we
           // can deterministically find the cfh corresponding to a particular
           // key while reading the key.
           batch.Put(db_with_cfh->GetCfh(rand_num), key,
-                    gen.Generate(value_size_));
+                    gen.Generate(value_size));
         }
-        bytes += value_size_ + key_size_;
+        bytes += value_size + key_size_;
       }
       s = db_with_cfh->db->Write(write_options_, &batch);
       thread->stats.FinishedOps(db_with_cfh, db_with_cfh->db,
-                                entries_per_batch_);
+                                entries_per_batch_, kWrite);
       if (!s.ok()) {
         fprintf(stderr, "put error: %s\n", s.ToString().c_str());
         exit(1);
@@ -2341,7 +2622,7 @@ class Benchmark {
     int64_t bytes = 0;
     for (iter->SeekToFirst(); i < reads_ && iter->Valid(); iter->Next()) {
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, kRead);
       ++i;
     }
     delete iter;
@@ -2364,7 +2645,7 @@ class Benchmark {
     int64_t bytes = 0;
     for (iter->SeekToLast(); i < reads_ && iter->Valid(); iter->Prev()) {
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, kRead);
       ++i;
     }
     delete iter;
@@ -2399,7 +2680,7 @@ class Benchmark {
           ++nonexist;
         }
       }
-      thread->stats.FinishedOps(nullptr, db, 100);
+      thread->stats.FinishedOps(nullptr, db, 100, kRead);
     } while (!duration.Done(100));
 
     char msg[100];
@@ -2441,7 +2722,7 @@ class Benchmark {
       if (s.ok()) {
         found++;
       }
-      thread->stats.FinishedOps(db_with_cfh, db_with_cfh->db, 1);
+      thread->stats.FinishedOps(db_with_cfh, db_with_cfh->db, 1, kRead);
     }
 
     char msg[100];
@@ -2483,7 +2764,7 @@ class Benchmark {
           ++found;
         }
       }
-      thread->stats.FinishedOps(nullptr, db, entries_per_batch_);
+      thread->stats.FinishedOps(nullptr, db, entries_per_batch_, kRead);
     }
     for (auto& k : keys) {
       delete k.data();
@@ -2577,7 +2858,7 @@ class Benchmark {
         assert(iter_to_use->status().ok());
       }
 
-      thread->stats.FinishedOps(&db_, db_.db, 1);
+      thread->stats.FinishedOps(&db_, db_.db, 1, kSeek);
     }
     delete single_iter;
     for (auto iter : multi_iters) {
@@ -2617,7 +2898,7 @@ class Benchmark {
         batch.Delete(key);
       }
       auto s = db->Write(write_options_, &batch);
-      thread->stats.FinishedOps(nullptr, db, entries_per_batch_);
+      thread->stats.FinishedOps(nullptr, db, entries_per_batch_, kDelete);
       if (!s.ok()) {
         fprintf(stderr, "del error: %s\n", s.ToString().c_str());
         exit(1);
@@ -2677,7 +2958,7 @@ class Benchmark {
         fprintf(stderr, "put error: %s\n", s.ToString().c_str());
         exit(1);
       }
-      thread->stats.FinishedOps(&db_, db_.db, 1);
+      thread->stats.FinishedOps(&db_, db_.db, 1, kWrite);
 
       ++num_writes;
       if (writes_per_second_by_10 && num_writes >= writes_per_second_by_10) {
@@ -2805,6 +3086,7 @@ class Benchmark {
       }
       GenerateKeyFromInt(thread->rand.Next() % FLAGS_numdistinct,
           FLAGS_numdistinct, &key);
+      OperationType op_type = kOthers;
       if (get_weight > 0) {
         // do all the gets first
         Status s = GetMany(db, options, key, &value);
@@ -2817,6 +3099,7 @@ class Benchmark {
         }
         get_weight--;
         gets_done++;
+        op_type = kRead;
       } else if (put_weight > 0) {
         // then do all the corresponding number of puts
         // for all the gets we have done earlier
@@ -2827,6 +3110,7 @@ class Benchmark {
         }
         put_weight--;
         puts_done++;
+        op_type = kWrite;
       } else if (delete_weight > 0) {
         Status s = DeleteMany(db, write_options_, key);
         if (!s.ok()) {
@@ -2835,9 +3119,10 @@ class Benchmark {
         }
         delete_weight--;
         deletes_done++;
+        op_type = kDelete;
       }
 
-      thread->stats.FinishedOps(&db_, db_.db, 1);
+      thread->stats.FinishedOps(&db_, db_.db, 1, op_type);
     }
     char msg[100];
     snprintf(msg, sizeof(msg),
@@ -2872,6 +3157,7 @@ class Benchmark {
         get_weight = FLAGS_readwritepercent;
         put_weight = 100 - get_weight;
       }
+      OperationType op_type = kOthers;
       if (get_weight > 0) {
         // do all the gets first
         Status s = db->Get(options, key, &value);
@@ -2884,6 +3170,7 @@ class Benchmark {
         }
         get_weight--;
         reads_done++;
+        op_type = kRead;
       } else  if (put_weight > 0) {
         // then do all the corresponding number of puts
         // for all the gets we have done earlier
@@ -2894,8 +3181,9 @@ class Benchmark {
         }
         put_weight--;
         writes_done++;
+        op_type = kWrite;
       }
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, op_type);
     }
     char msg[100];
     snprintf(msg, sizeof(msg), "( reads:%" PRIu64 " writes:%" PRIu64 \
@@ -2904,6 +3192,109 @@ class Benchmark {
     thread->stats.AddMessage(msg);
   }
 
+  // A mix of Get(), Put() and Seek() on skewed keys, at a paced rate, to
+  // mimic production workloads rather than uniform random accesses
+  void MixGraph(ThreadState* thread) {
+    ReadOptions options(FLAGS_verify_checksum, true);
+    RandomGenerator gen;
+    std::string value;
+    int64_t gets = 0;
+    int64_t puts = 0;
+    int64_t seeks = 0;
+    int64_t found = 0;
+    Duration duration(FLAGS_duration, readwrites_);
+
+    // With --prefix_dist, the prefix of the key is the skewed part, and its
+    // key within the prefix is uniform
+    bool use_prefix_dist = !FLAGS_prefix_dist.empty() && keys_per_prefix_ > 0;
+    int64_t num_prefix = use_prefix_dist ? FLAGS_num / keys_per_prefix_ : 0;
+    KeyDistribution::Type type;
+    KeyDistribution::ParseType(
+        use_prefix_dist ? FLAGS_prefix_dist : FLAGS_key_dist, &type);
+    KeyDistribution key_dist(type, use_prefix_dist ? num_prefix : FLAGS_num);
+
+    double total_ratio =
+        FLAGS_mix_get_ratio + FLAGS_mix_put_ratio + FLAGS_mix_seek_ratio;
+    if (total_ratio <= 0) {
+      fprintf(stderr, "mixgraph needs a positive mix_*_ratio\n");
+      exit(1);
+    }
+    double get_ratio = FLAGS_mix_get_ratio / total_ratio;
+    double put_ratio = get_ratio + FLAGS_mix_put_ratio / total_ratio;
+
+    Slice key = AllocateKey();
+    std::unique_ptr<const char[]> key_guard(key.data());
+
+    uint64_t start = FLAGS_env->NowMicros();
+    double next_op_micros = static_cast<double>(start);
+    while (!duration.Done(1)) {
+      if (FLAGS_mix_ops_per_second > 0) {
+        // Every thread does its share of the operations
+        uint64_t now = FLAGS_env->NowMicros();
+        double rate = static_cast<double>(FLAGS_mix_ops_per_second) /
+                      FLAGS_threads;
+        if (FLAGS_mix_ops_sine_amplitude > 0 && FLAGS_mix_ops_sine_period > 0) {
+          double t = (now - start) / 1000000.0;
+          rate *= 1.0 + FLAGS_mix_ops_sine_amplitude *
+                            std::sin(2 * M_PI * t / FLAGS_mix_ops_sine_period);
+        }
+        next_op_micros += 1000000.0 / std::max(rate, 1e-3);
+        if (next_op_micros > now) {
+          FLAGS_env->SleepForMicroseconds(
+              static_cast<int>(std::min(next_op_micros - now, 1000000.0)));
+        }
+      }
+
+      DB* db = SelectDB(thread);
+      int64_t key_num = static_cast<int64_t>(key_dist.Next(&thread->rand));
+      if (use_prefix_dist) {
+        key_num += num_prefix * (thread->rand.Next() % keys_per_prefix_);
+      }
+      GenerateKeyFromInt(key_num, FLAGS_num, &key);
+
+      double op = (thread->rand.Next() >> 11) * (1.0 / 9007199254740992.0);
+      OperationType op_type;
+      if (op < get_ratio) {
+        Status s = db->Get(options, key, &value);
+        if (!s.ok() && !s.IsNotFound()) {
+          fprintf(stderr, "get error: %s\n", s.ToString().c_str());
+        } else if (!s.IsNotFound()) {
+          found++;
+        }
+        gets++;
+        op_type = kRead;
+      } else if (op < put_ratio) {
+        int value_size = NextValueSize(&thread->rand, value_size_);
+        Status s = db->Put(write_options_, key, gen.Generate(value_size));
+        if (!s.ok()) {
+          fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+          exit(1);
+        }
+        thread->stats.AddBytes(value_size + key_size_);
+        puts++;
+        op_type = kWrite;
+      } else {
+        std::unique_ptr<Iterator> iter(db->NewIterator(options));
+        iter->Seek(key);
+        int64_t scan_len =
+            FLAGS_mix_max_scan_len > 0
+                ? thread->rand.Next() % (FLAGS_mix_max_scan_len + 1)
+                : 0;
+        for (int64_t i = 0; i < scan_len && iter->Valid(); i++) {
+          iter->Next();
+        }
+        seeks++;
+        op_type = kSeek;
+      }
+      thread->stats.FinishedOps(nullptr, db, 1, op_type);
+    }
+    char msg[100];
+    snprintf(msg, sizeof(msg), "( gets:%" PRIu64 " puts:%" PRIu64
+             " seeks:%" PRIu64 " found:%" PRIu64 ")",
+             gets, puts, seeks, found);
+    thread->stats.AddMessage(msg);
+  }
+
   //
   // Read-modify-write for random keys
   void UpdateRandom(ThreadState* thread) {
@@ -2929,7 +3320,7 @@ class Benchmark {
         fprintf(stderr, "put error: %s\n", s.ToString().c_str());
         exit(1);
       }
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, kUpdate);
     }
     char msg[100];
     snprintf(msg, sizeof(msg),
@@ -2976,7 +3367,7 @@ class Benchmark {
         fprintf(stderr, "put error: %s\n", s.ToString().c_str());
         exit(1);
       }
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, kUpdate);
     }
 
     char msg[100];
@@ -3012,7 +3403,7 @@ class Benchmark {
         fprintf(stderr, "merge error: %s\n", s.ToString().c_str());
         exit(1);
       }
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, kMerge);
     }
 
     // Print some statistics
@@ -3073,7 +3464,7 @@ class Benchmark {
 
       }
 
-      thread->stats.FinishedOps(nullptr, db, 1);
+      thread->stats.FinishedOps(nullptr, db, 1, do_merge ? kMerge : kRead);
     }
 
     char msg[100];
@@ -3119,6 +3510,61 @@ class Benchmark {
     db->CompactRange(nullptr, nullptr);
   }
 
+  void StartTrace(DB* db) {
+    std::unique_ptr<TraceWriter> trace_writer;
+    Status s = NewFileTraceWriter(FLAGS_env, EnvOptions(), FLAGS_trace_file,
+                                  &trace_writer);
+    if (s.ok()) {
+      s = db->StartTrace(TraceOptions(), std::move(trace_writer));
+    }
+    if (!s.ok()) {
+      fprintf(stderr, "Cannot start tracing: %s\n", s.ToString().c_str());
+      exit(1);
+    }
+    fprintf(stdout, "Tracing the workload to: [%s]\n",
+            FLAGS_trace_file.c_str());
+  }
+
+  void Replay(ThreadState* thread) {
+    if (FLAGS_trace_replay_file.empty()) {
+      fprintf(stderr, "Please set --trace_replay_file\n");
+      exit(1);
+    }
+    if (db_.db == nullptr) {
+      fprintf(stderr, "replay does not support --num_multi_db\n");
+      exit(1);
+    }
+    std::unique_ptr<TraceReader> trace_reader;
+    Status s = NewFileTraceReader(FLAGS_env, EnvOptions(),
+                                  FLAGS_trace_replay_file, &trace_reader);
+    if (!s.ok()) {
+      fprintf(stderr, "Cannot open the trace: %s\n", s.ToString().c_str());
+      exit(1);
+    }
+    std::vector<ColumnFamilyHandle*> handles;
+    if (db_.cfh.empty()) {
+      handles.push_back(db_.db->DefaultColumnFamily());
+    } else {
+      for (auto cfh : db_.cfh) {
+        if (cfh != nullptr) {
+          handles.push_back(cfh);
+        }
+      }
+    }
+    Replayer replayer(db_.db, handles, std::move(trace_reader));
+    s = replayer.Replay(FLAGS_trace_replay_threads,
+                        FLAGS_trace_replay_fast_forward);
+    thread->stats.FinishedOps(&db_, db_.db, replayer.num_replayed());
+    if (!s.ok()) {
+      fprintf(stderr, "Replay failed: %s\n", s.ToString().c_str());
+      exit(1);
+    }
+    char msg[100];
+    snprintf(msg, sizeof(msg), "(%" PRIu64 " requests replayed)",
+             replayer.num_replayed());
+    thread->stats.AddMessage(msg);
+  }
+
   void PrintStats(const char* key) {
     if (db_.db != nullptr) {
       PrintStats(db_.db, key, false);
@@ -3151,6 +3597,8 @@ int main(int argc, char** argv) {
   FLAGS_compaction_style_e = (rocksdb::CompactionStyle) FLAGS_compaction_style;
   if (FLAGS_statistics) {
     dbstats = rocksdb::CreateDBStatistics();
+    dbstats->set_stats_level(
+        static_cast<rocksdb::StatsLevel>(FLAGS_stats_level));
   }
 
   std::vector<std::string> fanout = rocksdb::StringSplit(
@@ -3182,6 +3630,37 @@ int main(int argc, char** argv) {
 
   FLAGS_rep_factory = StringToRepFactory(FLAGS_memtablerep.c_str());
 
+  rocksdb::KeyDistribution::Type key_dist;
+  if (!rocksdb::KeyDistribution::ParseType(FLAGS_key_dist, &key_dist)) {
+    fprintf(stderr, "Unknown key distribution: --key_dist=%s\n",
+            FLAGS_key_dist.c_str());
+    exit(1);
+  }
+  rocksdb::KeyDistribution::Type prefix_dist = key_dist;
+  if (!FLAGS_prefix_dist.empty() &&
+      !rocksdb::KeyDistribution::ParseType(FLAGS_prefix_dist, &prefix_dist)) {
+    fprintf(stderr, "Unknown key distribution: --prefix_dist=%s\n",
+            FLAGS_prefix_dist.c_str());
+    exit(1);
+  }
+  // The zipf generator divides by 1 - theta
+  if ((key_dist == rocksdb::KeyDistribution::kZipf ||
+       prefix_dist == rocksdb::KeyDistribution::kZipf) &&
+      (FLAGS_key_dist_zipf_theta <= 0 || FLAGS_key_dist_zipf_theta >= 1)) {
+    fprintf(stderr, "key_dist_zipf_theta must be in (0, 1)\n");
+    exit(1);
+  }
+  if (FLAGS_value_size_dist != "fixed" && FLAGS_value_size_dist != "uniform" &&
+      FLAGS_value_size_dist != "pareto") {
+    fprintf(stderr, "Unknown value size distribution: %s\n",
+            FLAGS_value_size_dist.c_str());
+    exit(1);
+  }
+  if (FLAGS_value_size_min < 0 || FLAGS_value_size_min > FLAGS_value_size_max) {
+    fprintf(stderr, "value_size_min must be between 0 and value_size_max\n");
+    exit(1);
+  }
+
   // The number of background threads should be at least as much the
   // max number of concurrent compactions.
   FLAGS_env->SetBackgroundThreads(FLAGS_max_background_compactions);
@@ -33,6 +33,7 @@
 #include "db/dbformat.h"
 #include "db/filename.h"
 #include "db/job_context.h"
+#include "db/log_prefetch_reader.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
@@ -75,6 +76,7 @@
 #include "util/mutexlock.h"
 #include "util/perf_context_imp.h"
 #include "util/iostats_context_imp.h"
+#include "util/request_tracer_imp.h"
 #include "util/stop_watch.h"
 #include "util/sync_point.h"
 #include "util/string_util.h"
@@ -90,12 +92,17 @@ void DumpRocksDBBuildVersion(Logger * log);
 struct DBImpl::WriteContext {
   autovector<SuperVersion*> superversions_to_free_;
   autovector<log::Writer*> logs_to_free_;
+  std::vector<std::shared_ptr<log::SyncCoordinator>> log_syncs_to_retire_;
   bool schedule_bg_work_ = false;
 
   ~WriteContext() {
     for (auto& sv : superversions_to_free_) {
       delete sv;
     }
+    // Writers may still be waiting for syncs of the logs being freed
+    for (auto& log_sync : log_syncs_to_retire_) {
+      log_sync->Retire();
+    }
     for (auto& log : logs_to_free_) {
       delete log;
     }
@@ -149,6 +156,11 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     result.db_paths.emplace_back(dbname, std::numeric_limits<uint64_t>::max());
   }
 
+  if (result.WAL_ttl_seconds > 0 || result.WAL_size_limit_MB > 0) {
+    // Obsolete logs are archived, so there is nothing to recycle
+    result.recycle_log_file_num = 0;
+  }
+
   return result;
 }
 
@@ -218,6 +230,9 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
           options.env->NowMicros() +
           db_options_.delete_obsolete_files_period_micros),
       last_stats_dump_time_microsec_(0),
+      stats_history_(options.env, dbname, db_options_),
+      last_stats_persist_time_micros_(options.env->NowMicros()),
+      tracing_(false),
       flush_on_destroy_(false),
       env_options_(options),
 #ifndef ROCKSDB_LITE
@@ -226,7 +241,11 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       bg_work_gate_closed_(false),
       refitting_level_(false),
       opened_successfully_(false),
-      notifying_events_(0) {
+      notifying_events_(0)
+#ifndef ROCKSDB_LITE
+      , notifying_write_stalls_(false)
+#endif  // ROCKSDB_LITE
+{
   env_->GetAbsolutePath(dbname, &db_absolute_path_);
 
   // Reserve ten files or so for other uses and give the rest to TableCache.
@@ -424,6 +443,59 @@ void DBImpl::MaybeDumpStats() {
   }
 }
 
+void DBImpl::MaybePersistStats() {
+  if (db_options_.stats_persist_period_sec == 0) return;
+
+  const uint64_t now_micros = env_->NowMicros();
+  uint64_t last = last_stats_persist_time_micros_.load();
+  if (last + db_options_.stats_persist_period_sec * 1000000ull > now_micros) {
+    return;
+  }
+  // Only the thread that moves the time forward writes the record
+  if (!last_stats_persist_time_micros_.compare_exchange_strong(last,
+                                                               now_micros)) {
+    return;
+  }
+  Status s = PersistStats(now_micros);
+  if (!s.ok()) {
+    Log(InfoLogLevel::WARN_LEVEL, db_options_.info_log,
+        "Failed to persist stats: %s", s.ToString().c_str());
+  }
+}
+
+Status DBImpl::PersistStats(uint64_t now_micros) {
+  StatsRecordWriter record;
+  record.BeginObject();
+  // The time comes first, see StatsHistory::RecordTime()
+  record.Add("time_micros", now_micros);
+  {
+    MutexLock l(&mutex_);
+    record.BeginObject("db");
+    default_cf_internal_stats_->AddDBStatsRecord(&record);
+    record.Add("write_stopped", write_controller_.IsStopped());
+    record.Add("write_delay_micros", write_controller_.GetDelay());
+    record.EndObject();
+    record.BeginArray("column_families");
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      if (cfd->IsDropped()) {
+        continue;
+      }
+      record.BeginObject();
+      cfd->internal_stats()->AddCFStatsRecord(&record);
+      record.EndObject();
+    }
+    record.EndArray();
+  }
+  stats_history_.AddStatistics(db_options_.statistics.get(), &record);
+  record.EndObject();
+  return stats_history_.Append(now_micros, record);
+}
+
+Status DBImpl::GetStatsHistory(uint64_t start_time, uint64_t end_time,
+                               std::vector<std::string>* records) {
+  return stats_history_.GetHistory(start_time, end_time, records);
+}
+
 // If it's doing full scan:
 // * Returns the list of live files in 'full_scan_sst_live' and the list
 // of all files in the filesystem in 'full_scan_candidate_files'.
@@ -467,6 +539,8 @@ void DBImpl::FindObsoleteFiles(JobContext* job_context, bool force,
       versions_->pending_manifest_file_number();
   job_context->log_number = versions_->MinLogNumber();
   job_context->prev_log_number = versions_->prev_log_number();
+  job_context->log_recycle_files.assign(log_recycle_files_.begin(),
+                                        log_recycle_files_.end());
 
   // don't delete live files
   if (pending_outputs_.size()) {
@@ -515,6 +589,23 @@ void DBImpl::FindObsoleteFiles(JobContext* job_context, bool force,
       }
     }
   }
+
+#ifndef ROCKSDB_LITE
+  // A deleted table file no longer belongs to any column family, so the
+  // listeners of all of them hear about it
+  if (!job_context->sst_delete_files.empty() ||
+      !job_context->full_scan_candidate_files.empty()) {
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      for (const auto& listener : cfd->ioptions()->listeners) {
+        if (std::find(job_context->listeners.begin(),
+                      job_context->listeners.end(),
+                      listener) == job_context->listeners.end()) {
+          job_context->listeners.push_back(listener);
+        }
+      }
+    }
+  }
+#endif  // ROCKSDB_LITE
 }
 
 namespace {
@@ -594,7 +685,10 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
     switch (type) {
       case kLogFile:
         keep = ((number >= state.log_number) ||
-                (number == state.prev_log_number));
+                (number == state.prev_log_number) ||
+                (std::find(state.log_recycle_files.begin(),
+                           state.log_recycle_files.end(),
+                           number) != state.log_recycle_files.end()));
         break;
       case kDescriptorFile:
         // Keep my manifest file, and any newer incarnations'
@@ -626,6 +720,7 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
       case kDBLockFile:
       case kIdentityFile:
       case kMetaDatabase:
+      case kStatsHistoryFile:
         keep = true;
         break;
     }
@@ -658,6 +753,15 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
       Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
           "Delete %s type=%d #%" PRIu64 " -- %s\n",
           fname.c_str(), type, number, s.ToString().c_str());
+      if (type == kTableFile && !state.listeners.empty()) {
+        TableFileDeletionInfo info;
+        info.db_name = dbname_;
+        info.file_path = fname;
+        info.status = s;
+        for (const auto& listener : state.listeners) {
+          listener->OnTableFileDeleted(info);
+        }
+      }
     }
 #endif  // ROCKSDB_LITE
   }
@@ -702,6 +806,7 @@ Status DBImpl::Recover(
     const std::vector<ColumnFamilyDescriptor>& column_families, bool read_only,
     bool error_if_log_file_exist) {
   mutex_.AssertHeld();
+  StopWatch sw(env_, stats_, DB_RECOVERY_MICROS);
 
   bool is_new_db = false;
   assert(db_lock_ == nullptr);
@@ -761,12 +866,16 @@ Status DBImpl::Recover(
     }
   }
 
+  uint64_t manifest_start_micros = env_->NowMicros();
   Status s = versions_->Recover(column_families, read_only);
+  uint64_t manifest_micros = env_->NowMicros() - manifest_start_micros;
+  uint64_t wal_replay_micros = 0;
   if (db_options_.paranoid_checks && s.ok()) {
     s = CheckConsistency();
   }
   if (s.ok()) {
     SequenceNumber max_sequence(0);
+    uint64_t corrupted_log_number = 0;
     default_cf_handle_ = new ColumnFamilyHandleImpl(
         versions_->GetColumnFamilySet()->GetDefault(), this, &mutex_);
     default_cf_internal_stats_ = default_cf_handle_->cfd()->internal_stats();
@@ -813,7 +922,18 @@ Status DBImpl::Recover(
     if (!logs.empty()) {
       // Recover in the order in which the logs were generated
       std::sort(logs.begin(), logs.end());
-      s = RecoverLogFiles(logs, &max_sequence, read_only);
+      // Report the progress of the replay through GetThreadList()
+      NewThreadStatusCfInfo(default_cf_handle_->cfd());
+      ThreadStatusUtil::SetColumnFamily(default_cf_handle_->cfd());
+      ThreadStatusUtil::SetThreadOperation(ThreadStatus::OP_RECOVERY);
+      ThreadStatusUtil::SetThreadOperationProperty(
+          ThreadStatus::RECOVERY_TABLE_FILES_OPENED,
+          versions_->recovery_tables_opened());
+      uint64_t wal_start_micros = env_->NowMicros();
+      s = RecoverLogFiles(logs, &max_sequence, read_only,
+                          &corrupted_log_number);
+      wal_replay_micros = env_->NowMicros() - wal_start_micros;
+      ThreadStatusUtil::ResetThreadStatus();
       if (!s.ok()) {
         // Clear memtables if recovery failed
         for (auto cfd : *versions_->GetColumnFamilySet()) {
@@ -822,6 +942,32 @@ Status DBImpl::Recover(
       }
     }
     SetTickerCount(stats_, SEQUENCE_NUMBER, versions_->LastSequence());
+
+    // Table loading is part of the manifest replay, report it separately
+    uint64_t table_load_micros = versions_->recovery_table_load_micros();
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_MANIFEST_MICROS,
+        manifest_micros - table_load_micros);
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_TABLE_LOAD_MICROS, table_load_micros);
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_WAL_REPLAY_MICROS, wal_replay_micros);
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_SEQUENCE,
+        corrupted_log_number != 0 ? max_sequence : versions_->LastSequence());
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_CORRUPTED_LOG, corrupted_log_number);
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_TABLE_FILES_OPENED,
+        versions_->recovery_tables_opened());
+    default_cf_internal_stats_->AddDBStats(
+        InternalStats::RECOVERY_TABLE_LOAD_THREADS,
+        versions_->recovery_table_load_threads());
+    Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
+        "Recovery took %" PRIu64 " us in manifest replay, %" PRIu64
+        " us in table load (%zu threads), %" PRIu64 " us in WAL replay",
+        manifest_micros - table_load_micros, table_load_micros,
+        versions_->recovery_table_load_threads(), wal_replay_micros);
   }
 
   // Initial value
@@ -835,14 +981,120 @@ Status DBImpl::Recover(
   return s;
 }
 
+struct DBImpl::RecoveryFlushJob {
+  ColumnFamilyData* cfd;
+  MemTable* mem;
+  VersionEdit* edit;
+  FileMetaData meta;
+  std::list<uint64_t>::iterator pending_outputs_inserted_elem;
+  SequenceNumber newest_snapshot;
+  uint64_t start_micros;
+  Status status;
+};
+
+// Hands the level-0 flushes of WAL recovery to the background flush thread
+// pool, so that replay continues into a new memtable while the full one is
+// written out. At most max_running flushes are in flight at a time; each
+// of them holds on to its memtable.
+class DBImpl::RecoveryFlushScheduler {
+ public:
+  RecoveryFlushScheduler(DBImpl* db, size_t max_running)
+      : db_(db), max_running_(max_running), cv_(&mu_), running_(0) {}
+
+  ~RecoveryFlushScheduler() {
+    // Only reached with jobs left if recovery failed anyway
+    Wait(0);
+  }
+
+  // Flush "mem", which the caller already replaced in cfd. Takes over the
+  // caller's reference to mem. Returns the error of any flush that
+  // finished meanwhile.
+  // REQUIRES: db mutex held
+  Status Schedule(ColumnFamilyData* cfd, MemTable* mem, VersionEdit* edit) {
+    Status s = Wait(max_running_ - 1);
+    Job* job = new Job;
+    job->scheduler = this;
+    job->done = false;
+    db_->PrepareRecoveryFlush(cfd, mem, edit, &job->flush);
+    jobs_.push_back(job);
+    {
+      MutexLock l(&mu_);
+      running_++;
+    }
+    db_->env_->Schedule(&RecoveryFlushScheduler::BGWork, job,
+                        db_->db_options_.max_background_flushes > 0
+                            ? Env::Priority::HIGH
+                            : Env::Priority::LOW);
+    return s;
+  }
+
+  // Wait until at most max_running flushes are in flight, and record the
+  // finished ones in their version edits.
+  // REQUIRES: db mutex held
+  Status Wait(size_t max_running) {
+    {
+      MutexLock l(&mu_);
+      while (running_ > max_running) {
+        cv_.Wait();
+      }
+    }
+    Status s;
+    for (auto iter = jobs_.begin(); iter != jobs_.end();) {
+      Job* job = *iter;
+      {
+        MutexLock l(&mu_);
+        if (!job->done) {
+          ++iter;
+          continue;
+        }
+      }
+      Status job_status = db_->FinishRecoveryFlush(&job->flush);
+      if (s.ok()) {
+        s = job_status;
+      }
+      delete job->flush.mem->Unref();
+      delete job;
+      iter = jobs_.erase(iter);
+    }
+    return s;
+  }
+
+ private:
+  struct Job {
+    RecoveryFlushScheduler* scheduler;
+    RecoveryFlushJob flush;
+    bool done;
+  };
+
+  static void BGWork(void* arg) {
+    Job* job = reinterpret_cast<Job*>(arg);
+    RecoveryFlushScheduler* scheduler = job->scheduler;
+    scheduler->db_->BuildRecoveryTable(&job->flush);
+    MutexLock l(&scheduler->mu_);
+    job->done = true;
+    scheduler->running_--;
+    scheduler->cv_.SignalAll();
+  }
+
+  DBImpl* db_;
+  const size_t max_running_;
+  port::Mutex mu_;
+  port::CondVar cv_;
+  size_t running_;
+  std::list<Job*> jobs_;
+};
+
 // REQUIRES: log_numbers are sorted in ascending order
 Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
-                               SequenceNumber* max_sequence, bool read_only) {
+                               SequenceNumber* max_sequence, bool read_only,
+                               uint64_t* corrupted_log_number) {
   struct LogReporter : public log::Reader::Reporter {
     Env* env;
     Logger* info_log;
     const char* fname;
-    Status* status;  // nullptr if db_options_.paranoid_checks==false
+    // nullptr if db_options_.paranoid_checks==false, unless in
+    // point-in-time recovery
+    Status* status;
     virtual void Corruption(size_t bytes, const Status& s) {
       Log(InfoLogLevel::WARN_LEVEL,
           info_log, "%s%s: dropping %d bytes; %s",
@@ -854,7 +1106,16 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
 
   mutex_.AssertHeld();
   Status status;
+  const bool point_in_time =
+      db_options_.wal_recovery_mode == kWALRecoveryModePointInTime;
+  // First corruption found in point-in-time recovery
+  Status corruption;
   std::unordered_map<int, VersionEdit> version_edits;
+  std::unique_ptr<RecoveryFlushScheduler> flush_scheduler;
+  if (db_options_.pipelined_wal_recovery && !read_only) {
+    flush_scheduler.reset(new RecoveryFlushScheduler(
+        this, std::max(db_options_.max_background_flushes, 1)));
+  }
   // no need to refcount because iteration is under mutex
   for (auto cfd : *versions_->GetColumnFamilySet()) {
     VersionEdit edit;
@@ -867,6 +1128,10 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     // records after allocating this log number.  So we manually
     // update the file number allocation counter in VersionSet.
     versions_->MarkFileNumberUsedDuringRecovery(log_number);
+    if (!corruption.ok()) {
+      // Point-in-time recovery stopped in an earlier log
+      continue;
+    }
     // Open the log file
     std::string fname = LogFileName(db_options_.wal_dir, log_number);
     unique_ptr<SequentialFile> file;
@@ -887,27 +1152,55 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     reporter.env = env_;
     reporter.info_log = db_options_.info_log.get();
     reporter.fname = fname.c_str();
-    reporter.status = (db_options_.paranoid_checks) ? &status : nullptr;
+    if (point_in_time) {
+      reporter.status = &corruption;
+    } else {
+      reporter.status = (db_options_.paranoid_checks) ? &status : nullptr;
+    }
     // We intentially make log::Reader do checksumming even if
     // paranoid_checks==false so that corruptions cause entire commits
     // to be skipped instead of propagating bad information (like overly
     // large sequence numbers).
-    log::Reader reader(std::move(file), &reporter, true /*checksum*/,
-                       0 /*initial_offset*/);
+    // With pipelined_wal_recovery, a background thread reads up to 4MB of
+    // records ahead of us.
+    unique_ptr<log::Reader> reader;
+    unique_ptr<log::PrefetchReader> prefetch_reader;
+    if (db_options_.pipelined_wal_recovery) {
+      prefetch_reader.reset(new log::PrefetchReader(
+          std::move(file), &reporter, true /*checksum*/, 0 /*initial_offset*/,
+          log_number, 4 << 20 /*max_buffered_bytes*/));
+    } else {
+      reader.reset(new log::Reader(std::move(file), &reporter,
+                                   true /*checksum*/, 0 /*initial_offset*/,
+                                   log_number));
+    }
     Log(InfoLogLevel::INFO_LEVEL,
         db_options_.info_log, "Recovering log #%" PRIu64 "", log_number);
+    ThreadStatusUtil::SetThreadOperationProperty(
+        ThreadStatus::RECOVERY_CURRENT_LOG_NUMBER, log_number);
 
     // Read all the records and add to a memtable
     std::string scratch;
     Slice record;
     WriteBatch batch;
-    while (reader.ReadRecord(&record, &scratch) && status.ok()) {
+    while ((prefetch_reader ? prefetch_reader->ReadRecord(&record, &scratch)
+                            : reader->ReadRecord(&record, &scratch)) &&
+           status.ok()) {
+      if (!corruption.ok()) {
+        // The record follows a corruption; ignore it and the rest of the
+        // logs
+        break;
+      }
       if (record.size() < 12) {
         reporter.Corruption(record.size(),
                             Status::Corruption("log record too small"));
         continue;
       }
       WriteBatchInternal::SetContents(&batch, record);
+      default_cf_internal_stats_->AddDBStats(InternalStats::RECOVERY_WAL_BYTES,
+                                             record.size());
+      ThreadStatusUtil::IncreaseThreadOperationProperty(
+          ThreadStatus::RECOVERY_WAL_BYTES_REPLAYED, record.size());
 
       // If column family was not found, it might mean that the WAL write
       // batch references to the column family that was dropped after the
@@ -940,13 +1233,20 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
           auto iter = version_edits.find(cfd->GetID());
           assert(iter != version_edits.end());
           VersionEdit* edit = &iter->second;
-          status = WriteLevel0TableForRecovery(cfd, cfd->mem(), edit);
+          if (flush_scheduler) {
+            MemTable* mem = cfd->mem();
+            mem->Ref();
+            cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions());
+            status = flush_scheduler->Schedule(cfd, mem, edit);
+          } else {
+            status = WriteLevel0TableForRecovery(cfd, cfd->mem(), edit);
+            cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions());
+          }
           if (!status.ok()) {
             // Reflect errors immediately so that conditions like full
             // file-systems cause the DB::Open() to fail.
             return status;
           }
-          cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions());
         }
       }
     }
@@ -954,11 +1254,49 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     if (!status.ok()) {
       return status;
     }
+    if (!corruption.ok()) {
+      *corrupted_log_number = log_number;
+    }
 
     flush_scheduler_.Clear();
     if (versions_->LastSequence() < *max_sequence) {
       versions_->SetLastSequence(*max_sequence);
     }
+    TEST_SYNC_POINT("DBImpl::RecoverLogFiles:1");
+    TEST_SYNC_POINT("DBImpl::RecoverLogFiles:2");
+  }
+
+  if (!corruption.ok()) {
+    // The table files must not hold anything written after the last record
+    // replayed, or the DB would not be at a consistent point in time. If
+    // no record was replayed, the point is where the table files are.
+    const SequenceNumber last_replayed = *max_sequence;
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      const auto* vstorage = cfd->current()->storage_info();
+      for (int level = 0; level < vstorage->num_levels(); level++) {
+        for (const auto* f : vstorage->LevelFiles(level)) {
+          if (last_replayed != 0 && f->largest_seqno > last_replayed) {
+            return Status::Corruption(
+                "Point-in-time recovery: column family " + cfd->GetName() +
+                " holds data written after the corruption in log " +
+                NumberToString(*corrupted_log_number));
+          }
+          *max_sequence = std::max(*max_sequence, f->largest_seqno);
+        }
+      }
+    }
+    Log(InfoLogLevel::WARN_LEVEL, db_options_.info_log,
+        "Point-in-time recovery stopped at the first corruption in log #%"
+        PRIu64 " (%s); recovered to sequence %" PRIu64
+        ", ignoring the rest of the logs",
+        *corrupted_log_number, corruption.ToString().c_str(), *max_sequence);
+  }
+
+  if (flush_scheduler) {
+    status = flush_scheduler->Wait(0);
+    if (!status.ok()) {
+      return status;
+    }
   }
 
   if (!read_only) {
@@ -1017,62 +1355,78 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
 Status DBImpl::WriteLevel0TableForRecovery(ColumnFamilyData* cfd, MemTable* mem,
                                            VersionEdit* edit) {
   mutex_.AssertHeld();
-  const uint64_t start_micros = env_->NowMicros();
-  FileMetaData meta;
-  meta.fd = FileDescriptor(versions_->NewFileNumber(), 0, 0);
-  auto pending_outputs_inserted_elem =
+  RecoveryFlushJob job;
+  PrepareRecoveryFlush(cfd, mem, edit, &job);
+  mutex_.Unlock();
+  BuildRecoveryTable(&job);
+  mutex_.Lock();
+  return FinishRecoveryFlush(&job);
+}
+
+void DBImpl::PrepareRecoveryFlush(ColumnFamilyData* cfd, MemTable* mem,
+                                  VersionEdit* edit, RecoveryFlushJob* job) {
+  mutex_.AssertHeld();
+  job->cfd = cfd;
+  job->mem = mem;
+  job->edit = edit;
+  job->start_micros = env_->NowMicros();
+  job->meta.fd = FileDescriptor(versions_->NewFileNumber(), 0, 0);
+  job->pending_outputs_inserted_elem =
       CaptureCurrentFileNumberInPendingOutputs();
+  job->newest_snapshot = snapshots_.GetNewest();
+}
+
+void DBImpl::BuildRecoveryTable(RecoveryFlushJob* job) {
+  ColumnFamilyData* cfd = job->cfd;
   ReadOptions ro;
   ro.total_order_seek = true;
   Arena arena;
-  Status s;
-  {
-    ScopedArenaIterator iter(mem->NewIterator(ro, &arena));
-    const SequenceNumber newest_snapshot = snapshots_.GetNewest();
-    const SequenceNumber earliest_seqno_in_memtable =
-        mem->GetFirstSequenceNumber();
-    Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
-        "[%s] [WriteLevel0TableForRecovery]"
-        " Level-0 table #%" PRIu64 ": started",
-        cfd->GetName().c_str(), meta.fd.GetNumber());
+  ScopedArenaIterator iter(job->mem->NewIterator(ro, &arena));
+  Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
+      "[%s] [WriteLevel0TableForRecovery]"
+      " Level-0 table #%" PRIu64 ": started",
+      cfd->GetName().c_str(), job->meta.fd.GetNumber());
+
+  job->status = BuildTable(
+      dbname_, env_, *cfd->ioptions(), env_options_, cfd->table_cache(),
+      iter.get(), &job->meta, cfd->internal_comparator(), job->newest_snapshot,
+      job->mem->GetFirstSequenceNumber(), GetCompressionFlush(*cfd->ioptions()),
+      cfd->ioptions()->compression_opts, Env::IO_HIGH);
+  LogFlush(db_options_.info_log);
 
-    {
-      mutex_.Unlock();
-      s = BuildTable(
-          dbname_, env_, *cfd->ioptions(), env_options_, cfd->table_cache(),
-          iter.get(), &meta, cfd->internal_comparator(), newest_snapshot,
-          earliest_seqno_in_memtable, GetCompressionFlush(*cfd->ioptions()),
-          cfd->ioptions()->compression_opts, Env::IO_HIGH);
-      LogFlush(db_options_.info_log);
-      mutex_.Lock();
-    }
+  Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
+      "[%s] [WriteLevel0TableForRecovery]"
+      " Level-0 table #%" PRIu64 ": %" PRIu64 " bytes %s",
+      cfd->GetName().c_str(), job->meta.fd.GetNumber(),
+      job->meta.fd.GetFileSize(), job->status.ToString().c_str());
+}
 
-    Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
-        "[%s] [WriteLevel0TableForRecovery]"
-        " Level-0 table #%" PRIu64 ": %" PRIu64 " bytes %s",
-        cfd->GetName().c_str(), meta.fd.GetNumber(), meta.fd.GetFileSize(),
-        s.ToString().c_str());
-  }
-  ReleaseFileNumberFromPendingOutputs(pending_outputs_inserted_elem);
+Status DBImpl::FinishRecoveryFlush(RecoveryFlushJob* job) {
+  mutex_.AssertHeld();
+  ColumnFamilyData* cfd = job->cfd;
+  const FileMetaData& meta = job->meta;
+  ReleaseFileNumberFromPendingOutputs(job->pending_outputs_inserted_elem);
 
   // Note that if file_size is zero, the file has been deleted and
   // should not be added to the manifest.
   int level = 0;
-  if (s.ok() && meta.fd.GetFileSize() > 0) {
-    edit->AddFile(level, meta.fd.GetNumber(), meta.fd.GetPathId(),
-                  meta.fd.GetFileSize(), meta.smallest, meta.largest,
-                  meta.smallest_seqno, meta.largest_seqno);
+  if (job->status.ok() && meta.fd.GetFileSize() > 0) {
+    job->edit->AddFile(level, meta);
   }
 
   InternalStats::CompactionStats stats(1);
-  stats.micros = env_->NowMicros() - start_micros;
+  stats.micros = env_->NowMicros() - job->start_micros;
   stats.bytes_written = meta.fd.GetFileSize();
   stats.files_out_levelnp1 = 1;
   cfd->internal_stats()->AddCompactionStats(level, stats);
   cfd->internal_stats()->AddCFStats(
       InternalStats::BYTES_FLUSHED, meta.fd.GetFileSize());
   RecordTick(stats_, COMPACT_WRITE_BYTES, meta.fd.GetFileSize());
-  return s;
+  default_cf_internal_stats_->AddDBStats(
+      InternalStats::RECOVERY_MEMTABLE_FLUSHES, 1);
+  ThreadStatusUtil::IncreaseThreadOperationProperty(
+      ThreadStatus::RECOVERY_MEMTABLE_FLUSHES, 1);
+  return job->status;
 }
 
 Status DBImpl::FlushMemTableToOutputFile(
@@ -1105,7 +1459,13 @@ Status DBImpl::FlushMemTableToOutputFile(
       while (alive_log_files_.size() &&
              alive_log_files_.begin()->number < versions_->MinLogNumber()) {
         const auto& earliest = *alive_log_files_.begin();
-        job_context->log_delete_files.push_back(earliest.number);
+        if (db_options_.recycle_log_file_num > log_recycle_files_.size()) {
+          LogToBuffer(log_buffer, "adding log %" PRIu64 " to recycle list\n",
+                      earliest.number);
+          log_recycle_files_.push_back(earliest.number);
+        } else {
+          job_context->log_delete_files.push_back(earliest.number);
+        }
         total_log_size_ -= earliest.size;
         alive_log_files_.pop_front();
       }
@@ -1161,6 +1521,86 @@ void DBImpl::NotifyOnFlushCompleted(
 #endif  // ROCKSDB_LITE
 }
 
+void DBImpl::NotifyOnCompactionCompleted(
+    ColumnFamilyData* cfd, Compaction* c, const Status& st,
+    const InternalStats::CompactionStats& stats) {
+#ifndef ROCKSDB_LITE
+  if (cfd->ioptions()->listeners.size() == 0U) {
+    return;
+  }
+  mutex_.AssertHeld();
+  if (shutting_down_.load(std::memory_order_acquire)) {
+    return;
+  }
+  CompactionJobInfo info;
+  info.cf_name = cfd->GetName();
+  info.status = st;
+  info.base_input_level = c->level();
+  info.output_level = c->output_level();
+  for (size_t i = 0; i < c->num_input_levels(); ++i) {
+    for (const auto* f : *c->inputs(i)) {
+      info.input_files.push_back(TableFileName(
+          db_options_.db_paths, f->fd.GetNumber(), f->fd.GetPathId()));
+    }
+  }
+  if (st.ok()) {
+    for (const auto& new_file : c->edit()->GetNewFiles()) {
+      const FileDescriptor& fd = new_file.second.fd;
+      info.output_files.push_back(TableFileName(
+          db_options_.db_paths, fd.GetNumber(), fd.GetPathId()));
+    }
+  }
+  info.elapsed_micros = stats.micros;
+  info.num_input_files_at_base_level = stats.files_in_leveln;
+  info.num_input_files_at_output_level = stats.files_in_levelnp1;
+  info.bytes_read_base_level = stats.bytes_readn;
+  info.bytes_read_output_level = stats.bytes_readnp1;
+  info.num_output_files = stats.files_out_levelnp1;
+  info.bytes_written = stats.bytes_written;
+  info.num_input_records = stats.num_input_records;
+  info.num_dropped_records = stats.num_dropped_records;
+
+  notifying_events_++;
+  // release lock while notifying events
+  mutex_.Unlock();
+  for (auto listener : cfd->ioptions()->listeners) {
+    listener->OnCompactionCompleted(this, info);
+  }
+  mutex_.Lock();
+  notifying_events_--;
+  assert(notifying_events_ >= 0);
+  // no need to signal bg_cv_ as it will be signaled at the end of the
+  // compaction process.
+#endif  // ROCKSDB_LITE
+}
+
+void DBImpl::NotifyOnStallConditionsChanged() {
+#ifndef ROCKSDB_LITE
+  mutex_.AssertHeld();
+  // A thread that is already reporting also reports the changes queued
+  // meanwhile, so that the listeners see them in order
+  if (write_stall_notifications_.empty() || notifying_write_stalls_) {
+    return;
+  }
+  notifying_write_stalls_ = true;
+  notifying_events_++;
+  while (!write_stall_notifications_.empty()) {
+    WriteStallNotification notification =
+        std::move(write_stall_notifications_.front());
+    write_stall_notifications_.pop_front();
+    // release lock while notifying events
+    mutex_.Unlock();
+    for (const auto& listener : notification.listeners) {
+      listener->OnStallConditionsChanged(notification.info);
+    }
+    mutex_.Lock();
+  }
+  notifying_write_stalls_ = false;
+  notifying_events_--;
+  assert(notifying_events_ >= 0);
+#endif  // ROCKSDB_LITE
+}
+
 Status DBImpl::CompactRange(ColumnFamilyHandle* column_family,
                             const Slice* begin, const Slice* end,
                             bool reduce_level, int target_level,
@@ -1328,21 +1768,32 @@ Status DBImpl::CompactFilesImpl(
                                      *c->mutable_cf_options(), &job_context,
                                      &log_buffer);
   };
-  CompactionJob compaction_job(c.get(), db_options_, *c->mutable_cf_options(),
-                               env_options_, versions_.get(), &shutting_down_,
-                               &log_buffer, db_directory_.get(), stats_,
-                               &snapshots_, is_snapshot_supported_,
-                               table_cache_, std::move(yield_callback));
+  CompactionJob compaction_job(dbname_, c.get(), db_options_,
+                               *c->mutable_cf_options(), env_options_,
+                               versions_.get(), &shutting_down_, &log_buffer,
+                               db_directory_.get(), stats_, &snapshots_,
+                               is_snapshot_supported_, table_cache_,
+                               std::move(yield_callback));
   compaction_job.Prepare();
 
   mutex_.Unlock();
-  Status status = compaction_job.Run();
+  Status status;
+  {
+    BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                             BlockCacheLookupCaller::kCompaction);
+    status = compaction_job.Run();
+  }
   mutex_.Lock();
   compaction_job.Install(&status, &mutex_);
   if (status.ok()) {
     InstallSuperVersionBackground(c->column_family_data(), &job_context,
                                   *c->mutable_cf_options());
   }
+#ifndef ROCKSDB_LITE
+  // may temporarily unlock and lock the mutex.
+  NotifyOnCompactionCompleted(c->column_family_data(), c.get(), status,
+                              compaction_job.compaction_stats());
+#endif  // ROCKSDB_LITE
   c->ReleaseCompactionFiles(s);
   c.reset();
 
@@ -1499,9 +1950,7 @@ Status DBImpl::ReFitLevel(ColumnFamilyData* cfd, int level, int target_level) {
     for (const auto& f : cfd->current()->storage_info()->LevelFiles(level)) {
       f->moved = true;
       edit.DeleteFile(level, f->fd.GetNumber());
-      edit.AddFile(to_level, f->fd.GetNumber(), f->fd.GetPathId(),
-                   f->fd.GetFileSize(), f->smallest, f->largest,
-                   f->smallest_seqno, f->largest_seqno);
+      edit.AddFile(to_level, *f);
     }
     Log(InfoLogLevel::DEBUG_LEVEL, db_options_.info_log,
         "[%s] Apply version edit:\n%s",
@@ -1848,6 +2297,7 @@ void DBImpl::BackgroundCallFlush() {
   JobContext job_context(true);
   assert(bg_flush_scheduled_);
 
+  MaybePersistStats();
   LogBuffer log_buffer(InfoLogLevel::INFO_LEVEL, db_options_.info_log.get());
   {
     MutexLock l(&mutex_);
@@ -1899,6 +2349,9 @@ void DBImpl::BackgroundCallFlush() {
       mutex_.Lock();
     }
 
+    // may temporarily unlock and lock the mutex.
+    NotifyOnStallConditionsChanged();
+
     bg_flush_scheduled_--;
     // See if there's more work to be done
     MaybeScheduleFlushOrCompaction();
@@ -1916,6 +2369,7 @@ void DBImpl::BackgroundCallCompaction() {
   JobContext job_context(true);
 
   MaybeDumpStats();
+  MaybePersistStats();
   LogBuffer log_buffer(InfoLogLevel::INFO_LEVEL, db_options_.info_log.get());
   {
     MutexLock l(&mutex_);
@@ -1971,6 +2425,9 @@ void DBImpl::BackgroundCallCompaction() {
       mutex_.Lock();
     }
 
+    // may temporarily unlock and lock the mutex.
+    NotifyOnStallConditionsChanged();
+
     bg_compaction_scheduled_--;
 
     versions_->GetColumnFamilySet()->FreeDeadColumnFamilies();
@@ -2157,9 +2614,7 @@ Status DBImpl::BackgroundCompaction(bool* madeProgress, JobContext* job_context,
     FileMetaData* f = c->input(0, 0);
     f->moved = true;
     c->edit()->DeleteFile(c->level(), f->fd.GetNumber());
-    c->edit()->AddFile(c->level() + 1, f->fd.GetNumber(), f->fd.GetPathId(),
-                       f->fd.GetFileSize(), f->smallest, f->largest,
-                       f->smallest_seqno, f->largest_seqno);
+    c->edit()->AddFile(c->level() + 1, *f);
     status = versions_->LogAndApply(c->column_family_data(),
                                     *c->mutable_cf_options(),
                                     c->edit(), &mutex_, db_directory_.get());
@@ -2187,20 +2642,30 @@ Status DBImpl::BackgroundCompaction(bool* madeProgress, JobContext* job_context,
                                        *c->mutable_cf_options(), job_context,
                                        log_buffer);
     };
-    CompactionJob compaction_job(c.get(), db_options_, *c->mutable_cf_options(),
-                                 env_options_, versions_.get(), &shutting_down_,
-                                 log_buffer, db_directory_.get(), stats_,
-                                 &snapshots_, is_snapshot_supported_,
-                                 table_cache_, std::move(yield_callback));
+    CompactionJob compaction_job(dbname_, c.get(), db_options_,
+                                 *c->mutable_cf_options(), env_options_,
+                                 versions_.get(), &shutting_down_, log_buffer,
+                                 db_directory_.get(), stats_, &snapshots_,
+                                 is_snapshot_supported_, table_cache_,
+                                 std::move(yield_callback));
     compaction_job.Prepare();
     mutex_.Unlock();
-    status = compaction_job.Run();
+    {
+      BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                               BlockCacheLookupCaller::kCompaction);
+      status = compaction_job.Run();
+    }
     mutex_.Lock();
     compaction_job.Install(&status, &mutex_);
     if (status.ok()) {
       InstallSuperVersionBackground(c->column_family_data(), job_context,
                                     *c->mutable_cf_options());
     }
+#ifndef ROCKSDB_LITE
+    // may temporarily unlock and lock the mutex.
+    NotifyOnCompactionCompleted(c->column_family_data(), c.get(), status,
+                                compaction_job.compaction_stats());
+#endif  // ROCKSDB_LITE
     c->ReleaseCompactionFiles(status);
     *madeProgress = true;
   }
@@ -2342,6 +2807,20 @@ ColumnFamilyHandle* DBImpl::DefaultColumnFamily() const {
 Status DBImpl::Get(const ReadOptions& read_options,
                    ColumnFamilyHandle* column_family, const Slice& key,
                    std::string* value) {
+  TraceGet(column_family, key);
+  PinnableSlice pinnable_val(value);
+  auto s = GetImpl(read_options, column_family, key, &pinnable_val);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }  // else value is already assigned
+  return s;
+}
+
+Status DBImpl::Get(const ReadOptions& read_options,
+                   ColumnFamilyHandle* column_family, const Slice& key,
+                   PinnableSlice* value) {
+  TraceGet(column_family, key);
+  value->Reset();
   return GetImpl(read_options, column_family, key, value);
 }
 
@@ -2381,9 +2860,24 @@ SuperVersion* DBImpl::InstallSuperVersion(
                         old_sv->mutable_cf_options.max_write_buffer_number;
   }
 
+  const WriteStallCondition old_stall_condition =
+      cfd->write_stall_condition();
   auto* old = cfd->InstallSuperVersion(
       new_sv ? new_sv : new SuperVersion(), &mutex_, mutable_cf_options);
 
+#ifndef ROCKSDB_LITE
+  // The listeners are called later, without the mutex
+  if (cfd->write_stall_condition() != old_stall_condition &&
+      !cfd->ioptions()->listeners.empty()) {
+    WriteStallNotification notification;
+    notification.info.cf_name = cfd->GetName();
+    notification.info.condition.cur = cfd->write_stall_condition();
+    notification.info.condition.prev = old_stall_condition;
+    notification.listeners = cfd->ioptions()->listeners;
+    write_stall_notifications_.push_back(std::move(notification));
+  }
+#endif  // ROCKSDB_LITE
+
   // Whenever we install new SuperVersion, we might need to issue new flushes or
   // compactions. dont_schedule_bg_work is true when scheduling from write
   // thread and we don't want to add additional overhead. Callers promise to
@@ -2404,12 +2898,17 @@ SuperVersion* DBImpl::InstallSuperVersion(
 
 Status DBImpl::GetImpl(const ReadOptions& read_options,
                        ColumnFamilyHandle* column_family, const Slice& key,
-                       std::string* value, bool* value_found) {
+                       PinnableSlice* value, bool* value_found) {
   StopWatch sw(env_, stats_, DB_GET);
+  TRACE_REQUEST_GUARD(db_options_.request_tracer.get(), read_options.trace,
+                      RequestTrace::kGet, env_);
+  BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                           BlockCacheLookupCaller::kUserGet);
   PERF_TIMER_GUARD(get_snapshot_time);
 
   auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
   auto cfd = cfh->cfd();
+  TRACE_REQUEST_SET_CF_NAME(cfd->GetName());
 
   SequenceNumber snapshot;
   if (read_options.snapshot != nullptr) {
@@ -2432,11 +2931,19 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   LookupKey lkey(key, snapshot);
   PERF_TIMER_STOP(get_snapshot_time);
 
-  if (sv->mem->Get(lkey, value, &s, &merge_context)) {
-    // Done
-    RecordTick(stats_, MEMTABLE_HIT);
-  } else if (sv->imm->Get(lkey, value, &s, &merge_context)) {
+  // Values found in memtables are copied into the self buffer of *value:
+  // memtable entries can be updated in place, so they are never pinned.
+  bool found_in_memtable;
+  {
+    TRACE_SPAN_GUARD(memtable_get, TraceSpanType::kMemTableGet);
+    found_in_memtable =
+        sv->mem->Get(lkey, value->GetSelf(), &s, &merge_context) ||
+        sv->imm->Get(lkey, value->GetSelf(), &s, &merge_context);
+    TRACE_SPAN_SET_VALUE(memtable_get, found_in_memtable ? 1 : 0);
+  }
+  if (found_in_memtable) {
     // Done
+    value->PinSelf();
     RecordTick(stats_, MEMTABLE_HIT);
   } else {
     PERF_TIMER_GUARD(get_from_output_files_time);
@@ -2453,6 +2960,7 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
     RecordTick(stats_, NUMBER_KEYS_READ);
     RecordTick(stats_, BYTES_READ, value->size());
   }
+  TRACE_REQUEST_SET_STATUS(s);
   return s;
 }
 
@@ -2460,8 +2968,11 @@ std::vector<Status> DBImpl::MultiGet(
     const ReadOptions& read_options,
     const std::vector<ColumnFamilyHandle*>& column_family,
     const std::vector<Slice>& keys, std::vector<std::string>* values) {
+  TraceMultiGet(column_family, keys);
 
   StopWatch sw(env_, stats_, DB_MULTIGET);
+  BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                           BlockCacheLookupCaller::kUserMultiGet);
   PERF_TIMER_GUARD(get_snapshot_time);
 
   SequenceNumber snapshot;
@@ -2515,6 +3026,7 @@ std::vector<Status> DBImpl::MultiGet(
     merge_context.Clear();
     Status& s = stat_list[i];
     std::string* value = &(*values)[i];
+    PinnableSlice pinnable_val(value);
 
     LookupKey lkey(keys[i], snapshot);
     auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
@@ -2528,8 +3040,11 @@ std::vector<Status> DBImpl::MultiGet(
       // Done
     } else {
       PERF_TIMER_GUARD(get_from_output_files_time);
-      super_version->current->Get(read_options, lkey, value, &s,
+      super_version->current->Get(read_options, lkey, &pinnable_val, &s,
                                   &merge_context);
+      if (s.ok() && pinnable_val.IsPinned()) {
+        value->assign(pinnable_val.data(), pinnable_val.size());
+      }
     }
 
     if (s.ok()) {
@@ -2704,7 +3219,11 @@ bool DBImpl::KeyMayExist(const ReadOptions& read_options,
   }
   ReadOptions roptions = read_options;
   roptions.read_tier = kBlockCacheTier; // read from block cache only
-  auto s = GetImpl(roptions, column_family, key, value, value_found);
+  PinnableSlice pinnable_val(value);
+  auto s = GetImpl(roptions, column_family, key, &pinnable_val, value_found);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }
 
   // If block_cache is enabled and the index block of the table didn't
   // not present in block_cache, the return value will be Status::Incomplete.
@@ -2722,6 +3241,10 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     // not supported in lite version
     return nullptr;
 #else
+    if (read_options.pin_data) {
+      return NewErrorIterator(Status::NotSupported(
+          "ReadOptions::pin_data is not supported for tailing iterators"));
+    }
     SuperVersion* sv = cfd->GetReferencedSuperVersion(&mutex_);
     auto iter = new ForwardIterator(this, read_options, cfd, sv);
     return NewDBIterator(env_, *cfd->ioptions(), cfd->user_comparator(), iter,
@@ -2784,11 +3307,14 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     ArenaWrappedDBIter* db_iter = NewArenaWrappedDbIterator(
         env_, *cfd->ioptions(), cfd->user_comparator(),
         snapshot, sv->mutable_cf_options.max_sequential_skip_in_iterations,
-        read_options.iterate_upper_bound);
+        read_options.iterate_upper_bound, read_options.pin_data);
 
+    BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                             BlockCacheLookupCaller::kUserIterator);
     Iterator* internal_iter =
         NewInternalIterator(read_options, cfd, sv, db_iter->GetArena());
     db_iter->SetIterUnderDBIter(internal_iter);
+    db_iter->SetTraceContext(this, cfd->GetID());
 
     return db_iter;
   }
@@ -2808,6 +3334,10 @@ Status DBImpl::NewIterators(
     return Status::InvalidArgument(
         "Tailing interator not supported in RocksDB lite");
 #else
+    if (read_options.pin_data) {
+      return Status::NotSupported(
+          "ReadOptions::pin_data is not supported for tailing iterators");
+    }
     for (auto cfh : column_families) {
       auto cfd = reinterpret_cast<ColumnFamilyHandleImpl*>(cfh)->cfd();
       SuperVersion* sv = cfd->GetReferencedSuperVersion(&mutex_);
@@ -2834,10 +3364,14 @@ Status DBImpl::NewIterators(
 
       ArenaWrappedDBIter* db_iter = NewArenaWrappedDbIterator(
           env_, *cfd->ioptions(), cfd->user_comparator(), snapshot,
-          sv->mutable_cf_options.max_sequential_skip_in_iterations);
+          sv->mutable_cf_options.max_sequential_skip_in_iterations,
+          nullptr /* iterate_upper_bound */, read_options.pin_data);
+      BLOCK_CACHE_LOOKUP_GUARD(&block_cache_tracer_,
+                               BlockCacheLookupCaller::kUserIterator);
       Iterator* internal_iter = NewInternalIterator(
           read_options, cfd, sv, db_iter->GetArena());
       db_iter->SetIterUnderDBIter(internal_iter);
+      db_iter->SetTraceContext(this, cfd->GetID());
       iterators->push_back(db_iter);
     }
   }
@@ -2882,6 +3416,18 @@ Status DBImpl::Delete(const WriteOptions& write_options,
 }
 
 Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
+  TRACE_REQUEST_GUARD(db_options_.request_tracer.get(), write_options.trace,
+                      RequestTrace::kWrite, env_);
+  if (my_batch != nullptr) {
+    TraceWrite(my_batch);
+  }
+  Status s = WriteImpl(write_options, my_batch);
+  TRACE_REQUEST_SET_STATUS(s);
+  return s;
+}
+
+Status DBImpl::WriteImpl(const WriteOptions& write_options,
+                         WriteBatch* my_batch) {
   if (my_batch == nullptr) {
     return Status::Corruption("Batch is nullptr!");
   }
@@ -2910,7 +3456,12 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
 
   WriteContext context;
   mutex_.Lock();
-  Status status = write_thread_.EnterWriteThread(&w, expiration_time);
+  Status status;
+  {
+    TRACE_SPAN_GUARD(queue_wait, TraceSpanType::kWriteQueueWait);
+    status = write_thread_.EnterWriteThread(&w, expiration_time);
+    TRACE_SPAN_SET_VALUE(queue_wait, w.done ? 1 : 0);
+  }
   assert(status.ok() || status.IsTimedOut());
   if (status.IsTimedOut()) {
     mutex_.Unlock();
@@ -2922,6 +3473,9 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
                                            1);
     mutex_.Unlock();
     RecordTick(stats_, WRITE_DONE_BY_OTHER);
+    if (w.status.ok() && w.sync && w.log_sync != nullptr) {
+      return WaitForLogSync(w);
+    }
     return w.status;
   }
 
@@ -2991,6 +3545,7 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
 
   if (UNLIKELY(status.ok()) &&
       (write_controller_.IsStopped() || write_controller_.GetDelay() > 0)) {
+    TRACE_SPAN_GUARD(stall, TraceSpanType::kWriteStall);
     status = DelayWrite(expiration_time);
   }
 
@@ -3038,15 +3593,25 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
       if (!write_options.disableWAL) {
         PERF_TIMER_GUARD(write_wal_time);
         Slice log_entry = WriteBatchInternal::Contents(updates);
-        status = log_->AddRecord(log_entry);
+        {
+          TRACE_SPAN_GUARD(wal_append, TraceSpanType::kWALAppend);
+          TRACE_SPAN_SET_VALUE(wal_append, log_entry.size());
+          status = log_->AddRecord(log_entry);
+        }
         total_log_size_ += log_entry.size();
         alive_log_files_.back().AddSize(log_entry.size());
         log_empty_ = false;
         log_size = log_entry.size();
         RecordTick(stats_, WAL_FILE_BYTES, log_size);
-        if (status.ok() && write_options.sync) {
+        if (status.ok() && write_options.sync && log_sync_ != nullptr) {
+          // Sync after leaving the write thread, so that the writers that
+          // queue up meanwhile can append and share the next sync
+          w.log_sync = log_sync_;
+          w.log_sync_ticket = log_sync_->NoteAppended(log_size);
+        } else if (status.ok() && write_options.sync) {
           RecordTick(stats_, WAL_FILE_SYNCED);
           StopWatch sw(env_, stats_, WAL_FILE_SYNC_MICROS);
+          TRACE_SPAN_GUARD(wal_sync, TraceSpanType::kWALSync);
           if (db_options_.use_fsync) {
             status = log_->file()->Fsync();
           } else {
@@ -3056,6 +3621,7 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
       }
       if (status.ok()) {
         PERF_TIMER_GUARD(write_memtable_time);
+        TRACE_SPAN_GUARD(memtable_insert, TraceSpanType::kMemTableInsert);
 
         status = WriteBatchInternal::InsertInto(
             updates, column_family_memtables_.get(),
@@ -3101,15 +3667,46 @@ Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
   if (context.schedule_bg_work_) {
     MaybeScheduleFlushOrCompaction();
   }
+  // may temporarily unlock and lock the mutex.
+  NotifyOnStallConditionsChanged();
   mutex_.Unlock();
 
   if (status.IsTimedOut()) {
     RecordTick(stats_, WRITE_TIMEDOUT);
   }
 
+  if (status.ok() && w.log_sync != nullptr) {
+    status = WaitForLogSync(w);
+  }
+
   return status;
 }
 
+std::shared_ptr<log::SyncCoordinator> DBImpl::NewLogSyncCoordinator(
+    log::Writer* log) {
+  if (!log->file()->IsSyncThreadSafe()) {
+    return nullptr;
+  }
+  return std::make_shared<log::SyncCoordinator>(
+      log->file(), db_options_.use_fsync, env_, stats_);
+}
+
+Status DBImpl::WaitForLogSync(const WriteThread::Writer& w) {
+  PERF_TIMER_GUARD(write_wal_time);
+  TRACE_SPAN_GUARD(wal_sync, TraceSpanType::kWALSync);
+  Status s = w.log_sync->SyncUpTo(w.log_sync_ticket);
+  if (!s.ok()) {
+    // The batches covered by the failed sync are already in the memtable,
+    // so even without paranoid_checks, no later write may succeed on top
+    // of them
+    MutexLock l(&mutex_);
+    if (bg_error_.ok()) {
+      bg_error_ = s;  // stop compaction & fail any further writes
+    }
+  }
+  return s;
+}
+
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::DelayWrite(uint64_t expiration_time) {
@@ -3177,6 +3774,11 @@ Status DBImpl::SetNewMemtableAndNewLogFile(ColumnFamilyData* cfd,
   // Do this without holding the dbmutex lock.
   assert(versions_->prev_log_number() == 0);
   bool creating_new_log = !log_empty_;
+  uint64_t recycle_log_number = 0;
+  if (creating_new_log && !log_recycle_files_.empty()) {
+    recycle_log_number = log_recycle_files_.front();
+    log_recycle_files_.pop_front();
+  }
   uint64_t new_log_number =
       creating_new_log ? versions_->NewFileNumber() : logfile_number_;
   SuperVersion* new_superversion = nullptr;
@@ -3185,15 +3787,35 @@ Status DBImpl::SetNewMemtableAndNewLogFile(ColumnFamilyData* cfd,
   Status s;
   {
     if (creating_new_log) {
-      s = env_->NewWritableFile(
-          LogFileName(db_options_.wal_dir, new_log_number),
-          &lfile, env_->OptimizeForLogWrite(env_options_));
+      EnvOptions opt_env_opt = env_->OptimizeForLogWrite(env_options_);
+      opt_env_opt.bytes_per_sync = db_options_.wal_bytes_per_sync;
+      if (recycle_log_number) {
+        Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
+            "reusing log %" PRIu64 " from recycle list\n", recycle_log_number);
+        s = env_->ReuseWritableFile(
+            LogFileName(db_options_.wal_dir, new_log_number),
+            LogFileName(db_options_.wal_dir, recycle_log_number), &lfile,
+            opt_env_opt);
+        if (!s.ok()) {
+          // The file may have been purged meanwhile; start a fresh one
+          Log(InfoLogLevel::WARN_LEVEL, db_options_.info_log,
+              "failed to reuse log %" PRIu64 ": %s\n", recycle_log_number,
+              s.ToString().c_str());
+        }
+      }
+      if (!recycle_log_number || !s.ok()) {
+        s = env_->NewWritableFile(
+            LogFileName(db_options_.wal_dir, new_log_number), &lfile,
+            opt_env_opt);
+      }
       if (s.ok()) {
         // Our final size should be less than write_buffer_size
         // (compression, etc) but err on the side of caution.
         lfile->SetPreallocationBlockSize(
             1.1 * mutable_cf_options.write_buffer_size);
-        new_log = new log::Writer(std::move(lfile));
+        new_log = new log::Writer(std::move(lfile), new_log_number,
+                                  db_options_.recycle_log_file_num > 0,
+                                  db_options_.wal_compression);
       }
     }
 
@@ -3217,7 +3839,11 @@ Status DBImpl::SetNewMemtableAndNewLogFile(ColumnFamilyData* cfd,
     logfile_number_ = new_log_number;
     assert(new_log != nullptr);
     context->logs_to_free_.push_back(log_.release());
+    if (log_sync_ != nullptr) {
+      context->log_syncs_to_retire_.push_back(log_sync_);
+    }
     log_.reset(new_log);
+    log_sync_ = NewLogSyncCoordinator(new_log);
     log_empty_ = true;
     alive_log_files_.push_back(LogFileNumberSize(logfile_number_));
     for (auto loop_cfd : *versions_->GetColumnFamilySet()) {
@@ -3551,6 +4177,89 @@ Status DBImpl::CheckConsistency() {
   }
 }
 
+Status DBImpl::StartTrace(const TraceOptions& trace_options,
+                          std::unique_ptr<TraceWriter>&& trace_writer) {
+  MutexLock l(&trace_mutex_);
+  if (tracer_ != nullptr) {
+    return Status::InvalidArgument("A trace is already being recorded");
+  }
+  std::unique_ptr<Tracer> tracer(
+      new Tracer(env_, trace_options, std::move(trace_writer)));
+  Status s = tracer->Start();
+  if (s.ok()) {
+    tracer_ = std::move(tracer);
+    tracing_.store(true, std::memory_order_relaxed);
+  }
+  return s;
+}
+
+Status DBImpl::EndTrace() {
+  MutexLock l(&trace_mutex_);
+  if (tracer_ == nullptr) {
+    return Status::InvalidArgument("No trace is being recorded");
+  }
+  tracing_.store(false, std::memory_order_relaxed);
+  Status s = tracer_->Close();
+  tracer_.reset();
+  return s;
+}
+
+// Errors writing the trace do not fail the requests
+void DBImpl::TraceWrite(WriteBatch* batch) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) {
+      tracer_->Write(batch);
+    }
+  }
+}
+
+void DBImpl::TraceGet(ColumnFamilyHandle* column_family, const Slice& key) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) {
+      tracer_->Get(cfh->GetID(), key);
+    }
+  }
+}
+
+void DBImpl::TraceMultiGet(
+    const std::vector<ColumnFamilyHandle*>& column_families,
+    const std::vector<Slice>& keys) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    std::vector<uint32_t> cf_ids;
+    cf_ids.reserve(column_families.size());
+    for (auto cf : column_families) {
+      cf_ids.push_back(reinterpret_cast<ColumnFamilyHandleImpl*>(cf)->GetID());
+    }
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) {
+      tracer_->MultiGet(cf_ids, keys);
+    }
+  }
+}
+
+void DBImpl::TraceIteratorSeek(uint32_t cf_id, const Slice& key) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) {
+      tracer_->IteratorSeek(cf_id, key);
+    }
+  }
+}
+
+Status DBImpl::StartBlockCacheTrace(
+    const TraceOptions& trace_options,
+    std::unique_ptr<TraceWriter>&& trace_writer) {
+  return block_cache_tracer_.StartTrace(env_, trace_options,
+                                        std::move(trace_writer));
+}
+
+Status DBImpl::EndBlockCacheTrace() {
+  return block_cache_tracer_.EndTrace();
+}
+
 Status DBImpl::GetDbIdentity(std::string& identity) {
   std::string idfilename = IdentityFileName(dbname_);
   unique_ptr<SequentialFile> idfile;
@@ -3693,14 +4402,20 @@ Status DB::Open(const DBOptions& db_options, const std::string& dbname,
   if (s.ok()) {
     uint64_t new_log_number = impl->versions_->NewFileNumber();
     unique_ptr<WritableFile> lfile;
-    EnvOptions soptions(db_options);
+    EnvOptions soptions =
+        impl->db_options_.env->OptimizeForLogWrite(EnvOptions(db_options));
+    soptions.bytes_per_sync = impl->db_options_.wal_bytes_per_sync;
     s = impl->db_options_.env->NewWritableFile(
         LogFileName(impl->db_options_.wal_dir, new_log_number), &lfile,
-        impl->db_options_.env->OptimizeForLogWrite(soptions));
+        soptions);
     if (s.ok()) {
       lfile->SetPreallocationBlockSize(1.1 * max_write_buffer_size);
       impl->logfile_number_ = new_log_number;
-      impl->log_.reset(new log::Writer(std::move(lfile)));
+      impl->log_.reset(new log::Writer(
+          std::move(lfile), new_log_number,
+          impl->db_options_.recycle_log_file_num > 0,
+          impl->db_options_.wal_compression));
+      impl->log_sync_ = impl->NewLogSyncCoordinator(impl->log_.get());
 
       // set column family handles
       for (auto cf : column_families) {
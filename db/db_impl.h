@@ -19,6 +19,7 @@
 #include <string>
 
 #include "db/dbformat.h"
+#include "db/log_sync_coordinator.h"
 #include "db/log_writer.h"
 #include "db/snapshot.h"
 #include "db/column_family.h"
@@ -35,8 +36,11 @@
 #include "util/stop_watch.h"
 #include "util/thread_local.h"
 #include "util/scoped_arena_iterator.h"
+#include "util/block_cache_tracer.h"
+#include "util/trace_replay.h"
 #include "util/hash.h"
 #include "db/internal_stats.h"
+#include "db/stats_history.h"
 #include "db/write_controller.h"
 #include "db/flush_scheduler.h"
 #include "db/write_thread.h"
@@ -75,6 +79,9 @@ class DBImpl : public DB {
   virtual Status Get(const ReadOptions& options,
                      ColumnFamilyHandle* column_family, const Slice& key,
                      std::string* value);
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value);
   using DB::MultiGet;
   virtual std::vector<Status> MultiGet(
       const ReadOptions& options,
@@ -179,6 +186,24 @@ class DBImpl : public DB {
 
   virtual Status GetDbIdentity(std::string& identity);
 
+  virtual Status StartTrace(
+      const TraceOptions& trace_options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override;
+  virtual Status EndTrace() override;
+
+  // Records an iterator Seek() in the trace started by StartTrace(), if any
+  void TraceIteratorSeek(uint32_t cf_id, const Slice& key);
+
+  virtual Status StartBlockCacheTrace(
+      const TraceOptions& trace_options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override;
+  virtual Status EndBlockCacheTrace() override;
+
+  BlockCacheTracer* block_cache_tracer() { return &block_cache_tracer_; }
+
+  virtual Status GetStatsHistory(uint64_t start_time, uint64_t end_time,
+                                 std::vector<std::string>* records) override;
+
   Status RunManualCompaction(ColumnFamilyData* cfd, int input_level,
                              int output_level, uint32_t output_path_id,
                              const Slice* begin, const Slice* end);
@@ -200,6 +225,9 @@ class DBImpl : public DB {
   // Wait for any compaction
   Status TEST_WaitForCompact();
 
+  // Write a stats record now, as if stats_persist_period_sec had elapsed
+  Status TEST_PersistStats();
+
   // Return an internal iterator over the current state of the database.
   // The keys of this iterator are internal keys (see format.h).
   // The returned iterator should be deleted when no longer needed.
@@ -268,6 +296,15 @@ class DBImpl : public DB {
   void NotifyOnFlushCompleted(ColumnFamilyData* cfd, uint64_t file_number,
                               const MutableCFOptions& mutable_cf_options);
 
+  void NotifyOnCompactionCompleted(ColumnFamilyData* cfd, Compaction* c,
+                                   const Status& st,
+                                   const InternalStats::CompactionStats& stats);
+
+  // Reports the queued write stall changes to the listeners, releasing the
+  // mutex while they run.
+  // REQUIRES: mutex_ held
+  void NotifyOnStallConditionsChanged();
+
   void NewThreadStatusCfInfo(ColumnFamilyData* cfd) const;
 
   void EraseThreadStatusCfInfo(ColumnFamilyData* cfd) const;
@@ -327,8 +364,13 @@ class DBImpl : public DB {
                                    LogBuffer* log_buffer);
 
   // REQUIRES: log_numbers are sorted in ascending order
+  // With kWALRecoveryModePointInTime, sets *corrupted_log_number to the log
+  // whose first corrupted record stopped the replay, and *max_sequence to
+  // the sequence number recovered to. *corrupted_log_number is left at 0
+  // otherwise.
   Status RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
-                         SequenceNumber* max_sequence, bool read_only);
+                         SequenceNumber* max_sequence, bool read_only,
+                         uint64_t* corrupted_log_number);
 
   // The following two methods are used to flush a memtable to
   // storage. The first one is used atdatabase RecoveryTime (when the
@@ -337,13 +379,44 @@ class DBImpl : public DB {
   // concurrent flush memtables to storage.
   Status WriteLevel0TableForRecovery(ColumnFamilyData* cfd, MemTable* mem,
                                      VersionEdit* edit);
+
+  // WriteLevel0TableForRecovery() in three steps, so that the table can be
+  // built in the background flush thread pool (pipelined_wal_recovery)
+  struct RecoveryFlushJob;
+  class RecoveryFlushScheduler;
+  // REQUIRES: mutex_ held
+  void PrepareRecoveryFlush(ColumnFamilyData* cfd, MemTable* mem,
+                            VersionEdit* edit, RecoveryFlushJob* job);
+  // REQUIRES: mutex_ not held
+  void BuildRecoveryTable(RecoveryFlushJob* job);
+  // REQUIRES: mutex_ held
+  Status FinishRecoveryFlush(RecoveryFlushJob* job);
   Status DelayWrite(uint64_t expiration_time);
 
+  // Write() without the request tracing
+  Status WriteImpl(const WriteOptions& write_options, WriteBatch* my_batch);
+
+  // Record requests in the trace started by StartTrace(), if any
+  void TraceWrite(WriteBatch* batch);
+  void TraceGet(ColumnFamilyHandle* column_family, const Slice& key);
+  void TraceMultiGet(const std::vector<ColumnFamilyHandle*>& column_families,
+                     const std::vector<Slice>& keys);
+
   Status ScheduleFlushes(WriteContext* context);
 
   Status SetNewMemtableAndNewLogFile(ColumnFamilyData* cfd,
                                      WriteContext* context);
 
+  // Returns the coordinator for the syncs of "log", or nullptr if its file
+  // cannot be synced while it is being appended to
+  std::shared_ptr<log::SyncCoordinator> NewLogSyncCoordinator(
+      log::Writer* log);
+
+  // Waits until the WAL is synced for the write group of "w", after "w"
+  // left the write thread.
+  // REQUIRES: mutex_ not held
+  Status WaitForLogSync(const WriteThread::Writer& w);
+
   // Force current memtable contents to be flushed.
   Status FlushMemTable(ColumnFamilyData* cfd, const FlushOptions& options);
 
@@ -386,6 +459,11 @@ class DBImpl : public DB {
   // dump rocksdb.stats to LOG
   void MaybeDumpStats();
 
+  // Appends a stats record to the STATS file if stats_persist_period_sec
+  // has elapsed since the previous one
+  void MaybePersistStats();
+  Status PersistStats(uint64_t now_micros);
+
   // Return the minimum empty level that could hold the total data in the
   // input level. Return the input level, if such level could not be found.
   int FindMinimumEmptyLevelFitting(ColumnFamilyData* cfd,
@@ -422,6 +500,8 @@ class DBImpl : public DB {
   port::CondVar bg_cv_;
   uint64_t logfile_number_;
   unique_ptr<log::Writer> log_;
+  // group commit for the syncs of log_; nullptr if not supported by its file
+  std::shared_ptr<log::SyncCoordinator> log_sync_;
   bool log_empty_;
   ColumnFamilyHandleImpl* default_cf_handle_;
   InternalStats* default_cf_internal_stats_;
@@ -435,6 +515,9 @@ class DBImpl : public DB {
     bool getting_flushed;
   };
   std::deque<LogFileNumberSize> alive_log_files_;
+  // obsolete log files kept around to be reused for new logs
+  // (see DBOptions::recycle_log_file_num)
+  std::deque<uint64_t> log_recycle_files_;
   uint64_t total_log_size_;
   // only used for dynamically adjusting max_total_wal_size. it is a sum of
   // [write_buffer_size * max_write_buffer_number] over all column families
@@ -539,6 +622,20 @@ class DBImpl : public DB {
   // last time stats were dumped to LOG
   std::atomic<uint64_t> last_stats_dump_time_microsec_;
 
+  // The records of stats_persist_period_sec, and the time of the last one
+  StatsHistory stats_history_;
+  std::atomic<uint64_t> last_stats_persist_time_micros_;
+
+  // The trace started by StartTrace(). tracing_ is set while there is one,
+  // so that requests only take trace_mutex_ when they may be recorded.
+  port::Mutex trace_mutex_;
+  std::unique_ptr<Tracer> tracer_;
+  std::atomic<bool> tracing_;
+
+  // Records the block cache lookups between StartBlockCacheTrace() and
+  // EndBlockCacheTrace()
+  BlockCacheTracer block_cache_tracer_;
+
   bool flush_on_destroy_; // Used when disableWAL is true.
 
   static const int KEEP_LOG_FILE_NUM = 1000;
@@ -566,6 +663,17 @@ class DBImpl : public DB {
   // count how many events are currently being notified.
   int notifying_events_;
 
+#ifndef ROCKSDB_LITE
+  // Write stall changes waiting to be reported, in the order they happened
+  struct WriteStallNotification {
+    WriteStallInfo info;
+    std::vector<std::shared_ptr<EventListener>> listeners;
+  };
+  std::deque<WriteStallNotification> write_stall_notifications_;
+  // A thread is reporting write stall changes
+  bool notifying_write_stalls_;
+#endif  // ROCKSDB_LITE
+
   // No copying allowed
   DBImpl(const DBImpl&);
   void operator=(const DBImpl&);
@@ -617,7 +725,7 @@ class DBImpl : public DB {
   // Function that Get and KeyMayExist call with no_io true or false
   // Note: 'value_found' from KeyMayExist propagates here
   Status GetImpl(const ReadOptions& options, ColumnFamilyHandle* column_family,
-                 const Slice& key, std::string* value,
+                 const Slice& key, PinnableSlice* value,
                  bool* value_found = nullptr);
 
   bool GetIntPropertyInternal(ColumnFamilyHandle* column_family,
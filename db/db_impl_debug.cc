@@ -106,6 +106,11 @@ Status DBImpl::TEST_WaitForFlushMemTable(ColumnFamilyHandle* column_family) {
   return WaitForFlushMemTable(cfd);
 }
 
+Status DBImpl::TEST_PersistStats() {
+  last_stats_persist_time_micros_ = env_->NowMicros();
+  return PersistStats(last_stats_persist_time_micros_);
+}
+
 Status DBImpl::TEST_WaitForCompact() {
   // Wait until the compaction completes
 
@@ -13,6 +13,7 @@
 #include <string>
 #include <limits>
 
+#include "db/db_impl.h"
 #include "db/filename.h"
 #include "db/dbformat.h"
 #include "rocksdb/env.h"
@@ -20,6 +21,7 @@
 #include "rocksdb/iterator.h"
 #include "rocksdb/merge_operator.h"
 #include "port/port.h"
+#include "table/iterator_wrapper.h"
 #include "util/arena.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
@@ -61,7 +63,7 @@ class DBIter: public Iterator {
   DBIter(Env* env, const ImmutableCFOptions& ioptions,
          const Comparator* cmp, Iterator* iter, SequenceNumber s,
          bool arena_mode, uint64_t max_sequential_skip_in_iterations,
-         const Slice* iterate_upper_bound = nullptr)
+         const Slice* iterate_upper_bound = nullptr, bool pin_data = false)
       : arena_mode_(arena_mode),
         env_(env),
         logger_(ioptions.info_log),
@@ -73,7 +75,9 @@ class DBIter: public Iterator {
         valid_(false),
         current_entry_is_merged_(false),
         statistics_(ioptions.statistics),
-        iterate_upper_bound_(iterate_upper_bound) {
+        iterate_upper_bound_(iterate_upper_bound),
+        pin_data_(pin_data),
+        pinned_copied_bytes_(0) {
     RecordTick(statistics_, NO_ITERATORS);
     prefix_extractor_ = ioptions.prefix_extractor;
     max_skip_ = max_sequential_skip_in_iterations;
@@ -93,12 +97,17 @@ class DBIter: public Iterator {
   virtual bool Valid() const { return valid_; }
   virtual Slice key() const {
     assert(valid_);
+    if (pin_data_) {
+      return pinned_key_;
+    }
     return saved_key_.GetKey();
   }
   virtual Slice value() const {
     assert(valid_);
-    return (direction_ == kForward && !current_entry_is_merged_) ?
-      iter_->value() : saved_value_;
+    if (pin_data_) {
+      return pinned_value_;
+    }
+    return CurrentValue();
   }
   virtual Status status() const {
     if (status_.ok()) {
@@ -114,7 +123,25 @@ class DBIter: public Iterator {
   virtual void SeekToFirst();
   virtual void SeekToLast();
 
+  virtual Status GetProperty(const std::string& prop_name,
+                             std::string* prop) override {
+    if (prop == nullptr) {
+      return Status::InvalidArgument("prop is nullptr");
+    }
+    if (prop_name == "rocksdb.iterator.pinned-data-size") {
+      *prop = NumberToString(GetPinnedDataSize(iter_) + pinned_copied_bytes_);
+      return Status::OK();
+    }
+    return Iterator::GetProperty(prop_name, prop);
+  }
+
  private:
+  Slice CurrentValue() const {
+    return (direction_ == kForward && !current_entry_is_merged_) ?
+      iter_->value() : saved_value_;
+  }
+  void PinCurrentEntry();
+  Slice CopyToPinnedArena(const Slice& s);
   void PrevInternal();
   void FindParseableKey(ParsedInternalKey* ikey, Direction direction);
   bool FindValueForCurrentKey();
@@ -153,6 +180,14 @@ class DBIter: public Iterator {
   Statistics* statistics_;
   uint64_t max_skip_;
   const Slice* iterate_upper_bound_;
+  // ReadOptions::pin_data. key() and value() then return pinned_key_ and
+  // pinned_value_, which point either into memory pinned by iter_ or into
+  // pinned_arena_, and stay valid until the iterator is deleted.
+  bool pin_data_;
+  Slice pinned_key_;
+  Slice pinned_value_;
+  std::unique_ptr<Arena> pinned_arena_;
+  uint64_t pinned_copied_bytes_;
 
   // No copying allowed
   DBIter(const DBIter&);
@@ -171,6 +206,38 @@ inline bool DBIter::ParseKey(ParsedInternalKey* ikey) {
   }
 }
 
+Slice DBIter::CopyToPinnedArena(const Slice& s) {
+  if (s.empty()) {
+    return Slice();
+  }
+  if (pinned_arena_ == nullptr) {
+    pinned_arena_.reset(new Arena());
+  }
+  char* buf = pinned_arena_->Allocate(s.size());
+  memcpy(buf, s.data(), s.size());
+  pinned_copied_bytes_ += s.size();
+  return Slice(buf, s.size());
+}
+
+// PRE: valid_ and pin_data_
+// Only when moving forward is iter_ positioned at the entry we yield, and
+// only if that entry was not the result of a merge can we hand out
+// iter_'s own memory; everything else is copied.
+void DBIter::PinCurrentEntry() {
+  assert(valid_ && pin_data_);
+  bool at_entry = direction_ == kForward && !current_entry_is_merged_;
+  if (at_entry && iter_->IsKeyPinned()) {
+    pinned_key_ = ExtractUserKey(iter_->key());
+  } else {
+    pinned_key_ = CopyToPinnedArena(saved_key_.GetKey());
+  }
+  if (at_entry && iter_->IsValuePinned()) {
+    pinned_value_ = iter_->value();
+  } else {
+    pinned_value_ = CopyToPinnedArena(CurrentValue());
+  }
+}
+
 void DBIter::Next() {
   assert(valid_);
 
@@ -188,6 +255,9 @@ void DBIter::Next() {
     return;
   }
   FindNextUserEntry(true /* skipping the current user key */);
+  if (pin_data_ && valid_) {
+    PinCurrentEntry();
+  }
 }
 
 // PRE: saved_key_ has the current user key if skipping
@@ -344,6 +414,9 @@ void DBIter::Prev() {
     direction_ = kReverse;
   }
   PrevInternal();
+  if (pin_data_ && valid_) {
+    PinCurrentEntry();
+  }
 }
 
 void DBIter::PrevInternal() {
@@ -596,6 +669,9 @@ void DBIter::Seek(const Slice& target) {
     direction_ = kForward;
     ClearSavedValue();
     FindNextUserEntry(false /*not skipping */);
+    if (pin_data_ && valid_) {
+      PinCurrentEntry();
+    }
   } else {
     valid_ = false;
   }
@@ -617,6 +693,9 @@ void DBIter::SeekToFirst() {
 
   if (iter_->Valid()) {
     FindNextUserEntry(false /* not skipping */);
+    if (pin_data_ && valid_) {
+      PinCurrentEntry();
+    }
   } else {
     valid_ = false;
   }
@@ -637,6 +716,9 @@ void DBIter::SeekToLast() {
   }
 
   PrevInternal();
+  if (pin_data_ && valid_) {
+    PinCurrentEntry();
+  }
 }
 
 Iterator* NewDBIterator(Env* env, const ImmutableCFOptions& ioptions,
@@ -644,10 +726,11 @@ Iterator* NewDBIterator(Env* env, const ImmutableCFOptions& ioptions,
                         Iterator* internal_iter,
                         const SequenceNumber& sequence,
                         uint64_t max_sequential_skip_in_iterations,
-                        const Slice* iterate_upper_bound) {
+                        const Slice* iterate_upper_bound,
+                        bool pin_data) {
   return new DBIter(env, ioptions, user_key_comparator, internal_iter, sequence,
                     false, max_sequential_skip_in_iterations,
-                    iterate_upper_bound);
+                    iterate_upper_bound, pin_data);
 }
 
 ArenaWrappedDBIter::~ArenaWrappedDBIter() { db_iter_->~DBIter(); }
@@ -659,16 +742,44 @@ void ArenaWrappedDBIter::SetIterUnderDBIter(Iterator* iter) {
 }
 
 inline bool ArenaWrappedDBIter::Valid() const { return db_iter_->Valid(); }
-inline void ArenaWrappedDBIter::SeekToFirst() { db_iter_->SeekToFirst(); }
-inline void ArenaWrappedDBIter::SeekToLast() { db_iter_->SeekToLast(); }
+inline BlockCacheTracer* ArenaWrappedDBIter::block_cache_tracer() const {
+  return db_impl_ != nullptr ? db_impl_->block_cache_tracer() : nullptr;
+}
+inline void ArenaWrappedDBIter::SeekToFirst() {
+  BLOCK_CACHE_LOOKUP_GUARD(block_cache_tracer(),
+                           BlockCacheLookupCaller::kUserIterator);
+  db_iter_->SeekToFirst();
+}
+inline void ArenaWrappedDBIter::SeekToLast() {
+  BLOCK_CACHE_LOOKUP_GUARD(block_cache_tracer(),
+                           BlockCacheLookupCaller::kUserIterator);
+  db_iter_->SeekToLast();
+}
 inline void ArenaWrappedDBIter::Seek(const Slice& target) {
+  if (db_impl_ != nullptr) {
+    db_impl_->TraceIteratorSeek(cf_id_, target);
+  }
+  BLOCK_CACHE_LOOKUP_GUARD(block_cache_tracer(),
+                           BlockCacheLookupCaller::kUserIterator);
   db_iter_->Seek(target);
 }
-inline void ArenaWrappedDBIter::Next() { db_iter_->Next(); }
-inline void ArenaWrappedDBIter::Prev() { db_iter_->Prev(); }
+inline void ArenaWrappedDBIter::Next() {
+  BLOCK_CACHE_LOOKUP_GUARD(block_cache_tracer(),
+                           BlockCacheLookupCaller::kUserIterator);
+  db_iter_->Next();
+}
+inline void ArenaWrappedDBIter::Prev() {
+  BLOCK_CACHE_LOOKUP_GUARD(block_cache_tracer(),
+                           BlockCacheLookupCaller::kUserIterator);
+  db_iter_->Prev();
+}
 inline Slice ArenaWrappedDBIter::key() const { return db_iter_->key(); }
 inline Slice ArenaWrappedDBIter::value() const { return db_iter_->value(); }
 inline Status ArenaWrappedDBIter::status() const { return db_iter_->status(); }
+Status ArenaWrappedDBIter::GetProperty(const std::string& prop_name,
+                                       std::string* prop) {
+  return db_iter_->GetProperty(prop_name, prop);
+}
 void ArenaWrappedDBIter::RegisterCleanup(CleanupFunction function, void* arg1,
                                          void* arg2) {
   db_iter_->RegisterCleanup(function, arg1, arg2);
@@ -679,13 +790,13 @@ ArenaWrappedDBIter* NewArenaWrappedDbIterator(
     const Comparator* user_key_comparator,
     const SequenceNumber& sequence,
     uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound) {
+    const Slice* iterate_upper_bound, bool pin_data) {
   ArenaWrappedDBIter* iter = new ArenaWrappedDBIter();
   Arena* arena = iter->GetArena();
   auto mem = arena->AllocateAligned(sizeof(DBIter));
   DBIter* db_iter = new (mem) DBIter(env, ioptions, user_key_comparator,
       nullptr, sequence, true, max_sequential_skip_in_iterations,
-      iterate_upper_bound);
+      iterate_upper_bound, pin_data);
 
   iter->SetDBIter(db_iter);
 
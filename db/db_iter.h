@@ -17,7 +17,9 @@
 namespace rocksdb {
 
 class Arena;
+class BlockCacheTracer;
 class DBIter;
+class DBImpl;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
@@ -29,7 +31,8 @@ extern Iterator* NewDBIterator(
     Iterator* internal_iter,
     const SequenceNumber& sequence,
     uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound = nullptr);
+    const Slice* iterate_upper_bound = nullptr,
+    bool pin_data = false);
 
 // A wrapper iterator which wraps DB Iterator and the arena, with which the DB
 // iterator is supposed be allocated. This class is used as an entry point of
@@ -38,6 +41,7 @@ extern Iterator* NewDBIterator(
 // to allocate.
 class ArenaWrappedDBIter : public Iterator {
  public:
+  ArenaWrappedDBIter() : db_impl_(nullptr), cf_id_(0) {}
   virtual ~ArenaWrappedDBIter();
 
   // Get the arena to be used to allocate memory for DBIter to be wrapped,
@@ -51,6 +55,14 @@ class ArenaWrappedDBIter : public Iterator {
   // Set the internal iterator wrapped inside the DB Iterator. Usually it is
   // a merging iterator.
   virtual void SetIterUnderDBIter(Iterator* iter);
+
+  // Report the Seek() calls to "db_impl", to be traced, and trace the block
+  // cache lookups of the iterator with the block cache trace of "db_impl"
+  void SetTraceContext(DBImpl* db_impl, uint32_t cf_id) {
+    db_impl_ = db_impl;
+    cf_id_ = cf_id;
+  }
+
   virtual bool Valid() const override;
   virtual void SeekToFirst() override;
   virtual void SeekToLast() override;
@@ -60,11 +72,17 @@ class ArenaWrappedDBIter : public Iterator {
   virtual Slice key() const override;
   virtual Slice value() const override;
   virtual Status status() const override;
+  virtual Status GetProperty(const std::string& prop_name,
+                             std::string* prop) override;
   void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
 
  private:
+  BlockCacheTracer* block_cache_tracer() const;
+
   DBIter* db_iter_;
   Arena arena_;
+  DBImpl* db_impl_;
+  uint32_t cf_id_;
 };
 
 // Generate the arena wrapped iterator class.
@@ -72,6 +90,6 @@ extern ArenaWrappedDBIter* NewArenaWrappedDbIterator(
     Env* env, const ImmutableCFOptions& options,
     const Comparator* user_key_comparator,
     const SequenceNumber& sequence, uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound = nullptr);
+    const Slice* iterate_upper_bound = nullptr, bool pin_data = false);
 
 }  // namespace rocksdb
@@ -8,6 +8,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include <algorithm>
+#include <limits>
 #include <iostream>
 #include <set>
 #include <unistd.h>
@@ -28,6 +29,7 @@
 #include "rocksdb/env.h"
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/perf_context.h"
+#include "rocksdb/request_tracer.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
@@ -53,6 +55,8 @@
 #include "util/mock_env.h"
 #include "util/string_util.h"
 #include "util/thread_status_util.h"
+#include "util/block_cache_trace_analyzer.h"
+#include "util/trace_replay.h"
 
 namespace rocksdb {
 
@@ -151,6 +155,9 @@ class SpecialEnv : public EnvWrapper {
   // Force write to log files to fail while this pointer is non-nullptr
   std::atomic<bool> log_write_error_;
 
+  // Force syncs of log files to fail while this is true
+  std::atomic<bool> log_sync_error_;
+
   // Slow down every log write, in micro-seconds.
   std::atomic<int> log_write_slowdown_;
 
@@ -166,6 +173,8 @@ class SpecialEnv : public EnvWrapper {
 
   std::atomic<int> sync_counter_;
 
+  std::atomic<int> manifest_sync_counter_;
+
   std::atomic<uint32_t> non_writeable_rate_;
 
   std::atomic<uint32_t> new_writable_count_;
@@ -186,9 +195,11 @@ class SpecialEnv : public EnvWrapper {
     manifest_sync_error_.store(false, std::memory_order_release);
     manifest_write_error_.store(false, std::memory_order_release);
     log_write_error_.store(false, std::memory_order_release);
+    log_sync_error_.store(false, std::memory_order_release);
     log_write_slowdown_ = 0;
     bytes_written_ = 0;
     sync_counter_ = 0;
+    manifest_sync_counter_ = 0;
     non_writeable_rate_ = 0;
     new_writable_count_ = 0;
     non_writable_count_ = 0;
@@ -252,6 +263,7 @@ class SpecialEnv : public EnvWrapper {
       Status Flush() { return base_->Flush(); }
       Status Sync() {
         ++env_->sync_counter_;
+        ++env_->manifest_sync_counter_;
         if (env_->manifest_sync_error_.load(std::memory_order_acquire)) {
           return Status::IOError("simulated sync error");
         } else {
@@ -287,6 +299,14 @@ class SpecialEnv : public EnvWrapper {
         ++env_->sync_counter_;
         return base_->Sync();
       }
+      bool IsSyncThreadSafe() const { return base_->IsSyncThreadSafe(); }
+      Status SyncWithoutFlush(bool use_fsync) {
+        ++env_->sync_counter_;
+        if (env_->log_sync_error_.load(std::memory_order_acquire)) {
+          return Status::IOError("simulated sync error");
+        }
+        return base_->SyncWithoutFlush(use_fsync);
+      }
     };
 
     if (non_writeable_rate_.load(std::memory_order_acquire) > 0) {
@@ -1621,6 +1641,56 @@ TEST(DBTest, GetFromVersions) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, GetPinnableSlice) {
+  Options options = CurrentOptions();
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  BlockBasedTableOptions table_options;
+  // Unreferenced blocks are evicted right away from a cache this small, so
+  // the usage tells whether a block is still pinned.
+  std::shared_ptr<Cache> cache = NewLRUCache(1, 0);
+  table_options.block_cache = cache;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  ASSERT_OK(Put(1, "foo", "v1"));
+  ASSERT_OK(Put(1, "bar", "b1"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(Put(1, "baz", "z1"));
+  ASSERT_OK(db_->Merge(WriteOptions(), handles_[1], "bar", "b2"));
+
+  // A value read from an SST file points into the pinned data block
+  PinnableSlice pinned;
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "foo", &pinned));
+  ASSERT_TRUE(pinned.IsPinned());
+  ASSERT_EQ("v1", pinned.ToString());
+  ASSERT_GT(cache->GetUsage(), 0U);
+  pinned.Reset();
+  ASSERT_EQ(0U, cache->GetUsage());
+
+  // The std::string overload copies and releases the block immediately
+  ASSERT_EQ("v1", Get(1, "foo"));
+  ASSERT_EQ(0U, cache->GetUsage());
+
+  // Memtable hits and merge results are kept in the self buffer
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "baz", &pinned));
+  ASSERT_TRUE(!pinned.IsPinned());
+  ASSERT_EQ("z1", pinned.ToString());
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "bar", &pinned));
+  ASSERT_TRUE(!pinned.IsPinned());
+  ASSERT_EQ("b1,b2", pinned.ToString());
+  ASSERT_EQ(0U, cache->GetUsage());
+
+  ASSERT_TRUE(
+      db_->Get(ReadOptions(), handles_[1], "missing", &pinned).IsNotFound());
+  ASSERT_TRUE(pinned.empty());
+
+  // Reusing a slice releases whatever it pinned before
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "foo", &pinned));
+  ASSERT_TRUE(pinned.IsPinned());
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "baz", &pinned));
+  ASSERT_EQ(0U, cache->GetUsage());
+}
+
 TEST(DBTest, GetSnapshot) {
   do {
     CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
@@ -2381,6 +2451,527 @@ TEST(DBTest, IterMultiWithDelete) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, PinDataIterator) {
+  Options options = CurrentOptions();
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  // Every released block is evicted right away
+  table_options.block_cache = NewLRUCache(1, 0);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 200; i++) {
+    std::string k = Key(i);
+    std::string v = RandomString(&rnd, 50);
+    ASSERT_OK(Put(k, v));
+    expected[k] = v;
+  }
+  ASSERT_OK(Flush());
+  // Some newer versions of keys in the memtable
+  for (int i = 0; i < 200; i += 7) {
+    std::string k = Key(i);
+    std::string v = RandomString(&rnd, 20);
+    ASSERT_OK(Put(k, v));
+    expected[k] = v;
+  }
+
+  ReadOptions ro;
+  ro.pin_data = true;
+  Iterator* iter = db_->NewIterator(ro);
+  std::string prop;
+  ASSERT_OK(iter->GetProperty("rocksdb.iterator.pinned-data-size", &prop));
+  ASSERT_EQ("0", prop);
+
+  std::vector<std::pair<Slice, Slice>> results;
+  uint64_t last_pinned_size = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    results.emplace_back(iter->key(), iter->value());
+    ASSERT_OK(iter->GetProperty("rocksdb.iterator.pinned-data-size", &prop));
+    uint64_t pinned_size = std::stoull(prop);
+    ASSERT_GE(pinned_size, last_pinned_size);
+    last_pinned_size = pinned_size;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_GT(last_pinned_size, 0U);
+
+  // All the slices are still valid although the blocks they came from are
+  // no longer being read.
+  ASSERT_EQ(expected.size(), results.size());
+  auto it = expected.begin();
+  for (auto& kv : results) {
+    ASSERT_EQ(it->first, kv.first.ToString());
+    ASSERT_EQ(it->second, kv.second.ToString());
+    ++it;
+  }
+
+  // Backward iteration copies keys and values when needed
+  results.clear();
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    results.emplace_back(iter->key(), iter->value());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(expected.size(), results.size());
+  auto rit = expected.rbegin();
+  for (auto& kv : results) {
+    ASSERT_EQ(rit->first, kv.first.ToString());
+    ASSERT_EQ(rit->second, kv.second.ToString());
+    ++rit;
+  }
+  delete iter;
+
+  // Without pin_data nothing accumulates
+  iter = db_->NewIterator(ReadOptions());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+  }
+  ASSERT_OK(iter->GetProperty("rocksdb.iterator.pinned-data-size", &prop));
+  ASSERT_EQ("0", prop);
+  ASSERT_TRUE(
+      iter->GetProperty("rocksdb.iterator.no-such-property", &prop)
+          .IsInvalidArgument());
+  delete iter;
+
+  // Tailing iterators do not pin
+  ro.tailing = true;
+  iter = db_->NewIterator(ro);
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_TRUE(iter->status().IsNotSupported());
+  delete iter;
+  std::vector<Iterator*> iters;
+  ASSERT_TRUE(db_->NewIterators(ro, handles_, &iters).IsNotSupported());
+}
+
+TEST(DBTest, AutoReadaheadOnSequentialScan) {
+  Options options = CurrentOptions();
+  env_->count_random_reads_ = true;
+  options.env = env_;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.no_block_cache = true;
+  table_options.block_size = 1024;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  const int kNumKeys = 2000;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 100)));
+  }
+  ASSERT_OK(Flush());
+
+  auto count_scan_reads = [&]() {
+    env_->random_read_counter_.Reset();
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(kNumKeys, count);
+    delete iter;
+    return env_->random_read_counter_.Read();
+  };
+
+  // About 200 data blocks; with readahead they take a handful of reads
+  int reads_with_readahead = count_scan_reads();
+  ASSERT_LT(reads_with_readahead, 40);
+
+  table_options.max_auto_readahead_size = 0;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  int reads_without_readahead = count_scan_reads();
+  ASSERT_GT(reads_without_readahead, 150);
+
+  // Point lookups read only the block they need
+  table_options.max_auto_readahead_size = 256 * 1024;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  env_->random_read_counter_.Reset();
+  for (int i = 0; i < kNumKeys; i += 100) {
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    iter->Seek(Key(i));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(Key(i), iter->key().ToString());
+    delete iter;
+  }
+  // (plus the reads that open the table file)
+  ASSERT_LE(env_->random_read_counter_.Read(), kNumKeys / 100 + 10);
+  env_->count_random_reads_ = false;
+}
+
+TEST(DBTest, DataBlockHashIndexGet) {
+  Options options = CurrentOptions();
+  BlockBasedTableOptions table_options;
+  table_options.data_block_hash_index = true;
+  table_options.block_restart_interval = 4;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  // Needs the newer table format
+  ASSERT_TRUE(TryReopen(options).IsInvalidArgument());
+
+  table_options.format_version = 3;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  const int kNumKeys = 1000;
+  std::vector<std::string> values(kNumKeys);
+  for (int i = 0; i < kNumKeys; i++) {
+    values[i] = RandomString(&rnd, 50);
+    ASSERT_OK(Put(Key(i * 2), values[i]));
+  }
+  ASSERT_OK(Flush());
+  // Newer versions of some keys, deletions of others, in a second file
+  for (int i = 0; i < kNumKeys; i += 3) {
+    values[i] = RandomString(&rnd, 50);
+    ASSERT_OK(Put(Key(i * 2), values[i]));
+  }
+  for (int i = 1; i < kNumKeys; i += 7) {
+    ASSERT_OK(Delete(Key(i * 2)));
+    values[i] = "NOT_FOUND";
+  }
+  ASSERT_OK(Flush());
+
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(values[i], Get(Key(i * 2)));
+    ASSERT_EQ("NOT_FOUND", Get(Key(i * 2 + 1)));
+  }
+
+  // Older tables stay readable once the option is turned off
+  table_options.data_block_hash_index = false;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(values[i], Get(Key(i * 2)));
+  }
+}
+
+TEST(DBTest, ParallelTableLoadOnOpen) {
+  Options options = CurrentOptions();
+  options.max_open_files = -1;
+  options.max_file_opening_threads = 4;
+  options.disable_auto_compactions = true;
+  DestroyAndReopen(options);
+
+  const int kNumFiles = 20;
+  for (int i = 0; i < kNumFiles; i++) {
+    ASSERT_OK(Put(Key(i), "v" + NumberToString(i)));
+    ASSERT_OK(Flush());
+  }
+  ASSERT_EQ(NumberToString(kNumFiles), FilesPerLevel(0));
+
+  Reopen(options);
+  // All the table readers are open before the first read
+  uint64_t table_readers_mem = 0;
+  ASSERT_TRUE(db_->GetIntProperty("rocksdb.estimate-table-readers-mem",
+                                  &table_readers_mem));
+  ASSERT_GT(table_readers_mem, 0U);
+  for (int i = 0; i < kNumFiles; i++) {
+    ASSERT_EQ("v" + NumberToString(i), Get(Key(i)));
+  }
+
+  std::string open_stats;
+  ASSERT_TRUE(db_->GetProperty("rocksdb.db-open-stats", &open_stats));
+  ASSERT_NE(std::string::npos, open_stats.find("Manifest replay(ms)"));
+  ASSERT_NE(std::string::npos, open_stats.find("Table load(ms)"));
+  ASSERT_NE(std::string::npos, open_stats.find("WAL replay(ms)"));
+  // One thread per kFilesPerOpeningThread files, not max_file_opening_threads
+  ASSERT_NE(std::string::npos, open_stats.find("Table load threads: 2\n"));
+}
+
+TEST(DBTest, FileStatsFromManifest) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.disable_auto_compactions = true;
+  options.write_file_stats_to_manifest = true;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 10; i++) {
+    for (int j = 0; j < 10; j++) {
+      ASSERT_OK(Put(Key(i * 10 + j), "value"));
+    }
+    ASSERT_OK(Delete(Key(i * 10)));
+    ASSERT_OK(Flush());
+  }
+
+  // Recovery schedules compactions from the stats in the MANIFEST without
+  // opening any of the table files
+  env_->count_random_reads_ = true;
+  env_->random_read_counter_.Reset();
+  Reopen(options);
+  ASSERT_EQ(0, env_->random_read_counter_.Read());
+  env_->count_random_reads_ = false;
+
+  // Also after the MANIFEST is rewritten with a snapshot of all the files
+  Reopen(options);
+  env_->count_random_reads_ = true;
+  env_->random_read_counter_.Reset();
+  Reopen(options);
+  ASSERT_EQ(0, env_->random_read_counter_.Read());
+  env_->count_random_reads_ = false;
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i % 10 == 0 ? "NOT_FOUND" : "value", Get(Key(i)));
+  }
+}
+
+TEST(DBTest, PipelinedWalRecovery) {
+  Options options = CurrentOptions();
+  options.pipelined_wal_recovery = true;
+  options.write_buffer_size = 10 << 20;  // 10MB
+  options.disable_auto_compactions = true;
+  options = CurrentOptions(options);
+  CreateAndReopenWithCF({"pikachu", "eevee"}, options);
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 1000; i++) {
+    values.push_back(RandomString(&rnd, 1000));
+    ASSERT_OK(Put(i % 3, Key(i), values[i]));
+  }
+  for (int i = 0; i < 1000; i += 10) {
+    ASSERT_OK(Delete(i % 3, Key(i)));
+  }
+
+  // Nothing was flushed so far; recovery fills and flushes several
+  // memtables of each column family
+  for (int cf = 0; cf < 3; cf++) {
+    ASSERT_EQ(0, NumTableFilesAtLevel(0, cf));
+  }
+  options.write_buffer_size = 100 << 10;  // 100KB
+  ReopenWithColumnFamilies({"default", "pikachu", "eevee"}, options);
+  for (int cf = 0; cf < 3; cf++) {
+    ASSERT_GT(NumTableFilesAtLevel(0, cf), 1);
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i % 10 == 0 ? "NOT_FOUND" : values[i], Get(i % 3, Key(i)));
+  }
+
+  // And once more, now that the data is in table files
+  ReopenWithColumnFamilies({"default", "pikachu", "eevee"}, options);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i % 10 == 0 ? "NOT_FOUND" : values[i], Get(i % 3, Key(i)));
+  }
+}
+
+TEST(DBTest, RecycleLogFile) {
+  Options options = CurrentOptions();
+  options.recycle_log_file_num = 2;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 5; i++) {
+    ASSERT_OK(Put(Key(i), "v" + NumberToString(i)));
+    ASSERT_OK(Flush());
+  }
+  // Obsolete logs are kept for reuse instead of being deleted, and the
+  // current log was renamed from one of them: it is not empty even though
+  // nothing was written to it yet
+  std::vector<std::string> files;
+  ASSERT_OK(env_->GetChildren(dbname_, &files));
+  uint64_t number;
+  FileType type;
+  uint64_t current_log_number = 0;
+  int num_logs = 0;
+  for (const auto& f : files) {
+    if (ParseFileName(f, &number, &type) && type == kLogFile) {
+      num_logs++;
+      current_log_number = std::max(current_log_number, number);
+    }
+  }
+  ASSERT_GT(num_logs, 1);
+  ASSERT_LE(num_logs, 3);
+  uint64_t current_log_size;
+  ASSERT_OK(env_->GetFileSize(LogFileName(dbname_, current_log_number),
+                              &current_log_size));
+  ASSERT_GT(current_log_size, 0U);
+
+  // Recovery only replays what was written to the log after it was reused
+  ASSERT_OK(Put("foo", "bar"));
+  Reopen(options);
+  ASSERT_EQ("bar", Get("foo"));
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ("v" + NumberToString(i), Get(Key(i)));
+  }
+  ASSERT_OK(Put("foo", "baz"));
+  Reopen(options);
+  ASSERT_EQ("baz", Get("foo"));
+}
+
+TEST(DBTest, WalBytesPerSync) {
+  const uint64_t kPageSize = getpagesize();
+  Options options = CurrentOptions();
+  options.wal_bytes_per_sync = 16 << 10;
+  options.bytes_per_sync = 0;
+  DestroyAndReopen(options);
+
+  // Only the WAL is written to: the ranges are those of the WAL
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "PosixWritableFile::Flush:RangeSync", [&](void* arg) {
+        ranges.push_back(*reinterpret_cast<std::pair<uint64_t, uint64_t>*>(
+            arg));
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  Random rnd(301);
+  for (int i = 0; i < 200; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 1000 + i)));
+  }
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+
+  // Whole pages are written back, one after the other, every
+  // wal_bytes_per_sync bytes
+  ASSERT_GT(ranges.size(), 5U);
+  uint64_t end = 0;
+  for (const auto& range : ranges) {
+    ASSERT_EQ(end, range.first);
+    ASSERT_EQ(0U, range.first % kPageSize);
+    ASSERT_EQ(0U, range.second % kPageSize);
+    ASSERT_GT(range.second + kPageSize, options.wal_bytes_per_sync);
+    end = range.first + range.second;
+  }
+  VectorLogPtr wal_files;
+  ASSERT_OK(db_->GetSortedWalFiles(wal_files));
+  ASSERT_EQ(1U, wal_files.size());
+  ASSERT_LE(end, wal_files[0]->SizeFileBytes());
+
+  // bytes_per_sync does not apply to the WAL
+  options.wal_bytes_per_sync = 0;
+  options.bytes_per_sync = 16 << 10;
+  DestroyAndReopen(options);
+  ranges.clear();
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  for (int i = 0; i < 200; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 1000 + i)));
+  }
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_EQ(0U, ranges.size());
+}
+
+TEST(DBTest, WalSyncDoesNotBlockWriters) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  DestroyAndReopen(options);
+
+  // Hold the WAL sync of a sync write until a write that arrives after it
+  // went through
+  rocksdb::SyncPoint::GetInstance()->LoadDependency({
+      {"SyncCoordinator::Sync:1", "DBTest::WalSyncDoesNotBlockWriters:1"},
+      {"DBTest::WalSyncDoesNotBlockWriters:2", "SyncCoordinator::Sync:2"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  env_->sync_counter_ = 0;
+  std::thread sync_writer([&]() {
+    WriteOptions write_options;
+    write_options.sync = true;
+    ASSERT_OK(db_->Put(write_options, "foo", "v1"));
+  });
+  TEST_SYNC_POINT("DBTest::WalSyncDoesNotBlockWriters:1");
+  ASSERT_OK(Put("bar", "v2"));
+  ASSERT_EQ("v2", Get("bar"));
+  TEST_SYNC_POINT("DBTest::WalSyncDoesNotBlockWriters:2");
+  sync_writer.join();
+  ASSERT_EQ(1, env_->sync_counter_.load());
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearTrace();
+
+  // Many concurrent sync writers
+  const int kNumThreads = 8;
+  const int kNumWrites = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      WriteOptions write_options;
+      write_options.sync = true;
+      for (int i = 0; i < kNumWrites; i++) {
+        ASSERT_OK(db_->Put(write_options, Key(t * kNumWrites + i), "v"));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  Reopen(options);
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+  for (int i = 0; i < kNumThreads * kNumWrites; i++) {
+    ASSERT_EQ("v", Get(Key(i)));
+  }
+}
+
+TEST(DBTest, WalSyncFailureStopsWrites) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  // A failed sync stops writes even without paranoid checks, as its batch
+  // is already in the memtable
+  options.paranoid_checks = false;
+  DestroyAndReopen(options);
+
+  WriteOptions write_options;
+  write_options.sync = true;
+  ASSERT_OK(db_->Put(write_options, "foo", "v1"));
+  env_->log_sync_error_.store(true, std::memory_order_release);
+  ASSERT_TRUE(db_->Put(write_options, "bar", "v2").IsIOError());
+  env_->log_sync_error_.store(false, std::memory_order_release);
+  // The failed write is visible, but nothing can be written after it
+  ASSERT_EQ("v2", Get("bar"));
+  ASSERT_TRUE(!db_->Put(write_options, "baz", "v3").ok());
+  ASSERT_TRUE(!Put("baz", "v3").ok());
+
+  Reopen(options);
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_OK(db_->Put(write_options, "baz", "v3"));
+  ASSERT_EQ("v3", Get("baz"));
+}
+
+TEST(DBTest, ManifestWriteBatchesColumnFamilies) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.disable_auto_compactions = true;
+  options.max_background_flushes = 3;
+  env_->SetBackgroundThreads(3, Env::HIGH);
+  CreateAndReopenWithCF({"one", "two", "three"}, options);
+
+  ASSERT_OK(Put(1, "foo", "v1"));
+  ASSERT_OK(Put(2, "bar", "v2"));
+  ASSERT_OK(Put(3, "baz", "v3"));
+
+  // Hold the MANIFEST write of the first flush until the two other flushes
+  // are queued behind it. They then go out in one batch, with one sync.
+  rocksdb::SyncPoint::GetInstance()->LoadDependency({
+      {"VersionSet::LogAndApply:Queued",
+       "DBTest::ManifestWriteBatchesColumnFamilies:1"},
+      {"DBTest::ManifestWriteBatchesColumnFamilies:2",
+       "VersionSet::LogAndApply:WriteManifest"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  env_->manifest_sync_counter_ = 0;
+  FlushOptions flush_options;
+  flush_options.wait = false;
+  ASSERT_OK(db_->Flush(flush_options, handles_[1]));
+  ASSERT_OK(db_->Flush(flush_options, handles_[2]));
+  TEST_SYNC_POINT("DBTest::ManifestWriteBatchesColumnFamilies:1");
+  rocksdb::SyncPoint::GetInstance()->ClearTrace();
+  ASSERT_OK(db_->Flush(flush_options, handles_[3]));
+  TEST_SYNC_POINT("DBTest::ManifestWriteBatchesColumnFamilies:1");
+  TEST_SYNC_POINT("DBTest::ManifestWriteBatchesColumnFamilies:2");
+  for (int cf = 1; cf <= 3; cf++) {
+    ASSERT_OK(dbfull()->TEST_WaitForFlushMemTable(handles_[cf]));
+  }
+  ASSERT_EQ(2, env_->manifest_sync_counter_.load());
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearTrace();
+
+  ReopenWithColumnFamilies({"default", "one", "two", "three"}, options);
+  for (int cf = 1; cf <= 3; cf++) {
+    ASSERT_EQ(1, NumTableFilesAtLevel(0, cf));
+  }
+  ASSERT_EQ("v1", Get(1, "foo"));
+  ASSERT_EQ("v2", Get(2, "bar"));
+  ASSERT_EQ("v3", Get(3, "baz"));
+}
+
 TEST(DBTest, IterPrevMaxSkip) {
   do {
     CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
@@ -6606,6 +7197,557 @@ TEST(DBTest, BloomFilter) {
   } while (ChangeCompactOptions());
 }
 
+TEST(DBTest, ReadAmpStatsByLevel) {
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  options.disable_auto_compactions = true;
+  BlockBasedTableOptions table_options;
+  table_options.no_block_cache = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Even keys in L1, odd keys in L0
+  for (int i = 0; i < 200; i += 2) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  ASSERT_OK(Flush());
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  for (int i = 1; i < 200; i += 2) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1,1", FilesPerLevel());
+
+  SetPerfLevel(kEnableCount);
+  perf_context.Reset();
+  for (int i = 1; i < 200; i++) {
+    ASSERT_EQ(Key(i), Get(Key(i)));
+  }
+
+  // Every Get() looks into L0; the even keys are then found in L1
+  const PerfContextByLevel& l0 = perf_context.level_perf_context[0];
+  const PerfContextByLevel& l1 = perf_context.level_perf_context[1];
+  ASSERT_EQ(199U, l0.get_files_probed);
+  ASSERT_EQ(100U, l0.get_hit_count);
+  ASSERT_EQ(199U, l0.bloom_filter_useful + l0.bloom_filter_positive);
+  ASSERT_EQ(100U, l0.bloom_filter_true_positive);
+  ASSERT_EQ(99U, l1.get_files_probed);
+  ASSERT_EQ(99U, l1.get_hit_count);
+  ASSERT_EQ(0U, l1.bloom_filter_useful);
+  ASSERT_EQ(99U, l1.bloom_filter_positive);
+  ASSERT_EQ(99U, l1.bloom_filter_true_positive);
+  ASSERT_GE(l1.block_read_count, 99U);
+  ASSERT_EQ(0U, perf_context.level_perf_context[2].get_files_probed);
+
+  ASSERT_EQ(100, TestGetTickerCount(options, GET_HIT_L0));
+  ASSERT_EQ(99, TestGetTickerCount(options, GET_HIT_L1));
+  ASSERT_EQ(0, TestGetTickerCount(options, GET_HIT_L2_AND_UP));
+  ASSERT_EQ(199, TestGetTickerCount(options, BLOOM_FILTER_TRUE_POSITIVE));
+
+  std::string prop;
+  ASSERT_TRUE(db_->GetProperty("rocksdb.read-amp-stats", &prop));
+  ASSERT_NE(std::string::npos, prop.find("\n  0         199       100"));
+  ASSERT_NE(std::string::npos, prop.find("\n  1          99        99"));
+
+  // Nothing is counted with perf stats disabled
+  SetPerfLevel(kDisable);
+  perf_context.Reset();
+  ASSERT_EQ(Key(2), Get(Key(2)));
+  ASSERT_EQ(0U, perf_context.level_perf_context[0].get_files_probed);
+  ASSERT_EQ(99, TestGetTickerCount(options, GET_HIT_L1));
+  SetPerfLevel(kEnableCount);
+
+  // Every thread counts on its own, and the counts of the threads that
+  // exited are kept
+  std::thread reader([&]() {
+    for (int i = 1; i < 200; i++) {
+      ASSERT_EQ(Key(i), Get(Key(i)));
+    }
+  });
+  reader.join();
+  ASSERT_TRUE(db_->GetProperty("rocksdb.read-amp-stats", &prop));
+  ASSERT_NE(std::string::npos, prop.find("\n  0         398       200"));
+  ASSERT_NE(std::string::npos, prop.find("\n  1         198       198"));
+}
+
+class CollectingRequestTracer : public RequestTracer {
+ public:
+  explicit CollectingRequestTracer(uint32_t sample_rate)
+      : RequestTracer(sample_rate) {}
+
+  virtual void OnRequestTraced(const RequestTrace& trace) override {
+    traces_.push_back(trace);
+  }
+
+  std::vector<RequestTrace> traces_;
+};
+
+TEST(DBTest, RequestTracer) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  BlockBasedTableOptions table_options;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  auto tracer = std::make_shared<CollectingRequestTracer>(0);
+  options.request_tracer = tracer;
+  DestroyAndReopen(options);
+
+  // Only the requests that ask for it are traced
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ(0U, tracer->traces_.size());
+
+  WriteOptions write_options;
+  write_options.trace = true;
+  ASSERT_OK(db_->Put(write_options, "bar", "v2"));
+  ASSERT_EQ(1U, tracer->traces_.size());
+  const RequestTrace& write_trace = tracer->traces_[0];
+  ASSERT_EQ(RequestTrace::kWrite, write_trace.operation);
+  ASSERT_OK(write_trace.status);
+  std::vector<TraceSpanType> types;
+  for (const auto& span : write_trace.spans) {
+    types.push_back(span.type);
+    ASSERT_LE(span.start_nanos + span.duration_nanos,
+              write_trace.duration_nanos);
+  }
+  ASSERT_TRUE(types == std::vector<TraceSpanType>(
+                           {TraceSpanType::kWriteQueueWait,
+                            TraceSpanType::kWALAppend,
+                            TraceSpanType::kMemTableInsert}));
+
+  // "foo" is only in the table file
+  ReadOptions read_options;
+  read_options.trace = true;
+  std::string value;
+  ASSERT_OK(db_->Get(read_options, "foo", &value));
+  ASSERT_EQ(2U, tracer->traces_.size());
+  const RequestTrace& get_trace = tracer->traces_[1];
+  ASSERT_EQ(RequestTrace::kGet, get_trace.operation);
+  ASSERT_EQ("default", get_trace.cf_name);
+  ASSERT_OK(get_trace.status);
+  ASSERT_GE(get_trace.spans.size(), 3U);
+  ASSERT_TRUE(get_trace.spans[0].type == TraceSpanType::kMemTableGet);
+  ASSERT_EQ(0U, get_trace.spans[0].value);
+  ASSERT_EQ(-1, get_trace.spans[0].level);
+  const TraceSpan& table_get = get_trace.spans[1];
+  ASSERT_TRUE(table_get.type == TraceSpanType::kTableGet);
+  ASSERT_EQ(0, table_get.level);
+  ASSERT_NE(0U, table_get.file_number);
+  bool filter_checked = false;
+  for (size_t i = 2; i < get_trace.spans.size(); ++i) {
+    // Every later step is taken within the table file lookup
+    const TraceSpan& span = get_trace.spans[i];
+    ASSERT_EQ(0, span.level);
+    ASSERT_EQ(table_get.file_number, span.file_number);
+    ASSERT_GE(span.start_nanos, table_get.start_nanos);
+    ASSERT_LE(span.start_nanos + span.duration_nanos,
+              table_get.start_nanos + table_get.duration_nanos);
+    if (span.type == TraceSpanType::kFilterCheck) {
+      ASSERT_EQ(1U, span.value);
+      filter_checked = true;
+    }
+  }
+  ASSERT_TRUE(filter_checked);
+
+  // "bar" is found in the memtable
+  ASSERT_OK(db_->Get(read_options, "bar", &value));
+  ASSERT_EQ(3U, tracer->traces_.size());
+  ASSERT_EQ(1U, tracer->traces_[2].spans.size());
+  ASSERT_EQ(1U, tracer->traces_[2].spans[0].value);
+
+  ASSERT_TRUE(db_->Get(read_options, "missing", &value).IsNotFound());
+  ASSERT_EQ(4U, tracer->traces_.size());
+  ASSERT_TRUE(tracer->traces_[3].status.IsNotFound());
+
+  // One request out of sample_rate is traced, on average
+  tracer = std::make_shared<CollectingRequestTracer>(10);
+  options.request_tracer = tracer;
+  Reopen(options);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ("v1", Get("foo"));
+  }
+  ASSERT_GT(tracer->traces_.size(), 50U);
+  ASSERT_LT(tracer->traces_.size(), 200U);
+
+  // Every tracer samples on its own, even when the requests to another DB
+  // are interleaved on the same thread
+  auto other_tracer = std::make_shared<CollectingRequestTracer>(1000);
+  Options other_options = CurrentOptions();
+  other_options.create_if_missing = true;
+  other_options.request_tracer = other_tracer;
+  const std::string other_dbname = dbname_ + "_other";
+  ASSERT_OK(DestroyDB(other_dbname, other_options));
+  DB* other_db = nullptr;
+  ASSERT_OK(DB::Open(other_options, other_dbname, &other_db));
+  ASSERT_OK(other_db->Put(WriteOptions(), "foo", "v2"));
+  tracer->traces_.clear();
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ("v1", Get("foo"));
+    ASSERT_OK(other_db->Get(ReadOptions(), "foo", &value));
+  }
+  ASSERT_GT(tracer->traces_.size(), 50U);
+  ASSERT_LT(tracer->traces_.size(), 200U);
+  ASSERT_LT(other_tracer->traces_.size(), 10U);
+  delete other_db;
+  ASSERT_OK(DestroyDB(other_dbname, other_options));
+
+  tracer = std::make_shared<CollectingRequestTracer>(1);
+  options.request_tracer = tracer;
+  Reopen(options);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ("v1", Get("foo"));
+  }
+  ASSERT_EQ(10U, tracer->traces_.size());
+}
+
+TEST(DBTest, TraceAndReplay) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  CreateAndReopenWithCF({"pikachu"}, options);
+  const std::string trace_filename = dbname_ + "_trace";
+  env_->DeleteFile(trace_filename);
+
+  // Nothing to end before a trace was started
+  ASSERT_TRUE(db_->EndTrace().IsInvalidArgument());
+
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_filename,
+                               &trace_writer));
+  ASSERT_OK(db_->StartTrace(TraceOptions(), std::move(trace_writer)));
+  // Only one trace runs at a time
+  std::unique_ptr<TraceWriter> second_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_filename + "2",
+                               &second_writer));
+  ASSERT_TRUE(db_->StartTrace(TraceOptions(), std::move(second_writer))
+                  .IsInvalidArgument());
+
+  ASSERT_OK(Put(0, "a", "1"));
+  WriteBatch batch;
+  batch.Put(handles_[1], "b", "2");
+  batch.Put(handles_[0], "c", "3");
+  batch.Delete(handles_[0], "a");
+  ASSERT_OK(db_->Write(WriteOptions(), &batch));
+  ASSERT_EQ("2", Get(1, "b"));
+  std::vector<std::string> values;
+  std::vector<Status> statuses = db_->MultiGet(
+      ReadOptions(), {handles_[0], handles_[1]}, {"c", "b"}, &values);
+  ASSERT_OK(statuses[0]);
+  ASSERT_OK(statuses[1]);
+  {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions(),
+                                                    handles_[1]));
+    iter->Seek("b");
+    ASSERT_TRUE(iter->Valid());
+  }
+  ASSERT_OK(db_->EndTrace());
+  ASSERT_TRUE(db_->EndTrace().IsInvalidArgument());
+
+  // The records come back in the order the requests were issued
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  std::vector<TraceType> types;
+  std::string record;
+  Status s = trace_reader->Read(&record);
+  for (; s.ok(); s = trace_reader->Read(&record)) {
+    Trace trace;
+    ASSERT_OK(trace.DecodeFrom(record));
+    types.push_back(trace.type);
+  }
+  ASSERT_TRUE(s.IsIncomplete());
+  std::vector<TraceType> expected = {kTraceBegin, kTraceWrite, kTraceWrite,
+                                     kTraceGet, kTraceMultiGet,
+                                     kTraceIteratorSeek, kTraceEnd};
+  ASSERT_TRUE(types == expected);
+
+  // Replaying the trace into an empty DB rebuilds its contents
+  DestroyAndReopen(options);
+  CreateAndReopenWithCF({"pikachu"}, options);
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  Replayer replayer(db_, handles_, std::move(trace_reader));
+  ASSERT_OK(replayer.Replay(2, 0));
+  ASSERT_EQ(5U, replayer.num_replayed());
+  ASSERT_EQ("NOT_FOUND", Get(0, "a"));
+  ASSERT_EQ("2", Get(1, "b"));
+  ASSERT_EQ("3", Get(0, "c"));
+
+  // Without the values, the replay writes values of the same sizes, and
+  // only one request out of sampling_frequency is recorded
+  TraceOptions trace_options;
+  trace_options.record_values = false;
+  trace_options.sampling_frequency = 2;
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_filename,
+                               &trace_writer));
+  ASSERT_OK(db_->StartTrace(trace_options, std::move(trace_writer)));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(Put(0, Key(i), std::string(i + 1, 'v')));
+  }
+  ASSERT_OK(db_->EndTrace());
+
+  DestroyAndReopen(options);
+  CreateAndReopenWithCF({"pikachu"}, options);
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  Replayer sized_replayer(db_, handles_, std::move(trace_reader));
+  ASSERT_OK(sized_replayer.Replay(1, 0));
+  ASSERT_EQ(2U, sized_replayer.num_replayed());
+  int found = 0;
+  for (int i = 0; i < 4; ++i) {
+    std::string value = Get(0, Key(i));
+    if (value != "NOT_FOUND") {
+      ASSERT_EQ(std::string(i + 1, 'x'), value);
+      ++found;
+    }
+  }
+  ASSERT_EQ(2, found);
+
+  // Corrupted traces are reported, not replayed
+  Trace begin;
+  begin.ts = 0;
+  begin.type = kTraceBegin;
+  begin.payload = kTraceMagic;
+  PutVarint32(&begin.payload, kTraceFormatVersion);
+  std::string begin_record;
+  begin.EncodeTo(&begin_record);
+  // A write record too short to hold a WriteBatch header
+  Trace short_write;
+  short_write.ts = 0;
+  short_write.type = kTraceWrite;
+  short_write.payload = std::string("\x01") + "short";
+  std::string short_write_record;
+  short_write.EncodeTo(&short_write_record);
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_filename,
+                               &trace_writer));
+  ASSERT_OK(trace_writer->Write(begin_record));
+  ASSERT_OK(trace_writer->Write(short_write_record));
+  ASSERT_OK(trace_writer->Close());
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  Replayer short_replayer(db_, handles_, std::move(trace_reader));
+  ASSERT_TRUE(short_replayer.Replay(1, 0).IsCorruption());
+
+  // A record size past the end of the file
+  std::string contents;
+  PutFixed32(&contents, static_cast<uint32_t>(begin_record.size()));
+  contents.append(begin_record);
+  PutFixed32(&contents, 1U << 30);
+  contents.append("abc");
+  ASSERT_OK(WriteStringToFile(env_, contents, trace_filename));
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  Replayer oversized_replayer(db_, handles_, std::move(trace_reader));
+  ASSERT_TRUE(oversized_replayer.Replay(1, 0).IsCorruption());
+
+  env_->DeleteFile(trace_filename);
+  env_->DeleteFile(trace_filename + "2");
+}
+
+TEST(DBTest, BlockCacheTrace) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_OK(Put("bar", "v2"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put("baz", "v3"));
+  ASSERT_OK(Flush());
+
+  const std::string trace_filename = dbname_ + "_block_cache_trace";
+  ASSERT_TRUE(db_->EndBlockCacheTrace().IsInvalidArgument());
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_filename,
+                               &trace_writer));
+  ASSERT_OK(db_->StartBlockCacheTrace(TraceOptions(),
+                                      std::move(trace_writer)));
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v1", Get("foo"));
+  {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ++count;
+    }
+    ASSERT_EQ(3, count);
+  }
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_OK(db_->EndBlockCacheTrace());
+
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_OK(NewFileTraceReader(env_, EnvOptions(), trace_filename,
+                               &trace_reader));
+  BlockCacheTraceReader reader(std::move(trace_reader));
+  uint64_t sampling_frequency;
+  ASSERT_OK(reader.ReadHeader(&sampling_frequency));
+  ASSERT_EQ(1U, sampling_frequency);
+  std::vector<BlockCacheTraceRecord> accesses;
+  BlockCacheTraceRecord access;
+  Status s = reader.ReadAccess(&access);
+  for (; s.ok(); s = reader.ReadAccess(&access)) {
+    accesses.push_back(access);
+  }
+  ASSERT_TRUE(s.IsIncomplete());
+
+  std::vector<BlockCacheTraceRecord> get_data_accesses;
+  int num_iterator_accesses = 0;
+  int num_compaction_accesses = 0;
+  for (const auto& a : accesses) {
+    ASSERT_GT(a.block_size, 0U);
+    switch (a.caller) {
+      case BlockCacheLookupCaller::kUserGet:
+        // Get() knows the table file of every lookup
+        ASSERT_EQ(0, a.level);
+        ASSERT_GT(a.file_number, 0U);
+        if (a.block_type == kBlockTraceDataBlock) {
+          get_data_accesses.push_back(a);
+        }
+        break;
+      case BlockCacheLookupCaller::kUserIterator:
+        ++num_iterator_accesses;
+        break;
+      case BlockCacheLookupCaller::kCompaction:
+        ++num_compaction_accesses;
+        // Compactions do not fill the block cache
+        if (a.block_type == kBlockTraceDataBlock && !a.is_cache_hit) {
+          ASSERT_TRUE(a.no_insert);
+        }
+        break;
+      default:
+        ASSERT_TRUE(false);
+    }
+  }
+  // The newer file does not have "foo", and its filter skips it
+  ASSERT_EQ(2U, get_data_accesses.size());
+  ASSERT_EQ(get_data_accesses[0].block_key, get_data_accesses[1].block_key);
+  ASSERT_TRUE(get_data_accesses[1].is_cache_hit);
+  ASSERT_GT(num_iterator_accesses, 0);
+  ASSERT_GT(num_compaction_accesses, 0);
+
+  // The analyzer reads the whole trace back
+  BlockCacheTraceAnalyzer analyzer(env_, trace_filename);
+  analyzer.AddSimulation("lru", 8 << 20, -1);
+  ASSERT_OK(analyzer.Analyze());
+  ASSERT_EQ(accesses.size(), analyzer.num_accesses());
+  env_->DeleteFile(trace_filename);
+}
+
+TEST(DBTest, StatsHistory) {
+  const uint64_t kMaxTime = std::numeric_limits<uint64_t>::max();
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  options.stats_persist_period_sec = 3600;
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  std::vector<std::string> records;
+  ASSERT_OK(db_->GetStatsHistory(0, kMaxTime, &records));
+  ASSERT_EQ(0U, records.size());
+
+  ASSERT_OK(Put(1, "foo", "v1"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(dbfull()->TEST_PersistStats());
+  ASSERT_OK(Put(1, "bar", "v2"));
+  ASSERT_EQ("v2", Get(1, "bar"));
+  env_->SleepForMicroseconds(1000);
+  ASSERT_OK(dbfull()->TEST_PersistStats());
+
+  ASSERT_OK(db_->GetStatsHistory(0, kMaxTime, &records));
+  ASSERT_EQ(2U, records.size());
+  for (const auto& record : records) {
+    ASSERT_EQ('{', record.front());
+    ASSERT_EQ('}', record.back());
+    ASSERT_NE(std::string::npos, record.find("\"keys_written\":"));
+    ASSERT_NE(std::string::npos, record.find("\"name\":\"pikachu\""));
+    ASSERT_NE(std::string::npos, record.find("\"levels\":[{\"level\":0,"));
+  }
+  // Tickers are counted since the previous record
+  const std::string keys_written = "\"rocksdb.number.keys.written\":1";
+  const std::string memtable_hit = "\"rocksdb.memtable.hit\":1";
+  ASSERT_NE(std::string::npos, records[0].find(keys_written));
+  ASSERT_NE(std::string::npos, records[1].find(keys_written));
+  ASSERT_EQ(std::string::npos, records[0].find(memtable_hit));
+  ASSERT_NE(std::string::npos, records[1].find(memtable_hit));
+
+  uint64_t first = StatsHistory::RecordTime(records[0]);
+  uint64_t second = StatsHistory::RecordTime(records[1]);
+  ASSERT_GT(first, 0U);
+  ASSERT_LT(first, second);
+  ASSERT_OK(db_->GetStatsHistory(first + 1, kMaxTime, &records));
+  ASSERT_EQ(1U, records.size());
+  ASSERT_EQ(second, StatsHistory::RecordTime(records[0]));
+  ASSERT_OK(db_->GetStatsHistory(0, first + 1, &records));
+  ASSERT_EQ(1U, records.size());
+  ASSERT_EQ(first, StatsHistory::RecordTime(records[0]));
+
+  // The records of the previous open are kept in an old file
+  ReopenWithColumnFamilies({"default", "pikachu"}, options);
+  ASSERT_OK(dbfull()->TEST_PersistStats());
+  ASSERT_OK(db_->GetStatsHistory(0, kMaxTime, &records));
+  ASSERT_EQ(3U, records.size());
+  ASSERT_EQ(first, StatsHistory::RecordTime(records[0]));
+}
+
+TEST(DBTest, StatsHistoryRoll) {
+  const uint64_t kMaxTime = std::numeric_limits<uint64_t>::max();
+  Options options = CurrentOptions();
+  options.stats_persist_period_sec = 3600;
+  // Every record fills a file
+  options.stats_persist_max_file_size = 1;
+  options.stats_persist_keep_file_num = 2;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 5; i++) {
+    ASSERT_OK(Put("foo", "v"));
+    ASSERT_OK(dbfull()->TEST_PersistStats());
+    env_->SleepForMicroseconds(1000);
+  }
+  std::vector<std::string> files;
+  ASSERT_OK(env_->GetChildren(dbname_, &files));
+  int num_old_files = 0;
+  bool has_current = false;
+  for (const auto& file : files) {
+    uint64_t number;
+    FileType type;
+    if (ParseFileName(file, &number, &type) && type == kStatsHistoryFile) {
+      if (number == 0) {
+        has_current = true;
+      } else {
+        ++num_old_files;
+      }
+    }
+  }
+  ASSERT_TRUE(has_current);
+  ASSERT_EQ(2, num_old_files);
+
+  std::vector<std::string> records;
+  ASSERT_OK(db_->GetStatsHistory(0, kMaxTime, &records));
+  ASSERT_EQ(3U, records.size());
+  for (size_t i = 1; i < records.size(); i++) {
+    ASSERT_LT(StatsHistory::RecordTime(records[i - 1]),
+              StatsHistory::RecordTime(records[i]));
+  }
+
+  // Records longer than a read are put back together, and old files rolled
+  // before start_micros are not read at all. This one claims a later
+  // record, which is only seen when the file is read.
+  const std::string long_record =
+      "{\"time_micros\":100,\"padding\":\"" + std::string(200000, 'x') +
+      "\"}";
+  ASSERT_OK(WriteStringToFile(env_, long_record + "\n",
+                              OldStatsHistoryFileName(dbname_, 50)));
+  ASSERT_OK(db_->GetStatsHistory(0, 200, &records));
+  ASSERT_EQ(1U, records.size());
+  ASSERT_EQ(long_record, records[0]);
+  ASSERT_OK(db_->GetStatsHistory(51, 200, &records));
+  ASSERT_EQ(0U, records.size());
+}
+
 TEST(DBTest, BloomFilterRate) {
   while (ChangeFilterOptions()) {
     Options options = CurrentOptions();
@@ -6634,6 +7776,92 @@ TEST(DBTest, BloomFilterRate) {
   }
 }
 
+TEST(DBTest, StatisticsFromManyThreads) {
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  // The stats of the threads that exited and of the live ones add up
+  const int kNumThreads = 8;
+  const int kKeysPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kKeysPerThread; i++) {
+        ASSERT_OK(Put(Key(t * kKeysPerThread + i), "v"));
+        options.statistics->measureTime(DB_MULTIGET, 10 * (t + 1));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (int i = 0; i < kKeysPerThread; i++) {
+    ASSERT_EQ("v", Get(Key(i)));
+  }
+  ASSERT_EQ(kNumThreads * kKeysPerThread,
+            TestGetTickerCount(options, NUMBER_KEYS_WRITTEN));
+  ASSERT_EQ(kKeysPerThread, TestGetTickerCount(options, NUMBER_KEYS_READ));
+  HistogramData data;
+  options.statistics->histogramData(DB_MULTIGET, &data);
+  ASSERT_EQ(10.0 * (kNumThreads + 1) / 2, data.average);
+
+  // Setting a ticker replaces what every thread recorded
+  options.statistics->setTickerCount(NUMBER_KEYS_WRITTEN, 10);
+  ASSERT_OK(Put("foo", "bar"));
+  ASSERT_EQ(11, TestGetTickerCount(options, NUMBER_KEYS_WRITTEN));
+}
+
+TEST(DBTest, StatsLevel) {
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  options.statistics->set_stats_level(kExceptTimers);
+  // Every data block read misses the cache
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(1);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  auto get_keys = [&]() {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_EQ("v", Get(Key(i)));
+    }
+  };
+  auto average = [&](Histograms type) {
+    HistogramData data;
+    options.statistics->histogramData(type, &data);
+    return data.average;
+  };
+
+  // Tickers are always collected
+  get_keys();
+  ASSERT_EQ(100, TestGetTickerCount(options, NUMBER_KEYS_READ));
+  ASSERT_EQ(0, average(DB_GET));
+  ASSERT_EQ(0, average(READ_BLOCK_GET_MICROS));
+
+  // Only the timers of whole operations
+  options.statistics->set_stats_level(kExceptDetailedTimers);
+  get_keys();
+  ASSERT_EQ(200, TestGetTickerCount(options, NUMBER_KEYS_READ));
+  for (int round = 0; round < 10 && average(DB_GET) == 0; round++) {
+    get_keys();
+  }
+  ASSERT_GT(average(DB_GET), 0);
+  ASSERT_EQ(0, average(READ_BLOCK_GET_MICROS));
+
+  // Everything
+  options.statistics->set_stats_level(kAll);
+  for (int round = 0; round < 10 && average(READ_BLOCK_GET_MICROS) == 0;
+       round++) {
+    get_keys();
+  }
+  ASSERT_GT(average(READ_BLOCK_GET_MICROS), 0);
+}
+
 TEST(DBTest, BloomFilterCompatibility) {
   Options options = CurrentOptions();
   options.statistics = rocksdb::CreateDBStatistics();
@@ -7329,6 +8557,149 @@ TEST(DBTest, TransactionLogIterator) {
   } while (ChangeCompactOptions());
 }
 
+TEST(DBTest, WalCompression) {
+  Options options = OptionsForLogIterTest();
+  options.wal_compression = kZlibCompression;
+  DestroyAndReopen(options);
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(i % 2, Key(i), DummyString(1024, 'a' + i % 26)));
+  }
+  Random rnd(301);
+  ASSERT_OK(Put(0, "foo", RandomString(&rnd, 1024)));
+
+  VectorLogPtr wal_files;
+  ASSERT_OK(dbfull()->GetSortedWalFiles(wal_files));
+  ASSERT_EQ(1U, wal_files.size());
+  if (ZlibCompressionSupported(CompressionOptions())) {
+    ASSERT_LT(wal_files[0]->SizeFileBytes(), kNumKeys * 1024U / 2);
+  }
+
+  // Tailing the log returns the uncompressed records
+  {
+    auto iter = OpenTransactionLogIter(0);
+    ExpectRecords(kNumKeys + 1, iter);
+  }
+
+  // Recovery replays them
+  std::string foo = Get(0, "foo");
+  ReopenWithColumnFamilies({"default", "pikachu"}, options);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(DummyString(1024, 'a' + i % 26), Get(i % 2, Key(i)));
+  }
+  ASSERT_EQ(foo, Get(0, "foo"));
+}
+
+namespace {
+// Flips a byte in the middle of the log file "number"
+void CorruptLogFile(Env* env, const std::string& dbname, uint64_t number) {
+  std::string fname = LogFileName(dbname, number);
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env, fname, &contents));
+  contents[contents.size() / 2] ^= 0x80;
+  ASSERT_OK(WriteStringToFile(env, contents, fname));
+}
+}  // namespace
+
+TEST(DBTest, PointInTimeRecovery) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), DummyString(1000, 'a' + i % 26)));
+  }
+  VectorLogPtr wal_files;
+  ASSERT_OK(dbfull()->GetSortedWalFiles(wal_files));
+  ASSERT_EQ(1U, wal_files.size());
+  const uint64_t log_number = wal_files[0]->LogNumber();
+  Close();
+  CorruptLogFile(env_, dbname_, log_number);
+
+  // Only the records before the corruption are replayed
+  options.wal_recovery_mode = kWALRecoveryModePointInTime;
+  Reopen(options);
+  int recovered = 0;
+  while (recovered < kNumKeys && Get(Key(recovered)) != "NOT_FOUND") {
+    recovered++;
+  }
+  ASSERT_GT(recovered, 0);
+  ASSERT_LT(recovered, kNumKeys);
+  for (int i = recovered; i < kNumKeys; i++) {
+    ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+  }
+  std::string open_stats;
+  ASSERT_TRUE(db_->GetProperty("rocksdb.db-open-stats", &open_stats));
+  ASSERT_NE(std::string::npos,
+            open_stats.find("Recovered to sequence: " + ToString(recovered)));
+  ASSERT_NE(std::string::npos,
+            open_stats.find("WAL replay stopped at corrupted log: #" +
+                            ToString(log_number)));
+
+  // The DB keeps working from that point
+  ASSERT_OK(Put("foo", "bar"));
+  Reopen(options);
+  ASSERT_EQ("bar", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get(Key(kNumKeys - 1)));
+}
+
+TEST(DBTest, PointInTimeRecoverySkipsLaterRecords) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), DummyString(1000, 'a' + i % 26)));
+  }
+  VectorLogPtr wal_files;
+  ASSERT_OK(dbfull()->GetSortedWalFiles(wal_files));
+  Close();
+  CorruptLogFile(env_, dbname_, wal_files[0]->LogNumber());
+
+  // Skipping the corrupted records replays the ones after them, leaving a
+  // hole in the history
+  options.paranoid_checks = false;
+  Reopen(options);
+  ASSERT_EQ(DummyString(1000, 'a' + (kNumKeys - 1) % 26),
+            Get(Key(kNumKeys - 1)));
+  int missing = 0;
+  for (int i = 0; i < kNumKeys; i++) {
+    if (Get(Key(i)) == "NOT_FOUND") {
+      missing++;
+    }
+  }
+  ASSERT_GT(missing, 0);
+}
+
+TEST(DBTest, PointInTimeRecoveryInconsistentTables) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  DestroyAndReopen(options);
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(0, Key(i), DummyString(1000)));
+  }
+  VectorLogPtr wal_files;
+  ASSERT_OK(dbfull()->GetSortedWalFiles(wal_files));
+  ASSERT_EQ(1U, wal_files.size());
+  const uint64_t log_number = wal_files[0]->LogNumber();
+  // pikachu's table holds a write made after the ones in the corrupted log
+  ASSERT_OK(Put(1, "foo", "bar"));
+  ASSERT_OK(Flush(1));
+  Close();
+  CorruptLogFile(env_, dbname_, log_number);
+
+  options.wal_recovery_mode = kWALRecoveryModePointInTime;
+  Status s = TryReopenWithColumnFamilies({"default", "pikachu"}, options);
+  ASSERT_TRUE(s.IsCorruption());
+  ASSERT_NE(std::string::npos, s.ToString().find("pikachu"));
+}
+
 #ifndef NDEBUG // sync point is not included with DNDEBUG build
 TEST(DBTest, TransactionLogIteratorRace) {
   static const int LOG_ITERATOR_RACE_TEST_COUNT = 2;
@@ -9622,6 +10993,74 @@ TEST(DBTest, ThreadStatusMultipleCompaction) {
       ThreadStatus::OP_COMPACTION, 0);
 }
 
+#ifndef NDEBUG  // sync point is not included with DNDEBUG build
+TEST(DBTest, ThreadStatusRecovery) {
+  Options options = CurrentOptions();
+  options.env = env_;
+  options.enable_thread_tracking = true;
+  options.max_open_files = -1;
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  ASSERT_OK(Put("foo", "bar"));
+  ASSERT_OK(Flush());
+  const int kNumKeys = 400;
+  Random rnd(301);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 1000)));
+  }
+  Close();
+
+  // Replaying the log into smaller memtables flushes them
+  options.write_buffer_size = 64 << 10;
+  rocksdb::SyncPoint::GetInstance()->LoadDependency(
+      {{"DBImpl::RecoverLogFiles:1", "DBTest::ThreadStatusRecovery:1"},
+       {"DBTest::ThreadStatusRecovery:2", "DBImpl::RecoverLogFiles:2"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  std::thread open_thread([&]() { Reopen(options); });
+
+  TEST_SYNC_POINT("DBTest::ThreadStatusRecovery:1");
+  std::vector<ThreadStatus> thread_list;
+  ASSERT_OK(env_->GetThreadList(&thread_list));
+  int recovery_count = 0;
+  for (auto& thread : thread_list) {
+    if (thread.operation_type != ThreadStatus::OP_RECOVERY) {
+      continue;
+    }
+    recovery_count++;
+    ASSERT_EQ(dbname_, thread.db_name);
+    ASSERT_EQ(kDefaultColumnFamilyName, thread.cf_name);
+    ASSERT_GT(thread.op_properties[ThreadStatus::RECOVERY_WAL_BYTES_REPLAYED],
+              kNumKeys * 1000U);
+    ASSERT_GT(thread.op_properties[ThreadStatus::RECOVERY_CURRENT_LOG_NUMBER],
+              0U);
+    ASSERT_GT(thread.op_properties[ThreadStatus::RECOVERY_MEMTABLE_FLUSHES],
+              0U);
+    ASSERT_EQ(1U,
+              thread.op_properties[ThreadStatus::RECOVERY_TABLE_FILES_OPENED]);
+  }
+  ASSERT_EQ(1, recovery_count);
+  TEST_SYNC_POINT("DBTest::ThreadStatusRecovery:2");
+  open_thread.join();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearTrace();
+
+  // The operation ends with the recovery, but its statistics remain
+  ASSERT_OK(env_->GetThreadList(&thread_list));
+  for (auto& thread : thread_list) {
+    ASSERT_NE(ThreadStatus::OP_RECOVERY, thread.operation_type);
+  }
+  std::string open_stats;
+  ASSERT_TRUE(db_->GetProperty("rocksdb.db-open-stats", &open_stats));
+  ASSERT_NE(std::string::npos, open_stats.find("Table files opened: 1\n"));
+  ASSERT_EQ(std::string::npos, open_stats.find("Memtables flushed: 0\n"));
+  HistogramData recovery_time;
+  options.statistics->histogramData(DB_RECOVERY_MICROS, &recovery_time);
+  ASSERT_GT(recovery_time.average, 0);
+  ASSERT_EQ("bar", Get("foo"));
+}
+#endif  // NDEBUG
+
 #endif  // ROCKSDB_USING_THREAD_STATUS
 
 TEST(DBTest, DynamicCompactionOptions) {
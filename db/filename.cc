@@ -182,6 +182,16 @@ std::string IdentityFileName(const std::string& dbname) {
   return dbname + "/IDENTITY";
 }
 
+std::string StatsHistoryFileName(const std::string& dbname) {
+  return dbname + "/STATS";
+}
+
+std::string OldStatsHistoryFileName(const std::string& dbname, uint64_t ts) {
+  char buf[50];
+  snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(ts));
+  return dbname + "/STATS.old." + buf;
+}
+
 // Owned filenames have the form:
 //    dbname/IDENTITY
 //    dbname/CURRENT
@@ -191,6 +201,8 @@ std::string IdentityFileName(const std::string& dbname) {
 //    dbname/MANIFEST-[0-9]+
 //    dbname/[0-9]+.(log|sst)
 //    dbname/METADB-[0-9]+
+//    dbname/STATS
+//    dbname/STATS.old.[0-9]+
 //    Disregards / at the beginning
 bool ParseFileName(const std::string& fname,
                    uint64_t* number,
@@ -215,6 +227,17 @@ bool ParseFileName(const std::string& fname, uint64_t* number,
   } else if (rest == "LOCK") {
     *number = 0;
     *type = kDBLockFile;
+  } else if (rest == "STATS") {
+    *number = 0;
+    *type = kStatsHistoryFile;
+  } else if (rest.starts_with("STATS.old.")) {
+    uint64_t ts_suffix;
+    rest.remove_prefix(sizeof("STATS.old.") - 1);
+    if (!ConsumeDecimalNumber(&rest, &ts_suffix) || !rest.empty()) {
+      return false;
+    }
+    *number = ts_suffix;
+    *type = kStatsHistoryFile;
   } else if (info_log_name_prefix.size() > 0 &&
              rest.starts_with(info_log_name_prefix)) {
     rest.remove_prefix(info_log_name_prefix.size());
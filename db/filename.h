@@ -35,7 +35,8 @@ enum FileType {
   kTempFile,
   kInfoLogFile,  // Either the current one, or an old one
   kMetaDatabase,
-  kIdentityFile
+  kIdentityFile,
+  kStatsHistoryFile  // Either the current one, or an old one
 };
 
 // Return the name of the log file with the specified number
@@ -117,6 +118,14 @@ extern std::string MetaDatabaseName(const std::string& dbname,
 // either from a backup-image or empty
 extern std::string IdentityFileName(const std::string& dbname);
 
+// Return the name of the file the stats records of
+// DBOptions::stats_persist_period_sec are appended to
+extern std::string StatsHistoryFileName(const std::string& dbname);
+
+// Return the name the stats history file is renamed to when it is full
+extern std::string OldStatsHistoryFileName(const std::string& dbname,
+                                           uint64_t ts);
+
 // If filename is a rocksdb file, store the type of the file in *type.
 // The number encoded in the filename is stored in *number.  If the
 // filename was successfully parsed, returns true.  Else return false.
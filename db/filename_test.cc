@@ -44,6 +44,8 @@ TEST(FileNameTest, Parse) {
         {"MANIFEST-7", 7, kDescriptorFile, kAllMode},
         {"METADB-2", 2, kMetaDatabase, kAllMode},
         {"METADB-7", 7, kMetaDatabase, kAllMode},
+        {"STATS", 0, kStatsHistoryFile, kAllMode},
+        {"STATS.old.6688", 6688, kStatsHistoryFile, kAllMode},
         {"LOG", 0, kInfoLogFile, kDefautInfoLogDir},
         {"LOG.old", 0, kInfoLogFile, kDefautInfoLogDir},
         {"LOG.old.6688", 6688, kInfoLogFile, kDefautInfoLogDir},
@@ -170,6 +172,12 @@ TEST(FileNameTest, Construction) {
   ASSERT_TRUE(ParseFileName(fname.c_str() + 4, &number, &type));
   ASSERT_EQ(100U, number);
   ASSERT_EQ(kMetaDatabase, type);
+
+  fname = OldStatsHistoryFileName("sts", 1234);
+  ASSERT_EQ("sts/", std::string(fname.data(), 4));
+  ASSERT_TRUE(ParseFileName(fname.c_str() + 4, &number, &type));
+  ASSERT_EQ(1234U, number);
+  ASSERT_EQ(kStatsHistoryFile, type);
 }
 
 }  // namespace rocksdb
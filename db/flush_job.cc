@@ -173,6 +173,13 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
     if (!db_options_.disableDataSync && db_directory_ != nullptr) {
       db_directory_->Fsync();
     }
+    if (s.ok() && meta.fd.GetFileSize() > 0) {
+      cfd_->NotifyOnTableFileCreated(
+          dbname_, TableFileName(db_options_.db_paths, meta.fd.GetNumber(),
+                                 meta.fd.GetPathId()),
+          meta.fd.GetFileSize(), meta.num_entries,
+          TableFileCreationReason::kFlush);
+    }
     db_mutex_->Lock();
   }
   base->Unref();
@@ -202,9 +209,7 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
         level = 0;
       }
     }
-    edit->AddFile(level, meta.fd.GetNumber(), meta.fd.GetPathId(),
-                  meta.fd.GetFileSize(), meta.smallest, meta.largest,
-                  meta.smallest_seqno, meta.largest_seqno);
+    edit->AddFile(level, meta);
   }
 
   InternalStats::CompactionStats stats(1);
@@ -17,6 +17,9 @@
 #include "db/column_family.h"
 
 #include "db/db_impl.h"
+#include "db/stats_history.h"
+#include "port/likely.h"
+#include "util/mutexlock.h"
 #include "util/string_util.h"
 
 namespace rocksdb {
@@ -110,6 +113,10 @@ DBPropertyType GetPropertyType(const Slice& property, bool* is_int_property,
     return kDBStats;
   } else if (in == "sstables") {
     return kSsTables;
+  } else if (in == "db-open-stats") {
+    return kDBOpenStats;
+  } else if (in == "read-amp-stats") {
+    return kReadAmpStats;
   }
 
   *is_int_property = true;
@@ -217,6 +224,12 @@ bool InternalStats::GetStringProperty(DBPropertyType property_type,
     case kSsTables:
       *value = current->DebugString();
       return true;
+    case kDBOpenStats:
+      DumpDBOpenStats(value);
+      return true;
+    case kReadAmpStats:
+      DumpReadAmpStats(value);
+      return true;
     default:
       return false;
   }
@@ -370,6 +383,156 @@ void InternalStats::DumpDBStats(std::string* value) {
   db_stats_snapshot_.write_stall_micros = write_stall_micros;
 }
 
+void InternalStats::DumpDBOpenStats(std::string* value) {
+  char buf[1000];
+  // DB-level stats, only available from default column family
+  snprintf(buf, sizeof(buf),
+           "Manifest replay(ms): %.3f\n"
+           "Table load(ms): %.3f\n"
+           "WAL replay(ms): %.3f\n",
+           db_stats_[InternalStats::RECOVERY_MANIFEST_MICROS] / 1000.0,
+           db_stats_[InternalStats::RECOVERY_TABLE_LOAD_MICROS] / 1000.0,
+           db_stats_[InternalStats::RECOVERY_WAL_REPLAY_MICROS] / 1000.0);
+  value->append(buf);
+  snprintf(buf, sizeof(buf),
+           "Table files opened: %" PRIu64 "\n"
+           "Table load threads: %" PRIu64 "\n"
+           "WAL bytes replayed: %" PRIu64 "\n"
+           "Memtables flushed: %" PRIu64 "\n"
+           "Recovered to sequence: %" PRIu64 "\n",
+           db_stats_[InternalStats::RECOVERY_TABLE_FILES_OPENED],
+           db_stats_[InternalStats::RECOVERY_TABLE_LOAD_THREADS],
+           db_stats_[InternalStats::RECOVERY_WAL_BYTES],
+           db_stats_[InternalStats::RECOVERY_MEMTABLE_FLUSHES],
+           db_stats_[InternalStats::RECOVERY_SEQUENCE]);
+  value->append(buf);
+  if (db_stats_[InternalStats::RECOVERY_CORRUPTED_LOG] != 0) {
+    snprintf(buf, sizeof(buf),
+             "WAL replay stopped at corrupted log: #%" PRIu64 "\n",
+             db_stats_[InternalStats::RECOVERY_CORRUPTED_LOG]);
+    value->append(buf);
+  }
+}
+
+void InternalStats::ReadAmpStats::Add(const ReadAmpStats& other) {
+  files_probed.fetch_add(other.files_probed.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+  hits.fetch_add(other.hits.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+  filter_useful.fetch_add(other.filter_useful.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  filter_positive.fetch_add(
+      other.filter_positive.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  filter_true_positive.fetch_add(
+      other.filter_true_positive.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  blocks_read.fetch_add(other.blocks_read.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+}
+
+void InternalStats::MergeExitedThread(void* ptr) {
+  auto* thread_stats = static_cast<ThreadReadAmpStats*>(ptr);
+  InternalStats* stats = thread_stats->owner;
+  {
+    MutexLock l(&stats->exited_mutex_);
+    for (int level = 0; level < stats->number_levels_; level++) {
+      stats->exited_read_amp_stats_[level].Add(thread_stats->levels[level]);
+    }
+  }
+  delete thread_stats;
+}
+
+void InternalStats::RecordTableGet(int level,
+                                   const PerfContextByLevel& stats) {
+  auto* thread_stats =
+      static_cast<ThreadReadAmpStats*>(thread_read_amp_stats_.Get());
+  if (UNLIKELY(thread_stats == nullptr)) {
+    thread_stats = new ThreadReadAmpStats(this, number_levels_);
+    thread_read_amp_stats_.Reset(thread_stats);
+  }
+  // Only this thread writes to its stats, so plain stores are enough
+  ReadAmpStats& l = thread_stats->levels[level];
+  l.files_probed.store(
+      l.files_probed.load(std::memory_order_relaxed) + stats.get_files_probed,
+      std::memory_order_relaxed);
+  if (stats.get_hit_count > 0) {
+    l.hits.store(l.hits.load(std::memory_order_relaxed) + stats.get_hit_count,
+                 std::memory_order_relaxed);
+  }
+  if (stats.bloom_filter_useful > 0) {
+    l.filter_useful.store(l.filter_useful.load(std::memory_order_relaxed) +
+                              stats.bloom_filter_useful,
+                          std::memory_order_relaxed);
+  }
+  if (stats.bloom_filter_positive > 0) {
+    l.filter_positive.store(l.filter_positive.load(std::memory_order_relaxed) +
+                                stats.bloom_filter_positive,
+                            std::memory_order_relaxed);
+  }
+  if (stats.bloom_filter_true_positive > 0) {
+    l.filter_true_positive.store(
+        l.filter_true_positive.load(std::memory_order_relaxed) +
+            stats.bloom_filter_true_positive,
+        std::memory_order_relaxed);
+  }
+  if (stats.block_read_count > 0) {
+    l.blocks_read.store(l.blocks_read.load(std::memory_order_relaxed) +
+                            stats.block_read_count,
+                        std::memory_order_relaxed);
+  }
+}
+
+void InternalStats::DumpReadAmpStats(std::string* value) {
+  std::vector<ReadAmpStats> read_amp_stats(number_levels_);
+  {
+    MutexLock l(&exited_mutex_);
+    for (int level = 0; level < number_levels_; level++) {
+      read_amp_stats[level].Add(exited_read_amp_stats_[level]);
+    }
+  }
+  thread_read_amp_stats_.Fold([](void* ptr, void* res) {
+    auto* thread_stats = static_cast<ThreadReadAmpStats*>(ptr);
+    auto* sum = static_cast<std::vector<ReadAmpStats>*>(res);
+    for (size_t level = 0; level < sum->size(); level++) {
+      (*sum)[level].Add(thread_stats->levels[level]);
+    }
+  }, &read_amp_stats);
+
+  char buf[1000];
+  snprintf(buf, sizeof(buf),
+           "Level    Probes      Hits  Filtered  Positive   TruePos  FP(%%)"
+           "    BlocksRead\n"
+           "------------------------------------------------------------"
+           "--------------\n");
+  value->append(buf);
+  for (int level = 0; level < number_levels_; level++) {
+    const ReadAmpStats& l = read_amp_stats[level];
+    uint64_t files_probed = l.files_probed.load(std::memory_order_relaxed);
+    if (files_probed == 0) {
+      continue;
+    }
+    uint64_t filter_useful = l.filter_useful.load(std::memory_order_relaxed);
+    uint64_t filter_positive =
+        l.filter_positive.load(std::memory_order_relaxed);
+    uint64_t filter_true_positive =
+        l.filter_true_positive.load(std::memory_order_relaxed);
+    // Share of the keys absent from a file that its filter let through
+    uint64_t false_positive = filter_positive > filter_true_positive
+                                  ? filter_positive - filter_true_positive
+                                  : 0;
+    uint64_t absent = false_positive + filter_useful;
+    snprintf(buf, sizeof(buf),
+             "%3d %11" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64
+             " %9" PRIu64 " %6.2f %13" PRIu64 "\n",
+             level, files_probed, l.hits.load(std::memory_order_relaxed),
+             filter_useful, filter_positive, filter_true_positive,
+             absent == 0 ? 0.0 : 100.0 * false_positive / absent,
+             l.blocks_read.load(std::memory_order_relaxed));
+    value->append(buf);
+  }
+}
+
 void InternalStats::DumpCFStats(std::string* value) {
   const VersionStorageInfo* vstorage = cfd_->current()->storage_info();
 
@@ -499,6 +662,91 @@ void InternalStats::DumpCFStats(std::string* value) {
   cf_stats_snapshot_.stall_count = total_stall_count;
 }
 
+namespace {
+// Returns the increase of a counter since "*last", and sets "*last" to it
+uint64_t Delta(uint64_t current, uint64_t* last) {
+  uint64_t delta = current - *last;
+  *last = current;
+  return delta;
+}
+}  // namespace
+
+void InternalStats::AddCFStatsRecord(StatsRecordWriter* record) {
+  if (record_snapshot_.comp_stats.empty()) {
+    record_snapshot_.comp_stats.resize(number_levels_);
+    record_snapshot_.leveln_stall_micros.resize(number_levels_, 0);
+    record_snapshot_.cf_stats_value.resize(INTERNAL_CF_STATS_ENUM_MAX, 0);
+  }
+  std::vector<uint64_t>& last_cf = record_snapshot_.cf_stats_value;
+  const VersionStorageInfo* vstorage = cfd_->current()->storage_info();
+
+  record->Add("name", cfd_->GetName());
+  record->Add("immutable_memtables",
+              static_cast<uint64_t>(cfd_->imm()->size()));
+  record->Add("flushed_bytes",
+              Delta(cf_stats_value_[BYTES_FLUSHED], &last_cf[BYTES_FLUSHED]));
+  record->BeginObject("stall_micros");
+  record->Add("level0_slowdown", Delta(cf_stats_value_[LEVEL0_SLOWDOWN],
+                                       &last_cf[LEVEL0_SLOWDOWN]));
+  record->Add("level0_num_files", Delta(cf_stats_value_[LEVEL0_NUM_FILES],
+                                        &last_cf[LEVEL0_NUM_FILES]));
+  record->Add("memtable_compaction",
+              Delta(cf_stats_value_[MEMTABLE_COMPACTION],
+                    &last_cf[MEMTABLE_COMPACTION]));
+  record->EndObject();
+
+  record->BeginArray("levels");
+  for (int level = 0; level < number_levels_; level++) {
+    CompactionStats interval(comp_stats_[level]);
+    interval.Subtract(record_snapshot_.comp_stats[level]);
+    record_snapshot_.comp_stats[level] = comp_stats_[level];
+    uint64_t stall_micros =
+        Delta(stall_leveln_slowdown_soft_[level] +
+                  stall_leveln_slowdown_hard_[level],
+              &record_snapshot_.leveln_stall_micros[level]);
+    int files = vstorage->NumLevelFiles(level);
+    if (files == 0 && interval.count == 0 && interval.bytes_moved == 0 &&
+        stall_micros == 0) {
+      continue;
+    }
+    record->BeginObject();
+    record->Add("level", static_cast<uint64_t>(level));
+    record->Add("files", static_cast<uint64_t>(files));
+    record->Add("bytes", vstorage->NumLevelBytes(level));
+    record->Add("compactions", static_cast<uint64_t>(interval.count));
+    record->Add("compaction_micros", interval.micros);
+    record->Add("read_bytes", interval.bytes_readn + interval.bytes_readnp1);
+    record->Add("written_bytes", interval.bytes_written);
+    record->Add("moved_bytes", interval.bytes_moved);
+    record->Add("input_records", interval.num_input_records);
+    record->Add("dropped_records", interval.num_dropped_records);
+    record->Add("stall_micros", stall_micros);
+    record->EndObject();
+  }
+  record->EndArray();
+}
+
+void InternalStats::AddDBStatsRecord(StatsRecordWriter* record) {
+  std::vector<uint64_t>& last = record_snapshot_.db_stats;
+  last.resize(INTERNAL_DB_STATS_ENUM_MAX, 0);
+  record->Add("user_bytes_written",
+              Delta(db_stats_[BYTES_WRITTEN], &last[BYTES_WRITTEN]));
+  record->Add("keys_written",
+              Delta(db_stats_[NUMBER_KEYS_WRITTEN], &last[NUMBER_KEYS_WRITTEN]));
+  record->Add("writes_done_by_self",
+              Delta(db_stats_[WRITE_DONE_BY_SELF], &last[WRITE_DONE_BY_SELF]));
+  record->Add("writes_done_by_other", Delta(db_stats_[WRITE_DONE_BY_OTHER],
+                                            &last[WRITE_DONE_BY_OTHER]));
+  record->Add("writes_with_wal",
+              Delta(db_stats_[WRITE_WITH_WAL], &last[WRITE_WITH_WAL]));
+  record->Add("wal_bytes",
+              Delta(db_stats_[WAL_FILE_BYTES], &last[WAL_FILE_BYTES]));
+  record->Add("wal_syncs",
+              Delta(db_stats_[WAL_FILE_SYNCED], &last[WAL_FILE_SYNCED]));
+  record->Add("write_stall_micros",
+              Delta(db_stats_[WRITE_STALL_MICROS], &last[WRITE_STALL_MICROS]));
+}
+
 
 #else
 
@@ -11,15 +11,21 @@
 #pragma once
 #include "db/version_set.h"
 
+#include <atomic>
 #include <vector>
 #include <string>
 
+#include "rocksdb/perf_context.h"
+#include "port/port.h"
+#include "util/thread_local.h"
+
 class ColumnFamilyData;
 
 namespace rocksdb {
 
 class MemTableList;
 class DBImpl;
+class StatsRecordWriter;
 
 // IMPORTANT: If you add a new property here, also add it to the list in
 //            include/rocksdb/db.h
@@ -31,6 +37,8 @@ enum DBPropertyType : uint32_t {
   kDBStats,          // Return general statitistics of DB
   kStats,            // Return general statitistics of both DB and CF
   kSsTables,         // Return a human readable string of current SST files
+  kDBOpenStats,      // Return time spent in each phase of DB::Open()
+  kReadAmpStats,     // Return the work Get()s did in the files of each level
   kStartIntTypes,    // ---- Dummy value to indicate the start of integer values
   kNumImmutableMemTable,   // Return number of immutable mem tables
   kMemtableFlushPending,   // Return 1 if mem table flushing is pending,
@@ -78,6 +86,19 @@ class InternalStats {
     WRITE_DONE_BY_SELF,
     WRITE_WITH_WAL,
     WRITE_STALL_MICROS,
+    // Time DB::Open() spent in each phase of recovery
+    RECOVERY_MANIFEST_MICROS,
+    RECOVERY_TABLE_LOAD_MICROS,
+    RECOVERY_WAL_REPLAY_MICROS,
+    // Sequence number DB::Open() recovered to, and the log whose corruption
+    // stopped a point-in-time recovery (0 if none)
+    RECOVERY_SEQUENCE,
+    RECOVERY_CORRUPTED_LOG,
+    // Work done by DB::Open() to recover
+    RECOVERY_WAL_BYTES,
+    RECOVERY_MEMTABLE_FLUSHES,
+    RECOVERY_TABLE_FILES_OPENED,
+    RECOVERY_TABLE_LOAD_THREADS,
     INTERNAL_DB_STATS_ENUM_MAX,
   };
 
@@ -90,11 +111,13 @@ class InternalStats {
         stall_leveln_slowdown_count_hard_(num_levels),
         stall_leveln_slowdown_soft_(num_levels),
         stall_leveln_slowdown_count_soft_(num_levels),
+        exited_read_amp_stats_(num_levels),
         bg_error_count_(0),
         number_levels_(num_levels),
         env_(env),
         cfd_(cfd),
-        started_at_(env->NowMicros()) {
+        started_at_(env->NowMicros()),
+        thread_read_amp_stats_(&InternalStats::MergeExitedThread) {
     for (int i = 0; i< INTERNAL_DB_STATS_ENUM_MAX; ++i) {
       db_stats_[i] = 0;
     }
@@ -228,6 +251,10 @@ class InternalStats {
     db_stats_[type] += value;
   }
 
+  // Adds the work a Get() did in a table file of "level" to the stats of
+  // the calling thread. Called without the DB mutex.
+  void RecordTableGet(int level, const PerfContextByLevel& stats);
+
   uint64_t GetBackgroundErrorCount() const { return bg_error_count_; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return ++bg_error_count_; }
@@ -241,9 +268,18 @@ class InternalStats {
   bool GetIntPropertyOutOfMutex(DBPropertyType property_type, Version* version,
                                 uint64_t* value) const;
 
+  // Add the fields of the stats records of
+  // DBOptions::stats_persist_period_sec: the counters are the deltas since
+  // the previous record. The DB ones are only kept by the default column
+  // family. REQUIRES: DB mutex held
+  void AddCFStatsRecord(StatsRecordWriter* record);
+  void AddDBStatsRecord(StatsRecordWriter* record);
+
  private:
   void DumpDBStats(std::string* value);
+  void DumpDBOpenStats(std::string* value);
   void DumpCFStats(std::string* value);
+  void DumpReadAmpStats(std::string* value);
 
   // Per-DB stats
   std::vector<uint64_t> db_stats_;
@@ -258,6 +294,46 @@ class InternalStats {
   std::vector<uint64_t> stall_leveln_slowdown_soft_;
   std::vector<uint64_t> stall_leveln_slowdown_count_soft_;
 
+  // Per level work done by Get()s in the table files. Every thread updates
+  // its own copy without the DB mutex, like StatisticsImpl does, and
+  // DumpReadAmpStats() folds them together.
+  struct ReadAmpStats {
+    std::atomic<uint64_t> files_probed;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> filter_useful;
+    std::atomic<uint64_t> filter_positive;
+    std::atomic<uint64_t> filter_true_positive;
+    std::atomic<uint64_t> blocks_read;
+
+    ReadAmpStats()
+        : files_probed(0),
+          hits(0),
+          filter_useful(0),
+          filter_positive(0),
+          filter_true_positive(0),
+          blocks_read(0) {}
+
+    void Add(const ReadAmpStats& other);
+  };
+
+  // The read amp stats recorded by one thread
+  struct ThreadReadAmpStats {
+    ThreadReadAmpStats(InternalStats* stats, int num_levels)
+        : owner(stats), levels(num_levels) {}
+
+    InternalStats* const owner;
+    std::vector<ReadAmpStats> levels;
+  };
+
+  // Folds the stats of a thread into exited_read_amp_stats_ when it exits
+  // (or when this object is destroyed)
+  static void MergeExitedThread(void* ptr);
+
+  // Protects exited_read_amp_stats_. Taken while the ThreadLocalPtr lock is
+  // held, never the other way around.
+  port::Mutex exited_mutex_;
+  std::vector<ReadAmpStats> exited_read_amp_stats_;
+
   // Used to compute per-interval statistics
   struct CFStatsSnapshot {
     // ColumnFamily-level stats
@@ -304,6 +380,14 @@ class InternalStats {
           seconds_up(0) {}
   } db_stats_snapshot_;
 
+  // The counters as of the previous stats record
+  struct RecordSnapshot {
+    std::vector<CompactionStats> comp_stats;
+    std::vector<uint64_t> leveln_stall_micros;
+    std::vector<uint64_t> cf_stats_value;
+    std::vector<uint64_t> db_stats;
+  } record_snapshot_;
+
   // Total number of background errors encountered. Every time a flush task
   // or compaction task fails, this counter is incremented. The failure can
   // be caused by any possible reason, including file system errors, out of
@@ -315,6 +399,10 @@ class InternalStats {
   Env* env_;
   ColumnFamilyData* cfd_;
   const uint64_t started_at_;
+
+  // Destroyed first, so that it merges the remaining threads' stats while
+  // exited_read_amp_stats_ is still alive
+  ThreadLocalPtr thread_read_amp_stats_;
 };
 
 #else
@@ -339,6 +427,18 @@ class InternalStats {
     WRITE_DONE_BY_SELF,
     WRITE_WITH_WAL,
     WRITE_STALL_MICROS,
+    // Time DB::Open() spent in each phase of recovery
+    RECOVERY_MANIFEST_MICROS,
+    RECOVERY_TABLE_LOAD_MICROS,
+    RECOVERY_WAL_REPLAY_MICROS,
+    // Sequence number DB::Open() recovered to, and the log whose corruption
+    // stopped a point-in-time recovery (0 if none)
+    RECOVERY_SEQUENCE,
+    RECOVERY_CORRUPTED_LOG,
+    RECOVERY_WAL_BYTES,
+    RECOVERY_MEMTABLE_FLUSHES,
+    RECOVERY_TABLE_FILES_OPENED,
+    RECOVERY_TABLE_LOAD_THREADS,
     INTERNAL_DB_STATS_ENUM_MAX,
   };
 
@@ -372,6 +472,8 @@ class InternalStats {
 
   void RecordLevelNSlowdown(int level, uint64_t micros, bool soft) {}
 
+  void RecordTableGet(int level, const PerfContextByLevel& stats) {}
+
   void AddCFStats(InternalCFStatsType type, uint64_t value) {}
 
   void AddDBStats(InternalDBStatsType type, uint64_t value) {}
@@ -388,6 +490,10 @@ class InternalStats {
 
   bool GetIntPropertyOutOfMutex(DBPropertyType property_type, Version* version,
                                 uint64_t* value) const { return false; }
+
+  void AddCFStatsRecord(StatsRecordWriter* record) {}
+
+  void AddDBStatsRecord(StatsRecordWriter* record) {}
 };
 #endif  // !ROCKSDB_LITE
 
@@ -52,6 +52,10 @@ struct JobContext {
   // a list of log files that we need to delete
   std::vector<uint64_t> log_delete_files;
 
+  // a list of log files that are kept to be recycled and must not be
+  // deleted
+  std::vector<uint64_t> log_recycle_files;
+
   // a list of memtables to be free
   autovector<MemTable*> memtables_to_free;
 
@@ -68,6 +72,12 @@ struct JobContext {
 
   uint64_t min_pending_output = 0;
 
+#ifndef ROCKSDB_LITE
+  // the listeners of all column families, which hear about the deleted
+  // table files
+  std::vector<std::shared_ptr<EventListener>> listeners;
+#endif  // ROCKSDB_LITE
+
   explicit JobContext(bool create_superversion = false) {
     manifest_file_number = 0;
     pending_manifest_file_number = 0;
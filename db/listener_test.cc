@@ -3,6 +3,8 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <algorithm>
+
 #include "db/dbformat.h"
 #include "db/db_impl.h"
 #include "db/filename.h"
@@ -338,6 +340,175 @@ TEST(EventListenerTest, DisableBGCompaction) {
   ASSERT_GE(listener->stop_count, 1);
 }
 
+class TestCompactionListener : public EventListener {
+ public:
+  void OnCompactionCompleted(DB* db, const CompactionJobInfo& ci) override {
+    MutexLock l(&mutex_);
+    compacted_dbs_.push_back(db);
+    infos_.push_back(ci);
+  }
+
+  port::Mutex mutex_;
+  std::vector<DB*> compacted_dbs_;
+  std::vector<CompactionJobInfo> infos_;
+};
+
+TEST(EventListenerTest, OnCompactionCompleted) {
+  Options options;
+  options.create_if_missing = true;
+  options.compression = kNoCompression;
+  options.disable_auto_compactions = true;
+  TestCompactionListener* listener = new TestCompactionListener();
+  options.listeners.emplace_back(listener);
+  CreateAndReopenWithCF({"pikachu"}, &options);
+
+  const int kNumFiles = 3;
+  for (int i = 0; i < kNumFiles; ++i) {
+    for (int k = 0; k < 10; ++k) {
+      ASSERT_OK(Put(1, ToString(k), ToString(i)));
+    }
+    ASSERT_OK(Flush(1));
+  }
+  ASSERT_OK(db_->CompactRange(handles_[1], nullptr, nullptr));
+
+  MutexLock l(&listener->mutex_);
+  ASSERT_EQ(listener->infos_.size(), 1U);
+  const CompactionJobInfo& ci = listener->infos_[0];
+  ASSERT_EQ(listener->compacted_dbs_[0], db_);
+  ASSERT_EQ(ci.cf_name, "pikachu");
+  ASSERT_OK(ci.status);
+  ASSERT_EQ(ci.base_input_level, 0);
+  ASSERT_EQ(ci.output_level, 1);
+  ASSERT_EQ(ci.input_files.size(), static_cast<size_t>(kNumFiles));
+  ASSERT_EQ(ci.num_input_files_at_base_level, kNumFiles);
+  ASSERT_EQ(ci.num_input_files_at_output_level, 0);
+  ASSERT_EQ(ci.output_files.size(), 1U);
+  ASSERT_EQ(ci.num_output_files, 1);
+  ASSERT_TRUE(options.env->FileExists(ci.output_files[0]));
+  ASSERT_GT(ci.bytes_read_base_level, 0U);
+  ASSERT_GT(ci.bytes_written, 0U);
+  // Each key was written once per file, only the newest survives
+  ASSERT_EQ(ci.num_input_records, 10U * kNumFiles);
+  ASSERT_EQ(ci.num_dropped_records, 10U * (kNumFiles - 1));
+}
+
+class TestTableFileListener : public EventListener {
+ public:
+  void OnTableFileCreated(const TableFileCreationInfo& info) override {
+    MutexLock l(&mutex_);
+    created_.push_back(info);
+  }
+
+  void OnTableFileDeleted(const TableFileDeletionInfo& info) override {
+    MutexLock l(&mutex_);
+    deleted_.push_back(info);
+  }
+
+  port::Mutex mutex_;
+  std::vector<TableFileCreationInfo> created_;
+  std::vector<TableFileDeletionInfo> deleted_;
+};
+
+TEST(EventListenerTest, OnTableFileCreatedAndDeleted) {
+  Options options;
+  options.create_if_missing = true;
+  options.disable_auto_compactions = true;
+  TestTableFileListener* listener = new TestTableFileListener();
+  options.listeners.emplace_back(listener);
+  CreateAndReopenWithCF({"pikachu"}, &options);
+
+  ASSERT_OK(Put(1, "a", "1"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(Put(1, "b", "2"));
+  ASSERT_OK(Flush(1));
+  std::vector<std::string> flushed_files;
+  {
+    MutexLock l(&listener->mutex_);
+    ASSERT_EQ(listener->created_.size(), 2U);
+    for (const auto& info : listener->created_) {
+      ASSERT_EQ(info.db_name, dbname_);
+      ASSERT_EQ(info.cf_name, "pikachu");
+      ASSERT_TRUE(info.reason == TableFileCreationReason::kFlush);
+      ASSERT_EQ(info.num_entries, 1U);
+      ASSERT_GT(info.file_size, 0U);
+      ASSERT_TRUE(options.env->FileExists(info.file_path));
+      flushed_files.push_back(info.file_path);
+    }
+  }
+
+  // The compaction replaces both flushed files with a new one
+  ASSERT_OK(db_->CompactRange(handles_[1], nullptr, nullptr));
+  MutexLock l(&listener->mutex_);
+  ASSERT_EQ(listener->created_.size(), 3U);
+  const TableFileCreationInfo& compacted = listener->created_[2];
+  ASSERT_TRUE(compacted.reason == TableFileCreationReason::kCompaction);
+  ASSERT_EQ(compacted.num_entries, 2U);
+  ASSERT_EQ(listener->deleted_.size(), 2U);
+  std::vector<std::string> deleted_files;
+  for (const auto& info : listener->deleted_) {
+    ASSERT_EQ(info.db_name, dbname_);
+    ASSERT_OK(info.status);
+    ASSERT_TRUE(!options.env->FileExists(info.file_path));
+    deleted_files.push_back(info.file_path);
+  }
+  std::sort(flushed_files.begin(), flushed_files.end());
+  std::sort(deleted_files.begin(), deleted_files.end());
+  ASSERT_TRUE(flushed_files == deleted_files);
+}
+
+class TestStallListener : public EventListener {
+ public:
+  void OnStallConditionsChanged(const WriteStallInfo& info) override {
+    MutexLock l(&mutex_);
+    infos_.push_back(info);
+  }
+
+  port::Mutex mutex_;
+  std::vector<WriteStallInfo> infos_;
+};
+
+TEST(EventListenerTest, OnStallConditionsChanged) {
+  Options options;
+  TestStallListener* listener = new TestStallListener();
+  const int kSlowdownTrigger = 3;
+  const int kStopTrigger = 5;
+  options.level0_slowdown_writes_trigger = kSlowdownTrigger;
+  options.level0_stop_writes_trigger = kStopTrigger;
+  options.listeners.emplace_back(listener);
+  // BG compaction is disabled, so level 0 files pile up until writes stop
+  options.compaction_style = kCompactionStyleNone;
+  options.compression = kNoCompression;
+  options.write_buffer_size = 100000;  // Small write buffer
+
+  CreateAndReopenWithCF({"pikachu"}, &options);
+  WriteOptions wopts;
+  wopts.timeout_hint_us = 100000;
+  ColumnFamilyMetaData cf_meta;
+  db_->GetColumnFamilyMetaData(handles_[1], &cf_meta);
+  for (int i = 0; static_cast<int>(cf_meta.file_count) < kStopTrigger; ++i) {
+    Put(1, ToString(i), std::string(100000, 'x'), wopts);
+    db_->GetColumnFamilyMetaData(handles_[1], &cf_meta);
+  }
+  // Wait for the flush that stopped the writes to report it
+  Close();
+
+  // Waiting for immutable memtables to flush may stop writes in between, so
+  // only check that the transitions chain up and go through a slowdown
+  MutexLock l(&listener->mutex_);
+  ASSERT_GE(listener->infos_.size(), 2U);
+  WriteStallCondition prev = WriteStallCondition::kNormal;
+  bool delayed = false;
+  for (const auto& info : listener->infos_) {
+    ASSERT_EQ(info.cf_name, "pikachu");
+    ASSERT_TRUE(info.condition.prev == prev);
+    ASSERT_TRUE(info.condition.cur != prev);
+    delayed |= info.condition.cur == WriteStallCondition::kDelayed;
+    prev = info.condition.cur;
+  }
+  ASSERT_TRUE(delayed);
+  ASSERT_TRUE(prev == WriteStallCondition::kStopped);
+}
+
 }  // namespace rocksdb
 
 #endif  // ROCKSDB_LITE
@@ -22,14 +22,34 @@ enum RecordType {
   // For fragments
   kFirstType = 2,
   kMiddleType = 3,
-  kLastType = 4
+  kLastType = 4,
+
+  // For recycled log files
+  kRecyclableFullType = 5,
+  kRecyclableFirstType = 6,
+  kRecyclableMiddleType = 7,
+  kRecyclableLastType = 8,
+
+  // First record of a log whose records are compressed. The payload is
+  // the CompressionType byte.
+  kSetCompressionType = 9,
+  kRecyclableSetCompressionType = 10,
 };
-static const int kMaxRecordType = kLastType;
+static const int kMaxRecordType = kRecyclableSetCompressionType;
+
+inline bool IsRecyclableType(unsigned int type) {
+  return (type >= kRecyclableFullType && type <= kRecyclableLastType) ||
+         type == kRecyclableSetCompressionType;
+}
 
 static const unsigned int kBlockSize = 32768;
 
-// Header is checksum (4 bytes), type (1 byte), length (2 bytes).
-static const int kHeaderSize = 4 + 1 + 2;
+// Header is checksum (4 bytes), length (2 bytes), type (1 byte).
+static const int kHeaderSize = 4 + 2 + 1;
+
+// Recyclable header is checksum (4 bytes), length (2 bytes), type (1 byte),
+// log number (4 bytes).
+static const int kRecyclableHeaderSize = 4 + 2 + 1 + 4;
 
 }  // namespace log
 }  // namespace rocksdb
@@ -0,0 +1,115 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/log_prefetch_reader.h"
+
+#include "rocksdb/env.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+namespace log {
+
+// Queues the corruptions found by the background thread so that
+// PrefetchReader::ReadRecord() can report them in order.
+class PrefetchReader::BufferingReporter : public Reader::Reporter {
+ public:
+  explicit BufferingReporter(PrefetchReader* reader) : reader_(reader) {}
+
+  virtual void Corruption(size_t bytes, const Status& status) override {
+    Entry entry;
+    entry.is_corruption = true;
+    entry.dropped_bytes = bytes;
+    entry.status = status;
+    MutexLock l(&reader_->mu_);
+    reader_->entries_.push_back(std::move(entry));
+    reader_->cv_.SignalAll();
+  }
+
+ private:
+  PrefetchReader* reader_;
+};
+
+PrefetchReader::PrefetchReader(unique_ptr<SequentialFile>&& file,
+                               Reader::Reporter* reporter, bool checksum,
+                               uint64_t initial_offset, uint64_t log_num,
+                               size_t max_buffered_bytes)
+    : reporter_(reporter),
+      max_buffered_bytes_(max_buffered_bytes),
+      cv_(&mu_),
+      buffered_bytes_(0),
+      done_(false),
+      stop_(false),
+      buffering_reporter_(new BufferingReporter(this)),
+      reader_(std::move(file), buffering_reporter_.get(), checksum,
+              initial_offset, log_num) {
+  thread_ = std::thread(&PrefetchReader::BackgroundRead, this);
+}
+
+PrefetchReader::~PrefetchReader() {
+  {
+    MutexLock l(&mu_);
+    stop_ = true;
+    cv_.SignalAll();
+  }
+  thread_.join();
+}
+
+bool PrefetchReader::ReadRecord(Slice* record, std::string* scratch) {
+  while (true) {
+    Entry entry;
+    {
+      MutexLock l(&mu_);
+      while (entries_.empty() && !done_) {
+        cv_.Wait();
+      }
+      if (entries_.empty()) {
+        return false;
+      }
+      entry = std::move(entries_.front());
+      entries_.pop_front();
+      buffered_bytes_ -= entry.record.size();
+      cv_.SignalAll();
+    }
+    if (entry.is_corruption) {
+      if (reporter_ != nullptr) {
+        reporter_->Corruption(entry.dropped_bytes, entry.status);
+      }
+      continue;
+    }
+    scratch->swap(entry.record);
+    *record = Slice(*scratch);
+    return true;
+  }
+}
+
+void PrefetchReader::BackgroundRead() {
+  Slice record;
+  std::string scratch;
+  while (reader_.ReadRecord(&record, &scratch)) {
+    Entry entry;
+    entry.record.assign(record.data(), record.size());
+    entry.is_corruption = false;
+    entry.dropped_bytes = 0;
+
+    MutexLock l(&mu_);
+    // Always allow one record in, however large it is
+    while (!stop_ && !entries_.empty() &&
+           buffered_bytes_ + entry.record.size() > max_buffered_bytes_) {
+      cv_.Wait();
+    }
+    if (stop_) {
+      return;
+    }
+    buffered_bytes_ += entry.record.size();
+    entries_.push_back(std::move(entry));
+    cv_.SignalAll();
+  }
+  MutexLock l(&mu_);
+  done_ = true;
+  cv_.SignalAll();
+}
+
+}  // namespace log
+}  // namespace rocksdb
@@ -0,0 +1,72 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "db/log_reader.h"
+#include "port/port.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+namespace log {
+
+// Reads the records of a log file on a background thread, up to
+// max_buffered_bytes ahead of the caller, so that reading and checksumming
+// the log overlaps with applying its records.
+//
+// Corruptions found by the background thread are reported to "reporter"
+// from ReadRecord(), on the caller's thread and in log order, exactly as
+// a Reader would report them.
+class PrefetchReader {
+ public:
+  PrefetchReader(unique_ptr<SequentialFile>&& file, Reader::Reporter* reporter,
+                 bool checksum, uint64_t initial_offset, uint64_t log_num,
+                 size_t max_buffered_bytes);
+
+  // Stops the background thread, even if the log was not read to the end.
+  ~PrefetchReader();
+
+  // Same contract as Reader::ReadRecord().
+  bool ReadRecord(Slice* record, std::string* scratch);
+
+ private:
+  class BufferingReporter;
+
+  // A record, or a corruption that was found before the next record
+  struct Entry {
+    std::string record;
+    bool is_corruption;
+    size_t dropped_bytes;
+    Status status;
+  };
+
+  void BackgroundRead();
+
+  Reader::Reporter* const reporter_;
+  const size_t max_buffered_bytes_;
+
+  port::Mutex mu_;
+  port::CondVar cv_;
+  std::deque<Entry> entries_;
+  size_t buffered_bytes_;
+  bool done_;  // the background thread read the whole log
+  bool stop_;  // the reader is being destroyed
+
+  std::unique_ptr<Reader::Reporter> buffering_reporter_;
+  Reader reader_;  // only used by the background thread
+  std::thread thread_;
+
+  // No copying allowed
+  PrefetchReader(const PrefetchReader&);
+  void operator=(const PrefetchReader&);
+};
+
+}  // namespace log
+}  // namespace rocksdb
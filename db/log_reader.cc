@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 
 namespace rocksdb {
@@ -21,7 +22,7 @@ Reader::Reporter::~Reporter() {
 }
 
 Reader::Reader(unique_ptr<SequentialFile>&& _file, Reporter* reporter,
-               bool checksum, uint64_t initial_offset)
+               bool checksum, uint64_t initial_offset, uint64_t log_num)
     : file_(std::move(_file)),
       reporter_(reporter),
       checksum_(checksum),
@@ -32,7 +33,11 @@ Reader::Reader(unique_ptr<SequentialFile>&& _file, Reporter* reporter,
       eof_offset_(0),
       last_record_offset_(0),
       end_of_buffer_offset_(0),
-      initial_offset_(initial_offset) {}
+      initial_offset_(initial_offset),
+      log_number_(log_num),
+      recycled_(false),
+      pending_drop_bytes_(0),
+      compressed_(false) {}
 
 Reader::~Reader() {
   delete[] backing_store_;
@@ -52,7 +57,13 @@ bool Reader::SkipToInitialBlock() {
 
   // Skip to start of first block that can contain the initial record
   if (block_start_location > 0) {
-    Status skip_status = file_->Skip(block_start_location);
+    // Whether the records are compressed is told by the first record of
+    // the file, which is skipped otherwise
+    size_t bytes_read = 0;
+    if (!ReadCompressionType(&bytes_read)) {
+      return false;
+    }
+    Status skip_status = file_->Skip(block_start_location - bytes_read);
     if (!skip_status.ok()) {
       ReportDrop(static_cast<size_t>(block_start_location), skip_status);
       return false;
@@ -62,6 +73,47 @@ bool Reader::SkipToInitialBlock() {
   return true;
 }
 
+bool Reader::ReadCompressionType(size_t* bytes_read) {
+  Slice header;
+  Status s = file_->Read(kRecyclableHeaderSize + 1, &header, backing_store_);
+  if (!s.ok()) {
+    ReportDrop(kRecyclableHeaderSize + 1, s);
+    return false;
+  }
+  *bytes_read = header.size();
+  if (header.size() < static_cast<size_t>(kHeaderSize)) {
+    return true;
+  }
+
+  const char* data = header.data();
+  const uint32_t length = (static_cast<uint32_t>(data[4]) & 0xff) |
+                          ((static_cast<uint32_t>(data[5]) & 0xff) << 8);
+  const unsigned int type = data[6];
+  int header_size = kHeaderSize;
+  if (type == kRecyclableSetCompressionType) {
+    header_size = kRecyclableHeaderSize;
+  } else if (type != kSetCompressionType) {
+    return true;
+  }
+  if (length != 1 || header.size() < static_cast<size_t>(header_size + 1)) {
+    return true;
+  }
+  if (type == kRecyclableSetCompressionType &&
+      DecodeFixed32(data + 7) != static_cast<uint32_t>(log_number_)) {
+    // Left over from a previous use of the file
+    return true;
+  }
+  if (checksum_) {
+    uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(data));
+    uint32_t actual_crc = crc32c::Value(data + 6, length + header_size - 6);
+    if (actual_crc != expected_crc) {
+      return true;
+    }
+  }
+  compressed_ = true;
+  return true;
+}
+
 bool Reader::ReadRecord(Slice* record, std::string* scratch) {
   if (last_record_offset_ < initial_offset_) {
     if (!SkipToInitialBlock()) {
@@ -82,6 +134,7 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
     const unsigned int record_type = ReadPhysicalRecord(&fragment);
     switch (record_type) {
       case kFullType:
+      case kRecyclableFullType:
         if (in_fragmented_record) {
           // Handle bug in earlier versions of log::Writer where
           // it could emit an empty kFirstType record at the tail end
@@ -97,9 +150,13 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
         scratch->clear();
         *record = fragment;
         last_record_offset_ = prospective_record_offset;
+        if (compressed_ && !UncompressRecord(record, scratch)) {
+          break;
+        }
         return true;
 
       case kFirstType:
+      case kRecyclableFirstType:
         if (in_fragmented_record) {
           // Handle bug in earlier versions of log::Writer where
           // it could emit an empty kFirstType record at the tail end
@@ -117,6 +174,7 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
         break;
 
       case kMiddleType:
+      case kRecyclableMiddleType:
         if (!in_fragmented_record) {
           ReportCorruption(fragment.size(),
                            "missing start of fragmented record(1)");
@@ -126,6 +184,7 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
         break;
 
       case kLastType:
+      case kRecyclableLastType:
         if (!in_fragmented_record) {
           ReportCorruption(fragment.size(),
                            "missing start of fragmented record(2)");
@@ -133,11 +192,32 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
           scratch->append(fragment.data(), fragment.size());
           *record = Slice(*scratch);
           last_record_offset_ = prospective_record_offset;
+          in_fragmented_record = false;
+          if (compressed_ && !UncompressRecord(record, scratch)) {
+            break;
+          }
           return true;
         }
         break;
 
+      case kSetCompressionType:
+      case kRecyclableSetCompressionType:
+        if (in_fragmented_record) {
+          ReportCorruption(scratch->size(), "partial record without end(3)");
+          in_fragmented_record = false;
+          scratch->clear();
+        }
+        if (fragment.size() != 1) {
+          ReportCorruption(fragment.size(), "bad compression type record");
+        } else {
+          compressed_ = true;
+        }
+        break;
+
       case kEof:
+        // A corruption not followed by any valid record of a recycled log
+        // was a torn write at its end
+        pending_drop_bytes_ = 0;
         if (in_fragmented_record) {
           // This can be caused by the writer dying immediately after
           //  writing a physical record but before completing the next; don't
@@ -146,9 +226,17 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
         }
         return false;
 
+      case kOldRecord:
+        // What follows was written to a previous incarnation of this
+        // recycled log file; treat it like the end of the log.
+        pending_drop_bytes_ = 0;
+        scratch->clear();
+        return false;
+
       case kBadRecord:
         if (in_fragmented_record) {
-          ReportCorruption(scratch->size(), "error in middle of record");
+          ReportPossibleTailCorruption(scratch->size(),
+                                       "error in middle of record");
           in_fragmented_record = false;
           scratch->clear();
         }
@@ -236,10 +324,81 @@ void Reader::UnmarkEOF() {
   }
 }
 
+bool Reader::UncompressRecord(Slice* record, std::string* scratch) {
+  // Same formats as compressed blocks in format_version 2 tables
+  const uint32_t kCompressFormatVersion = 2;
+  if (record->empty()) {
+    ReportCorruption(0, "missing record compression type");
+    return false;
+  }
+  const char* data = record->data();
+  const size_t n = record->size() - 1;
+  const CompressionType type = static_cast<CompressionType>((*record)[n]);
+  if (type == kNoCompression) {
+    record->remove_suffix(1);
+    return true;
+  }
+
+  std::unique_ptr<char[]> ubuf;
+  int decompress_size = 0;
+  switch (type) {
+    case kSnappyCompression: {
+      size_t ulength = 0;
+      if (Snappy_GetUncompressedLength(data, n, &ulength)) {
+        ubuf.reset(new char[ulength]);
+        if (Snappy_Uncompress(data, n, ubuf.get())) {
+          decompress_size = static_cast<int>(ulength);
+        } else {
+          ubuf.reset();
+        }
+      }
+      break;
+    }
+    case kZlibCompression:
+      ubuf.reset(Zlib_Uncompress(data, n, &decompress_size,
+                                 kCompressFormatVersion));
+      break;
+    case kBZip2Compression:
+      ubuf.reset(BZip2_Uncompress(data, n, &decompress_size,
+                                  kCompressFormatVersion));
+      break;
+    case kLZ4Compression:
+    case kLZ4HCCompression:
+      ubuf.reset(LZ4_Uncompress(data, n, &decompress_size,
+                                kCompressFormatVersion));
+      break;
+    default:
+      break;
+  }
+  if (!ubuf) {
+    ReportCorruption(record->size(),
+                     "compression not supported or corrupted record");
+    scratch->clear();
+    return false;
+  }
+  scratch->assign(ubuf.get(), decompress_size);
+  *record = Slice(*scratch);
+  return true;
+}
+
 void Reader::ReportCorruption(size_t bytes, const char* reason) {
   ReportDrop(bytes, Status::Corruption(reason));
 }
 
+void Reader::ReportPossibleTailCorruption(size_t bytes, const char* reason) {
+  if (!recycled_) {
+    ReportCorruption(bytes, reason);
+    return;
+  }
+  if (reporter_ != nullptr &&
+      end_of_buffer_offset_ - buffer_.size() - bytes >= initial_offset_) {
+    if (pending_drop_bytes_ == 0) {
+      pending_drop_reason_ = reason;
+    }
+    pending_drop_bytes_ += bytes;
+  }
+}
+
 void Reader::ReportDrop(size_t bytes, const Status& reason) {
   if (reporter_ != nullptr &&
       end_of_buffer_offset_ - buffer_.size() - bytes >= initial_offset_) {
@@ -281,9 +440,36 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
     const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
     const unsigned int type = header[6];
     const uint32_t length = a | (b << 8);
-    if (kHeaderSize + length > buffer_.size()) {
+    int header_size = kHeaderSize;
+    if (IsRecyclableType(type)) {
+      recycled_ = true;
+      header_size = kRecyclableHeaderSize;
+      // A writer never splits a recyclable header across blocks
+      if (buffer_.size() < static_cast<size_t>(kRecyclableHeaderSize)) {
+        size_t drop_size = buffer_.size();
+        buffer_.clear();
+        ReportPossibleTailCorruption(drop_size, "truncated record header");
+        return kBadRecord;
+      }
+      const uint32_t log_num = DecodeFixed32(header + 7);
+      if (log_num != static_cast<uint32_t>(log_number_)) {
+        buffer_.clear();
+        return kOldRecord;
+      }
+    } else if (recycled_ && type != kZeroType) {
+      // A recycled log only holds recyclable records
       size_t drop_size = buffer_.size();
       buffer_.clear();
+      ReportPossibleTailCorruption(drop_size, "bad record type");
+      return kBadRecord;
+    }
+    if (header_size + length > buffer_.size()) {
+      size_t drop_size = buffer_.size();
+      buffer_.clear();
+      if (recycled_ && !eof_) {
+        ReportPossibleTailCorruption(drop_size, "bad record length");
+        return kBadRecord;
+      }
       if (!eof_) {
         ReportCorruption(drop_size, "bad record length");
         return kBadRecord;
@@ -307,7 +493,7 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
     // Check crc
     if (checksum_) {
       uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(header));
-      uint32_t actual_crc = crc32c::Value(header + 6, 1 + length);
+      uint32_t actual_crc = crc32c::Value(header + 6, length + header_size - 6);
       if (actual_crc != expected_crc) {
         // Drop the rest of the buffer since "length" itself may have
         // been corrupted and if we trust it, we could find some
@@ -315,21 +501,31 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
         // like a valid log record.
         size_t drop_size = buffer_.size();
         buffer_.clear();
-        ReportCorruption(drop_size, "checksum mismatch");
+        ReportPossibleTailCorruption(drop_size, "checksum mismatch");
         return kBadRecord;
       }
     }
 
-    buffer_.remove_prefix(kHeaderSize + length);
+    buffer_.remove_prefix(header_size + length);
+
+    if (pending_drop_bytes_ > 0) {
+      // A valid record follows the corruption, which was not the torn end
+      // of the log
+      reporter_->Corruption(pending_drop_bytes_,
+                            Status::Corruption(pending_drop_reason_));
+      pending_drop_bytes_ = 0;
+    }
 
-    // Skip physical record that started before initial_offset_
-    if (end_of_buffer_offset_ - buffer_.size() - kHeaderSize - length <
-        initial_offset_) {
+    // Skip physical record that started before initial_offset_, but not
+    // the kSetCompressionType record, which applies to all the others
+    if (end_of_buffer_offset_ - buffer_.size() - header_size - length <
+            initial_offset_ &&
+        type != kSetCompressionType && type != kRecyclableSetCompressionType) {
       result->clear();
       return kBadRecord;
     }
 
-    *result = Slice(header + kHeaderSize, length);
+    *result = Slice(header + header_size, length);
     return type;
   }
 }
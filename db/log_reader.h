@@ -45,8 +45,18 @@ class Reader {
   //
   // The Reader will start reading at the first record located at physical
   // position >= initial_offset within the file.
+  //
+  // "log_num" is the number of the log file being read. Records written
+  // in the recyclable format for any other log number are left over from
+  // a previous use of the file and end the log. Other bad records of a
+  // recycled log are reported, unless no valid record of the log follows
+  // them: the log then ends with a torn write over the previous contents
+  // of the file.
+  //
+  // Records of logs that start with a kSetCompressionType record are
+  // returned uncompressed, whatever initial_offset is.
   Reader(unique_ptr<SequentialFile>&& file, Reporter* reporter,
-         bool checksum, uint64_t initial_offset);
+         bool checksum, uint64_t initial_offset, uint64_t log_num = 0);
 
   ~Reader();
 
@@ -97,6 +107,20 @@ class Reader {
   // Offset at which to start looking for the first record to return
   uint64_t const initial_offset_;
 
+  // which log number this is
+  uint64_t const log_number_;
+
+  // Whether this is a recycled log file
+  bool recycled_;
+
+  // Corruption found in a recycled log, reported once a valid record of
+  // the log follows it, or dropped if the log ends first
+  size_t pending_drop_bytes_;
+  std::string pending_drop_reason_;
+
+  // Whether the records of this log are compressed
+  bool compressed_;
+
   // Extend record types with the following special values
   enum {
     kEof = kMaxRecordType + 1,
@@ -105,7 +129,11 @@ class Reader {
     // * The record has an invalid CRC (ReadPhysicalRecord reports a drop)
     // * The record is a 0-length record (No drop is reported)
     // * The record is below constructor's initial_offset (No drop is reported)
-    kBadRecord = kMaxRecordType + 2
+    kBadRecord = kMaxRecordType + 2,
+    // Returned when we find a record left over from a previous use of a
+    // recycled log file, as told by its log number. No drop is reported
+    // and the log ends here.
+    kOldRecord = kMaxRecordType + 3
   };
 
   // Skips all blocks that are completely before "initial_offset_".
@@ -113,13 +141,28 @@ class Reader {
   // Returns true on success. Handles reporting.
   bool SkipToInitialBlock();
 
+  // Reads the beginning of the file, before anything else was read, and
+  // sets compressed_ if it is a kSetCompressionType record. Sets
+  // *bytes_read to the number of bytes read.
+  //
+  // Returns true on success. Handles reporting.
+  bool ReadCompressionType(size_t* bytes_read);
+
   // Return type, or one of the preceding special values
   unsigned int ReadPhysicalRecord(Slice* result);
 
+  // Replaces the compressed *record by its uncompressed contents, stored
+  // in *scratch. Returns false, after reporting the drop, if the record
+  // cannot be uncompressed.
+  bool UncompressRecord(Slice* record, std::string* scratch);
+
   // Reports dropped bytes to the reporter.
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
   void ReportCorruption(size_t bytes, const char* reason);
   void ReportDrop(size_t bytes, const Status& reason);
+  // Like ReportCorruption(), but in a recycled log the report waits until
+  // a valid record of the log shows that the bad data was not its tail
+  void ReportPossibleTailCorruption(size_t bytes, const char* reason);
 
   // No copying allowed
   Reader(const Reader&);
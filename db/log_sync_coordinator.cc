@@ -0,0 +1,99 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/log_sync_coordinator.h"
+
+#include "rocksdb/env.h"
+#include "rocksdb/statistics.h"
+#include "util/mutexlock.h"
+#include "util/statistics.h"
+#include "util/stop_watch.h"
+#include "util/sync_point.h"
+
+namespace rocksdb {
+namespace log {
+
+SyncCoordinator::SyncCoordinator(WritableFile* file, bool use_fsync, Env* env,
+                                 Statistics* stats)
+    : file_(file),
+      use_fsync_(use_fsync),
+      env_(env),
+      stats_(stats),
+      cv_(&mu_),
+      appended_(0),
+      synced_(0),
+      syncing_(false),
+      retired_(false) {
+  assert(file_->IsSyncThreadSafe());
+}
+
+uint64_t SyncCoordinator::NoteAppended(uint64_t bytes) {
+  MutexLock l(&mu_);
+  assert(!retired_);
+  appended_ += bytes;
+  return appended_;
+}
+
+Status SyncCoordinator::SyncUpTo(uint64_t ticket) {
+  MutexLock l(&mu_);
+  while (synced_ < ticket) {
+    if (retired_) {
+      // Retire() synced every ticket, unless it failed
+      return retire_status_;
+    }
+    if (syncing_) {
+      // The running sync may not cover us; check again when it is done
+      cv_.Wait();
+      continue;
+    }
+    Status s = SyncLocked();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
+Status SyncCoordinator::Retire() {
+  MutexLock l(&mu_);
+  while (syncing_) {
+    cv_.Wait();
+  }
+  if (!retired_) {
+    if (synced_ < appended_) {
+      retire_status_ = SyncLocked();
+    }
+    retired_ = true;
+  }
+  return retire_status_;
+}
+
+Status SyncCoordinator::SyncLocked() {
+  mu_.AssertHeld();
+  assert(!syncing_);
+  syncing_ = true;
+  const uint64_t target = appended_;
+  mu_.Unlock();
+
+  TEST_SYNC_POINT("SyncCoordinator::Sync:1");
+  TEST_SYNC_POINT("SyncCoordinator::Sync:2");
+  Status s;
+  {
+    StopWatch sw(env_, stats_, WAL_FILE_SYNC_MICROS);
+    s = file_->SyncWithoutFlush(use_fsync_);
+  }
+  RecordTick(stats_, WAL_FILE_SYNCED);
+
+  mu_.Lock();
+  syncing_ = false;
+  if (s.ok() && target > synced_) {
+    synced_ = target;
+  }
+  cv_.SignalAll();
+  return s;
+}
+
+}  // namespace log
+}  // namespace rocksdb
@@ -0,0 +1,74 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+
+#include "port/port.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+class Env;
+class Statistics;
+class WritableFile;
+
+namespace log {
+
+// Group commit for the syncs of one log file.
+//
+// After appending records that must be synced, the appending thread calls
+// NoteAppended(), which returns a ticket, and may then leave the write
+// queue and wait in SyncUpTo() until the file is synced past its ticket.
+// Only one sync runs at a time, and it covers every append made before it
+// started, so all the writers that append while a sync is in flight share
+// the next one.
+//
+// Requires a file for which WritableFile::IsSyncThreadSafe() is true.
+class SyncCoordinator {
+ public:
+  SyncCoordinator(WritableFile* file, bool use_fsync, Env* env,
+                  Statistics* stats);
+
+  // Records that "bytes" that must be synced were appended (and flushed)
+  // to the file. Returns the ticket to pass to SyncUpTo().
+  // REQUIRES: the caller is the only thread appending to the file
+  uint64_t NoteAppended(uint64_t bytes);
+
+  // Waits until everything appended up to "ticket" is synced, syncing the
+  // file if no other thread is doing it.
+  Status SyncUpTo(uint64_t ticket);
+
+  // Syncs whatever was noted and has not been synced yet, and
+  // stops using the file, so that it can be closed. Later SyncUpTo()
+  // calls return without touching the file.
+  // REQUIRES: nothing is appended to the file any more
+  Status Retire();
+
+ private:
+  // Syncs everything appended so far.
+  // REQUIRES: mu_ held and no sync running
+  Status SyncLocked();
+
+  WritableFile* const file_;
+  const bool use_fsync_;
+  Env* const env_;
+  Statistics* const stats_;
+
+  port::Mutex mu_;
+  port::CondVar cv_;
+  uint64_t appended_;         // bytes noted by NoteAppended()
+  uint64_t synced_;           // everything up to here is synced
+  bool syncing_;              // a thread is syncing the file
+  bool retired_;
+  Status retire_status_;
+
+  // No copying allowed
+  SyncCoordinator(const SyncCoordinator&);
+  void operator=(const SyncCoordinator&);
+};
+
+}  // namespace log
+}  // namespace rocksdb
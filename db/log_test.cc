@@ -7,13 +7,18 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+#include <algorithm>
+
+#include "db/log_prefetch_reader.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/random.h"
 #include "util/testharness.h"
+#include "util/testutil.h"
 
 namespace rocksdb {
 namespace log {
@@ -297,6 +302,72 @@ class LogTest {
     ASSERT_TRUE(!offset_reader->ReadRecord(&record, &scratch));
   }
 
+  // Returns the contents of a log file "log_number" holding "records"
+  static std::string WriteLog(
+      const std::vector<std::string>& records, uint64_t log_number,
+      bool recycle_log_files,
+      CompressionType compression = kNoCompression) {
+    Slice unused;
+    unique_ptr<StringDest> dest(new StringDest(unused));
+    Writer writer(std::move(dest), log_number, recycle_log_files,
+                  compression);
+    for (const auto& record : records) {
+      writer.AddRecord(Slice(record));
+    }
+    return dynamic_cast<StringDest*>(writer.file())->contents_;
+  }
+
+  // Returns the records read from "contents" as log file "log_number",
+  // starting at "initial_offset". Their offsets go to "*offsets" if it is
+  // not nullptr.
+  static std::vector<std::string> ReadLog(
+      const std::string& contents, uint64_t log_number, size_t* dropped_bytes,
+      uint64_t initial_offset = 0, std::vector<uint64_t>* offsets = nullptr) {
+    Slice source_contents(contents);
+    unique_ptr<StringSource> source(new StringSource(source_contents));
+    ReportCollector report;
+    Reader reader(std::move(source), &report, true /*checksum*/,
+                  initial_offset, log_number);
+    std::vector<std::string> records;
+    std::string scratch;
+    Slice record;
+    while (reader.ReadRecord(&record, &scratch)) {
+      records.push_back(record.ToString());
+      if (offsets != nullptr) {
+        offsets->push_back(reader.LastRecordOffset());
+      }
+    }
+    *dropped_bytes = report.dropped_bytes_;
+    return records;
+  }
+
+  // Read the log again with a PrefetchReader, which must return the same
+  // records and report the same corruptions as the plain reader did
+  void CheckPrefetchReader(const std::vector<std::string>& expected,
+                           size_t max_buffered_bytes,
+                           size_t max_records = SIZE_MAX) {
+    Slice contents(dest_contents());
+    unique_ptr<StringSource> source(new StringSource(contents));
+    ReportCollector report;
+    PrefetchReader prefetch_reader(std::move(source), &report,
+                                   true /*checksum*/, 0 /*initial_offset*/,
+                                   0 /*log_num*/, max_buffered_bytes);
+    Slice record;
+    std::string scratch;
+    size_t count = 0;
+    while (count < max_records &&
+           prefetch_reader.ReadRecord(&record, &scratch)) {
+      ASSERT_LT(count, expected.size());
+      ASSERT_EQ(expected[count], record.ToString());
+      count++;
+    }
+    if (count < max_records) {
+      ASSERT_EQ(expected.size(), count);
+      ASSERT_EQ(report_.dropped_bytes_, report.dropped_bytes_);
+      ASSERT_EQ(report_.message_, report.message_);
+    }
+  }
+
   void CheckInitialOffsetRecord(uint64_t initial_offset,
                                 int expected_record_offset) {
     WriteInitialOffsetLog();
@@ -681,6 +752,167 @@ TEST(LogTest, ClearEofError2) {
   ASSERT_EQ("OK", MatchError("read error"));
 }
 
+TEST(LogTest, PrefetchReader) {
+  for (int i = 0; i < 500; i++) {
+    Write(BigString(NumberString(i), (i * 37) % 3000 + 1));
+  }
+  // Corrupt a record in the middle of the log
+  IncrementByte(static_cast<int>(WrittenBytes() / 2), 1);
+
+  // What a plain Reader returns and reports
+  std::vector<std::string> expected;
+  for (std::string record = Read(); record != "EOF"; record = Read()) {
+    expected.push_back(record);
+  }
+  ASSERT_GT(DroppedBytes(), 0U);
+  ASSERT_LT(expected.size(), 500U);
+
+  // Small enough that the background thread has to wait for us
+  CheckPrefetchReader(expected, 1000);
+  CheckPrefetchReader(expected, 1 << 20);
+  // Stopping early does not wait for the rest of the log
+  CheckPrefetchReader(expected, 1000, 1);
+}
+
+TEST(LogTest, RecycleLog) {
+  Random rnd(301);
+  std::vector<std::string> old_records;
+  for (int i = 0; i < 100; i++) {
+    old_records.push_back(RandomSkewedString(i, &rnd));
+  }
+  std::vector<std::string> new_records(old_records.begin(),
+                                       old_records.begin() + 10);
+  for (auto& record : new_records) {
+    record += "new";
+  }
+  const std::string new_contents = WriteLog(new_records, 2, true);
+
+  size_t dropped_bytes;
+  ASSERT_TRUE(old_records ==
+              ReadLog(WriteLog(old_records, 1, true), 1, &dropped_bytes));
+  ASSERT_EQ(0U, dropped_bytes);
+
+  // Log 2 overwrites the start of log 1, written with or without the
+  // recyclable format
+  for (bool old_recycle : {true, false}) {
+    std::string contents = WriteLog(old_records, 1, old_recycle);
+    ASSERT_GT(contents.size(), new_contents.size());
+    contents.replace(0, new_contents.size(), new_contents);
+
+    ASSERT_TRUE(new_records == ReadLog(contents, 2, &dropped_bytes));
+    ASSERT_EQ(0U, dropped_bytes);
+
+    // The last record of log 2 was only partially written
+    contents = WriteLog(old_records, 1, old_recycle);
+    contents.replace(0, new_contents.size() - 3,
+                     new_contents.substr(0, new_contents.size() - 3));
+    std::vector<std::string> records = ReadLog(contents, 2, &dropped_bytes);
+    ASSERT_EQ(new_records.size() - 1, records.size());
+    ASSERT_TRUE(std::equal(records.begin(), records.end(),
+                           new_records.begin()));
+    ASSERT_EQ(0U, dropped_bytes);
+  }
+}
+
+TEST(LogTest, RecycleLogCorruption) {
+  Random rnd(301);
+  std::vector<std::string> old_records;
+  for (int i = 0; i < 100; i++) {
+    std::string record;
+    test::RandomString(&rnd, 5000, &record);
+    old_records.push_back(record);
+  }
+  // Log 2 spans several blocks
+  std::vector<std::string> new_records;
+  for (int i = 0; i < 30; i++) {
+    std::string record;
+    test::RandomString(&rnd, 5000, &record);
+    new_records.push_back(record);
+  }
+  const std::string new_contents = WriteLog(new_records, 2, true);
+  ASSERT_GT(new_contents.size(), 3U * kBlockSize);
+
+  // A corruption in the first block of log 2 is reported: the records in
+  // the next blocks show that it was not the end of the log
+  std::string contents = WriteLog(old_records, 1, true);
+  ASSERT_GT(contents.size(), new_contents.size());
+  contents.replace(0, new_contents.size(), new_contents);
+  contents[kRecyclableHeaderSize + 100] ^= 1;
+  size_t dropped_bytes;
+  std::vector<std::string> records = ReadLog(contents, 2, &dropped_bytes);
+  ASSERT_GT(dropped_bytes, 0U);
+  ASSERT_GT(records.size(), 0U);
+  ASSERT_EQ(new_records.back(), records.back());
+  ASSERT_LT(records.size(), new_records.size());
+}
+
+TEST(LogTest, CompressedRecords) {
+  Random rnd(301);
+  std::vector<std::string> records;
+  records.push_back("");
+  for (int i = 0; i < 50; i++) {
+    // Compressible records, some of them fragmented
+    records.push_back(std::string(rnd.Skewed(17), static_cast<char>('a' + i)));
+    // Records that do not compress
+    std::string random;
+    test::RandomString(&rnd, rnd.Skewed(12), &random);
+    records.push_back(random);
+  }
+  std::string uncompressed_contents = WriteLog(records, 1, false);
+
+  for (CompressionType type :
+       {kSnappyCompression, kZlibCompression, kBZip2Compression,
+        kLZ4Compression, kLZ4HCCompression}) {
+    for (bool recycle : {true, false}) {
+      std::string contents = WriteLog(records, 1, recycle, type);
+      size_t dropped_bytes;
+      ASSERT_TRUE(records == ReadLog(contents, 1, &dropped_bytes));
+      ASSERT_EQ(0U, dropped_bytes);
+    }
+  }
+
+  std::string compressed;
+  if (Zlib_Compress(CompressionOptions(), 2, "a", 1, &compressed)) {
+    std::string contents = WriteLog(records, 1, false, kZlibCompression);
+    ASSERT_LT(contents.size(), uncompressed_contents.size() / 2);
+  }
+}
+
+TEST(LogTest, CompressedRecordsFromInitialOffset) {
+  Random rnd(301);
+  std::vector<std::string> records;
+  for (int i = 0; i < 20; i++) {
+    std::string random;
+    test::RandomString(&rnd, 5000, &random);
+    records.push_back(std::string(5000, static_cast<char>('a' + i)) + random);
+  }
+
+  for (bool recycle : {true, false}) {
+    // Without snappy, records are stored uncompressed, followed by the
+    // kNoCompression byte
+    std::string contents = WriteLog(records, 1, recycle, kSnappyCompression);
+
+    size_t dropped_bytes;
+    std::vector<uint64_t> offsets;
+    ASSERT_TRUE(records == ReadLog(contents, 1, &dropped_bytes, 0, &offsets));
+
+    // Whether in the first block or a later one, the records after the
+    // initial offset are returned uncompressed
+    for (uint64_t initial_offset : {static_cast<uint64_t>(1), offsets[1],
+                                    static_cast<uint64_t>(kBlockSize + 1),
+                                    offsets[15] - 1}) {
+      size_t first = std::lower_bound(offsets.begin(), offsets.end(),
+                                      initial_offset) -
+                     offsets.begin();
+      std::vector<std::string> expected(records.begin() + first,
+                                        records.end());
+      ASSERT_TRUE(expected ==
+                  ReadLog(contents, 1, &dropped_bytes, initial_offset));
+      ASSERT_EQ(0U, dropped_bytes);
+    }
+  }
+}
+
 }  // namespace log
 }  // namespace rocksdb
 
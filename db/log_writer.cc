@@ -12,14 +12,20 @@
 #include <stdint.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 
 namespace rocksdb {
 namespace log {
 
-Writer::Writer(unique_ptr<WritableFile>&& dest)
+Writer::Writer(unique_ptr<WritableFile>&& dest, uint64_t log_number,
+               bool recycle_log_files, CompressionType compression)
     : dest_(std::move(dest)),
-      block_offset_(0) {
+      block_offset_(0),
+      log_number_(log_number),
+      recycle_log_files_(recycle_log_files),
+      compression_(compression),
+      compression_type_recorded_(false) {
   for (int i = 0; i <= kMaxRecordType; i++) {
     char t = static_cast<char>(i);
     type_crc_[i] = crc32c::Value(&t, 1);
@@ -30,43 +36,66 @@ Writer::~Writer() {
 }
 
 Status Writer::AddRecord(const Slice& slice) {
+  Status s;
   const char* ptr = slice.data();
   size_t left = slice.size();
+  if (compression_ != kNoCompression) {
+    if (!compression_type_recorded_) {
+      // Nothing was written yet, so the record fits in the first block
+      assert(block_offset_ == 0);
+      const char type = static_cast<char>(compression_);
+      s = EmitPhysicalRecord(recycle_log_files_ ? kRecyclableSetCompressionType
+                                                : kSetCompressionType,
+                             &type, 1);
+      if (!s.ok()) {
+        return s;
+      }
+      compression_type_recorded_ = true;
+    }
+    CompressRecord(slice);
+    ptr = compressed_.data();
+    left = compressed_.size();
+  }
 
   // Fragment the record if necessary and emit it.  Note that if slice
   // is empty, we still want to iterate once to emit a single
   // zero-length record
-  Status s;
+  // Header size varies depending on whether we are recycling or not.
+  const int header_size =
+      recycle_log_files_ ? kRecyclableHeaderSize : kHeaderSize;
+
   bool begin = true;
   do {
     const int leftover = kBlockSize - block_offset_;
     assert(leftover >= 0);
-    if (leftover < kHeaderSize) {
+    if (leftover < header_size) {
       // Switch to a new block
       if (leftover > 0) {
-        // Fill the trailer (literal below relies on kHeaderSize being 7)
-        assert(kHeaderSize == 7);
-        dest_->Append(Slice("\x00\x00\x00\x00\x00\x00", leftover));
+        // Fill the trailer (literal below relies on header_size being at
+        // most 11)
+        assert(header_size <= 11);
+        dest_->Append(
+            Slice("\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", leftover));
       }
       block_offset_ = 0;
     }
 
-    // Invariant: we never leave < kHeaderSize bytes in a block.
-    assert(kBlockSize - block_offset_ - kHeaderSize >= 0);
+    // Invariant: we never leave < header_size bytes in a block.
+    assert(static_cast<int>(kBlockSize - block_offset_) >= header_size);
 
-    const size_t avail = kBlockSize - block_offset_ - kHeaderSize;
+    const size_t avail = kBlockSize - block_offset_ - header_size;
     const size_t fragment_length = (left < avail) ? left : avail;
 
     RecordType type;
     const bool end = (left == fragment_length);
     if (begin && end) {
-      type = kFullType;
+      type = recycle_log_files_ ? kRecyclableFullType : kFullType;
     } else if (begin) {
-      type = kFirstType;
+      type = recycle_log_files_ ? kRecyclableFirstType : kFirstType;
     } else if (end) {
-      type = kLastType;
+      type = recycle_log_files_ ? kRecyclableLastType : kLastType;
     } else {
-      type = kMiddleType;
+      type = recycle_log_files_ ? kRecyclableMiddleType : kMiddleType;
     }
 
     s = EmitPhysicalRecord(type, ptr, fragment_length);
@@ -79,30 +108,87 @@ Status Writer::AddRecord(const Slice& slice) {
 
 Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   assert(n <= 0xffff);  // Must fit in two bytes
-  assert(block_offset_ + kHeaderSize + n <= kBlockSize);
+
+  size_t header_size;
+  char buf[kRecyclableHeaderSize];
 
   // Format the header
-  char buf[kHeaderSize];
   buf[4] = static_cast<char>(n & 0xff);
   buf[5] = static_cast<char>(n >> 8);
   buf[6] = static_cast<char>(t);
 
+  uint32_t crc = type_crc_[t];
+  if (!IsRecyclableType(t)) {
+    // Legacy record format
+    assert(block_offset_ + kHeaderSize + n <= kBlockSize);
+    header_size = kHeaderSize;
+  } else {
+    // Recyclable record format
+    assert(block_offset_ + kRecyclableHeaderSize + n <= kBlockSize);
+    header_size = kRecyclableHeaderSize;
+
+    // Only encode low 32-bits of the 64-bit log number.  This means
+    // we will fail to detect an old record if we recycled a log from
+    // ~4 billion logs ago, but that is effectively impossible, and
+    // even if it were we'd detect a junk record as a checksum mismatch.
+    EncodeFixed32(buf + 7, static_cast<uint32_t>(log_number_));
+    crc = crc32c::Extend(crc, buf + 7, 4);
+  }
+
   // Compute the crc of the record type and the payload.
-  uint32_t crc = crc32c::Extend(type_crc_[t], ptr, n);
+  crc = crc32c::Extend(crc, ptr, n);
   crc = crc32c::Mask(crc);                 // Adjust for storage
   EncodeFixed32(buf, crc);
 
   // Write the header and the payload
-  Status s = dest_->Append(Slice(buf, kHeaderSize));
+  Status s = dest_->Append(Slice(buf, header_size));
   if (s.ok()) {
     s = dest_->Append(Slice(ptr, n));
     if (s.ok()) {
       s = dest_->Flush();
     }
   }
-  block_offset_ += kHeaderSize + n;
+  block_offset_ += static_cast<int>(header_size + n);
   return s;
 }
 
+void Writer::CompressRecord(const Slice& record) {
+  // Same formats as compressed blocks in format_version 2 tables
+  const uint32_t kCompressFormatVersion = 2;
+  CompressionOptions opts;
+  bool ok = false;
+  compressed_.clear();
+  switch (compression_) {
+    case kSnappyCompression:
+      ok = Snappy_Compress(opts, record.data(), record.size(), &compressed_);
+      break;
+    case kZlibCompression:
+      ok = Zlib_Compress(opts, kCompressFormatVersion, record.data(),
+                         record.size(), &compressed_);
+      break;
+    case kBZip2Compression:
+      ok = BZip2_Compress(opts, kCompressFormatVersion, record.data(),
+                          record.size(), &compressed_);
+      break;
+    case kLZ4Compression:
+      ok = LZ4_Compress(opts, kCompressFormatVersion, record.data(),
+                        record.size(), &compressed_);
+      break;
+    case kLZ4HCCompression:
+      ok = LZ4HC_Compress(opts, kCompressFormatVersion, record.data(),
+                          record.size(), &compressed_);
+      break;
+    default:
+      break;
+  }
+  // Keep the compressed form only if it saves at least 12.5%
+  if (ok && compressed_.size() < record.size() - (record.size() / 8u)) {
+    compressed_.push_back(static_cast<char>(compression_));
+  } else {
+    compressed_.assign(record.data(), record.size());
+    compressed_.push_back(static_cast<char>(kNoCompression));
+  }
+}
+
 }  // namespace log
 }  // namespace rocksdb
@@ -10,7 +10,9 @@
 #pragma once
 #include <memory>
 #include <stdint.h>
+#include <string>
 #include "db/log_format.h"
+#include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
@@ -25,9 +27,19 @@ namespace log {
 class Writer {
  public:
   // Create a writer that will append data to "*dest".
-  // "*dest" must be initially empty.
+  // "*dest" must be initially empty, unless "recycle_log_files" is true,
+  // in which case it may be an old log file that is being overwritten.
   // "*dest" must remain live while this Writer is in use.
-  explicit Writer(unique_ptr<WritableFile>&& dest);
+  //
+  // If "recycle_log_files" is true, records are written with the
+  // recyclable record types, which carry "log_number" so that a Reader
+  // can tell them apart from what is left of a previous log in the file.
+  //
+  // If "compression" is not kNoCompression, the log starts with a
+  // kSetCompressionType record and every record is compressed with it.
+  explicit Writer(unique_ptr<WritableFile>&& dest, uint64_t log_number = 0,
+                  bool recycle_log_files = false,
+                  CompressionType compression = kNoCompression);
   ~Writer();
 
   Status AddRecord(const Slice& slice);
@@ -38,6 +50,11 @@ class Writer {
  private:
   unique_ptr<WritableFile> dest_;
   int block_offset_;       // Current offset in block
+  uint64_t log_number_;
+  bool recycle_log_files_;
+  CompressionType compression_;
+  bool compression_type_recorded_;
+  std::string compressed_;  // reused to compress every record
 
   // crc32c values for all supported record types.  These are
   // pre-computed to reduce the overhead of computing the crc of the
@@ -46,6 +63,10 @@ class Writer {
 
   Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
 
+  // Compresses "record" into compressed_, followed by the CompressionType
+  // actually used, which is kNoCompression if it did not compress well.
+  void CompressRecord(const Slice& record);
+
   // No copying allowed
   Writer(const Writer&);
   void operator=(const Writer&);
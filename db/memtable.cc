@@ -204,6 +204,7 @@ class MemTableIterator: public Iterator {
       : bloom_(nullptr),
         prefix_extractor_(mem.prefix_extractor_),
         valid_(false),
+        value_pinned_(!mem.moptions_.inplace_update_support),
         arena_mode_(arena != nullptr) {
     if (prefix_extractor_ != nullptr && !read_options.total_order_seek) {
       bloom_ = mem.prefix_bloom_.get();
@@ -261,11 +262,17 @@ class MemTableIterator: public Iterator {
 
   virtual Status status() const { return Status::OK(); }
 
+  // Entries live in the memtable arena, which outlives the iterator. Values
+  // may be overwritten in place when inplace_update_support is enabled.
+  virtual bool IsKeyPinned() const override { return true; }
+  virtual bool IsValuePinned() const override { return value_pinned_; }
+
  private:
   DynamicBloom* bloom_;
   const SliceTransform* const prefix_extractor_;
   MemTableRep::Iterator* iter_;
   bool valid_;
+  bool value_pinned_;
   bool arena_mode_;
 
   // No copying allowed
@@ -215,7 +215,7 @@ class Repairer {
     // propagating bad information (like overly large sequence
     // numbers).
     log::Reader reader(std::move(lfile), &reporter, false/*do not checksum*/,
-                       0/*initial_offset*/);
+                       0/*initial_offset*/, log);
 
     // Read all the records and add to a memtable
     std::string scratch;
@@ -0,0 +1,319 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "db/stats_history.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "db/filename.h"
+#include "util/logging.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+namespace {
+// Every record starts with its time, so that it can be read without
+// parsing the rest
+const char kRecordTimePrefix[] = "{\"time_micros\":";
+
+// Bytes read from a stats file at a time by GetHistory()
+const size_t kReadSize = 64 * 1024;
+}  // namespace
+
+StatsRecordWriter::StatsRecordWriter() : first_(true) {}
+
+void StatsRecordWriter::BeginObject(const char* name) {
+  AddKey(name);
+  out_.push_back('{');
+  first_ = true;
+}
+
+void StatsRecordWriter::EndObject() {
+  out_.push_back('}');
+  first_ = false;
+}
+
+void StatsRecordWriter::BeginArray(const char* name) {
+  AddKey(name);
+  out_.push_back('[');
+  first_ = true;
+}
+
+void StatsRecordWriter::EndArray() {
+  out_.push_back(']');
+  first_ = false;
+}
+
+void StatsRecordWriter::Add(const char* name, uint64_t value) {
+  AddKey(name);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%" PRIu64, value);
+  out_.append(buf);
+}
+
+void StatsRecordWriter::Add(const char* name, double value) {
+  AddKey(name);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.2f", value);
+  out_.append(buf);
+}
+
+void StatsRecordWriter::Add(const char* name, bool value) {
+  AddKey(name);
+  out_.append(value ? "true" : "false");
+}
+
+void StatsRecordWriter::Add(const char* name, const std::string& value) {
+  AddKey(name);
+  AddString(value);
+}
+
+void StatsRecordWriter::AddKey(const char* name) {
+  if (!first_) {
+    out_.push_back(',');
+  }
+  first_ = false;
+  if (name != nullptr) {
+    AddString(name);
+    out_.push_back(':');
+  }
+}
+
+void StatsRecordWriter::AddString(const std::string& value) {
+  out_.push_back('"');
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      out_.push_back('\\');
+      out_.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+      out_.append(buf);
+    } else {
+      out_.push_back(c);
+    }
+  }
+  out_.push_back('"');
+}
+
+StatsHistory::StatsHistory(Env* env, const std::string& dbname,
+                           const DBOptions& db_options)
+    : env_(env),
+      dbname_(dbname),
+      max_file_size_(db_options.stats_persist_max_file_size),
+      keep_file_num_(db_options.stats_persist_keep_file_num),
+      file_size_(0) {}
+
+void StatsHistory::AddStatistics(Statistics* statistics,
+                                 StatsRecordWriter* record) {
+  if (statistics == nullptr) {
+    return;
+  }
+  MutexLock l(&mutex_);
+  last_tickers_.resize(TICKER_ENUM_MAX, 0);
+  record->BeginObject("tickers");
+  for (const auto& ticker : TickersNameMap) {
+    uint64_t count = statistics->getTickerCount(ticker.first);
+    uint64_t& last = last_tickers_[ticker.first];
+    // A ticker set lower by setTickerCount() starts over
+    uint64_t delta = count >= last ? count - last : count;
+    last = count;
+    if (delta > 0) {
+      record->Add(ticker.second.c_str(), delta);
+    }
+  }
+  record->EndObject();
+
+  record->BeginObject("histograms");
+  for (const auto& histogram : HistogramsNameMap) {
+    HistogramData data;
+    statistics->histogramData(histogram.first, &data);
+    if (data.max == 0) {
+      continue;
+    }
+    record->BeginObject(histogram.second.c_str());
+    record->Add("p50", data.median);
+    record->Add("p95", data.percentile95);
+    record->Add("p99", data.percentile99);
+    record->Add("p99.9", data.percentile999);
+    record->Add("p99.99", data.percentile9999);
+    record->Add("max", data.max);
+    record->Add("average", data.average);
+    record->EndObject();
+  }
+  record->EndObject();
+}
+
+Status StatsHistory::Append(uint64_t now_micros,
+                            const StatsRecordWriter& record) {
+  MutexLock l(&mutex_);
+  Status s;
+  if (file_ == nullptr || file_size_ >= max_file_size_) {
+    // The STATS of a previous DB::Open() is rolled like a full one
+    if (file_ != nullptr ||
+        env_->FileExists(StatsHistoryFileName(dbname_))) {
+      s = Roll(now_micros);
+    }
+    if (s.ok()) {
+      EnvOptions env_options;
+      s = env_->NewWritableFile(StatsHistoryFileName(dbname_), &file_,
+                                env_options);
+      file_size_ = 0;
+    }
+    if (!s.ok()) {
+      file_.reset();
+      return s;
+    }
+  }
+  std::string line = record.str();
+  line.push_back('\n');
+  s = file_->Append(line);
+  if (s.ok()) {
+    s = file_->Flush();
+  }
+  file_size_ += line.size();
+  return s;
+}
+
+Status StatsHistory::Roll(uint64_t now_micros) {
+  mutex_.AssertHeld();
+  if (file_ != nullptr) {
+    file_->Close();
+    file_.reset();
+  }
+  Status s = env_->RenameFile(StatsHistoryFileName(dbname_),
+                              OldStatsHistoryFileName(dbname_, now_micros));
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::vector<std::string> children;
+  s = env_->GetChildren(dbname_, &children);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<uint64_t> old_files;
+  for (const auto& child : children) {
+    uint64_t number;
+    FileType type;
+    if (ParseFileName(child, &number, &type) && type == kStatsHistoryFile &&
+        number != 0) {
+      old_files.push_back(number);
+    }
+  }
+  std::sort(old_files.begin(), old_files.end());
+  for (size_t i = 0; i + keep_file_num_ < old_files.size(); i++) {
+    env_->DeleteFile(OldStatsHistoryFileName(dbname_, old_files[i]));
+  }
+  return Status::OK();
+}
+
+Status StatsHistory::GetHistory(uint64_t start_micros, uint64_t end_micros,
+                                std::vector<std::string>* records) {
+  records->clear();
+  // Only the listing and the opening of the files are done under the
+  // mutex, so that a concurrent Append() cannot rename or delete them in
+  // between. Reading them could take long, and is done without it.
+  std::vector<std::unique_ptr<SequentialFile>> files;
+  {
+    MutexLock l(&mutex_);
+    std::vector<std::string> children;
+    Status s = env_->GetChildren(dbname_, &children);
+    if (!s.ok()) {
+      return s;
+    }
+    std::vector<uint64_t> numbers;
+    bool has_current = false;
+    for (const auto& child : children) {
+      uint64_t number;
+      FileType type;
+      if (ParseFileName(child, &number, &type) && type == kStatsHistoryFile) {
+        if (number == 0) {
+          has_current = true;
+        } else if (number >= start_micros) {
+          // Old files are named after the time they were rolled, which is
+          // past the time of all their records
+          numbers.push_back(number);
+        }
+      }
+    }
+    // The current file is the most recent
+    std::sort(numbers.begin(), numbers.end());
+    if (has_current) {
+      numbers.push_back(0);
+    }
+    EnvOptions env_options;
+    for (uint64_t number : numbers) {
+      std::unique_ptr<SequentialFile> file;
+      s = env_->NewSequentialFile(
+          number == 0 ? StatsHistoryFileName(dbname_)
+                      : OldStatsHistoryFileName(dbname_, number),
+          &file, env_options);
+      if (!s.ok()) {
+        return s;
+      }
+      files.push_back(std::move(file));
+    }
+  }
+
+  std::unique_ptr<char[]> buffer(new char[kReadSize]);
+  for (auto& file : files) {
+    // The part of the record that the previous reads ended in
+    std::string record;
+    while (true) {
+      Slice data;
+      Status s = file->Read(kReadSize, &data, buffer.get());
+      if (!s.ok()) {
+        return s;
+      }
+      if (data.empty()) {
+        // A record left without its newline was cut short by a crash, or
+        // is being appended
+        break;
+      }
+      const char* p = data.data();
+      const char* limit = p + data.size();
+      while (p < limit) {
+        const char* end =
+            static_cast<const char*>(memchr(p, '\n', limit - p));
+        if (end == nullptr) {
+          record.append(p, limit - p);
+          break;
+        }
+        record.append(p, end - p);
+        uint64_t time = RecordTime(record);
+        if (time >= start_micros && time < end_micros) {
+          records->push_back(std::move(record));
+        }
+        record.clear();
+        p = end + 1;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+uint64_t StatsHistory::RecordTime(const std::string& record) {
+  Slice input(record);
+  const Slice prefix(kRecordTimePrefix, sizeof(kRecordTimePrefix) - 1);
+  uint64_t time;
+  if (!input.starts_with(prefix)) {
+    return 0;
+  }
+  input.remove_prefix(prefix.size());
+  if (!ConsumeDecimalNumber(&input, &time)) {
+    return 0;
+  }
+  return time;
+}
+
+}  // namespace rocksdb
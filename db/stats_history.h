@@ -0,0 +1,89 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/options.h"
+#include "rocksdb/statistics.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// Builds the JSON object of one stats record. Fields are added in order;
+// the caller nests objects and arrays with the Begin/End calls.
+class StatsRecordWriter {
+ public:
+  StatsRecordWriter();
+
+  // "name" is nullptr for the elements of an array and the outer object
+  void BeginObject(const char* name = nullptr);
+  void EndObject();
+  void BeginArray(const char* name);
+  void EndArray();
+
+  void Add(const char* name, uint64_t value);
+  void Add(const char* name, double value);
+  void Add(const char* name, bool value);
+  void Add(const char* name, const std::string& value);
+
+  const std::string& str() const { return out_; }
+
+ private:
+  void AddKey(const char* name);
+  void AddString(const std::string& value);
+
+  std::string out_;
+  // Whether the next field is the first of its object or array
+  bool first_;
+};
+
+// The stats records of DBOptions::stats_persist_period_sec. They are
+// appended to dbname/STATS, one per line, and STATS is renamed to
+// STATS.old.<time> when full. The first record of a DB opened again goes
+// to a new STATS.
+class StatsHistory {
+ public:
+  StatsHistory(Env* env, const std::string& dbname,
+               const DBOptions& db_options);
+
+  // Adds the tickers of "statistics", as deltas since the previous
+  // record, and the percentiles of its histograms, since the DB was opened
+  void AddStatistics(Statistics* statistics, StatsRecordWriter* record);
+
+  // Appends "record", whose "time_micros" is "now_micros", to STATS
+  Status Append(uint64_t now_micros, const StatsRecordWriter& record);
+
+  // Returns the records whose time is in [start_micros, end_micros), oldest
+  // first. The files are read without blocking Append().
+  Status GetHistory(uint64_t start_micros, uint64_t end_micros,
+                    std::vector<std::string>* records);
+
+  // Returns the time of "record", 0 if it has none
+  static uint64_t RecordTime(const std::string& record);
+
+ private:
+  // Renames STATS to STATS.old.<now_micros> and removes the oldest old
+  // files. REQUIRES: mutex_ held
+  Status Roll(uint64_t now_micros);
+
+  Env* const env_;
+  const std::string dbname_;
+  const size_t max_file_size_;
+  const size_t keep_file_num_;
+
+  port::Mutex mutex_;
+  std::unique_ptr<WritableFile> file_;
+  uint64_t file_size_;
+  // The tickers as of the previous record
+  std::vector<uint64_t> last_tickers_;
+};
+
+}  // namespace rocksdb
@@ -15,7 +15,9 @@
 
 #include <inttypes.h>
 #include <algorithm>
+#include <atomic>
 #include <set>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -279,12 +281,28 @@ class VersionBuilder::Rep {
     CheckConsistency(vstorage);
   }
 
-  void LoadTableHandlers() {
+  size_t LoadTableHandlers(int max_threads, size_t* threads_used) {
     assert(table_cache_ != nullptr);
+    std::vector<FileMetaData*> files_meta;
     for (int level = 0; level < base_vstorage_->num_levels(); level++) {
       for (auto& file_meta_pair : levels_[level].added_files) {
         auto* file_meta = file_meta_pair.second;
         assert(!file_meta->table_reader_handle);
+        files_meta.push_back(file_meta);
+      }
+    }
+
+    // Each thread claims the next file to open. Opening a table reads its
+    // footer, index and filter blocks, so this is mostly waiting on IO.
+    std::atomic<size_t> next_file_meta_idx(0);
+    std::atomic<size_t> num_opened(0);
+    auto load_handlers_func = [&]() {
+      while (true) {
+        size_t file_idx = next_file_meta_idx.fetch_add(1);
+        if (file_idx >= files_meta.size()) {
+          break;
+        }
+        auto* file_meta = files_meta[file_idx];
         table_cache_->FindTable(
             env_options_, *(base_vstorage_->InternalComparator()),
             file_meta->fd, &file_meta->table_reader_handle, false);
@@ -292,9 +310,33 @@ class VersionBuilder::Rep {
           // Load table_reader
           file_meta->fd.table_reader = table_cache_->GetTableReaderFromHandle(
               file_meta->table_reader_handle);
+          num_opened.fetch_add(1);
         }
       }
+    };
+
+    // Starting a thread costs more than opening a few files, so a flush or
+    // a compaction, which add a handful of files, opens them serially
+    size_t num_threads =
+        std::min((files_meta.size() + kFilesPerOpeningThread - 1) /
+                     kFilesPerOpeningThread,
+                 static_cast<size_t>(std::max(max_threads, 1)));
+    if (threads_used != nullptr) {
+      *threads_used = num_threads;
     }
+    if (num_threads <= 1) {
+      load_handlers_func();
+      return num_opened.load();
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+      threads.emplace_back(load_handlers_func);
+    }
+    load_handlers_func();
+    for (auto& t : threads) {
+      t.join();
+    }
+    return num_opened.load();
   }
 
   void MaybeAddFile(VersionStorageInfo* vstorage, int level, FileMetaData* f) {
@@ -322,7 +364,10 @@ void VersionBuilder::Apply(VersionEdit* edit) { rep_->Apply(edit); }
 void VersionBuilder::SaveTo(VersionStorageInfo* vstorage) {
   rep_->SaveTo(vstorage);
 }
-void VersionBuilder::LoadTableHandlers() { rep_->LoadTableHandlers(); }
+size_t VersionBuilder::LoadTableHandlers(int max_threads,
+                                         size_t* threads_used) {
+  return rep_->LoadTableHandlers(max_threads, threads_used);
+}
 void VersionBuilder::MaybeAddFile(VersionStorageInfo* vstorage, int level,
                                   FileMetaData* f) {
   rep_->MaybeAddFile(vstorage, level, f);
@@ -30,9 +30,17 @@ class VersionBuilder {
                                   int level);
   void Apply(VersionEdit* edit);
   void SaveTo(VersionStorageInfo* vstorage);
-  void LoadTableHandlers();
+  // Open the table files added by the applied edits and keep their table
+  // readers in the table cache, using up to max_threads threads, but no
+  // more than one per kFilesPerOpeningThread files.
+  // Returns the number of table files opened. If threads_used is not
+  // nullptr, stores there the number of threads that opened them.
+  size_t LoadTableHandlers(int max_threads = 1,
+                           size_t* threads_used = nullptr);
   void MaybeAddFile(VersionStorageInfo* vstorage, int level, FileMetaData* f);
 
+  static const size_t kFilesPerOpeningThread = 16;
+
  private:
   class Rep;
   Rep* rep_;
@@ -31,6 +31,7 @@ enum Tag {
   // these are new formats divergent from open source leveldb
   kNewFile2 = 100,
   kNewFile3 = 102,
+  kNewFileStats = 104,  // data-entry stats of the preceding new file
   kColumnFamily = 200,  // specify column family for version edit
   kColumnFamilyAdd = 201,
   kColumnFamilyDrop = 202,
@@ -64,7 +65,7 @@ void VersionEdit::Clear() {
   column_family_name_.clear();
 }
 
-bool VersionEdit::EncodeTo(std::string* dst) const {
+bool VersionEdit::EncodeTo(std::string* dst, bool write_file_stats) const {
   if (has_comparator_) {
     PutVarint32(dst, kComparator);
     PutLengthPrefixedSlice(dst, comparator_);
@@ -118,6 +119,14 @@ bool VersionEdit::EncodeTo(std::string* dst) const {
     PutLengthPrefixedSlice(dst, f.largest.Encode());
     PutVarint64(dst, f.smallest_seqno);
     PutVarint64(dst, f.largest_seqno);
+    if (write_file_stats && f.num_entries > 0) {
+      PutVarint32(dst, kNewFileStats);
+      PutVarint64(dst, f.fd.GetNumber());
+      PutVarint64(dst, f.num_entries);
+      PutVarint64(dst, f.num_deletions);
+      PutVarint64(dst, f.raw_key_size);
+      PutVarint64(dst, f.raw_value_size);
+    }
   }
 
   // 0 is default and does not need to be explicitly written
@@ -303,6 +312,29 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         break;
       }
 
+      case kNewFileStats: {
+        uint64_t number;
+        FileMetaData stats;
+        if (GetVarint64(&input, &number) &&
+            GetVarint64(&input, &stats.num_entries) &&
+            GetVarint64(&input, &stats.num_deletions) &&
+            GetVarint64(&input, &stats.raw_key_size) &&
+            GetVarint64(&input, &stats.raw_value_size) &&
+            !new_files_.empty() &&
+            new_files_.back().second.fd.GetNumber() == number) {
+          FileMetaData& file = new_files_.back().second;
+          file.num_entries = stats.num_entries;
+          file.num_deletions = stats.num_deletions;
+          file.raw_key_size = stats.raw_key_size;
+          file.raw_value_size = stats.raw_value_size;
+        } else {
+          if (!msg) {
+            msg = "new-file stats entry";
+          }
+        }
+        break;
+      }
+
       case kColumnFamily:
         if (!GetVarint32(&input, &column_family_)) {
           if (!msg) {
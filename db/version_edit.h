@@ -78,12 +78,16 @@ struct FileMetaData {
   // This is updated in Version::UpdateAccumulatedStats() first time when the
   // file is created or loaded.  After it is updated, it is immutable.
   uint64_t compensated_file_size;
+  // The data-entry stats below are recorded in the MANIFEST for files
+  // written by flushes and compactions. For older files they are read from
+  // the table properties in Version::UpdateAccumulatedStats(). num_entries
+  // is 0 while they are unknown.
   uint64_t num_entries;            // the number of entries.
   uint64_t num_deletions;          // the number of deletion entries.
   uint64_t raw_key_size;           // total uncompressed key size.
   uint64_t raw_value_size;         // total uncompressed value size.
   bool init_stats_from_file;   // true if the data-entry stats of this file
-                               // has initialized from file.
+                               // has been accumulated into the version.
 
   // Always false for new files. Set to true if the file was part of move
   // compaction. Can only be mutated from the compaction process, under DB mutex
@@ -100,6 +104,16 @@ struct FileMetaData {
         raw_value_size(0),
         init_stats_from_file(false),
         moved(false) {}
+
+  // Account for an entry added to the file, like the table properties do
+  void UpdateStats(const Slice& internal_key, const Slice& value) {
+    num_entries++;
+    if (ExtractValueType(internal_key) == kTypeDeletion) {
+      num_deletions++;
+    }
+    raw_key_size += internal_key.size();
+    raw_value_size += value.size();
+  }
 };
 
 // A compressed copy of file meta data that just contain
@@ -179,6 +193,17 @@ class VersionEdit {
     new_files_.push_back(std::make_pair(level, f));
   }
 
+  // Add the file described by "f", including its data-entry stats.
+  void AddFile(int level, const FileMetaData& f) {
+    AddFile(level, f.fd.GetNumber(), f.fd.GetPathId(), f.fd.GetFileSize(),
+            f.smallest, f.largest, f.smallest_seqno, f.largest_seqno);
+    FileMetaData& added = new_files_.back().second;
+    added.num_entries = f.num_entries;
+    added.num_deletions = f.num_deletions;
+    added.raw_key_size = f.raw_key_size;
+    added.raw_value_size = f.raw_value_size;
+  }
+
   // Delete the specified "file" from the specified "level".
   void DeleteFile(int level, uint64_t file) {
     deleted_files_.insert({level, file});
@@ -213,7 +238,9 @@ class VersionEdit {
   }
 
   // return true on success.
-  bool EncodeTo(std::string* dst) const;
+  // The data-entry stats of the new files are only written with
+  // write_file_stats, as older versions cannot read them.
+  bool EncodeTo(std::string* dst, bool write_file_stats = false) const;
   Status DecodeFrom(const Slice& src);
 
   typedef std::set<std::pair<int, uint64_t>> DeletedFileSet;
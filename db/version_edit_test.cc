@@ -12,13 +12,14 @@
 
 namespace rocksdb {
 
-static void TestEncodeDecode(const VersionEdit& edit) {
+static void TestEncodeDecode(const VersionEdit& edit,
+                             bool write_file_stats = false) {
   std::string encoded, encoded2;
-  edit.EncodeTo(&encoded);
+  edit.EncodeTo(&encoded, write_file_stats);
   VersionEdit parsed;
   Status s = parsed.DecodeFrom(encoded);
   ASSERT_TRUE(s.ok()) << s.ToString();
-  parsed.EncodeTo(&encoded2);
+  parsed.EncodeTo(&encoded2, write_file_stats);
   ASSERT_EQ(encoded, encoded2);
 }
 
@@ -45,6 +46,45 @@ TEST(VersionEditTest, EncodeDecode) {
   TestEncodeDecode(edit);
 }
 
+TEST(VersionEditTest, EncodeDecodeFileStats) {
+  VersionEdit edit;
+  FileMetaData f;
+  f.fd = FileDescriptor(300, 0, 1000);
+  f.smallest = InternalKey("foo", 500, kTypeValue);
+  f.largest = InternalKey("zoo", 600, kTypeDeletion);
+  f.smallest_seqno = 500;
+  f.largest_seqno = 600;
+  f.num_entries = 100;
+  f.num_deletions = 20;
+  f.raw_key_size = 1600;
+  f.raw_value_size = 8000;
+  edit.AddFile(1, f);
+  // A file without stats, as written by older versions
+  edit.AddFile(1, 301, 0, 1000, InternalKey("foo", 700, kTypeValue),
+               InternalKey("zoo", 800, kTypeValue), 700, 800);
+  TestEncodeDecode(edit, true);
+
+  std::string encoded;
+  edit.EncodeTo(&encoded, true);
+  VersionEdit parsed;
+  ASSERT_OK(parsed.DecodeFrom(encoded));
+  const auto& new_files = parsed.GetNewFiles();
+  ASSERT_EQ(2U, new_files.size());
+  ASSERT_EQ(100U, new_files[0].second.num_entries);
+  ASSERT_EQ(20U, new_files[0].second.num_deletions);
+  ASSERT_EQ(1600U, new_files[0].second.raw_key_size);
+  ASSERT_EQ(8000U, new_files[0].second.raw_value_size);
+  ASSERT_EQ(0U, new_files[1].second.num_entries);
+
+  // By default the stats are left out, so that older versions can read it
+  std::string compatible;
+  edit.EncodeTo(&compatible);
+  ASSERT_LT(compatible.size(), encoded.size());
+  VersionEdit parsed_compatible;
+  ASSERT_OK(parsed_compatible.DecodeFrom(compatible));
+  ASSERT_EQ(0U, parsed_compatible.GetNewFiles()[0].second.num_entries);
+}
+
 TEST(VersionEditTest, EncodeEmptyFile) {
   VersionEdit edit;
   edit.AddFile(0, 0, 0, 0,
@@ -15,6 +15,7 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
 #include <map>
 #include <set>
@@ -24,6 +25,7 @@
 #include <string>
 
 #include "db/filename.h"
+#include "db/internal_stats.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
@@ -41,9 +43,13 @@
 #include "table/plain_table_factory.h"
 #include "table/meta_blocks.h"
 #include "table/get_context.h"
+#include "util/block_cache_tracer.h"
 #include "util/coding.h"
 #include "util/logging.h"
+#include "util/perf_context_imp.h"
+#include "util/request_tracer_imp.h"
 #include "util/stop_watch.h"
+#include "util/sync_point.h"
 
 namespace rocksdb {
 
@@ -91,6 +97,7 @@ class FilePicker {
       const InternalKeyComparator* internal_comparator)
       : num_levels_(num_levels),
         curr_level_(-1),
+        hit_file_level_(-1),
         search_left_bound_(0),
         search_right_bound_(FileIndexer::kLevelMaxIndex),
 #ifndef NDEBUG
@@ -184,6 +191,7 @@ class FilePicker {
         }
         prev_file_ = f;
 #endif
+        hit_file_level_ = curr_level_;
         if (curr_level_ > 0 && cmp_largest < 0) {
           // No more files to search in this level.
           search_ended_ = !PrepareNextLevel();
@@ -199,9 +207,13 @@ class FilePicker {
     return nullptr;
   }
 
+  // Level of the file last returned by GetNextFile()
+  unsigned int GetHitFileLevel() const { return hit_file_level_; }
+
  private:
   unsigned int num_levels_;
   unsigned int curr_level_;
+  unsigned int hit_file_level_;
   int32_t search_left_bound_;
   int32_t search_right_bound_;
 #ifndef NDEBUG
@@ -475,7 +487,7 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
     const ReadOptions& read_options, const EnvOptions& env_options,
     const InternalKeyComparator& icomparator, bool for_compaction,
     bool prefix_enabled)
-    : TwoLevelIteratorState(prefix_enabled),
+    : TwoLevelIteratorState(prefix_enabled, read_options.pin_data),
       table_cache_(table_cache), read_options_(read_options),
       env_options_(env_options), icomparator_(icomparator),
       for_compaction_(for_compaction) {}
@@ -772,9 +784,99 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
       refs_(0),
       version_number_(version_number) {}
 
+namespace {
+// Attributes the filter checks and block reads that the table reader
+// counted in the thread's PerfContext while a Get() looked into one table
+// file, along with the outcome of the lookup, to the level of the file.
+class TableGetTracker {
+ public:
+  TableGetTracker(const GetContext* get_context,
+                  const MergeContext* merge_context)
+      : get_context_(get_context),
+        merge_context_(merge_context),
+        enabled_(GetPerfLevel() >= kEnableCount),
+        state_(GetContext::kNotFound),
+        num_operands_(0),
+        filter_useful_(0),
+        filter_positive_(0),
+        block_read_count_(0) {}
+
+  void Start() {
+    if (!enabled_) {
+      return;
+    }
+    state_ = get_context_->State();
+    num_operands_ = merge_context_->GetNumOperands();
+#if !defined(NPERF_CONTEXT) && !defined(IOS_CROSS_COMPILE)
+    filter_useful_ = perf_context.bloom_filter_useful;
+    filter_positive_ = perf_context.bloom_filter_positive;
+    block_read_count_ = perf_context.block_read_count;
+#endif
+  }
+
+  void Finish(int level, InternalStats* internal_stats,
+              Statistics* statistics) {
+    if (!enabled_) {
+      return;
+    }
+    PerfContextByLevel stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.get_files_probed = 1;
+    GetContext::GetState state = get_context_->State();
+    if (state == GetContext::kFound || state == GetContext::kDeleted) {
+      stats.get_hit_count = 1;
+      RecordTick(statistics, level == 0 ? GET_HIT_L0
+                                        : level == 1 ? GET_HIT_L1
+                                                     : GET_HIT_L2_AND_UP);
+    }
+#if !defined(NPERF_CONTEXT) && !defined(IOS_CROSS_COMPILE)
+    stats.bloom_filter_useful =
+        perf_context.bloom_filter_useful - filter_useful_;
+    stats.bloom_filter_positive =
+        perf_context.bloom_filter_positive - filter_positive_;
+    stats.block_read_count = perf_context.block_read_count - block_read_count_;
+#endif
+    if (stats.bloom_filter_positive > 0) {
+      RecordTick(statistics, BLOOM_FILTER_POSITIVE,
+                 stats.bloom_filter_positive);
+      // The file had an entry for the key if the lookup changed the state
+      // or picked up merge operands
+      if (state != state_ ||
+          merge_context_->GetNumOperands() != num_operands_) {
+        stats.bloom_filter_true_positive = 1;
+        RecordTick(statistics, BLOOM_FILTER_TRUE_POSITIVE);
+      }
+    }
+    if (internal_stats != nullptr) {
+      internal_stats->RecordTableGet(level, stats);
+    }
+#if !defined(NPERF_CONTEXT) && !defined(IOS_CROSS_COMPILE)
+    PerfContextByLevel& l = perf_context.level_perf_context[std::min(
+        level, kPerfContextMaxLevels - 1)];
+    l.get_files_probed += stats.get_files_probed;
+    l.get_hit_count += stats.get_hit_count;
+    l.bloom_filter_useful += stats.bloom_filter_useful;
+    l.bloom_filter_positive += stats.bloom_filter_positive;
+    l.bloom_filter_true_positive += stats.bloom_filter_true_positive;
+    l.block_read_count += stats.block_read_count;
+#endif
+  }
+
+ private:
+  const GetContext* get_context_;
+  const MergeContext* merge_context_;
+  const bool enabled_;
+  GetContext::GetState state_;
+  size_t num_operands_;
+  uint64_t filter_useful_;
+  uint64_t filter_positive_;
+  uint64_t block_read_count_;
+};
+}  // namespace
+
 void Version::Get(const ReadOptions& read_options,
                   const LookupKey& k,
-                  std::string* value,
+                  PinnableSlice* value,
                   Status* status,
                   MergeContext* merge_context,
                   bool* value_found) {
@@ -792,10 +894,21 @@ void Version::Get(const ReadOptions& read_options,
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
       storage_info_.num_non_empty_levels_, &storage_info_.file_indexer_,
       user_comparator(), internal_comparator());
+  TableGetTracker tracker(&get_context, merge_context);
   FdWithKeyRange* f = fp.GetNextFile();
   while (f != nullptr) {
-    *status = table_cache_->Get(read_options, *internal_comparator(), f->fd,
-                                ikey, &get_context);
+    tracker.Start();
+    {
+      TRACE_TABLE_GUARD(static_cast<int>(fp.GetHitFileLevel()),
+                        f->fd.GetNumber());
+      BLOCK_CACHE_LOOKUP_TABLE_GUARD(static_cast<int>(fp.GetHitFileLevel()),
+                                     f->fd.GetNumber());
+      *status = table_cache_->Get(read_options, *internal_comparator(), f->fd,
+                                  ikey, &get_context);
+    }
+    tracker.Finish(fp.GetHitFileLevel(),
+                   cfd_ != nullptr ? cfd_->internal_stats() : nullptr,
+                   db_statistics_);
     // TODO: examine the behavior for corrupted key
     if (!status->ok()) {
       return;
@@ -829,8 +942,9 @@ void Version::Get(const ReadOptions& read_options,
     // merge_operands are in saver and we hit the beginning of the key history
     // do a final merge of nullptr and operands;
     if (merge_operator_->FullMerge(user_key, nullptr,
-                                   merge_context->GetOperands(), value,
-                                   info_log_)) {
+                                   merge_context->GetOperands(),
+                                   value->GetSelf(), info_log_)) {
+      value->PinSelf();
       *status = Status::OK();
     } else {
       RecordTick(db_statistics_, NUMBER_MERGE_FAILURES);
@@ -867,6 +981,11 @@ bool Version::MaybeInitializeFileMetaData(FileMetaData* file_meta) {
       file_meta->compensated_file_size > 0) {
     return false;
   }
+  if (file_meta->num_entries > 0) {
+    // The stats came with the file's MANIFEST entry, no IO needed
+    file_meta->init_stats_from_file = true;
+    return true;
+  }
   std::shared_ptr<const TableProperties> tp;
   Status s = GetTableProperties(&tp, file_meta);
   file_meta->init_stats_from_file = true;
@@ -910,15 +1029,19 @@ void Version::UpdateAccumulatedStats() {
   // compensated_file_size, making lower-level to higher-level compaction
   // will be triggered, which creates higher-level files whose num_deletions
   // will be updated here.
-  for (int level = 0;
-       level < storage_info_.num_levels_ && init_count < kMaxInitCount;
-       ++level) {
+  // Files whose stats are recorded in the MANIFEST cost no IO, so all of
+  // them are used and they do not count against kMaxInitCount.
+  for (int level = 0; level < storage_info_.num_levels_; ++level) {
     for (auto* file_meta : storage_info_.files_[level]) {
+      bool needs_io = file_meta->num_entries == 0;
+      if (needs_io && init_count >= kMaxInitCount) {
+        continue;
+      }
       if (MaybeInitializeFileMetaData(file_meta)) {
         // each FileMeta will be initialized only once.
         storage_info_.UpdateAccumulatedStats(file_meta);
-        if (++init_count >= kMaxInitCount) {
-          break;
+        if (needs_io) {
+          ++init_count;
         }
       }
     }
@@ -1488,13 +1611,39 @@ struct VersionSet::ManifestWriter {
   bool done;
   port::CondVar cv;
   ColumnFamilyData* cfd;
+  const MutableCFOptions* mutable_cf_options;
   VersionEdit* edit;
 
   explicit ManifestWriter(port::Mutex* mu, ColumnFamilyData* _cfd,
-                          VersionEdit* e)
-      : done(false), cv(mu), cfd(_cfd), edit(e) {}
+                          const MutableCFOptions* cf_options, VersionEdit* e)
+      : done(false),
+        cv(mu),
+        cfd(_cfd),
+        mutable_cf_options(cf_options),
+        edit(e) {}
 };
 
+namespace {
+// A column family that has edits in a batch of manifest writes, and the
+// new version that the batch builds for it
+struct BatchedColumnFamily {
+  ColumnFamilyData* cfd;
+  const MutableCFOptions* mutable_cf_options;
+  Version* version;
+  std::unique_ptr<BaseReferencedVersionBuilder> builder;
+  uint64_t max_log_number;
+  std::vector<uint64_t> size_being_compacted;
+
+  BatchedColumnFamily(ColumnFamilyData* _cfd,
+                      const MutableCFOptions* cf_options, Version* v)
+      : cfd(_cfd),
+        mutable_cf_options(cf_options),
+        version(v),
+        builder(new BaseReferencedVersionBuilder(_cfd)),
+        max_log_number(0) {}
+};
+}  // anonymous namespace
+
 VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
                        const EnvOptions& storage_options, Cache* table_cache,
                        WriteBuffer* write_buffer,
@@ -1512,6 +1661,9 @@ VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
       prev_log_number_(0),
       current_version_number_(0),
       manifest_file_size_(0),
+      recovery_table_load_micros_(0),
+      recovery_tables_opened_(0),
+      recovery_table_load_threads_(0),
       env_options_(storage_options),
       env_options_compactions_(env_options_) {}
 
@@ -1563,8 +1715,11 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
   }
 
   // queue our request
-  ManifestWriter w(mu, column_family_data, edit);
+  ManifestWriter w(mu, column_family_data, &mutable_cf_options, edit);
   manifest_writers_.push_back(&w);
+  if (manifest_writers_.size() > 1) {
+    TEST_SYNC_POINT("VersionSet::LogAndApply:Queued");
+  }
   while (!w.done && &w != manifest_writers_.front()) {
     w.cv.Wait();
   }
@@ -1583,8 +1738,7 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
   }
 
   std::vector<VersionEdit*> batch_edits;
-  Version* v = nullptr;
-  std::unique_ptr<BaseReferencedVersionBuilder> builder_guard(nullptr);
+  std::vector<BatchedColumnFamily> batch_cfds;
 
   // process all requests in the queue
   ManifestWriter* last_writer = &w;
@@ -1595,21 +1749,43 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
     LogAndApplyCFHelper(edit);
     batch_edits.push_back(edit);
   } else {
-    v = new Version(column_family_data, this, current_version_number_++);
-    builder_guard.reset(new BaseReferencedVersionBuilder(column_family_data));
-    auto* builder = builder_guard->version_builder();
+    // Group the edits of all the queued writers, whatever their column
+    // family, so that they share one MANIFEST write and sync. Every column
+    // family in the batch gets one new version.
     for (const auto& writer : manifest_writers_) {
-      if (writer->edit->IsColumnFamilyManipulation() ||
-          writer->cfd->GetID() != column_family_data->GetID()) {
+      if (writer->edit->IsColumnFamilyManipulation()) {
         // no group commits for column family add or drop
-        // also, group commits across column families are not supported
         break;
       }
       last_writer = writer;
-      LogAndApplyHelper(column_family_data, builder, v, last_writer->edit, mu);
-      batch_edits.push_back(last_writer->edit);
+      if (writer->cfd->IsDropped()) {
+        // no need to write anything for a dropped column family
+        continue;
+      }
+      BatchedColumnFamily* batched = nullptr;
+      for (auto& b : batch_cfds) {
+        if (b.cfd == writer->cfd) {
+          batched = &b;
+          break;
+        }
+      }
+      if (batched == nullptr) {
+        batch_cfds.emplace_back(
+            writer->cfd, writer->mutable_cf_options,
+            new Version(writer->cfd, this, current_version_number_++));
+        batched = &batch_cfds.back();
+      }
+      LogAndApplyHelper(writer->cfd, batched->builder->version_builder(),
+                        batched->version, writer->edit, mu);
+      if (writer->edit->has_log_number_) {
+        batched->max_log_number =
+            std::max(batched->max_log_number, writer->edit->log_number_);
+      }
+      batch_edits.push_back(writer->edit);
+    }
+    for (auto& b : batch_cfds) {
+      b.builder->version_builder()->SaveTo(b.version->storage_info());
     }
-    builder->SaveTo(v->storage_info());
   }
 
   // Initialize new descriptor log file if necessary by creating
@@ -1637,21 +1813,23 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
   // Unlock during expensive operations. New writes cannot get here
   // because &w is ensuring that all new writes get queued.
   {
-    std::vector<uint64_t> size_being_compacted;
-    if (!edit->IsColumnFamilyManipulation()) {
-      size_being_compacted.resize(v->storage_info()->num_levels() - 1);
+    for (auto& b : batch_cfds) {
+      b.size_being_compacted.resize(
+          b.version->storage_info()->num_levels() - 1);
       // calculate the amount of data being compacted at every level
-      column_family_data->compaction_picker()->SizeBeingCompacted(
-          size_being_compacted);
+      b.cfd->compaction_picker()->SizeBeingCompacted(b.size_being_compacted);
     }
 
     mu->Unlock();
 
-    if (!edit->IsColumnFamilyManipulation() &&
-        db_options_->max_open_files == -1) {
+    TEST_SYNC_POINT("VersionSet::LogAndApply:WriteManifest");
+    if (db_options_->max_open_files == -1) {
       // unlimited table cache. Pre-load table handle now.
       // Need to do it out of the mutex.
-      builder_guard->version_builder()->LoadTableHandlers();
+      for (auto& b : batch_cfds) {
+        b.builder->version_builder()->LoadTableHandlers(
+            db_options_->max_file_opening_threads);
+      }
     }
 
     // This is fine because everything inside of this block is serialized --
@@ -1672,16 +1850,17 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
       }
     }
 
-    if (!edit->IsColumnFamilyManipulation()) {
+    for (auto& b : batch_cfds) {
       // This is cpu-heavy operations, which should be called outside mutex.
-      v->PrepareApply(mutable_cf_options, size_being_compacted);
+      b.version->PrepareApply(*b.mutable_cf_options, b.size_being_compacted);
     }
 
     // Write new record to MANIFEST log
     if (s.ok()) {
       for (auto& e : batch_edits) {
         std::string record;
-        if (!e->EncodeTo(&record)) {
+        if (!e->EncodeTo(&record,
+                         db_options_->write_file_stats_to_manifest)) {
           s = Status::Corruption(
               "Unable to Encode VersionEdit:" + e->DebugString(true));
           break;
@@ -1708,7 +1887,8 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
         bool all_records_in = true;
         for (auto& e : batch_edits) {
           std::string record;
-          if (!e->EncodeTo(&record)) {
+          if (!e->EncodeTo(&record,
+                           db_options_->write_file_stats_to_manifest)) {
             s = Status::Corruption(
                 "Unable to Encode VersionEdit:" + e->DebugString(true));
             all_records_in = false;
@@ -1768,29 +1948,26 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
         delete column_family_data;
       }
     } else {
-      uint64_t max_log_number_in_batch  = 0;
-      for (auto& e : batch_edits) {
-        if (e->has_log_number_) {
-          max_log_number_in_batch =
-              std::max(max_log_number_in_batch, e->log_number_);
+      for (auto& b : batch_cfds) {
+        if (b.max_log_number != 0) {
+          assert(b.cfd->GetLogNumber() <= b.max_log_number);
+          b.cfd->SetLogNumber(b.max_log_number);
         }
+        AppendVersion(b.cfd, b.version);
       }
-      if (max_log_number_in_batch != 0) {
-        assert(column_family_data->GetLogNumber() <= max_log_number_in_batch);
-        column_family_data->SetLogNumber(max_log_number_in_batch);
-      }
-      AppendVersion(column_family_data, v);
     }
 
     manifest_file_number_ = pending_manifest_file_number_;
     manifest_file_size_ = new_manifest_file_size;
     prev_log_number_ = edit->prev_log_number_;
   } else {
-    Log(InfoLogLevel::ERROR_LEVEL, db_options_->info_log,
-        "Error in committing version %lu to [%s]",
-        (unsigned long)v->GetVersionNumber(),
-        column_family_data->GetName().c_str());
-    delete v;
+    for (auto& b : batch_cfds) {
+      Log(InfoLogLevel::ERROR_LEVEL, db_options_->info_log,
+          "Error in committing version %lu to [%s]",
+          (unsigned long)b.version->GetVersionNumber(),
+          b.cfd->GetName().c_str());
+      delete b.version;
+    }
     if (new_descriptor_log) {
       Log(InfoLogLevel::INFO_LEVEL, db_options_->info_log,
         "Deleting manifest %" PRIu64 " current manifest %" PRIu64 "\n",
@@ -2098,7 +2275,13 @@ Status VersionSet::Recover(
       if (db_options_->max_open_files == -1) {
       // unlimited table cache. Pre-load table handle now.
       // Need to do it out of the mutex.
-        builder->LoadTableHandlers();
+        uint64_t start_micros = env_->NowMicros();
+        size_t threads_used = 0;
+        recovery_tables_opened_ += builder->LoadTableHandlers(
+            db_options_->max_file_opening_threads, &threads_used);
+        recovery_table_load_micros_ += env_->NowMicros() - start_micros;
+        recovery_table_load_threads_ =
+            std::max(recovery_table_load_threads_, threads_used);
       }
 
       Version* v = new Version(cfd, this, current_version_number_++);
@@ -2528,14 +2711,12 @@ Status VersionSet::WriteSnapshot(log::Writer* log) {
       for (int level = 0; level < cfd->NumberLevels(); level++) {
         for (const auto& f :
              cfd->current()->storage_info()->LevelFiles(level)) {
-          edit.AddFile(level, f->fd.GetNumber(), f->fd.GetPathId(),
-                       f->fd.GetFileSize(), f->smallest, f->largest,
-                       f->smallest_seqno, f->largest_seqno);
+          edit.AddFile(level, *f);
         }
       }
       edit.SetLogNumber(cfd->GetLogNumber());
       std::string record;
-      if (!edit.EncodeTo(&record)) {
+      if (!edit.EncodeTo(&record, db_options_->write_file_stats_to_manifest)) {
         return Status::Corruption(
             "Unable to Encode VersionEdit:" + edit.DebugString(true));
       }
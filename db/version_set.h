@@ -358,10 +358,11 @@ class Version {
                     MergeIteratorBuilder* merger_iter_builder);
 
   // Lookup the value for key.  If found, store it in *val and
-  // return OK.  Else return a non-OK status.
+  // return OK.  Else return a non-OK status. *val may be left pointing
+  // into a pinned block cache entry instead of holding a copy.
   // Uses *operands to store merge_operator operations to apply later
   // REQUIRES: lock is not held
-  void Get(const ReadOptions&, const LookupKey& key, std::string* val,
+  void Get(const ReadOptions&, const LookupKey& key, PinnableSlice* val,
            Status* status, MergeContext* merge_context,
            bool* value_found = nullptr);
 
@@ -482,6 +483,8 @@ class VersionSet {
   // Apply *edit to the current version to form a new descriptor that
   // is both saved to persistent state and installed as the new
   // current version.  Will release *mu while actually writing to the file.
+  // Edits queued by concurrent callers, for any column family, are written
+  // together with a single sync of the MANIFEST.
   // column_family_options has to be set if edit is column family add
   // REQUIRES: *mu is held on entry.
   // REQUIRES: no other thread concurrently calls LogAndApply()
@@ -581,6 +584,20 @@ class VersionSet {
   // Return the size of the current manifest file
   uint64_t manifest_file_size() const { return manifest_file_size_; }
 
+  // Time Recover() spent opening table files (max_open_files == -1 only)
+  uint64_t recovery_table_load_micros() const {
+    return recovery_table_load_micros_;
+  }
+
+  // Number of table files Recover() opened (max_open_files == -1 only)
+  uint64_t recovery_tables_opened() const { return recovery_tables_opened_; }
+
+  // Most threads Recover() used to open the table files of a column family
+  // (max_open_files == -1 only)
+  size_t recovery_table_load_threads() const {
+    return recovery_table_load_threads_;
+  }
+
   // verify that the files that we started with for a compaction
   // still exist in the current version and in the same original level.
   // This ensures that a concurrent compaction did not erroneously
@@ -644,6 +661,10 @@ class VersionSet {
   // Current size of manifest file
   uint64_t manifest_file_size_;
 
+  uint64_t recovery_table_load_micros_;
+  uint64_t recovery_tables_opened_;
+  size_t recovery_table_load_threads_;
+
   std::vector<FileMetaData*> obsolete_files_;
 
   // env options for all reads and writes except compactions
@@ -36,11 +36,12 @@
 
 namespace rocksdb {
 
-// WriteBatch header has an 8-byte sequence number followed by a 4-byte count.
-static const size_t kHeader = 12;
+const size_t WriteBatchInternal::kHeader;
 
 WriteBatch::WriteBatch(size_t reserved_bytes) {
-  rep_.reserve((reserved_bytes > kHeader) ? reserved_bytes : kHeader);
+  rep_.reserve((reserved_bytes > WriteBatchInternal::kHeader)
+                   ? reserved_bytes
+                   : WriteBatchInternal::kHeader);
   Clear();
 }
 
@@ -59,7 +60,7 @@ bool WriteBatch::Handler::Continue() {
 
 void WriteBatch::Clear() {
   rep_.clear();
-  rep_.resize(kHeader);
+  rep_.resize(WriteBatchInternal::kHeader);
 }
 
 int WriteBatch::Count() const {
@@ -120,11 +121,11 @@ Status ReadRecordFromWriteBatch(Slice* input, char* tag,
 
 Status WriteBatch::Iterate(Handler* handler) const {
   Slice input(rep_);
-  if (input.size() < kHeader) {
+  if (input.size() < WriteBatchInternal::kHeader) {
     return Status::Corruption("malformed WriteBatch (too small)");
   }
 
-  input.remove_prefix(kHeader);
+  input.remove_prefix(WriteBatchInternal::kHeader);
   Slice key, value, blob;
   int found = 0;
   Status s;
@@ -70,6 +70,8 @@ void WriteThread::ExitWriteThread(WriteThread::Writer* w,
     writers_.pop_front();
     if (ready != w) {
       ready->status = status;
+      ready->log_sync = w->log_sync;
+      ready->log_sync_ticket = w->log_sync_ticket;
       ready->done = true;
       ready->cv.Signal();
     }
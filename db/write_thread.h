@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <deque>
 #include <limits>
+#include <memory>
 #include "rocksdb/status.h"
 #include "db/write_batch_internal.h"
 #include "util/autovector.h"
@@ -15,6 +16,10 @@
 
 namespace rocksdb {
 
+namespace log {
+class SyncCoordinator;
+}  // namespace log
+
 class WriteThread {
  public:
   static const uint64_t kNoTimeOut = std::numeric_limits<uint64_t>::max();
@@ -27,6 +32,11 @@ class WriteThread {
     bool in_batch_group;
     bool done;
     uint64_t timeout_hint_us;
+    // If set by the leader of the group, the WAL is synced after the
+    // writers leave the write thread: they wait for log_sync to sync the
+    // log up to log_sync_ticket.
+    std::shared_ptr<log::SyncCoordinator> log_sync;
+    uint64_t log_sync_ticket;
     port::CondVar cv;
 
     explicit Writer(port::Mutex* mu)
@@ -36,6 +46,7 @@ class WriteThread {
           in_batch_group(false),
           done(false),
           timeout_hint_us(kNoTimeOut),
+          log_sync_ticket(0),
           cv(mu) {}
   };
 
@@ -64,6 +75,8 @@ class WriteThread {
   //                      we should pass last_writer as a parameter to
   //                      ExitWriteThread
   //                      (if you don't touch other writers, just pass w)
+  //                      Their log_sync and log_sync_ticket are copied
+  //                      from w.
   // Status status:       Status of write operation
   // See also: EnterWriteThread
   // REQUIRES: db mutex held
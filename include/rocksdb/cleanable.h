@@ -0,0 +1,58 @@
+// Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Cleanable is a base for objects that hold on to resources owned by
+// somebody else (e.g. block cache entries) and need to give them back when
+// they are destroyed. Iterator and PinnableSlice are both Cleanables.
+
+#ifndef STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
+#define STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
+
+namespace rocksdb {
+
+class Cleanable {
+ public:
+  Cleanable();
+  ~Cleanable();
+
+  // Clients are allowed to register function/arg1/arg2 triples that
+  // will be invoked when this object is destroyed or Reset().
+  //
+  // Note that this method is not virtual and therefore clients should not
+  // override it.
+  typedef void (*CleanupFunction)(void* arg1, void* arg2);
+  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+
+  // Move all the registered cleanups to "other". After this call this
+  // object no longer releases anything on destruction; "other" does.
+  // REQUIRES: other != this
+  void DelegateCleanupsTo(Cleanable* other);
+
+  // Run all the registered cleanups now and make the object reusable.
+  void Reset();
+
+ protected:
+  struct Cleanup {
+    CleanupFunction function;
+    void* arg1;
+    void* arg2;
+    Cleanup* next;
+  };
+  Cleanup cleanup_;
+
+ private:
+  void DoCleanup();
+
+  // No copying allowed
+  Cleanable(const Cleanable&);
+  void operator=(const Cleanable&);
+};
+
+}  // namespace rocksdb
+
+#endif  // STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
@@ -23,6 +23,7 @@
 #include "rocksdb/transaction_log.h"
 #include "rocksdb/listener.h"
 #include "rocksdb/thread_status.h"
+#include "rocksdb/trace_reader_writer.h"
 
 namespace rocksdb {
 
@@ -216,6 +217,29 @@ class DB {
     return Get(options, DefaultColumnFamily(), key, value);
   }
 
+  // Same as Get() above, but the value is returned through a PinnableSlice.
+  // When the value is found in an uncompressed block of the block cache,
+  // *value points directly into that block and keeps it pinned in the cache
+  // until *value is destroyed or Reset(); no copy is made. Values found
+  // elsewhere are copied into value->GetSelf().
+  //
+  // Whatever *value was pinning before the call is released first.
+  // The default implementation always copies.
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) {
+    value->Reset();
+    Status s = Get(options, column_family, key, value->GetSelf());
+    if (s.ok()) {
+      value->PinSelf();
+    }
+    return s;
+  }
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     PinnableSlice* value) {
+    return Get(options, DefaultColumnFamily(), key, value);
+  }
+
   // If keys[i] does not exist in the database, then the i'th returned
   // status will be one for which Status::IsNotFound() is true, and
   // (*values)[i] will be set to some arbitrary value (often ""). Otherwise,
@@ -306,6 +330,10 @@ class DB {
   //     of the sstables that make up the db contents.
   //  "rocksdb.cfstats"
   //  "rocksdb.dbstats"
+  //  "rocksdb.db-open-stats" - time spent in manifest replay, table loading
+  //      and WAL replay during DB::Open()
+  //  "rocksdb.read-amp-stats" - per level number of table files probed,
+  //      hits, filter results and blocks read by Get()
   //  "rocksdb.num-immutable-mem-table"
   //  "rocksdb.mem-table-flush-pending"
   //  "rocksdb.compaction-pending" - 1 if at least one compaction is pending
@@ -552,6 +580,47 @@ class DB {
   // Returns default column family handle
   virtual ColumnFamilyHandle* DefaultColumnFamily() const = 0;
 
+  // Starts recording the Get(), MultiGet(), Write() and iterator Seek()
+  // requests issued to the DB, with their timestamps, column families and
+  // keys, into "trace_writer". The trace can be replayed against a DB with
+  // the replay benchmark of db_bench. Only one trace can be recorded at a
+  // time.
+  virtual Status StartTrace(const TraceOptions& trace_options,
+                            std::unique_ptr<TraceWriter>&& trace_writer) {
+    return Status::NotSupported("StartTrace() is not implemented.");
+  }
+
+  // Stops the trace started by StartTrace() and closes its writer
+  virtual Status EndTrace() {
+    return Status::NotSupported("EndTrace() is not implemented.");
+  }
+
+  // Starts recording every lookup of a block in the block cache, with the
+  // block key and size, whether it was a hit, and the request that made it,
+  // into "trace_writer". The trace can be analyzed, and simulated against
+  // caches of other sizes, with block_cache_trace_analyzer.
+  // trace_options.sampling_frequency samples the blocks rather than the
+  // lookups. Only one block cache trace can be recorded at a time.
+  virtual Status StartBlockCacheTrace(
+      const TraceOptions& trace_options,
+      std::unique_ptr<TraceWriter>&& trace_writer) {
+    return Status::NotSupported("StartBlockCacheTrace() is not implemented.");
+  }
+
+  // Stops the trace started by StartBlockCacheTrace() and closes its writer
+  virtual Status EndBlockCacheTrace() {
+    return Status::NotSupported("EndBlockCacheTrace() is not implemented.");
+  }
+
+  // Returns the stats records written with
+  // DBOptions::stats_persist_period_sec whose time, in microseconds as
+  // given by Env::NowMicros(), is in [start_time, end_time), oldest first.
+  // Every record is a JSON object starting with its "time_micros".
+  virtual Status GetStatsHistory(uint64_t start_time, uint64_t end_time,
+                                 std::vector<std::string>* records) {
+    return Status::NotSupported("GetStatsHistory() is not implemented.");
+  }
+
 #ifndef ROCKSDB_LITE
   virtual Status GetPropertiesOfAllTables(ColumnFamilyHandle* column_family,
                                           TablePropertiesCollection* props) = 0;
@@ -130,6 +130,18 @@ class Env {
                                  unique_ptr<WritableFile>* result,
                                  const EnvOptions& options) = 0;
 
+  // Reuse an existing file by renaming it from "old_fname" to "fname" and
+  // opening it for writing from the beginning, without truncating it, so
+  // that writes overwrite the existing, already allocated blocks. On
+  // success, stores a pointer to the file in *result and returns OK.
+  //
+  // The default implementation renames the file and then truncates it
+  // through NewWritableFile().
+  virtual Status ReuseWritableFile(const std::string& fname,
+                                   const std::string& old_fname,
+                                   unique_ptr<WritableFile>* result,
+                                   const EnvOptions& options);
+
   // Create an object that both reads and writes to a file on
   // specified offsets (random access). If file already exists,
   // does not overwrite it. On success, stores a pointer to the
@@ -444,6 +456,23 @@ class WritableFile {
     return Sync();
   }
 
+  /*
+   * Returns true if SyncWithoutFlush() may be called by one thread while
+   * another thread calls Append() and Flush().
+   */
+  virtual bool IsSyncThreadSafe() const {
+    return false;
+  }
+
+  /*
+   * Sync (or fsync, if use_fsync is true) the data that was already
+   * flushed to the file. Unlike Sync(), it does not flush buffered data
+   * first. Only supported if IsSyncThreadSafe() returns true.
+   */
+  virtual Status SyncWithoutFlush(bool use_fsync) {
+    return Status::NotSupported("SyncWithoutFlush is not supported");
+  }
+
   /*
    * Change the priority in rate limiter if rate limiting is enabled.
    * If rate limiting is not enabled, this call has no effect.
@@ -747,6 +776,12 @@ class EnvWrapper : public Env {
                          const EnvOptions& options) {
     return target_->NewWritableFile(f, r, options);
   }
+  Status ReuseWritableFile(const std::string& fname,
+                           const std::string& old_fname,
+                           unique_ptr<WritableFile>* r,
+                           const EnvOptions& options) {
+    return target_->ReuseWritableFile(fname, old_fname, r, options);
+  }
   Status NewRandomRWFile(const std::string& f, unique_ptr<RandomRWFile>* r,
                          const EnvOptions& options) {
     return target_->NewRandomRWFile(f, r, options);
@@ -19,12 +19,13 @@
 #ifndef STORAGE_ROCKSDB_INCLUDE_ITERATOR_H_
 #define STORAGE_ROCKSDB_INCLUDE_ITERATOR_H_
 
+#include "rocksdb/cleanable.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
 namespace rocksdb {
 
-class Iterator {
+class Iterator : public Cleanable {
  public:
   Iterator();
   virtual ~Iterator();
@@ -73,23 +74,25 @@ class Iterator {
   // satisfied without doing some IO, then this returns Status::Incomplete().
   virtual Status status() const = 0;
 
-  // Clients are allowed to register function/arg1/arg2 triples that
-  // will be invoked when this iterator is destroyed.
+  // Iterators expose some of their internal state through properties:
   //
-  // Note that unlike all of the preceding methods, this method is
-  // not abstract and therefore clients should not override it.
-  typedef void (*CleanupFunction)(void* arg1, void* arg2);
-  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+  // "rocksdb.iterator.pinned-data-size" - the number of bytes of table data
+  //   blocks the iterator currently keeps in memory. When the iterator was
+  //   created with ReadOptions::pin_data, this grows with every block the
+  //   iterator touches and also counts the keys and values it had to copy
+  //   to keep them valid, until the iterator is deleted.
+  //
+  // Returns InvalidArgument for unknown properties.
+  virtual Status GetProperty(const std::string& prop_name, std::string* prop);
 
- private:
-  struct Cleanup {
-    CleanupFunction function;
-    void* arg1;
-    void* arg2;
-    Cleanup* next;
-  };
-  Cleanup cleanup_;
+  // Used internally to implement ReadOptions::pin_data. Returns true if the
+  // memory behind key() (respectively value()) stays valid after the
+  // iterator is moved, for as long as the iterator (or whichever Cleanable
+  // its cleanups were delegated to) is alive.
+  virtual bool IsKeyPinned() const { return false; }
+  virtual bool IsValuePinned() const { return false; }
 
+ private:
   // No copying allowed
   Iterator(const Iterator&);
   void operator=(const Iterator&);
@@ -4,16 +4,95 @@
 
 #pragma once
 
-#ifndef ROCKSDB_LITE
-
+#include <stdint.h>
 #include <string>
+#include <vector>
 #include "rocksdb/status.h"
 
 namespace rocksdb {
 
+enum class TableFileCreationReason {
+  kFlush,
+  kCompaction,
+};
+
+enum class WriteStallCondition {
+  kNormal,   // writes go through
+  kDelayed,  // writes are slowed down
+  kStopped,  // writes are blocked
+};
+
+#ifndef ROCKSDB_LITE
+
 class DB;
 class Status;
 
+struct TableFileCreationInfo {
+  // the name of the database the file belongs to.
+  std::string db_name;
+  // the name of the column family the file belongs to.
+  std::string cf_name;
+  // the path to the created file.
+  std::string file_path;
+  // the size of the file in bytes.
+  uint64_t file_size;
+  // the number of entries in the file.
+  uint64_t num_entries;
+  // whether a flush or a compaction created the file.
+  TableFileCreationReason reason;
+};
+
+struct TableFileDeletionInfo {
+  // the name of the database the file belonged to.
+  std::string db_name;
+  // the path to the deleted file.
+  std::string file_path;
+  // the status of the deletion.
+  Status status;
+};
+
+struct CompactionJobInfo {
+  // the name of the column family where the compaction happened.
+  std::string cf_name;
+  // the status of the compaction.
+  Status status;
+  // the level the compaction picked its files from, and the level it
+  // wrote its output to.
+  int base_input_level;
+  int output_level;
+  // the paths of the input files of both input levels, and of the files
+  // the compaction created.  The output files are only listed when the
+  // compaction succeeded.
+  std::vector<std::string> input_files;
+  std::vector<std::string> output_files;
+
+  // time spent in the compaction, excluding the flushes it ran.
+  uint64_t elapsed_micros;
+  // number of files and bytes read from the base input level and from
+  // the output level.
+  int num_input_files_at_base_level;
+  int num_input_files_at_output_level;
+  uint64_t bytes_read_base_level;
+  uint64_t bytes_read_output_level;
+  // number of files and bytes written.
+  int num_output_files;
+  uint64_t bytes_written;
+  // number of records read from the base input level, and number of
+  // records the compaction dropped.
+  uint64_t num_input_records;
+  uint64_t num_dropped_records;
+};
+
+struct WriteStallInfo {
+  // the name of the column family whose stall condition changed.
+  std::string cf_name;
+  // the condition of the column family before and after the change.
+  struct {
+    WriteStallCondition cur;
+    WriteStallCondition prev;
+  } condition;
+};
+
 // EventListener class contains a set of call-back functions that will
 // be called when specific RocksDB event happens such as flush.  It can
 // be used as a building block for developing custom features such as
@@ -58,9 +137,52 @@ class EventListener {
       const std::string& file_path,
       bool triggered_writes_slowdown,
       bool triggered_writes_stop) {}
+
+  // A call-back function for RocksDB which will be called whenever
+  // a registered RocksDB compacts files.  The default implementation
+  // is a no-op.  It is called for failed compactions as well, with
+  // the error in "ci.status".
+  //
+  // Note that this function must be implemented in a way such that
+  // it should not run for an extended period of time before the function
+  // returns.  Otherwise, RocksDB may be blocked.
+  //
+  // @param db a pointer to the rocksdb instance which just compacted
+  //     files.
+  // @param ci a reference to a CompactionJobInfo struct, which describes
+  //     the input and output files of the compaction and the work it did.
+  virtual void OnCompactionCompleted(DB* db, const CompactionJobInfo& ci) {}
+
+  // A call-back function for RocksDB which will be called whenever
+  // a flush or a compaction finished writing a table file.  The file is
+  // not yet part of the DB when the callback runs, and is deleted again
+  // if the flush or compaction that created it fails.
+  //
+  // Note that this function must be implemented in a way such that
+  // it should not run for an extended period of time before the function
+  // returns.  Otherwise, RocksDB may be blocked.
+  virtual void OnTableFileCreated(const TableFileCreationInfo& info) {}
+
+  // A call-back function for RocksDB which will be called whenever
+  // a table file is deleted.  The listeners of every column family of the
+  // DB are called, as the file no longer belongs to any of them.
+  //
+  // Note that this function must be implemented in a way such that
+  // it should not run for an extended period of time before the function
+  // returns.  Otherwise, RocksDB may be blocked.
+  virtual void OnTableFileDeleted(const TableFileDeletionInfo& info) {}
+
+  // A call-back function for RocksDB which will be called whenever
+  // the write stall condition of a column family changes, e.g. when
+  // writes start to be delayed because there are too many level 0
+  // files, or stop because all the memtables are waiting to be flushed.
+  // Calls are made in the order the conditions changed, but possibly
+  // some time after the change and from any thread.
+  virtual void OnStallConditionsChanged(const WriteStallInfo& info) {}
+
   virtual ~EventListener() {}
 };
 
-}  // namespace rocksdb
-
 #endif  // ROCKSDB_LITE
+
+}  // namespace rocksdb
@@ -34,6 +34,7 @@ enum InfoLogLevel : unsigned char;
 class FilterPolicy;
 class Logger;
 class MergeOperator;
+class RequestTracer;
 class Snapshot;
 class TableFactory;
 class MemTableRepFactory;
@@ -70,6 +71,21 @@ enum CompactionStyle : char {
   kCompactionStyleNone = 0x3,
 };
 
+// How DB::Open() deals with corrupted records in the WAL
+enum WALRecoveryMode : char {
+  // Drop corrupted records wherever they are found and replay the rest of
+  // the logs, unless paranoid_checks is set, in which case the first
+  // corrupted record makes DB::Open() fail.
+  kWALRecoveryModeSkipCorruptedRecords = 0x0,
+  // Stop replaying the logs at the first corrupted record, and ignore
+  // everything written after it. The DB is recovered to the consistent
+  // point in time just before the corruption, whatever paranoid_checks is.
+  // DB::Open() still fails if table files already hold data written after
+  // that point. The sequence number recovered to is logged and reported by
+  // the "rocksdb.db-open-stats" property.
+  kWALRecoveryModePointInTime = 0x1,
+};
+
 struct CompactionOptionsFIFO {
   // once the total sum of table files reaches this, we will delete the oldest
   // table file
@@ -655,6 +671,10 @@ struct DBOptions {
   // Default: true
   bool paranoid_checks;
 
+  // How corrupted WAL records are handled when the DB is opened.
+  // Default: kWALRecoveryModeSkipCorruptedRecords
+  WALRecoveryMode wal_recovery_mode;
+
   // Use the specified object to interact with the environment,
   // e.g. to read/write files, schedule background work, etc.
   // Default: Env::Default()
@@ -682,6 +702,13 @@ struct DBOptions {
   // Default: 5000
   int max_open_files;
 
+  // If max_open_files is -1, DB will open all files on DB::Open(). You can
+  // use this option to increase the number of threads used to open the files.
+  // Threads are only started when there are many files to open, so the
+  // few files added by a flush or a compaction are opened serially.
+  // Default: 16
+  int max_file_opening_threads;
+
   // Once write-ahead logs exceed this size, we will start forcing the flush of
   // column families whose memtables are backed by the oldest live WAL file
   // (i.e. the ones that are causing all the space amplification). If set to 0
@@ -695,6 +722,11 @@ struct DBOptions {
   // it does not use any locks to prevent concurrent updates.
   std::shared_ptr<Statistics> statistics;
 
+  // If non-null, a latency breakdown of sampled Get() and Write() requests
+  // is handed to this object. See rocksdb/request_tracer.h.
+  // Default: nullptr
+  std::shared_ptr<RequestTracer> request_tracer;
+
   // If true, then the contents of manifest and data files are not synced
   // to stable storage. Their contents remain in the OS buffers till the
   // OS decides to flush them. This option is good for bulk-loading
@@ -804,6 +836,14 @@ struct DBOptions {
   // The default value is MAX_INT so that roll-over does not take place.
   uint64_t max_manifest_file_size;
 
+  // If true, the MANIFEST records the number of entries, deletions and raw
+  // key/value sizes of every new table file, so that DB::Open() does not
+  // read the table properties to compute compensated file sizes.
+  // A MANIFEST written with this option cannot be read by RocksDB versions
+  // that do not know this record. Set it only when no downgrade is needed.
+  // Default: false
+  bool write_file_stats_to_manifest;
+
   // Number of shards used for table cache.
   int table_cache_numshardbits;
 
@@ -831,6 +871,27 @@ struct DBOptions {
   uint64_t WAL_ttl_seconds;
   uint64_t WAL_size_limit_MB;
 
+  // If non-zero, obsolete log files are kept around and reused for new
+  // logs, overwriting the old data in place, instead of being deleted. The
+  // value is the number of such files kept around at any point in time.
+  // Overwriting a file whose blocks are already allocated means fdatasync
+  // does not have to update the file size in the inode on every sync write.
+  // The end of a recycled log cannot be told apart from a corruption of its
+  // last records, which recovery treats as a torn write. Corruptions
+  // followed by valid records are reported as in other logs.
+  // Ignored when WAL archival is enabled (WAL_ttl_seconds or
+  // WAL_size_limit_MB is not 0).
+  // Default: 0
+  size_t recycle_log_file_num;
+
+  // If not kNoCompression, every record written to the WAL is compressed
+  // with this compression type, and stored uncompressed when it does not
+  // compress well. Compression happens inside the write queue, so it is
+  // worth enabling when WAL write bandwidth, not CPU, limits writes.
+  // Logs written with compression cannot be read by older versions.
+  // Default: kNoCompression
+  CompressionType wal_compression;
+
   // Number of bytes to preallocate (via fallocate) the manifest
   // files.  Default is 4mb, which is reasonable to reduce random IO
   // as well as prevent overallocation for mounts that preallocate
@@ -853,10 +914,34 @@ struct DBOptions {
   // DEPRECATED -- this options is no longer used
   bool skip_log_error_on_recovery;
 
+  // If true, DB::Open() replays the WAL as a pipeline: a background thread
+  // reads and checksums log records ahead of the thread applying them, and
+  // memtables that fill up during recovery are flushed by the background
+  // flush thread pool while replay continues into a new memtable.
+  // Default: false
+  bool pipelined_wal_recovery;
+
   // if not zero, dump rocksdb.stats to LOG every stats_dump_period_sec
   // Default: 3600 (1 hour)
   unsigned int stats_dump_period_sec;
 
+  // If not zero, every stats_persist_period_sec the DB appends a record of
+  // its stats to the file STATS in the DB directory, one JSON object per
+  // line: the tickers and histogram percentiles of "statistics", and per
+  // column family and level the files, bytes and compaction work, plus the
+  // write stalls and the state of the write controller. Counters are the
+  // deltas since the previous record. DB::GetStatsHistory() returns the
+  // records of a time range. Like the dumps of stats_dump_period_sec, the
+  // records are written by background flushes and compactions.
+  // Default: 0 (disabled)
+  unsigned int stats_persist_period_sec;
+
+  // STATS is renamed to STATS.old.<time> once larger than this, and only
+  // the stats_persist_keep_file_num most recent old files are kept.
+  // Default: 64MB and 10
+  size_t stats_persist_max_file_size;
+  size_t stats_persist_keep_file_num;
+
   // If set true, will hint the underlying file system that the file
   // access pattern is random, when a sst file is opened.
   // Default: true
@@ -907,8 +992,20 @@ struct DBOptions {
   // You may consider using rate_limiter to regulate write rate to device.
   // When rate limiter is enabled, it automatically enables bytes_per_sync
   // to 1MB.
+  //
+  // This option does not apply to WAL files, see wal_bytes_per_sync.
   uint64_t bytes_per_sync;
 
+  // Same as bytes_per_sync, but for WAL files. Writeback is only started
+  // for whole pages that the log has completed, so that a sync write only
+  // leaves the last, partially written page of the log for fdatasync to
+  // write out.
+  // The WAL is still written with buffered, unaligned writes: it is not
+  // opened with O_DIRECT, and it is not preallocated beyond what the
+  // Env already does for it.
+  // Default: 0, turned off
+  uint64_t wal_bytes_per_sync;
+
   // If true, then the status of the threads involved in this DB will
   // be tracked and available via GetThreadList() API.
   //
@@ -1025,6 +1122,23 @@ struct ReadOptions {
   // this option.
   bool total_order_seek;
 
+  // Keep every data block loaded by an iterator pinned in memory until the
+  // iterator is deleted, so that the Slices returned by key() and value()
+  // stay valid for the whole lifetime of the iterator instead of only until
+  // the next move. Keys and values that do not live in a pinned block
+  // (e.g. merge results) are copied into memory owned by the iterator.
+  // The pinned memory is reported by the iterator property
+  // "rocksdb.iterator.pinned-data-size".
+  // Not supported for tailing iterators: NewIterator() then returns an
+  // iterator whose status() is NotSupported.
+  // Default: false
+  bool pin_data;
+
+  // Trace this read if DBOptions::request_tracer is set, whether or not it
+  // is sampled. Only used by Get().
+  // Default: false
+  bool trace;
+
   ReadOptions()
       : verify_checksums(true),
         fill_cache(true),
@@ -1032,7 +1146,9 @@ struct ReadOptions {
         iterate_upper_bound(nullptr),
         read_tier(kReadAllTier),
         tailing(false),
-        total_order_seek(false) {}
+        total_order_seek(false),
+        pin_data(false),
+        trace(false) {}
   ReadOptions(bool cksum, bool cache)
       : verify_checksums(cksum),
         fill_cache(cache),
@@ -1040,7 +1156,9 @@ struct ReadOptions {
         iterate_upper_bound(nullptr),
         read_tier(kReadAllTier),
         tailing(false),
-        total_order_seek(false) {}
+        total_order_seek(false),
+        pin_data(false),
+        trace(false) {}
 };
 
 // Options that control write operations
@@ -1060,6 +1178,13 @@ struct WriteOptions {
   // with sync==true has similar crash semantics to a "write()"
   // system call followed by "fdatasync()".
   //
+  // When the WAL file supports WritableFile::IsSyncThreadSafe(), the WAL
+  // is synced after the write has been applied to the memtable, so that
+  // other writers can proceed meanwhile. A sync write is therefore
+  // visible to readers before it returns, and before it is durable. If
+  // the sync fails, the write returns the error but stays visible, and
+  // the DB fails every later write until it is reopened.
+  //
   // Default: false
   bool sync;
 
@@ -1084,11 +1209,17 @@ struct WriteOptions {
   // Default: false
   bool ignore_missing_column_families;
 
+  // Trace this write if DBOptions::request_tracer is set, whether or not it
+  // is sampled.
+  // Default: false
+  bool trace;
+
   WriteOptions()
       : sync(false),
         disableWAL(false),
         timeout_hint_us(0),
-        ignore_missing_column_families(false) {}
+        ignore_missing_column_families(false),
+        trace(false) {}
 };
 
 // Options that control flush operations
@@ -23,6 +23,24 @@ void SetPerfLevel(PerfLevel level);
 // get current perf stats level
 PerfLevel GetPerfLevel();
 
+// What the Get()s of a thread did in the table files of one level.
+struct PerfContextByLevel {
+  uint64_t get_files_probed;   // number of table files looked into
+  uint64_t get_hit_count;      // number of Get()s answered by the level
+  // number of times a filter ruled the key out
+  uint64_t bloom_filter_useful;
+  // number of times a filter let the key through, and how many of those
+  // the file actually had an entry for the key
+  uint64_t bloom_filter_positive;
+  uint64_t bloom_filter_true_positive;
+  // number of blocks (data, index or filter) read from the files
+  uint64_t block_read_count;
+};
+
+// Levels at and below this one share the last entry of
+// PerfContext::level_perf_context.
+const int kPerfContextMaxLevels = 7;
+
 // A thread local context for gathering performance counter efficiently
 // and transparently.
 
@@ -65,6 +83,15 @@ struct PerfContext {
   uint64_t write_wal_time;            // total time spent on writing to WAL
   // total time spent on writing to mem tables
   uint64_t write_memtable_time;
+  // number of times a filter ruled the key of a Get() out of a table file,
+  // and number of times it let the key through
+  uint64_t bloom_filter_useful;
+  uint64_t bloom_filter_positive;
+
+  // The counters above attributed to the level of the table files that
+  // Get() looked into, indexed by level. Only kept with perf level
+  // kEnableCount or higher.
+  PerfContextByLevel level_perf_context[kPerfContextMaxLevels];
 };
 
 #if defined(NPERF_CONTEXT) || defined(IOS_CROSS_COMPILE)
@@ -0,0 +1,105 @@
+// Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+class ThreadLocalPtr;
+
+// A step taken while serving a traced request
+enum class TraceSpanType : unsigned char {
+  // Get(): lookup in the mutable and immutable memtables.
+  // value: 1 if the lookup found the key, 0 otherwise
+  kMemTableGet,
+  // Get(): lookup in one table file. level and file_number are set.
+  kTableGet,
+  // Get(): bloom filter check. value: 0 if the filter ruled the key out
+  kFilterCheck,
+  // Lookup in the block cache that found the block
+  kBlockCacheHit,
+  // Lookup in the block cache that did not find the block
+  kBlockCacheMiss,
+  // Block read from a table file. value: bytes read
+  kBlockRead,
+  // Block decompression. value: size of the uncompressed block
+  kBlockDecompress,
+  // Write(): waiting in the write queue, until the write is done by another
+  // writer (value: 1) or this writer gets to write (value: 0)
+  kWriteQueueWait,
+  // Write(): writes delayed or stopped by the write controller
+  kWriteStall,
+  // Write(): appending the batch to the WAL. value: bytes appended
+  kWALAppend,
+  // Write(): syncing the WAL
+  kWALSync,
+  // Write(): inserting the batch into the memtables
+  kMemTableInsert,
+};
+
+struct TraceSpan {
+  TraceSpanType type;
+  // The level and number of the table file the step was taken for, or
+  // -1 and 0 if the step is not tied to a table file.
+  int level;
+  uint64_t file_number;
+  // Start of the step, relative to the start of the request
+  uint64_t start_nanos;
+  uint64_t duration_nanos;
+  // Meaning depends on type
+  uint64_t value;
+};
+
+// The steps taken by one sampled request, in the order they started
+struct RequestTrace {
+  enum Operation {
+    kGet,
+    kWrite,
+  };
+
+  Operation operation;
+  // Column family read from by Get(), empty for Write()
+  std::string cf_name;
+  // Env::NowMicros() when the request started
+  uint64_t start_micros;
+  uint64_t duration_nanos;
+  Status status;
+  std::vector<TraceSpan> spans;
+};
+
+// Collects a latency breakdown of sampled Get() and Write() requests.
+//
+// One request out of every sample_rate() on each thread is traced, as well
+// as every request issued with ReadOptions::trace or WriteOptions::trace.
+// Requests that are not traced only pay for a thread-local counter update;
+// traced ones read the clock around every step.
+class RequestTracer {
+ public:
+  // A sample_rate of 0 only traces the requests that ask for it
+  explicit RequestTracer(uint32_t sample_rate);
+  virtual ~RequestTracer();
+
+  // Called with the trace of every traced request, on the thread that
+  // issued the request, once the request is done. No DB lock is held.
+  virtual void OnRequestTraced(const RequestTrace& trace) = 0;
+
+  uint32_t sample_rate() const { return sample_rate_; }
+
+ private:
+  friend bool ShouldSampleRequest(RequestTracer* tracer);
+
+  const uint32_t sample_rate_;
+  // Requests left on each thread until the next one this tracer samples
+  std::unique_ptr<ThreadLocalPtr> sample_countdown_;
+};
+
+}  // namespace rocksdb
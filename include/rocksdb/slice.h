@@ -24,6 +24,8 @@
 #include <string.h>
 #include <string>
 
+#include "rocksdb/cleanable.h"
+
 namespace rocksdb {
 
 class Slice {
@@ -68,6 +70,12 @@ class Slice {
     size_ -= n;
   }
 
+  // Drop the last "n" bytes from this slice.
+  void remove_suffix(size_t n) {
+    assert(n <= size());
+    size_ -= n;
+  }
+
   // Return a string that contains the copy of the referenced data.
   std::string ToString(bool hex = false) const {
     if (hex) {
@@ -102,6 +110,77 @@ class Slice {
   // Intentionally copyable
 };
 
+// A Slice that can either point at memory owned by somebody else and kept
+// alive by the registered cleanups (e.g. a block in the block cache that
+// stays pinned until the PinnableSlice is destroyed or Reset()), or at a
+// copy of the data kept in a std::string buffer ("self").
+//
+// DB::Get() uses it to hand out values without copying them out of the
+// block cache.
+class PinnableSlice : public Slice, public Cleanable {
+ public:
+  PinnableSlice() : buf_(&self_space_), pinned_(false) {}
+  // Use *buf as the backing store for values that have to be copied.
+  explicit PinnableSlice(std::string* buf) : buf_(buf), pinned_(false) {}
+
+  // Point to "s" and take over the cleanups registered in "cleanable",
+  // which are responsible for keeping "s" alive.
+  // REQUIRES: !IsPinned()
+  void PinSlice(const Slice& s, Cleanable* cleanable) {
+    assert(!pinned_);
+    pinned_ = true;
+    data_ = s.data();
+    size_ = s.size();
+    cleanable->DelegateCleanupsTo(this);
+  }
+
+  // Point to "s" and run (function)(arg1, arg2) once "s" is not needed.
+  // REQUIRES: !IsPinned()
+  void PinSlice(const Slice& s, CleanupFunction function, void* arg1,
+                void* arg2) {
+    assert(!pinned_);
+    pinned_ = true;
+    data_ = s.data();
+    size_ = s.size();
+    RegisterCleanup(function, arg1, arg2);
+  }
+
+  // Copy "s" into the self buffer and point to it.
+  // REQUIRES: !IsPinned()
+  void PinSelf(const Slice& s) {
+    assert(!pinned_);
+    buf_->assign(s.data(), s.size());
+    data_ = buf_->data();
+    size_ = buf_->size();
+  }
+
+  // Point to whatever has been written into GetSelf().
+  // REQUIRES: !IsPinned()
+  void PinSelf() {
+    assert(!pinned_);
+    data_ = buf_->data();
+    size_ = buf_->size();
+  }
+
+  // Release the pinned memory (if any) and make the slice empty.
+  void Reset() {
+    Cleanable::Reset();
+    pinned_ = false;
+    clear();
+  }
+
+  // The buffer used for values that are not pinned.
+  std::string* GetSelf() { return buf_; }
+
+  // True iff the slice points at pinned memory rather than at GetSelf().
+  bool IsPinned() const { return pinned_; }
+
+ private:
+  std::string self_space_;
+  std::string* buf_;
+  bool pinned_;
+};
+
 // A set of Slices that are virtually concatenated together.  'parts' points
 // to an array of Slices.  The number of elements in the array is 'num_parts'.
 struct SliceParts {
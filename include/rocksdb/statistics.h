@@ -130,6 +130,15 @@ enum Tickers : uint32_t {
   NUMBER_SUPERVERSION_RELEASES,
   NUMBER_SUPERVERSION_CLEANUPS,
   NUMBER_BLOCK_NOT_COMPRESSED,
+
+  // # of Get()s answered by the table files of L0, L1, and L2 and deeper.
+  GET_HIT_L0,
+  GET_HIT_L1,
+  GET_HIT_L2_AND_UP,
+  // # of times a bloom filter let the key of a Get() through, and # of
+  // those times the table file had an entry for the key.
+  BLOOM_FILTER_POSITIVE,
+  BLOOM_FILTER_TRUE_POSITIVE,
   TICKER_ENUM_MAX
 };
 
@@ -191,7 +200,12 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {NUMBER_SUPERVERSION_ACQUIRES, "rocksdb.number.superversion_acquires"},
     {NUMBER_SUPERVERSION_RELEASES, "rocksdb.number.superversion_releases"},
     {NUMBER_SUPERVERSION_CLEANUPS, "rocksdb.number.superversion_cleanups"},
-    {NUMBER_BLOCK_NOT_COMPRESSED, "rocksdb.number.block.not_compressed"}, };
+    {NUMBER_BLOCK_NOT_COMPRESSED, "rocksdb.number.block.not_compressed"},
+    {GET_HIT_L0, "rocksdb.l0.hit"},
+    {GET_HIT_L1, "rocksdb.l1.hit"},
+    {GET_HIT_L2_AND_UP, "rocksdb.l2andup.hit"},
+    {BLOOM_FILTER_POSITIVE, "rocksdb.bloom.filter.positive"},
+    {BLOOM_FILTER_TRUE_POSITIVE, "rocksdb.bloom.filter.true.positive"}, };
 
 /**
  * Keep adding histogram's here.
@@ -222,6 +236,8 @@ enum Histograms : uint32_t {
   NUM_FILES_IN_SINGLE_COMPACTION,
   DB_SEEK,
   WRITE_STALL,
+  // Time DB::Open() spent recovering the DB from the MANIFEST and the WAL
+  DB_RECOVERY_MICROS,
   HISTOGRAM_ENUM_MAX,
 };
 
@@ -245,6 +261,21 @@ const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
   { SOFT_RATE_LIMIT_DELAY_COUNT, "rocksdb.soft.rate.limit.delay.count"},
   { NUM_FILES_IN_SINGLE_COMPACTION, "rocksdb.numfiles.in.singlecompaction" },
   { DB_SEEK, "rocksdb.db.seek.micros" },
+  { DB_RECOVERY_MICROS, "rocksdb.db.recovery.micros" },
+};
+
+// Which stats RocksDB collects. Tickers are always collected; the levels
+// differ in the histograms that time operations, since each of them reads
+// the clock twice per operation.
+enum StatsLevel : unsigned char {
+  // Skip every timer. Histograms of sizes and counts are still collected.
+  kExceptTimers,
+  // Skip the timers of the steps done many times per operation, such as
+  // READ_BLOCK_GET_MICROS and WRITE_RAW_BLOCK_MICROS. The timers of whole
+  // operations such as DB_GET or WAL_FILE_SYNC_MICROS are collected.
+  kExceptDetailedTimers,
+  // Collect everything
+  kAll,
 };
 
 struct HistogramData {
@@ -253,11 +284,16 @@ struct HistogramData {
   double percentile99;
   double average;
   double standard_deviation;
+  // The tail, for latency objectives set at P99.9 and beyond
+  double percentile999;
+  double percentile9999;
+  double max;
 };
 
 // Analyze the performance of a db
 class Statistics {
  public:
+  Statistics() : stats_level_(kAll) {}
   virtual ~Statistics() {}
 
   virtual uint64_t getTickerCount(uint32_t tickerType) const = 0;
@@ -278,6 +314,17 @@ class Statistics {
   virtual bool HistEnabledForType(uint32_t type) const {
     return type < HISTOGRAM_ENUM_MAX;
   }
+
+  // The stats level can be changed at any time. Defaults to kAll.
+  void set_stats_level(StatsLevel level) {
+    stats_level_.store(level, std::memory_order_relaxed);
+  }
+  StatsLevel get_stats_level() const {
+    return stats_level_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<StatsLevel> stats_level_;
 };
 
 // Create a concrete DBStatistics object
@@ -126,6 +126,30 @@ struct BlockBasedTableOptions {
   // This must generally be true for gets to be efficient.
   bool whole_key_filtering = true;
 
+  // Table iterators that keep reading data blocks that follow each other
+  // in the file start prefetching: after a couple of such reads they read
+  // 8KB ahead, and double that window on every prefetch up to this size.
+  // A seek, or a read somewhere else in the file, starts over without
+  // readahead, so point lookups are not affected. Ignored with
+  // allow_mmap_reads. Set to 0 to disable readahead.
+  size_t max_auto_readahead_size = 256 * 1024;
+
+  // If true, data blocks whose restart keys all have the same length also
+  // store a copy of those keys in a contiguous column. Seeks inside such a
+  // block binary search the column with vectorized (SSE4.2/AVX2, when the
+  // CPU has them) key compares instead of decoding entries. Meant for
+  // fixed-size keys; costs block_size / block_restart_interval / key size
+  // extra bytes per block. Only used with the bytewise comparator.
+  // Requires format_version >= 3.
+  bool fixed_key_seek_column = false;
+
+  // If true, data blocks get a small hash table mapping each user key to
+  // its restart interval, so Get() can skip the binary search over the
+  // restart array. Costs about one byte per 0.75 keys per block; blocks
+  // with more than 253 restart points are written without it.
+  // Requires format_version >= 3.
+  bool data_block_hash_index = false;
+
   // For more details on BlockBasedTable's formats, see FORMAT-CHANGES.md
   // We currently have three versions:
   // 0 -- This version is currently written out by all RocksDB's versions by
@@ -139,6 +163,8 @@ struct BlockBasedTableOptions {
   // encode compressed blocks with LZ4, BZip2 and Zlib compression. If you
   // don't plan to run RocksDB before version 3.10, you should probably use
   // this.
+  // 3 -- Can be read by RocksDB's versions since 3.11. Allows the optional
+  // data block extensions fixed_key_seek_column and data_block_hash_index.
   // This option only affects newly written tables. When reading exising tables,
   // the information about version is read from the footer.
   uint32_t format_version = 0;
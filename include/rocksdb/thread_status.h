@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <cstddef>
 #include <string>
 
@@ -45,9 +46,24 @@ struct ThreadStatus {
     OP_UNKNOWN = 0,
     OP_COMPACTION,
     OP_FLUSH,
+    OP_RECOVERY,  // DB::Open() replaying the WAL
     NUM_OP_TYPES
   };
 
+  // The number of operation properties a thread reports.  What each
+  // property means depends on the operation.
+  static const int kNumOperationProperties = 4;
+
+  // The operation properties of OP_RECOVERY, reported by the thread
+  // running DB::Open() under the default column family.
+  enum RecoveryPropertyType : int {
+    RECOVERY_WAL_BYTES_REPLAYED = 0,  // bytes of WAL records replayed so far
+    RECOVERY_CURRENT_LOG_NUMBER,      // the log being replayed
+    RECOVERY_MEMTABLE_FLUSHES,        // memtables flushed by the replay
+    RECOVERY_TABLE_FILES_OPENED,      // table files opened from the MANIFEST
+    NUM_RECOVERY_PROPERTIES
+  };
+
   // The type used to refer to a thread state.
   // A state describes lower-level action of a thread
   // such as reading / writing a file or waiting for a mutex.
@@ -61,11 +77,26 @@ struct ThreadStatus {
                const std::string& _db_name,
                const std::string& _cf_name,
                const OperationType _operation_type,
+               const uint64_t* _op_properties,
                const StateType _state_type) :
       thread_id(_id), thread_type(_thread_type),
       db_name(_db_name),
       cf_name(_cf_name),
-      operation_type(_operation_type), state_type(_state_type) {}
+      operation_type(_operation_type), state_type(_state_type) {
+    for (int i = 0; i < kNumOperationProperties; ++i) {
+      op_properties[i] = _op_properties != nullptr ? _op_properties[i] : 0;
+    }
+  }
+
+  // Same as above, with all the operation properties set to 0.
+  ThreadStatus(const uint64_t _id,
+               const ThreadType _thread_type,
+               const std::string& _db_name,
+               const std::string& _cf_name,
+               const OperationType _operation_type,
+               const StateType _state_type) :
+      ThreadStatus(_id, _thread_type, _db_name, _cf_name, _operation_type,
+                   nullptr, _state_type) {}
 
   // An unique ID for the thread.
   const uint64_t thread_id;
@@ -87,6 +118,11 @@ struct ThreadStatus {
   // The operation (high-level action) that the current thread is involved.
   const OperationType operation_type;
 
+  // The properties of the current operation, such as the progress of
+  // OP_RECOVERY (see RecoveryPropertyType).  All zeros when the
+  // operation does not report any.
+  uint64_t op_properties[kNumOperationProperties];
+
   // The state (lower-level action) that the current thread is involved.
   const StateType state_type;
 };
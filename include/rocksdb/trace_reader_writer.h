@@ -0,0 +1,86 @@
+// Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// Options for DB::StartTrace()
+//
+// Iterators are traced by their Seek() calls only: the Next() and Prev()
+// calls that follow a Seek() are not recorded, so replaying a trace issues
+// the Seek() alone.
+struct TraceOptions {
+  // Tracing stops, and later requests are dropped, once this many bytes
+  // were written to the trace.
+  // Default: 64GB
+  uint64_t max_trace_file_size;
+
+  // Record one request out of every sampling_frequency.
+  // Default: 1, every request is recorded
+  uint64_t sampling_frequency;
+
+  // If false, the values written by Write() are not recorded, only their
+  // sizes. The trace is then much smaller, and replaying it writes values
+  // of the same sizes.
+  // Default: true
+  bool record_values;
+
+  TraceOptions()
+      : max_trace_file_size(64ULL * 1024 * 1024 * 1024),
+        sampling_frequency(1),
+        record_values(true) {}
+};
+
+// Stores the records of a trace. Called by one thread at a time.
+class TraceWriter {
+ public:
+  TraceWriter() {}
+  virtual ~TraceWriter() {}
+
+  virtual Status Write(const Slice& record) = 0;
+  virtual Status Close() = 0;
+  // Bytes written so far
+  virtual uint64_t GetFileSize() = 0;
+
+ private:
+  // No copying allowed
+  TraceWriter(const TraceWriter&);
+  void operator=(const TraceWriter&);
+};
+
+// Reads back the records stored by a TraceWriter, in order
+class TraceReader {
+ public:
+  TraceReader() {}
+  virtual ~TraceReader() {}
+
+  // Returns Status::Incomplete() once every record was read
+  virtual Status Read(std::string* record) = 0;
+  virtual Status Close() = 0;
+
+ private:
+  // No copying allowed
+  TraceReader(const TraceReader&);
+  void operator=(const TraceReader&);
+};
+
+// Trace writer and reader that store the trace in a file
+extern Status NewFileTraceWriter(Env* env, const EnvOptions& env_options,
+                                 const std::string& trace_filename,
+                                 std::unique_ptr<TraceWriter>* trace_writer);
+extern Status NewFileTraceReader(Env* env, const EnvOptions& env_options,
+                                 const std::string& trace_filename,
+                                 std::unique_ptr<TraceReader>* trace_reader);
+
+}  // namespace rocksdb
@@ -45,6 +45,11 @@ class StackableDB : public DB {
                      std::string* value) override {
     return db_->Get(options, column_family, key, value);
   }
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) override {
+    return db_->Get(options, column_family, key, value);
+  }
 
   using DB::MultiGet;
   virtual std::vector<Status> MultiGet(
@@ -247,6 +252,29 @@ class StackableDB : public DB {
     return db_->DefaultColumnFamily();
   }
 
+  virtual Status StartTrace(
+      const TraceOptions& trace_options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override {
+    return db_->StartTrace(trace_options, std::move(trace_writer));
+  }
+
+  virtual Status EndTrace() override { return db_->EndTrace(); }
+
+  virtual Status StartBlockCacheTrace(
+      const TraceOptions& trace_options,
+      std::unique_ptr<TraceWriter>&& trace_writer) override {
+    return db_->StartBlockCacheTrace(trace_options, std::move(trace_writer));
+  }
+
+  virtual Status EndBlockCacheTrace() override {
+    return db_->EndBlockCacheTrace();
+  }
+
+  virtual Status GetStatsHistory(uint64_t start_time, uint64_t end_time,
+                                 std::vector<std::string>* records) override {
+    return db_->GetStatsHistory(start_time, end_time, records);
+  }
+
  protected:
   DB* db_;
 };
@@ -0,0 +1,85 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#include "table/adaptive_readahead_file.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace rocksdb {
+
+AdaptiveReadaheadFile::AdaptiveReadaheadFile(RandomAccessFile* file,
+                                             size_t initial_readahead_size,
+                                             size_t max_readahead_size)
+    : file_(file),
+      initial_readahead_size_(
+          std::min(initial_readahead_size, max_readahead_size)),
+      max_readahead_size_(max_readahead_size),
+      next_sequential_offset_(0),
+      num_sequential_reads_(0),
+      readahead_size_(initial_readahead_size_),
+      buffer_capacity_(0),
+      buffer_offset_(0),
+      buffer_len_(0) {}
+
+void AdaptiveReadaheadFile::Reset() {
+  num_sequential_reads_ = 0;
+  readahead_size_ = initial_readahead_size_;
+}
+
+bool AdaptiveReadaheadFile::TryReadFromBuffer(uint64_t offset, size_t n,
+                                              Slice* result,
+                                              char* scratch) const {
+  if (offset < buffer_offset_ || offset + n > buffer_offset_ + buffer_len_) {
+    return false;
+  }
+  memcpy(scratch, buffer_.get() + (offset - buffer_offset_), n);
+  *result = Slice(scratch, n);
+  return true;
+}
+
+Status AdaptiveReadaheadFile::Read(uint64_t offset, size_t n, Slice* result,
+                                   char* scratch) const {
+  if (offset == next_sequential_offset_) {
+    num_sequential_reads_++;
+  } else {
+    num_sequential_reads_ = 0;
+    readahead_size_ = initial_readahead_size_;
+  }
+  next_sequential_offset_ = offset + n;
+
+  if (TryReadFromBuffer(offset, n, result, scratch)) {
+    return Status::OK();
+  }
+  if (num_sequential_reads_ < kReadsBeforeReadahead || readahead_size_ <= n) {
+    return file_->Read(offset, n, result, scratch);
+  }
+
+  if (buffer_capacity_ < readahead_size_) {
+    buffer_.reset(new char[readahead_size_]);
+    buffer_capacity_ = readahead_size_;
+  }
+  Slice prefetched;
+  buffer_len_ = 0;
+  Status s = file_->Read(offset, readahead_size_, &prefetched, buffer_.get());
+  if (!s.ok()) {
+    return s;
+  }
+  if (prefetched.data() != buffer_.get()) {
+    memcpy(buffer_.get(), prefetched.data(), prefetched.size());
+  }
+  buffer_offset_ = offset;
+  buffer_len_ = prefetched.size();
+  readahead_size_ = std::min(readahead_size_ * 2, max_readahead_size_);
+
+  // A short read means we hit the end of the file
+  size_t copied = std::min(n, buffer_len_);
+  memcpy(scratch, buffer_.get(), copied);
+  *result = Slice(scratch, copied);
+  return Status::OK();
+}
+
+}  // namespace rocksdb
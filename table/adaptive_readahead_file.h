@@ -0,0 +1,70 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// A RandomAccessFile wrapper that detects sequential access and prefetches
+// ahead of it. Once kReadsBeforeReadahead reads in a row have each started
+// where the previous one ended, a read fetches readahead_size bytes into an
+// internal buffer instead of just the requested range, and the window is
+// doubled for the next prefetch, up to max_readahead_size. Any read that is
+// not contiguous with the previous one (or a call to Reset()) falls back to
+// plain reads with the initial window.
+//
+// Meant to be owned by a single iterator: it is not thread-safe, and it
+// does not own the underlying file, which must outlive it.
+class AdaptiveReadaheadFile : public RandomAccessFile {
+ public:
+  static const int kReadsBeforeReadahead = 2;
+
+  AdaptiveReadaheadFile(RandomAccessFile* file, size_t initial_readahead_size,
+                        size_t max_readahead_size);
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const override;
+
+  virtual size_t GetUniqueId(char* id, size_t max_size) const override {
+    return file_->GetUniqueId(id, max_size);
+  }
+
+  // Forget the access pattern seen so far, e.g. when the iterator seeks.
+  // Data already prefetched stays usable.
+  void Reset();
+
+  size_t readahead_size() const { return readahead_size_; }
+
+ private:
+  // Copy [offset, offset + n) to scratch if it is entirely in buffer_
+  bool TryReadFromBuffer(uint64_t offset, size_t n, Slice* result,
+                         char* scratch) const;
+
+  RandomAccessFile* file_;
+  const size_t initial_readahead_size_;
+  const size_t max_readahead_size_;
+
+  // Read() is const in the RandomAccessFile interface
+  mutable uint64_t next_sequential_offset_;
+  mutable int num_sequential_reads_;
+  mutable size_t readahead_size_;
+  mutable std::unique_ptr<char[]> buffer_;
+  mutable size_t buffer_capacity_;
+  mutable uint64_t buffer_offset_;
+  mutable size_t buffer_len_;
+
+  // No copying allowed
+  AdaptiveReadaheadFile(const AdaptiveReadaheadFile&);
+  void operator=(const AdaptiveReadaheadFile&);
+};
+
+}  // namespace rocksdb
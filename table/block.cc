@@ -16,6 +16,11 @@
 #include <unordered_map>
 #include <vector>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define ROCKSDB_BLOCK_SEEK_SIMD
+#endif
+
 #include "rocksdb/comparator.h"
 #include "table/format.h"
 #include "table/block_hash_index.h"
@@ -25,6 +30,83 @@
 
 namespace rocksdb {
 
+namespace {
+
+// Compare the first n bytes of a and b like memcmp(). The fixed key column
+// search does little else, so we pick the widest vector compare the CPU
+// supports at startup.
+typedef int (*CompareBytesFunc)(const char* a, const char* b, size_t n);
+
+int CompareBytesScalar(const char* a, const char* b, size_t n) {
+  return memcmp(a, b, n);
+}
+
+#ifdef ROCKSDB_BLOCK_SEEK_SIMD
+inline int ByteDiff(const char* a, const char* b, size_t i) {
+  return static_cast<int>(static_cast<unsigned char>(a[i])) -
+         static_cast<int>(static_cast<unsigned char>(b[i]));
+}
+
+__attribute__((target("sse4.2")))
+int CompareBytesSSE42(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    // Index of the first byte that differs, 16 if there is none
+    int diff = _mm_cmpestri(va, 16, vb, 16,
+                            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH |
+                                _SIDD_NEGATIVE_POLARITY);
+    if (diff < 16) {
+      return ByteDiff(a, b, i + diff);
+    }
+  }
+  return memcmp(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+int CompareBytesAVX2(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    uint32_t equal =
+        static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    if (equal != 0xffffffffu) {
+      return ByteDiff(a, b, i + __builtin_ctz(~equal));
+    }
+  }
+  if (i + 16 <= n) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    uint32_t equal =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+    if (equal != 0xffffu) {
+      return ByteDiff(a, b, i + __builtin_ctz(~equal));
+    }
+    i += 16;
+  }
+  return memcmp(a + i, b + i, n - i);
+}
+#endif  // ROCKSDB_BLOCK_SEEK_SIMD
+
+CompareBytesFunc ChooseCompareBytes() {
+#ifdef ROCKSDB_BLOCK_SEEK_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return CompareBytesAVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return CompareBytesSSE42;
+  }
+#endif
+  return CompareBytesScalar;
+}
+
+const CompareBytesFunc CompareFixedKeyBytes = ChooseCompareBytes();
+
+}  // namespace
+
 // Helper routine: decode the next block entry starting at "p",
 // storing the number of shared key bytes, non_shared key bytes,
 // and the length of the value in "*shared", "*non_shared", and
@@ -55,6 +137,23 @@ static inline const char* DecodeEntry(const char* p, const char* limit,
   return p;
 }
 
+Status BlockIter::GetProperty(const std::string& prop_name,
+                              std::string* prop) {
+  if (prop == nullptr) {
+    return Status::InvalidArgument("prop is nullptr");
+  }
+  if (prop_name == "rocksdb.iterator.pinned-data-size") {
+    uint64_t pinned_size = 0;
+    if (data_ != nullptr) {
+      // entries, restart array and the trailing restart count
+      pinned_size = restarts_ + (num_restarts_ + 1) * sizeof(uint32_t);
+    }
+    *prop = NumberToString(pinned_size);
+    return Status::OK();
+  }
+  return Iterator::GetProperty(prop_name, prop);
+}
+
 void BlockIter::Next() {
   assert(Valid());
   ParseNextKey();
@@ -89,9 +188,13 @@ void BlockIter::Seek(const Slice& target) {
   bool ok = false;
   if (prefix_index_) {
     ok = PrefixSeek(target, &index);
+  } else if (hash_index_) {
+    ok = HashSeek(target, &index);
+  } else if (fixed_key_column_ != nullptr &&
+             target.size() == fixed_key_size_) {
+    ok = FixedKeySeek(target, &index);
   } else {
-    ok = hash_index_ ? HashSeek(target, &index)
-      : BinarySeek(target, 0, num_restarts_ - 1, &index);
+    ok = BinarySeek(target, 0, num_restarts_ - 1, &index);
   }
 
   if (!ok) {
@@ -107,6 +210,32 @@ void BlockIter::Seek(const Slice& target) {
   }
 }
 
+void BlockIter::SeekForGet(const Slice& target) {
+  if (data_block_hash_index_ == nullptr) {
+    Seek(target);
+    return;
+  }
+  if (data_ == nullptr) {  // Not init yet
+    return;
+  }
+  uint8_t entry = data_block_hash_index_->Lookup(ExtractUserKey(target));
+  if (entry == kCollision || entry >= num_restarts_) {
+    Seek(target);
+    return;
+  }
+  if (entry == kNoEntry) {
+    // The user key is not in this block. We still leave the iterator where
+    // a Get() would look next: on a larger key (which has a different user
+    // key) or past the end of the block, from where the lookup continues
+    // in the next block. Scanning the last restart interval gets us there.
+    entry = static_cast<uint8_t>(num_restarts_ - 1);
+  }
+  SeekToRestartPoint(entry);
+  // Linear search (within restart block) for first key >= target
+  while (ParseNextKey() && Compare(key_.GetKey(), target) < 0) {
+  }
+}
+
 void BlockIter::SeekToFirst() {
   if (data_ == nullptr) {  // Not init yet
     return;
@@ -197,6 +326,39 @@ bool BlockIter::BinarySeek(const Slice& target, uint32_t left, uint32_t right,
   return true;
 }
 
+// Same as BinarySeek() over the whole restart array, but compares target
+// against the copies of the restart keys in the fixed key column instead
+// of decoding the entries. The keys are internal keys whose user keys are
+// ordered bytewise.
+bool BlockIter::FixedKeySeek(const Slice& target, uint32_t* index) {
+  assert(fixed_key_column_ != nullptr && target.size() == fixed_key_size_);
+  const size_t user_key_size = fixed_key_size_ - 8;
+  const uint64_t target_tag = DecodeFixed64(target.data() + user_key_size);
+  uint32_t left = 0;
+  uint32_t right = num_restarts_ - 1;
+
+  while (left < right) {
+    uint32_t mid = (left + right + 1) / 2;
+    const char* mid_key = fixed_key_column_ + mid * fixed_key_size_;
+    int cmp = CompareFixedKeyBytes(mid_key, target.data(), user_key_size);
+    if (cmp == 0) {
+      // Same user key: the larger (sequence, type) tag sorts first
+      uint64_t mid_tag = DecodeFixed64(mid_key + user_key_size);
+      cmp = (mid_tag > target_tag) ? -1 : (mid_tag < target_tag ? 1 : 0);
+    }
+    if (cmp < 0) {
+      left = mid;
+    } else if (cmp > 0) {
+      right = mid - 1;
+    } else {
+      left = right = mid;
+    }
+  }
+
+  *index = left;
+  return true;
+}
+
 // Compare target key and the block key of the block of `block_index`.
 // Return -1 if error.
 int BlockIter::CompareBlockKey(uint32_t block_index, const Slice& target) {
@@ -294,24 +456,62 @@ bool BlockIter::PrefixSeek(const Slice& target, uint32_t* index) {
 
 uint32_t Block::NumRestarts() const {
   assert(size_ >= 2*sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  return DecodeFixed32(data_ + size_ - sizeof(uint32_t)) &
+         kBlockNumRestartsMask;
 }
 
 Block::Block(BlockContents&& contents)
     : contents_(std::move(contents)),
       data_(contents_.data.data()),
-      size_(contents_.data.size()) {
+      size_(contents_.data.size()),
+      fixed_key_column_offset_(0),
+      fixed_key_size_(0),
+      has_data_block_hash_index_(false) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
-  } else {
-    restart_offset_ =
-        static_cast<uint32_t>(size_) - (1 + NumRestarts()) * sizeof(uint32_t);
-    if (restart_offset_ > size_ - sizeof(uint32_t)) {
-      // The size is too small for NumRestarts() and therefore
-      // restart_offset_ wrapped around.
-      size_ = 0;
+    return;
+  }
+  const uint32_t footer = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  const uint32_t num_restarts = footer & kBlockNumRestartsMask;
+  // Walk the trailer backwards; "end" is where the part parsed so far starts
+  uint64_t end = size_ - sizeof(uint32_t);
+  bool corrupted = false;
+  if (footer & kBlockHashIndexFlag) {
+    uint32_t num_buckets =
+        end >= sizeof(uint32_t) ? DecodeFixed32(data_ + end - sizeof(uint32_t))
+                                : 0;
+    if (num_buckets == 0 || num_buckets + sizeof(uint32_t) > end) {
+      corrupted = true;
+    } else {
+      end -= num_buckets + sizeof(uint32_t);
+      data_block_hash_index_.Initialize(data_ + end, num_buckets);
+      has_data_block_hash_index_ = true;
+    }
+  }
+  if (!corrupted && (footer & kBlockFixedKeyColumnFlag)) {
+    uint32_t key_size =
+        end >= sizeof(uint32_t) ? DecodeFixed32(data_ + end - sizeof(uint32_t))
+                                : 0;
+    uint64_t column_size = static_cast<uint64_t>(num_restarts) * key_size;
+    // The column holds internal keys
+    if (key_size < 8 || column_size + sizeof(uint32_t) > end) {
+      corrupted = true;
+    } else {
+      end -= column_size + sizeof(uint32_t);
+      fixed_key_column_offset_ = static_cast<uint32_t>(end);
+      fixed_key_size_ = key_size;
     }
   }
+  const uint64_t restarts_size =
+      static_cast<uint64_t>(num_restarts) * sizeof(uint32_t);
+  if (corrupted || restarts_size > end) {
+    // The size is too small for NumRestarts() and the optional parts.
+    size_ = 0;
+    fixed_key_size_ = 0;
+    has_data_block_hash_index_ = false;
+  } else {
+    restart_offset_ = static_cast<uint32_t>(end - restarts_size);
+  }
 }
 
 Iterator* Block::NewIterator(
@@ -338,12 +538,19 @@ Iterator* Block::NewIterator(
     BlockPrefixIndex* prefix_index_ptr =
         total_order_seek ? nullptr : prefix_index_.get();
 
+    const char* fixed_key_column =
+        fixed_key_size_ > 0 ? data_ + fixed_key_column_offset_ : nullptr;
+    const DataBlockHashIndex* data_block_hash_index =
+        has_data_block_hash_index_ ? &data_block_hash_index_ : nullptr;
+
     if (iter != nullptr) {
       iter->Initialize(cmp, data_, restart_offset_, num_restarts,
-                    hash_index_ptr, prefix_index_ptr);
+                    hash_index_ptr, prefix_index_ptr, fixed_key_column,
+                    fixed_key_size_, data_block_hash_index);
     } else {
       iter = new BlockIter(cmp, data_, restart_offset_, num_restarts,
-                           hash_index_ptr, prefix_index_ptr);
+                           hash_index_ptr, prefix_index_ptr, fixed_key_column,
+                           fixed_key_size_, data_block_hash_index);
     }
   }
 
@@ -16,6 +16,7 @@
 #include "db/dbformat.h"
 #include "table/block_prefix_index.h"
 #include "table/block_hash_index.h"
+#include "table/data_block_hash_index.h"
 
 #include "format.h"
 
@@ -68,6 +69,12 @@ class Block {
   const char* data_;            // contents_.data.data()
   size_t size_;                 // contents_.data.size()
   uint32_t restart_offset_;     // Offset in data_ of restart array
+  // Offset in data_ of the fixed key column and the size of its keys.
+  // fixed_key_size_ is 0 if the block has no such column.
+  uint32_t fixed_key_column_offset_;
+  uint32_t fixed_key_size_;
+  bool has_data_block_hash_index_;
+  DataBlockHashIndex data_block_hash_index_;
   std::unique_ptr<BlockHashIndex> hash_index_;
   std::unique_ptr<BlockPrefixIndex> prefix_index_;
 
@@ -87,19 +94,31 @@ class BlockIter : public Iterator {
         restart_index_(0),
         status_(Status::OK()),
         hash_index_(nullptr),
-        prefix_index_(nullptr) {}
+        prefix_index_(nullptr),
+        fixed_key_column_(nullptr),
+        fixed_key_size_(0),
+        data_block_hash_index_(nullptr) {}
 
   BlockIter(const Comparator* comparator, const char* data, uint32_t restarts,
        uint32_t num_restarts, BlockHashIndex* hash_index,
-       BlockPrefixIndex* prefix_index)
+       BlockPrefixIndex* prefix_index, const char* fixed_key_column = nullptr,
+       uint32_t fixed_key_size = 0,
+       const DataBlockHashIndex* data_block_hash_index = nullptr)
       : BlockIter() {
     Initialize(comparator, data, restarts, num_restarts,
-        hash_index, prefix_index);
+        hash_index, prefix_index, fixed_key_column, fixed_key_size,
+        data_block_hash_index);
   }
 
+  // fixed_key_column: the restart keys of the block stored back to back,
+  // each fixed_key_size bytes long, or nullptr if the block has no such
+  // column.
+  // data_block_hash_index: the hash index of a data block, or nullptr.
   void Initialize(const Comparator* comparator, const char* data,
       uint32_t restarts, uint32_t num_restarts, BlockHashIndex* hash_index,
-      BlockPrefixIndex* prefix_index) {
+      BlockPrefixIndex* prefix_index, const char* fixed_key_column = nullptr,
+      uint32_t fixed_key_size = 0,
+      const DataBlockHashIndex* data_block_hash_index = nullptr) {
     assert(data_ == nullptr);           // Ensure it is called only once
     assert(num_restarts > 0);           // Ensure the param is valid
 
@@ -111,6 +130,9 @@ class BlockIter : public Iterator {
     restart_index_ = num_restarts_;
     hash_index_ = hash_index;
     prefix_index_ = prefix_index;
+    fixed_key_column_ = fixed_key_column;
+    fixed_key_size_ = fixed_key_size;
+    data_block_hash_index_ = data_block_hash_index;
   }
 
   void SetStatus(Status s) {
@@ -128,12 +150,24 @@ class BlockIter : public Iterator {
     return value_;
   }
 
+  virtual Status GetProperty(const std::string& prop_name,
+                             std::string* prop) override;
+
+  // Values point straight into the block contents. Keys are delta encoded
+  // and get rebuilt in key_, so they do not survive a move.
+  virtual bool IsValuePinned() const override { return true; }
+
   virtual void Next() override;
 
   virtual void Prev() override;
 
   virtual void Seek(const Slice& target) override;
 
+  // Like Seek(), for point lookups of the user key of target: uses the
+  // block's hash index, if it has one, to find the restart interval of the
+  // user key instead of searching the restart array.
+  void SeekForGet(const Slice& target);
+
   virtual void SeekToFirst() override;
 
   virtual void SeekToLast() override;
@@ -152,6 +186,9 @@ class BlockIter : public Iterator {
   Status status_;
   BlockHashIndex* hash_index_;
   BlockPrefixIndex* prefix_index_;
+  const char* fixed_key_column_;
+  uint32_t fixed_key_size_;
+  const DataBlockHashIndex* data_block_hash_index_;
 
   inline int Compare(const Slice& a, const Slice& b) const {
     return comparator_->Compare(a, b);
@@ -185,6 +222,8 @@ class BlockIter : public Iterator {
   bool BinarySeek(const Slice& target, uint32_t left, uint32_t right,
                   uint32_t* index);
 
+  bool FixedKeySeek(const Slice& target, uint32_t* index);
+
   int CompareBlockKey(uint32_t block_index, const Slice& target);
 
   bool BinaryBlockIndexSeek(const Slice& target, uint32_t* block_ids,
@@ -456,7 +456,10 @@ struct BlockBasedTableBuilder::Rep {
         table_options(table_opt),
         internal_comparator(icomparator),
         file(f),
-        data_block(table_options.block_restart_interval),
+        data_block(table_options.block_restart_interval,
+                   table_options.fixed_key_seek_column &&
+                       icomparator.user_comparator() == BytewiseComparator(),
+                   table_options.data_block_hash_index),
         internal_prefix_transform(_ioptions.prefix_extractor),
         index_builder(CreateIndexBuilder(table_options.index_type,
                                          &internal_comparator,
@@ -82,6 +82,13 @@ Status BlockBasedTableFactory::SanitizeOptions(
         "Unsupported BlockBasedTable format_version. Please check "
         "include/rocksdb/table.h for more info");
   }
+  if ((table_options_.fixed_key_seek_column ||
+       table_options_.data_block_hash_index) &&
+      table_options_.format_version < 3) {
+    return Status::InvalidArgument(
+        "fixed_key_seek_column and data_block_hash_index require "
+        "format_version >= 3");
+  }
   return Status::OK();
 }
 
@@ -141,6 +148,15 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   ret.append(buffer);
   snprintf(buffer, kBufferSize, "  whole_key_filtering: %d\n",
            table_options_.whole_key_filtering);
+  snprintf(buffer, kBufferSize, "  max_auto_readahead_size: %zd\n",
+           table_options_.max_auto_readahead_size);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  fixed_key_seek_column: %d\n",
+           table_options_.fixed_key_seek_column);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  data_block_hash_index: %d\n",
+           table_options_.data_block_hash_index);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  format_version: %d\n",
            table_options_.format_version);
   ret.append(buffer);
@@ -24,6 +24,7 @@
 #include "rocksdb/table.h"
 #include "rocksdb/table_properties.h"
 
+#include "table/adaptive_readahead_file.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/block_based_filter_block.h"
@@ -35,8 +36,10 @@
 #include "table/two_level_iterator.h"
 #include "table/get_context.h"
 
+#include "util/block_cache_tracer.h"
 #include "util/coding.h"
 #include "util/perf_context_imp.h"
+#include "util/request_tracer_imp.h"
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 
@@ -57,6 +60,11 @@ namespace {
 const size_t kMaxCacheKeyPrefixSize __attribute__((unused)) =
     kMaxVarint64Length * 3 + 1;
 
+// Readahead window of a table iterator once it starts prefetching. It is
+// doubled on every prefetch up to
+// BlockBasedTableOptions::max_auto_readahead_size.
+const size_t kInitAutoReadaheadSize = 8 * 1024;
+
 // Read the block identified by "handle" from "file".
 // The only relevant option is options.verify_checksums for now.
 // On failure return non-OK.
@@ -109,8 +117,10 @@ Cache::Handle* GetEntryFromCache(Cache* block_cache, const Slice& key,
                                  Tickers block_cache_miss_ticker,
                                  Tickers block_cache_hit_ticker,
                                  Statistics* statistics) {
+  TRACE_SPAN_GUARD(cache_lookup, TraceSpanType::kBlockCacheMiss);
   auto cache_handle = block_cache->Lookup(key);
   if (cache_handle != nullptr) {
+    TRACE_SPAN_SET_TYPE(cache_lookup, TraceSpanType::kBlockCacheHit);
     PERF_COUNTER_ADD(block_cache_hit_count, 1);
     // overall cache hit
     RecordTick(statistics, BLOCK_CACHE_HIT);
@@ -605,10 +615,14 @@ Status BlockBasedTable::GetDataBlockFromCache(
     const Slice& block_cache_key, const Slice& compressed_block_cache_key,
     Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
     const ReadOptions& read_options,
-    BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version) {
+    BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
+    bool* is_cache_hit) {
   Status s;
   Block* compressed_block = nullptr;
   Cache::Handle* block_cache_compressed_handle = nullptr;
+  if (is_cache_hit != nullptr) {
+    *is_cache_hit = false;
+  }
 
   // Lookup uncompressed cache first
   if (block_cache != nullptr) {
@@ -618,6 +632,9 @@ Status BlockBasedTable::GetDataBlockFromCache(
     if (block->cache_handle != nullptr) {
       block->value =
           reinterpret_cast<Block*>(block_cache->Value(block->cache_handle));
+      if (is_cache_hit != nullptr) {
+        *is_cache_hit = true;
+      }
       return s;
     }
   }
@@ -799,8 +816,11 @@ BlockBasedTable::CachableEntry<FilterBlockReader> BlockBasedTable::GetFilter(
   if (cache_handle != nullptr) {
     filter = reinterpret_cast<FilterBlockReader*>(
         block_cache->Value(cache_handle));
+    RecordBlockCacheLookup(kBlockTraceFilterBlock, key,
+                           filter->ApproximateMemoryUsage(), true, false);
   } else if (no_io) {
     // Do not invoke any io.
+    RecordBlockCacheLookup(kBlockTraceFilterBlock, key, 0, false, true);
     return CachableEntry<FilterBlockReader>();
   } else {
     size_t filter_size = 0;
@@ -817,6 +837,8 @@ BlockBasedTable::CachableEntry<FilterBlockReader> BlockBasedTable::GetFilter(
         RecordTick(statistics, BLOCK_CACHE_ADD);
       }
     }
+    RecordBlockCacheLookup(kBlockTraceFilterBlock, key, filter_size, false,
+                           filter == nullptr);
   }
 
   return { filter, cache_handle };
@@ -841,6 +863,7 @@ Iterator* BlockBasedTable::NewIndexIterator(const ReadOptions& read_options,
                         BLOCK_CACHE_INDEX_HIT, statistics);
 
   if (cache_handle == nullptr && no_io) {
+    RecordBlockCacheLookup(kBlockTraceIndexBlock, key, 0, false, true);
     if (input_iter != nullptr) {
       input_iter->SetStatus(Status::Incomplete("no blocking io"));
       return input_iter;
@@ -853,6 +876,8 @@ Iterator* BlockBasedTable::NewIndexIterator(const ReadOptions& read_options,
   if (cache_handle != nullptr) {
     index_reader =
         reinterpret_cast<IndexReader*>(block_cache->Value(cache_handle));
+    RecordBlockCacheLookup(kBlockTraceIndexBlock, key, index_reader->size(),
+                           true, false);
   } else {
     // Create index reader and put it in the cache.
     Status s;
@@ -872,6 +897,8 @@ Iterator* BlockBasedTable::NewIndexIterator(const ReadOptions& read_options,
     cache_handle = block_cache->Insert(key, index_reader, index_reader->size(),
                                        &DeleteCachedEntry<IndexReader>);
     RecordTick(statistics, BLOCK_CACHE_ADD);
+    RecordBlockCacheLookup(kBlockTraceIndexBlock, key, index_reader->size(),
+                           false, false);
   }
 
   assert(cache_handle);
@@ -887,8 +914,11 @@ Iterator* BlockBasedTable::NewIndexIterator(const ReadOptions& read_options,
 // If input_iter is not null, update this iter and return it
 Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
     const ReadOptions& ro, const Slice& index_value,
-    BlockIter* input_iter) {
+    BlockIter* input_iter, RandomAccessFile* file) {
   const bool no_io = (ro.read_tier == kBlockCacheTier);
+  if (file == nullptr) {
+    file = rep->file.get();
+  }
   Cache* block_cache = rep->table_options.block_cache.get();
   Cache* block_cache_compressed =
       rep->table_options.block_cache_compressed.get();
@@ -929,15 +959,17 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
                          compressed_cache_key);
     }
 
+    bool is_cache_hit = false;
     s = GetDataBlockFromCache(key, ckey, block_cache, block_cache_compressed,
                               statistics, ro, &block,
-                              rep->table_options.format_version);
+                              rep->table_options.format_version,
+                              &is_cache_hit);
 
     if (block.value == nullptr && !no_io && ro.fill_cache) {
       Block* raw_block = nullptr;
       {
         StopWatch sw(rep->ioptions.env, statistics, READ_BLOCK_GET_MICROS);
-        s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
+        s = ReadBlockFromFile(file, rep->footer, ro, handle,
                               &raw_block, rep->ioptions.env,
                               block_cache_compressed == nullptr);
       }
@@ -948,6 +980,15 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
                                 rep->table_options.format_version);
       }
     }
+
+    if (block_cache != nullptr) {
+      // A block read without filling the cache is not in memory yet. Its
+      // size is the one of the block on disk.
+      RecordBlockCacheLookup(
+          kBlockTraceDataBlock, key,
+          block.value != nullptr ? block.value->size() : handle.size(),
+          is_cache_hit, block.cache_handle == nullptr);
+    }
   }
 
   // Didn't get any data from block caches.
@@ -961,7 +1002,7 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
         return NewErrorIterator(Status::Incomplete("no blocking io"));
       }
     }
-    s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
+    s = ReadBlockFromFile(file, rep->footer, ro, handle,
                           &block.value, rep->ioptions.env);
   }
 
@@ -990,12 +1031,26 @@ class BlockBasedTable::BlockEntryIteratorState : public TwoLevelIteratorState {
   BlockEntryIteratorState(BlockBasedTable* table,
                           const ReadOptions& read_options)
       : TwoLevelIteratorState(
-          table->rep_->ioptions.prefix_extractor != nullptr),
+          table->rep_->ioptions.prefix_extractor != nullptr,
+          read_options.pin_data),
         table_(table),
-        read_options_(read_options) {}
+        read_options_(read_options) {
+    size_t max_readahead = table->rep_->table_options.max_auto_readahead_size;
+    if (max_readahead > 0 && !table->rep_->ioptions.allow_mmap_reads) {
+      readahead_file_.reset(new AdaptiveReadaheadFile(
+          table->rep_->file.get(), kInitAutoReadaheadSize, max_readahead));
+    }
+  }
 
   Iterator* NewSecondaryIterator(const Slice& index_value) override {
-    return NewDataBlockIterator(table_->rep_, read_options_, index_value);
+    return NewDataBlockIterator(table_->rep_, read_options_, index_value,
+                                nullptr, readahead_file_.get());
+  }
+
+  void OnSeek() override {
+    if (readahead_file_ != nullptr) {
+      readahead_file_->Reset();
+    }
   }
 
   bool PrefixMayMatch(const Slice& internal_key) override {
@@ -1009,6 +1064,8 @@ class BlockBasedTable::BlockEntryIteratorState : public TwoLevelIteratorState {
   // Don't own table_
   BlockBasedTable* table_;
   const ReadOptions read_options_;
+  // Prefetches data blocks during sequential scans; nullptr if disabled
+  std::unique_ptr<AdaptiveReadaheadFile> readahead_file_;
 };
 
 // This will be broken if the user specifies an unusual implementation
@@ -1116,7 +1173,13 @@ Status BlockBasedTable::Get(
   if (filter != nullptr && !filter->IsBlockBased()
                         && !filter->KeyMayMatch(ExtractUserKey(key))) {
     RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+    PERF_COUNTER_ADD(bloom_filter_useful, 1);
+    TRACE_EVENT(TraceSpanType::kFilterCheck, 0);
   } else {
+    if (filter != nullptr && !filter->IsBlockBased()) {
+      PERF_COUNTER_ADD(bloom_filter_positive, 1);
+      TRACE_EVENT(TraceSpanType::kFilterCheck, 1);
+    }
     BlockIter iiter;
     NewIndexIterator(read_options, &iiter);
 
@@ -1135,8 +1198,14 @@ Status BlockBasedTable::Get(
         // TODO: think about interaction with Merge. If a user key cannot
         // cross one data block, we should be fine.
         RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+        PERF_COUNTER_ADD(bloom_filter_useful, 1);
+        TRACE_EVENT(TraceSpanType::kFilterCheck, 0);
         break;
       } else {
+        if (filter != nullptr && filter->IsBlockBased()) {
+          PERF_COUNTER_ADD(bloom_filter_positive, 1);
+          TRACE_EVENT(TraceSpanType::kFilterCheck, 1);
+        }
         BlockIter biter;
         NewDataBlockIterator(rep_, read_options, iiter.value(), &biter);
 
@@ -1153,13 +1222,15 @@ Status BlockBasedTable::Get(
         }
 
         // Call the *saver function on each entry/block until it returns false
-        for (biter.Seek(key); biter.Valid(); biter.Next()) {
+        for (biter.SeekForGet(key); biter.Valid(); biter.Next()) {
           ParsedInternalKey parsed_key;
           if (!ParseInternalKey(biter.key(), &parsed_key)) {
             s = Status::Corruption(Slice());
           }
 
-          if (!get_context->SaveValue(parsed_key, biter.value())) {
+          // The value is handed out in place: if it is kept, the data
+          // block stays pinned until the caller releases the result.
+          if (!get_context->SaveValue(parsed_key, biter.value(), &biter)) {
             done = true;
             break;
           }
@@ -120,9 +120,11 @@ class BlockBasedTable : public TableReader {
 
   class BlockEntryIteratorState;
   // input_iter: if it is not null, update this one and return it as Iterator
+  // file: if it is not null, read the block through it instead of rep->file
   static Iterator* NewDataBlockIterator(Rep* rep, const ReadOptions& ro,
                                         const Slice& index_value,
-                                        BlockIter* input_iter = nullptr);
+                                        BlockIter* input_iter = nullptr,
+                                        RandomAccessFile* file = nullptr);
 
   // For the following two functions:
   // if `no_io == true`, we will not try to read filter/index from sst file
@@ -150,7 +152,8 @@ class BlockBasedTable : public TableReader {
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
       const ReadOptions& read_options,
-      BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version);
+      BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
+      bool* is_cache_hit = nullptr);
   // Put a raw block (maybe compressed) to the corresponding block caches.
   // This method will perform decompression against raw_block if needed and then
   // populate the block caches.
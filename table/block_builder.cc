@@ -30,6 +30,22 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// If the builder was asked for a fixed key column and all the restart keys
+// have the same length, the trailer is instead:
+//     restarts: uint32[num_restarts]
+//     restart_keys: char[num_restarts * key_size]
+//     key_size: uint32
+//     num_restarts | kBlockFixedKeyColumnFlag: uint32
+// restart_keys[i] is a copy of the key at restarts[i], so that a seek can
+// search the restart keys without decoding any entry.
+//
+// If the builder was asked for a hash index, and the block has few enough
+// restart points, the trailer is followed by a DataBlockHashIndex (see
+// data_block_hash_index.h) and kBlockHashIndexFlag is set in the last word:
+//     <trailer without its last word>
+//     hash_index: DataBlockHashIndex
+//     num_restarts | flags: uint32
 
 #include "table/block_builder.h"
 
@@ -37,15 +53,20 @@
 #include <assert.h>
 #include "rocksdb/comparator.h"
 #include "db/dbformat.h"
+#include "table/format.h"
 #include "util/coding.h"
 
 namespace rocksdb {
 
-BlockBuilder::BlockBuilder(int block_restart_interval)
+BlockBuilder::BlockBuilder(int block_restart_interval, bool fixed_key_column,
+                           bool hash_index)
     : block_restart_interval_(block_restart_interval),
+      fixed_key_column_(fixed_key_column),
+      hash_index_(hash_index),
       restarts_(),
       counter_(0),
-      finished_(false) {
+      finished_(false),
+      restart_keys_fixed_size_(true) {
   assert(block_restart_interval_ >= 1);
   restarts_.push_back(0);       // First restart point is at offset 0
 }
@@ -57,12 +78,22 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  restart_keys_.clear();
+  restart_keys_fixed_size_ = true;
+  hash_index_builder_.Reset();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  return (buffer_.size() +                        // Raw data buffer
-          restarts_.size() * sizeof(uint32_t) +   // Restart array
-          sizeof(uint32_t));                      // Restart array length
+  size_t estimate = buffer_.size() +                        // Raw data buffer
+                    restarts_.size() * sizeof(uint32_t) +   // Restart array
+                    sizeof(uint32_t);                       // Restart count
+  if (HasFixedKeyColumn()) {
+    estimate += restart_keys_.size() + sizeof(uint32_t);
+  }
+  if (hash_index_) {
+    estimate += hash_index_builder_.EstimateSize();
+  }
+  return estimate;
 }
 
 size_t BlockBuilder::EstimateSizeAfterKV(const Slice& key, const Slice& value)
@@ -71,6 +102,12 @@ size_t BlockBuilder::EstimateSizeAfterKV(const Slice& key, const Slice& value)
   estimate += key.size() + value.size();
   if (counter_ >= block_restart_interval_) {
     estimate += sizeof(uint32_t); // a new restart entry.
+    if (HasFixedKeyColumn()) {
+      estimate += key.size();  // a new restart key
+    }
+  }
+  if (hash_index_ && hash_index_builder_.Valid()) {
+    estimate += 2;  // hash buckets, rounded up
   }
 
   estimate += sizeof(int32_t); // varint for shared prefix length.
@@ -85,7 +122,20 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, static_cast<uint32_t>(restarts_.size()));
+  uint32_t num_restarts = static_cast<uint32_t>(restarts_.size());
+  assert((num_restarts & ~kBlockNumRestartsMask) == 0);
+  if (HasFixedKeyColumn()) {
+    buffer_.append(restart_keys_);
+    PutFixed32(&buffer_,
+               static_cast<uint32_t>(restart_keys_.size() / restarts_.size()));
+    num_restarts |= kBlockFixedKeyColumnFlag;
+  }
+  if (hash_index_ && hash_index_builder_.Valid() &&
+      !hash_index_builder_.empty()) {
+    hash_index_builder_.Finish(&buffer_);
+    num_restarts |= kBlockHashIndexFlag;
+  }
+  PutFixed32(&buffer_, num_restarts);
   finished_ = true;
   return Slice(buffer_);
 }
@@ -106,6 +156,19 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
     restarts_.push_back(static_cast<uint32_t>(buffer_.size()));
     counter_ = 0;
   }
+  if (fixed_key_column_ && counter_ == 0 && restart_keys_fixed_size_) {
+    if (!restart_keys_.empty() &&
+        key.size() * (restarts_.size() - 1) != restart_keys_.size()) {
+      // Restart keys of different sizes; write a regular block
+      restart_keys_fixed_size_ = false;
+      restart_keys_.clear();
+    } else {
+      restart_keys_.append(key.data(), key.size());
+    }
+  }
+  if (hash_index_) {
+    hash_index_builder_.Add(ExtractUserKey(key), restarts_.size() - 1);
+  }
   const size_t non_shared = key.size() - shared;
 
   // Add "<shared><non_shared><value_size>" to buffer_
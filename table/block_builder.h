@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include "rocksdb/slice.h"
+#include "table/data_block_hash_index.h"
 
 namespace rocksdb {
 
@@ -20,7 +21,20 @@ class BlockBuilder {
   BlockBuilder(const BlockBuilder&) = delete;
   void operator=(const BlockBuilder&) = delete;
 
-  explicit BlockBuilder(int block_restart_interval);
+  // If fixed_key_column is true and all the restart keys of a block turn out
+  // to have the same length, the block also stores a copy of them in a
+  // contiguous column (see block_builder.cc). Blocks with such a column
+  // cannot be read by RocksDB versions that predate it.
+  // REQUIRES: if fixed_key_column, keys are internal keys whose user keys
+  // are ordered bytewise; BlockIter::Seek() relies on that.
+  //
+  // If hash_index is true, the block also gets a hash index from user key
+  // to restart interval (see data_block_hash_index.h) used by
+  // BlockIter::SeekForGet(). Same compatibility caveat.
+  // REQUIRES: if hash_index, keys are internal keys.
+  explicit BlockBuilder(int block_restart_interval,
+                        bool fixed_key_column = false,
+                        bool hash_index = false);
 
   // Reset the contents as if the BlockBuilder was just constructed.
   void Reset();
@@ -47,13 +61,24 @@ class BlockBuilder {
   }
 
  private:
+  bool HasFixedKeyColumn() const {
+    return fixed_key_column_ && restart_keys_fixed_size_ &&
+           !restart_keys_.empty();
+  }
+
   const int          block_restart_interval_;
+  const bool         fixed_key_column_;
+  const bool         hash_index_;
 
   std::string           buffer_;    // Destination buffer
   std::vector<uint32_t> restarts_;  // Restart points
   int                   counter_;   // Number of entries emitted since restart
   bool                  finished_;  // Has Finish() been called?
   std::string           last_key_;
+  std::string           restart_keys_;  // Fixed key column being built
+  // False once restart keys of different lengths were added
+  bool                  restart_keys_fixed_size_;
+  DataBlockHashIndexBuilder hash_index_builder_;
 };
 
 }  // namespace rocksdb
@@ -234,6 +234,170 @@ TEST(BlockTest, IndexHashWithSharedPrefix) {
   CheckBlockContents(std::move(contents), kMaxKey, keys, values);
 }
 
+TEST(BlockTest, FixedKeyColumnSeek) {
+  Random rnd(301);
+  InternalKeyComparator icmp(BytewiseComparator());
+
+  // 16 byte user keys, with several versions of some of them
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  const int kNumUserKeys = 2000;
+  for (int i = 0; i < kNumUserKeys; i++) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016d", i * 2);
+    int versions = (i % 3 == 0) ? 3 : 1;
+    for (int v = 0; v < versions; v++) {
+      keys.push_back(InternalKey(buf, 1000 - v, kTypeValue).Encode().ToString());
+      values.push_back(RandomString(&rnd, 20));
+    }
+  }
+
+  BlockBuilder plain_builder(16);
+  BlockBuilder column_builder(16, true /* fixed_key_column */);
+  for (size_t i = 0; i < keys.size(); i++) {
+    plain_builder.Add(keys[i], values[i]);
+    column_builder.Add(keys[i], values[i]);
+  }
+  size_t column_size_estimate = column_builder.CurrentSizeEstimate();
+  ASSERT_EQ(plain_builder.CurrentSizeEstimate() +
+                (keys.size() + 15) / 16 * keys[0].size() + sizeof(uint32_t),
+            column_size_estimate);
+
+  BlockContents plain_contents;
+  plain_contents.data = plain_builder.Finish();
+  Block plain_block(std::move(plain_contents));
+  BlockContents column_contents;
+  column_contents.data = column_builder.Finish();
+  ASSERT_EQ(column_size_estimate, column_contents.data.size());
+  Block column_block(std::move(column_contents));
+  ASSERT_EQ(plain_block.NumRestarts(), column_block.NumRestarts());
+
+  std::unique_ptr<Iterator> plain_iter(plain_block.NewIterator(&icmp));
+  std::unique_ptr<Iterator> column_iter(column_block.NewIterator(&icmp));
+
+  // Full scans see the same entries
+  int count = 0;
+  for (column_iter->SeekToFirst(); column_iter->Valid(); column_iter->Next()) {
+    ASSERT_EQ(keys[count], column_iter->key().ToString());
+    ASSERT_EQ(values[count], column_iter->value().ToString());
+    count++;
+  }
+  ASSERT_EQ(static_cast<int>(keys.size()), count);
+
+  // Existing and missing user keys, at various sequence numbers
+  for (int i = -1; i <= kNumUserKeys * 2; i++) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016d", i);
+    for (SequenceNumber seq : {2000, 999, 500}) {
+      std::string target =
+          InternalKey(buf, seq, kValueTypeForSeek).Encode().ToString();
+      plain_iter->Seek(target);
+      column_iter->Seek(target);
+      ASSERT_EQ(plain_iter->Valid(), column_iter->Valid());
+      if (plain_iter->Valid()) {
+        ASSERT_EQ(plain_iter->key().ToString(), column_iter->key().ToString());
+        ASSERT_EQ(plain_iter->value().ToString(),
+                  column_iter->value().ToString());
+      }
+    }
+  }
+
+  // Restart keys of different sizes: the builder writes a regular block
+  BlockBuilder mixed_builder(1, true /* fixed_key_column */);
+  mixed_builder.Add(InternalKey("a", 1, kTypeValue).Encode(), "v");
+  mixed_builder.Add(InternalKey("bb", 1, kTypeValue).Encode(), "v");
+  BlockBuilder regular_builder(1);
+  regular_builder.Add(InternalKey("a", 1, kTypeValue).Encode(), "v");
+  regular_builder.Add(InternalKey("bb", 1, kTypeValue).Encode(), "v");
+  ASSERT_EQ(regular_builder.Finish().ToString(),
+            mixed_builder.Finish().ToString());
+}
+
+TEST(BlockTest, DataBlockHashIndexSeekForGet) {
+  Random rnd(301);
+  InternalKeyComparator icmp(BytewiseComparator());
+
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  const int kNumUserKeys = 500;
+  for (int i = 0; i < kNumUserKeys; i++) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016d", i * 2);
+    int versions = (i % 3 == 0) ? 3 : 1;
+    for (int v = 0; v < versions; v++) {
+      keys.push_back(InternalKey(buf, 1000 - v, kTypeValue).Encode().ToString());
+      values.push_back(RandomString(&rnd, 20));
+    }
+  }
+
+  // With and without the fixed key column, which sits before the hash index
+  for (bool fixed_key_column : {false, true}) {
+    BlockBuilder plain_builder(16);
+    BlockBuilder hash_builder(16, fixed_key_column, true /* hash_index */);
+    for (size_t i = 0; i < keys.size(); i++) {
+      plain_builder.Add(keys[i], values[i]);
+      hash_builder.Add(keys[i], values[i]);
+    }
+    size_t hash_size_estimate = hash_builder.CurrentSizeEstimate();
+    BlockContents plain_contents;
+    plain_contents.data = plain_builder.Finish();
+    Block plain_block(std::move(plain_contents));
+    BlockContents hash_contents;
+    hash_contents.data = hash_builder.Finish();
+    ASSERT_EQ(hash_size_estimate, hash_contents.data.size());
+    Block hash_block(std::move(hash_contents));
+    ASSERT_EQ(plain_block.NumRestarts(), hash_block.NumRestarts());
+
+    BlockIter plain_iter;
+    plain_block.NewIterator(&icmp, &plain_iter);
+    BlockIter hash_iter;
+    hash_block.NewIterator(&icmp, &hash_iter);
+
+    int count = 0;
+    for (hash_iter.SeekToFirst(); hash_iter.Valid(); hash_iter.Next()) {
+      ASSERT_EQ(keys[count], hash_iter.key().ToString());
+      count++;
+    }
+    ASSERT_EQ(static_cast<int>(keys.size()), count);
+
+    for (int i = -1; i <= kNumUserKeys * 2; i++) {
+      char buf[17];
+      snprintf(buf, sizeof(buf), "%016d", i);
+      for (SequenceNumber seq : {2000, 999, 500}) {
+        std::string target =
+            InternalKey(buf, seq, kValueTypeForSeek).Encode().ToString();
+        plain_iter.Seek(target);
+        hash_iter.SeekForGet(target);
+        if (i >= 0 && i % 2 == 0) {
+          // Present user key: same position as Seek()
+          ASSERT_EQ(plain_iter.Valid(), hash_iter.Valid());
+          if (plain_iter.Valid()) {
+            ASSERT_EQ(plain_iter.key().ToString(), hash_iter.key().ToString());
+            ASSERT_EQ(plain_iter.value().ToString(),
+                      hash_iter.value().ToString());
+          }
+        } else if (hash_iter.Valid()) {
+          // Missing user key: never lands on an entry of that user key
+          ASSERT_TRUE(ExtractUserKey(hash_iter.key()) != Slice(buf));
+          ASSERT_GT(icmp.Compare(hash_iter.key(), target), 0);
+        }
+      }
+    }
+  }
+
+  // Too many restart points for a one byte bucket: no hash index is written
+  BlockBuilder many_restarts_builder(1, false, true /* hash_index */);
+  BlockBuilder regular_builder(1);
+  for (int i = 0; i < 300; i++) {
+    std::string key = InternalKey("key" + std::to_string(1000 + i), 1,
+                                  kTypeValue).Encode().ToString();
+    many_restarts_builder.Add(key, "v");
+    regular_builder.Add(key, "v");
+  }
+  ASSERT_EQ(regular_builder.Finish().ToString(),
+            many_restarts_builder.Finish().ToString());
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
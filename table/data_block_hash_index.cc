@@ -0,0 +1,78 @@
+// Copyright (c) 2013, Facebook, Inc. All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/data_block_hash_index.h"
+
+#include <assert.h>
+#include <algorithm>
+
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+namespace {
+const uint32_t kHashSeed = 397;
+
+inline uint32_t HashUserKey(const Slice& user_key) {
+  return Hash(user_key.data(), user_key.size(), kHashSeed);
+}
+}  // namespace
+
+void DataBlockHashIndexBuilder::Add(const Slice& user_key,
+                                    size_t restart_index) {
+  if (!valid_) {
+    return;
+  }
+  if (restart_index > kMaxRestartSupportedByHashIndex) {
+    valid_ = false;
+    hash_and_restart_pairs_.clear();
+    return;
+  }
+  hash_and_restart_pairs_.emplace_back(HashUserKey(user_key),
+                                       static_cast<uint8_t>(restart_index));
+}
+
+uint32_t DataBlockHashIndexBuilder::NumBuckets() const {
+  uint32_t num_buckets = static_cast<uint32_t>(
+      static_cast<double>(hash_and_restart_pairs_.size()) / util_ratio_);
+  // An odd number of buckets spreads the hashes better
+  return num_buckets | 1;
+}
+
+size_t DataBlockHashIndexBuilder::EstimateSize() const {
+  if (!valid_ || empty()) {
+    return 0;
+  }
+  return NumBuckets() + sizeof(uint32_t);
+}
+
+void DataBlockHashIndexBuilder::Finish(std::string* buffer) const {
+  assert(valid_ && !empty());
+  uint32_t num_buckets = NumBuckets();
+  std::vector<uint8_t> buckets(num_buckets, kNoEntry);
+  for (const auto& entry : hash_and_restart_pairs_) {
+    uint8_t& bucket = buckets[entry.first % num_buckets];
+    if (bucket == kNoEntry) {
+      bucket = entry.second;
+    } else if (bucket != entry.second) {
+      bucket = kCollision;
+    }
+  }
+  buffer->append(reinterpret_cast<const char*>(buckets.data()), num_buckets);
+  PutFixed32(buffer, num_buckets);
+}
+
+void DataBlockHashIndexBuilder::Reset() {
+  valid_ = true;
+  hash_and_restart_pairs_.clear();
+}
+
+uint8_t DataBlockHashIndex::Lookup(const Slice& user_key) const {
+  assert(num_buckets_ > 0);
+  return static_cast<uint8_t>(buckets_[HashUserKey(user_key) % num_buckets_]);
+}
+
+}  // namespace rocksdb
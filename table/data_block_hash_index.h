@@ -0,0 +1,81 @@
+// Copyright (c) 2013, Facebook, Inc. All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+
+namespace rocksdb {
+
+// A small hash table appended to a data block that maps the user keys of
+// the block to the restart interval they are stored in, so a point lookup
+// can jump straight to the right restart point instead of binary searching
+// the restart array.
+//
+// Format:
+//     buckets: uint8[num_buckets]
+//     num_buckets: uint32
+// Each bucket holds the restart index of the user keys that hash to it,
+// kNoEntry if none does, or kCollision if user keys from different restart
+// intervals do (including a single user key whose versions span two
+// intervals). Restart indexes above kMaxRestartSupportedByHashIndex cannot
+// be represented; blocks with more restart points get no hash index.
+const uint8_t kNoEntry = 255;
+const uint8_t kCollision = 254;
+const uint8_t kMaxRestartSupportedByHashIndex = 253;
+
+class DataBlockHashIndexBuilder {
+ public:
+  // util_ratio: number of distinct hashes per bucket we aim for
+  explicit DataBlockHashIndexBuilder(double util_ratio = 0.75)
+      : util_ratio_(util_ratio), valid_(true) {}
+
+  void Add(const Slice& user_key, size_t restart_index);
+
+  // False if the block has too many restart points for a hash index
+  bool Valid() const { return valid_; }
+  bool empty() const { return hash_and_restart_pairs_.empty(); }
+
+  // Size of the hash index if Finish() was called now
+  size_t EstimateSize() const;
+
+  // Append the hash index to buffer.
+  // REQUIRES: Valid() && !empty()
+  void Finish(std::string* buffer) const;
+
+  void Reset();
+
+ private:
+  uint32_t NumBuckets() const;
+
+  const double util_ratio_;
+  bool valid_;
+  std::vector<std::pair<uint32_t, uint8_t>> hash_and_restart_pairs_;
+};
+
+// Read-only view over the hash index of a block. Does not own the data.
+class DataBlockHashIndex {
+ public:
+  DataBlockHashIndex() : buckets_(nullptr), num_buckets_(0) {}
+
+  void Initialize(const char* buckets, uint32_t num_buckets) {
+    buckets_ = buckets;
+    num_buckets_ = num_buckets;
+  }
+
+  // Returns the restart index of user_key, kNoEntry or kCollision
+  uint8_t Lookup(const Slice& user_key) const;
+
+  size_t size() const { return num_buckets_ + sizeof(uint32_t); }
+
+ private:
+  const char* buckets_;
+  uint32_t num_buckets_;
+};
+
+}  // namespace rocksdb
@@ -18,6 +18,7 @@
 #include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/perf_context_imp.h"
+#include "util/request_tracer_imp.h"
 #include "util/xxhash.h"
 
 namespace rocksdb {
@@ -256,6 +257,8 @@ Status ReadBlock(RandomAccessFile* file, const Footer& footer,
 
   {
     PERF_TIMER_GUARD(block_read_time);
+    TRACE_SPAN_GUARD(block_read, TraceSpanType::kBlockRead);
+    TRACE_SPAN_SET_VALUE(block_read, n + kBlockTrailerSize);
     s = file->Read(handle.offset(), n + kBlockTrailerSize, contents, buf);
   }
 
@@ -358,6 +361,7 @@ Status ReadBlockContents(RandomAccessFile* file, const Footer& footer,
 Status UncompressBlockContents(const char* data, size_t n,
                                BlockContents* contents,
                                uint32_t format_version) {
+  TRACE_SPAN_GUARD(decompress, TraceSpanType::kBlockDecompress);
   std::unique_ptr<char[]> ubuf;
   int decompress_size = 0;
   assert(data[n] != kNoCompression);
@@ -427,6 +431,7 @@ Status UncompressBlockContents(const char* data, size_t n,
     default:
       return Status::Corruption("bad block type");
   }
+  TRACE_SPAN_SET_VALUE(decompress, contents->data.size());
   return Status::OK();
 }
 
@@ -77,7 +77,7 @@ inline uint32_t GetCompressFormatForVersion(CompressionType compression_type,
 }
 
 inline bool BlockBasedTableSupportedVersion(uint32_t version) {
-  return version <= 2;
+  return version <= 3;
 }
 
 // Footer encapsulates the fixed information stored at the tail
@@ -173,6 +173,13 @@ Status ReadFooterFromFile(RandomAccessFile* file, uint64_t file_size,
 // 1-byte type + 32-bit crc
 static const size_t kBlockTrailerSize = 5;
 
+// The last fixed32 of a block holds the number of restart points. Its top
+// bits flag optional search structures that BlockBuilder appended after the
+// restart array; see block_builder.cc for their layout.
+static const uint32_t kBlockHashIndexFlag = 1u << 31;
+static const uint32_t kBlockFixedKeyColumnFlag = 1u << 30;
+static const uint32_t kBlockNumRestartsMask = (1u << 30) - 1;
+
 struct BlockContents {
   Slice data;           // Actual contents of data
   bool cachable;        // True iff data can be cached
@@ -5,6 +5,7 @@
 
 #include "table/get_context.h"
 #include "rocksdb/merge_operator.h"
+#include "rocksdb/slice.h"
 #include "rocksdb/statistics.h"
 #include "util/statistics.h"
 
@@ -13,15 +14,16 @@ namespace rocksdb {
 GetContext::GetContext(const Comparator* ucmp,
       const MergeOperator* merge_operator,
       Logger* logger, Statistics* statistics,
-      GetState init_state, const Slice& user_key, std::string* ret_value,
-      bool* value_found, MergeContext* merge_context)
+      GetState init_state, const Slice& user_key,
+      PinnableSlice* pinnable_val, bool* value_found,
+      MergeContext* merge_context)
   : ucmp_(ucmp),
     merge_operator_(merge_operator),
     logger_(logger),
     statistics_(statistics),
     state_(init_state),
     user_key_(user_key),
-    value_(ret_value),
+    pinnable_val_(pinnable_val),
     value_found_(value_found),
     merge_context_(merge_context) {
 }
@@ -40,11 +42,11 @@ void GetContext::MarkKeyMayExist() {
 
 void GetContext::SaveValue(const Slice& value) {
   state_ = kFound;
-  value_->assign(value.data(), value.size());
+  pinnable_val_->PinSelf(value);
 }
 
 bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
-                           const Slice& value) {
+                           const Slice& value, Cleanable* value_pinner) {
   assert((state_ != kMerge && parsed_key.type != kTypeMerge) ||
          merge_context_ != nullptr);
   if (ucmp_->Compare(parsed_key.user_key, user_key_) == 0) {
@@ -54,16 +56,21 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
         assert(state_ == kNotFound || state_ == kMerge);
         if (kNotFound == state_) {
           state_ = kFound;
-          value_->assign(value.data(), value.size());
+          if (value_pinner != nullptr) {
+            pinnable_val_->PinSlice(value, value_pinner);
+          } else {
+            pinnable_val_->PinSelf(value);
+          }
         } else if (kMerge == state_) {
           assert(merge_operator_ != nullptr);
           state_ = kFound;
           if (!merge_operator_->FullMerge(user_key_, &value,
                                           merge_context_->GetOperands(),
-                                          value_, logger_)) {
+                                          pinnable_val_->GetSelf(), logger_)) {
             RecordTick(statistics_, NUMBER_MERGE_FAILURES);
             state_ = kCorrupt;
           }
+          pinnable_val_->PinSelf();
         }
         return false;
 
@@ -75,10 +82,11 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           state_ = kFound;
           if (!merge_operator_->FullMerge(user_key_, nullptr,
                                           merge_context_->GetOperands(),
-                                          value_, logger_)) {
+                                          pinnable_val_->GetSelf(), logger_)) {
             RecordTick(statistics_, NUMBER_MERGE_FAILURES);
             state_ = kCorrupt;
           }
+          pinnable_val_->PinSelf();
         }
         return false;
 
@@ -9,6 +9,8 @@
 
 namespace rocksdb {
 class MergeContext;
+class Cleanable;
+class PinnableSlice;
 
 class GetContext {
  public:
@@ -22,12 +24,19 @@ class GetContext {
 
   GetContext(const Comparator* ucmp, const MergeOperator* merge_operator,
              Logger* logger, Statistics* statistics,
-             GetState init_state, const Slice& user_key, std::string* ret_value,
-             bool* value_found, MergeContext* merge_context);
+             GetState init_state, const Slice& user_key,
+             PinnableSlice* pinnable_val, bool* value_found,
+             MergeContext* merge_context);
 
   void MarkKeyMayExist();
   void SaveValue(const Slice& value);
-  bool SaveValue(const ParsedInternalKey& parsed_key, const Slice& value);
+
+  // Records an entry of the table that matches "parsed_key". If
+  // "value_pinner" is not null and the value can be handed out as is, the
+  // cleanups registered in "value_pinner" are moved to the result so that
+  // "value" stays valid without being copied.
+  bool SaveValue(const ParsedInternalKey& parsed_key, const Slice& value,
+                 Cleanable* value_pinner = nullptr);
   GetState State() const { return state_; }
 
  private:
@@ -39,7 +48,7 @@ class GetContext {
 
   GetState state_;
   Slice user_key_;
-  std::string* value_;
+  PinnableSlice* pinnable_val_;
   bool* value_found_;  // Is value set correctly? Used by KeyMayExist
   MergeContext* merge_context_;
 };
@@ -8,17 +8,28 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "rocksdb/iterator.h"
+
+#include <stdlib.h>
+
 #include "table/iterator_wrapper.h"
 #include "util/arena.h"
 
 namespace rocksdb {
 
-Iterator::Iterator() {
+Cleanable::Cleanable() {
+  cleanup_.function = nullptr;
+  cleanup_.next = nullptr;
+}
+
+Cleanable::~Cleanable() { DoCleanup(); }
+
+void Cleanable::Reset() {
+  DoCleanup();
   cleanup_.function = nullptr;
   cleanup_.next = nullptr;
 }
 
-Iterator::~Iterator() {
+void Cleanable::DoCleanup() {
   if (cleanup_.function != nullptr) {
     (*cleanup_.function)(cleanup_.arg1, cleanup_.arg2);
     for (Cleanup* c = cleanup_.next; c != nullptr; ) {
@@ -30,7 +41,23 @@ Iterator::~Iterator() {
   }
 }
 
-void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
+void Cleanable::DelegateCleanupsTo(Cleanable* other) {
+  assert(other != nullptr && other != this);
+  if (cleanup_.function == nullptr) {
+    return;
+  }
+  other->RegisterCleanup(cleanup_.function, cleanup_.arg1, cleanup_.arg2);
+  for (Cleanup* c = cleanup_.next; c != nullptr; ) {
+    other->RegisterCleanup(c->function, c->arg1, c->arg2);
+    Cleanup* next = c->next;
+    delete c;
+    c = next;
+  }
+  cleanup_.function = nullptr;
+  cleanup_.next = nullptr;
+}
+
+void Cleanable::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   assert(func != nullptr);
   Cleanup* c;
   if (cleanup_.function == nullptr) {
@@ -45,6 +72,30 @@ void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   c->arg2 = arg2;
 }
 
+Iterator::Iterator() {}
+
+Iterator::~Iterator() {}
+
+Status Iterator::GetProperty(const std::string& prop_name, std::string* prop) {
+  if (prop == nullptr) {
+    return Status::InvalidArgument("prop is nullptr");
+  }
+  if (prop_name == "rocksdb.iterator.pinned-data-size") {
+    *prop = "0";
+    return Status::OK();
+  }
+  return Status::InvalidArgument("Unidentified property.");
+}
+
+uint64_t GetPinnedDataSize(Iterator* iter) {
+  std::string prop;
+  if (iter == nullptr ||
+      !iter->GetProperty("rocksdb.iterator.pinned-data-size", &prop).ok()) {
+    return 0;
+  }
+  return strtoull(prop.c_str(), nullptr, 10);
+}
+
 namespace {
 class EmptyIterator : public Iterator {
  public:
@@ -69,6 +69,10 @@ class IteratorWrapper {
   Slice key_;
 };
 
+// Return the "rocksdb.iterator.pinned-data-size" property of iter as a
+// number, or 0 if iter is null or does not report it.
+extern uint64_t GetPinnedDataSize(Iterator* iter);
+
 class Arena;
 // Return an empty iterator (yields nothing) allocated from arena.
 extern Iterator* NewEmptyIterator(Arena* arena);
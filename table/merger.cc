@@ -21,6 +21,7 @@
 #include "util/stop_watch.h"
 #include "util/perf_context_imp.h"
 #include "util/autovector.h"
+#include "util/logging.h"
 
 namespace rocksdb {
 // Without anonymous namespace here, we fail the warning -Wmissing-prototypes
@@ -247,6 +248,32 @@ class MergingIterator : public Iterator {
     return s;
   }
 
+  virtual Status GetProperty(const std::string& prop_name,
+                             std::string* prop) override {
+    if (prop == nullptr) {
+      return Status::InvalidArgument("prop is nullptr");
+    }
+    if (prop_name == "rocksdb.iterator.pinned-data-size") {
+      uint64_t pinned_size = 0;
+      for (auto& child : children_) {
+        pinned_size += GetPinnedDataSize(child.iter());
+      }
+      *prop = NumberToString(pinned_size);
+      return Status::OK();
+    }
+    return Iterator::GetProperty(prop_name, prop);
+  }
+
+  virtual bool IsKeyPinned() const override {
+    assert(Valid());
+    return current_->iter()->IsKeyPinned();
+  }
+
+  virtual bool IsValuePinned() const override {
+    assert(Valid());
+    return current_->iter()->IsValuePinned();
+  }
+
  private:
   void FindSmallest();
   void FindLargest();
@@ -14,6 +14,7 @@
 #include "table/block.h"
 #include "table/format.h"
 #include "util/arena.h"
+#include "util/logging.h"
 
 namespace rocksdb {
 
@@ -58,6 +59,28 @@ class TwoLevelIterator: public Iterator {
     }
   }
 
+  virtual Status GetProperty(const std::string& prop_name,
+                             std::string* prop) override {
+    if (prop == nullptr) {
+      return Status::InvalidArgument("prop is nullptr");
+    }
+    if (prop_name == "rocksdb.iterator.pinned-data-size") {
+      *prop = NumberToString(pinned_data_size_ +
+                             GetPinnedDataSize(second_level_iter_.iter()));
+      return Status::OK();
+    }
+    return Iterator::GetProperty(prop_name, prop);
+  }
+
+  virtual bool IsKeyPinned() const override {
+    return state_->pin_data && second_level_iter_.iter() != nullptr &&
+           second_level_iter_.iter()->IsKeyPinned();
+  }
+  virtual bool IsValuePinned() const override {
+    return state_->pin_data && second_level_iter_.iter() != nullptr &&
+           second_level_iter_.iter()->IsValuePinned();
+  }
+
  private:
   void SaveError(const Status& s) {
     if (status_.ok() && !s.ok()) status_ = s;
@@ -74,13 +97,18 @@ class TwoLevelIterator: public Iterator {
   // If second_level_iter is non-nullptr, then "data_block_handle_" holds the
   // "index_value" passed to block_function_ to create the second_level_iter.
   std::string data_block_handle_;
+  // Size of the data pinned by the secondary iterators we already let go of.
+  // Only non-zero when state_->pin_data is set.
+  uint64_t pinned_data_size_;
 };
 
 TwoLevelIterator::TwoLevelIterator(TwoLevelIteratorState* state,
     Iterator* first_level_iter)
-  : state_(state), first_level_iter_(first_level_iter) {}
+  : state_(state), first_level_iter_(first_level_iter),
+    pinned_data_size_(0) {}
 
 void TwoLevelIterator::Seek(const Slice& target) {
+  state_->OnSeek();
   if (state_->check_prefix_may_match &&
       !state_->PrefixMayMatch(target)) {
     SetSecondLevelIterator(nullptr);
@@ -96,6 +124,7 @@ void TwoLevelIterator::Seek(const Slice& target) {
 }
 
 void TwoLevelIterator::SeekToFirst() {
+  state_->OnSeek();
   first_level_iter_.SeekToFirst();
   InitDataBlock();
   if (second_level_iter_.iter() != nullptr) {
@@ -105,6 +134,7 @@ void TwoLevelIterator::SeekToFirst() {
 }
 
 void TwoLevelIterator::SeekToLast() {
+  state_->OnSeek();
   first_level_iter_.SeekToLast();
   InitDataBlock();
   if (second_level_iter_.iter() != nullptr) {
@@ -161,8 +191,19 @@ void TwoLevelIterator::SkipEmptyDataBlocksBackward() {
 }
 
 void TwoLevelIterator::SetSecondLevelIterator(Iterator* iter) {
-  if (second_level_iter_.iter() != nullptr) {
-    SaveError(second_level_iter_.status());
+  Iterator* old_iter = second_level_iter_.iter();
+  if (old_iter != nullptr) {
+    SaveError(old_iter->status());
+    if (state_->pin_data && old_iter != iter) {
+      // Keep whatever the old iterator pinned alive until we are deleted.
+      // Cleanups it registered after it was created (e.g. blocks pinned by
+      // a nested two level iterator) are picked up here.
+      pinned_data_size_ += GetPinnedDataSize(old_iter);
+      old_iter->DelegateCleanupsTo(this);
+    }
+  }
+  if (iter != nullptr && state_->pin_data) {
+    iter->DelegateCleanupsTo(this);
   }
   second_level_iter_.Set(iter);
 }
@@ -19,15 +19,24 @@ class InternalKeyComparator;
 class Arena;
 
 struct TwoLevelIteratorState {
-  explicit TwoLevelIteratorState(bool _check_prefix_may_match)
-      : check_prefix_may_match(_check_prefix_may_match) {}
+  explicit TwoLevelIteratorState(bool _check_prefix_may_match,
+                                 bool _pin_data = false)
+      : check_prefix_may_match(_check_prefix_may_match),
+        pin_data(_pin_data) {}
 
   virtual ~TwoLevelIteratorState() {}
   virtual Iterator* NewSecondaryIterator(const Slice& handle) = 0;
   virtual bool PrefixMayMatch(const Slice& internal_key) = 0;
+  // Called whenever the two level iterator is repositioned by a Seek(),
+  // SeekToFirst() or SeekToLast().
+  virtual void OnSeek() {}
 
   // If call PrefixMayMatch()
   bool check_prefix_may_match;
+  // If true, the resources held by every secondary iterator (e.g. block
+  // cache handles) are released only when the two level iterator is
+  // deleted, not when it moves on to the next secondary iterator.
+  bool pin_data;
 };
 
 
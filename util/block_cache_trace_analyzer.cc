@@ -0,0 +1,311 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+#ifndef ROCKSDB_LITE
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "util/block_cache_trace_analyzer.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "rocksdb/trace_reader_writer.h"
+
+namespace rocksdb {
+
+namespace {
+
+const char* BlockTypeName(TraceType type) {
+  switch (type) {
+    case kBlockTraceIndexBlock:
+      return "index";
+    case kBlockTraceFilterBlock:
+      return "filter";
+    case kBlockTraceDataBlock:
+      return "data";
+    default:
+      return "unknown";
+  }
+}
+
+const char* CallerName(BlockCacheLookupCaller caller) {
+  switch (caller) {
+    case BlockCacheLookupCaller::kUserGet:
+      return "Get";
+    case BlockCacheLookupCaller::kUserMultiGet:
+      return "MultiGet";
+    case BlockCacheLookupCaller::kUserIterator:
+      return "Iterator";
+    case BlockCacheLookupCaller::kCompaction:
+      return "Compaction";
+    default:
+      return "unknown";
+  }
+}
+
+double HitRatio(uint64_t hits, uint64_t accesses) {
+  return accesses == 0 ? 0.0 : 100.0 * hits / accesses;
+}
+
+template <class Key>
+uint64_t Lookup(const std::map<Key, uint64_t>& counts, const Key& key) {
+  auto it = counts.find(key);
+  return it == counts.end() ? 0 : it->second;
+}
+
+// Parses a size such as 1024, 64K, 512M or 2G
+bool ParseCacheSize(const std::string& value, uint64_t* size) {
+  char* end;
+  uint64_t n = strtoull(value.c_str(), &end, 10);
+  if (end == value.c_str()) {
+    return false;
+  }
+  switch (*end) {
+    case 'k':
+    case 'K':
+      n <<= 10;
+      ++end;
+      break;
+    case 'm':
+    case 'M':
+      n <<= 20;
+      ++end;
+      break;
+    case 'g':
+    case 'G':
+      n <<= 30;
+      ++end;
+      break;
+  }
+  *size = n;
+  return *end == '\0' && n > 0;
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    if (end > start) {
+      items.push_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return items;
+}
+
+void print_help() {
+  fprintf(stderr,
+          "block_cache_trace_analyzer --trace_file=<block cache trace>"
+          " [--cache_sizes=16M,64M,256M,1G,4G]"
+          " [--policies=lru,ghost_lru,ghost_lru_data]"
+          " [--num_shard_bits=N]\n");
+}
+
+}  // namespace
+
+BlockCacheTraceAnalyzer::BlockCacheTraceAnalyzer(Env* env,
+                                                 const std::string& trace_file)
+    : env_(env),
+      trace_file_(trace_file),
+      sampling_frequency_(1),
+      num_accesses_(0),
+      num_cache_hits_(0),
+      first_access_micros_(0),
+      last_access_micros_(0) {}
+
+void BlockCacheTraceAnalyzer::AddSimulation(const std::string& policy,
+                                            uint64_t cache_size,
+                                            int num_shard_bits) {
+  Simulation simulation;
+  simulation.policy = policy;
+  simulation.cache_size = cache_size;
+  simulation.num_shard_bits = num_shard_bits;
+  simulations_.push_back(std::move(simulation));
+}
+
+Status BlockCacheTraceAnalyzer::Analyze() {
+  std::unique_ptr<TraceReader> trace_reader;
+  Status s = NewFileTraceReader(env_, EnvOptions(), trace_file_, &trace_reader);
+  if (!s.ok()) {
+    return s;
+  }
+  BlockCacheTraceReader reader(std::move(trace_reader));
+  s = reader.ReadHeader(&sampling_frequency_);
+  if (!s.ok()) {
+    return s;
+  }
+  if (sampling_frequency_ == 0) {
+    sampling_frequency_ = 1;
+  }
+  for (auto& simulation : simulations_) {
+    s = NewCacheSimulator(simulation.policy,
+                          simulation.cache_size / sampling_frequency_,
+                          simulation.num_shard_bits, &simulation.simulator);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  BlockCacheTraceRecord access;
+  for (s = reader.ReadAccess(&access); s.ok();
+       s = reader.ReadAccess(&access)) {
+    RecordAccess(access);
+    for (auto& simulation : simulations_) {
+      simulation.simulator->Access(access);
+    }
+  }
+  // A trace that was not ended, as when the DB crashed, has no kTraceEnd
+  // record, but all its lookups are usable
+  return s.IsIncomplete() ? Status::OK() : s;
+}
+
+void BlockCacheTraceAnalyzer::RecordAccess(
+    const BlockCacheTraceRecord& access) {
+  if (num_accesses_ == 0) {
+    first_access_micros_ = access.access_timestamp;
+  }
+  last_access_micros_ = access.access_timestamp;
+  ++num_accesses_;
+  ++type_accesses_[access.block_type];
+  ++caller_accesses_[access.caller];
+  ++level_accesses_[access.level];
+  if (access.is_cache_hit) {
+    ++num_cache_hits_;
+    ++type_hits_[access.block_type];
+    ++caller_hits_[access.caller];
+    ++level_hits_[access.level];
+  }
+  if (access.block_size > 0) {
+    block_sizes_[access.block_key] = access.block_size;
+  } else {
+    block_sizes_.insert({access.block_key, 0});
+  }
+}
+
+void BlockCacheTraceAnalyzer::PrintStatistics(FILE* out) const {
+  uint64_t total_block_size = 0;
+  for (const auto& block : block_sizes_) {
+    total_block_size += block.second;
+  }
+  fprintf(out,
+          "%" PRIu64 " lookups of %" PRIu64 " blocks of %" PRIu64
+          " bytes over %.1f seconds, sampled 1 out of %" PRIu64 " blocks\n",
+          num_accesses_, static_cast<uint64_t>(block_sizes_.size()),
+          total_block_size,
+          (last_access_micros_ - first_access_micros_) / 1000000.0,
+          sampling_frequency_);
+  fprintf(out, "Traced hit ratio: %.2f%%\n",
+          HitRatio(num_cache_hits_, num_accesses_));
+
+  fprintf(out, "\n%-12s %12s %10s\n", "Block type", "Lookups", "Hit ratio");
+  for (const auto& type : type_accesses_) {
+    fprintf(out, "%-12s %12" PRIu64 " %9.2f%%\n", BlockTypeName(type.first),
+            type.second, HitRatio(Lookup(type_hits_, type.first), type.second));
+  }
+  fprintf(out, "\n%-12s %12s %10s\n", "Caller", "Lookups", "Hit ratio");
+  for (const auto& caller : caller_accesses_) {
+    fprintf(out, "%-12s %12" PRIu64 " %9.2f%%\n", CallerName(caller.first),
+            caller.second,
+            HitRatio(Lookup(caller_hits_, caller.first), caller.second));
+  }
+  fprintf(out, "\n%-12s %12s %10s\n", "Level", "Lookups", "Hit ratio");
+  for (const auto& level : level_accesses_) {
+    char name[16];
+    if (level.first < 0) {
+      snprintf(name, sizeof(name), "unknown");
+    } else {
+      snprintf(name, sizeof(name), "%d", level.first);
+    }
+    fprintf(out, "%-12s %12" PRIu64 " %9.2f%%\n", name, level.second,
+            HitRatio(Lookup(level_hits_, level.first), level.second));
+  }
+}
+
+void BlockCacheTraceAnalyzer::PrintMissRatioCurves(FILE* out) const {
+  std::vector<const Simulation*> sorted;
+  for (const auto& simulation : simulations_) {
+    if (simulation.simulator != nullptr) {
+      sorted.push_back(&simulation);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Simulation* a, const Simulation* b) {
+              return a->policy != b->policy ? a->policy < b->policy
+                                            : a->cache_size < b->cache_size;
+            });
+  fprintf(out,
+          "policy,cache_size,lookups,miss_ratio,get_miss_ratio,"
+          "multiget_miss_ratio,iterator_miss_ratio,compaction_miss_ratio\n");
+  for (const Simulation* simulation : sorted) {
+    const CacheSimulator& sim = *simulation->simulator;
+    fprintf(out, "%s,%" PRIu64 ",%" PRIu64 ",%.4f,%.4f,%.4f,%.4f,%.4f\n",
+            simulation->policy.c_str(), simulation->cache_size,
+            sim.num_accesses(), sim.miss_ratio(),
+            sim.miss_ratio(BlockCacheLookupCaller::kUserGet),
+            sim.miss_ratio(BlockCacheLookupCaller::kUserMultiGet),
+            sim.miss_ratio(BlockCacheLookupCaller::kUserIterator),
+            sim.miss_ratio(BlockCacheLookupCaller::kCompaction));
+  }
+}
+
+int BlockCacheTraceAnalyzerTool::Run(int argc, char** argv) {
+  std::string trace_file;
+  std::string cache_sizes = "16M,64M,256M,1G,4G";
+  std::string policies = "lru,ghost_lru,ghost_lru_data";
+  int num_shard_bits = -1;
+  char junk;
+  int n;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--trace_file=", 13) == 0) {
+      trace_file = argv[i] + 13;
+    } else if (strncmp(argv[i], "--cache_sizes=", 14) == 0) {
+      cache_sizes = argv[i] + 14;
+    } else if (strncmp(argv[i], "--policies=", 11) == 0) {
+      policies = argv[i] + 11;
+    } else if (sscanf(argv[i], "--num_shard_bits=%d%c", &n, &junk) == 1) {
+      num_shard_bits = n;
+    } else {
+      print_help();
+      return 1;
+    }
+  }
+  if (trace_file.empty()) {
+    print_help();
+    return 1;
+  }
+
+  BlockCacheTraceAnalyzer analyzer(Env::Default(), trace_file);
+  for (const auto& policy : SplitList(policies)) {
+    for (const auto& size : SplitList(cache_sizes)) {
+      uint64_t cache_size;
+      if (!ParseCacheSize(size, &cache_size)) {
+        fprintf(stderr, "Invalid cache size %s\n", size.c_str());
+        return 1;
+      }
+      analyzer.AddSimulation(policy, cache_size, num_shard_bits);
+    }
+  }
+  Status s = analyzer.Analyze();
+  if (!s.ok()) {
+    fprintf(stderr, "%s: %s\n", trace_file.c_str(), s.ToString().c_str());
+    return 1;
+  }
+  analyzer.PrintStatistics(stdout);
+  fprintf(stdout, "\n");
+  analyzer.PrintMissRatioCurves(stdout);
+  return 0;
+}
+
+}  // namespace rocksdb
+
+#endif  // ROCKSDB_LITE
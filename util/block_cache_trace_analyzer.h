@@ -0,0 +1,84 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "util/block_cache_tracer.h"
+#include "util/cache_simulator.h"
+
+namespace rocksdb {
+
+// Reads a block cache trace, summarizes its lookups, and replays them
+// against simulated caches of several sizes and policies to draw their
+// miss ratio curves.
+class BlockCacheTraceAnalyzer {
+ public:
+  BlockCacheTraceAnalyzer(Env* env, const std::string& trace_file);
+
+  // Simulates a cache of "cache_size" bytes with "policy", one of the
+  // policies of NewCacheSimulator(). For a sampled trace, the simulated
+  // cache is as many times smaller as blocks were left out of the trace.
+  void AddSimulation(const std::string& policy, uint64_t cache_size,
+                     int num_shard_bits);
+
+  Status Analyze();
+
+  // Lookups per block type, caller and level, and the number and size of
+  // the distinct blocks
+  void PrintStatistics(FILE* out) const;
+  // One CSV line per simulated cache, with the miss ratios overall and per
+  // caller, sorted by policy and cache size
+  void PrintMissRatioCurves(FILE* out) const;
+
+  struct Simulation {
+    std::string policy;
+    uint64_t cache_size;
+    int num_shard_bits;
+    std::unique_ptr<CacheSimulator> simulator;
+  };
+  const std::vector<Simulation>& simulations() const { return simulations_; }
+
+  uint64_t num_accesses() const { return num_accesses_; }
+  uint64_t num_cache_hits() const { return num_cache_hits_; }
+  uint64_t num_blocks() const { return block_sizes_.size(); }
+  uint64_t sampling_frequency() const { return sampling_frequency_; }
+
+ private:
+  void RecordAccess(const BlockCacheTraceRecord& access);
+
+  Env* const env_;
+  const std::string trace_file_;
+  std::vector<Simulation> simulations_;
+
+  uint64_t sampling_frequency_;
+  uint64_t num_accesses_;
+  uint64_t num_cache_hits_;
+  uint64_t first_access_micros_;
+  uint64_t last_access_micros_;
+  std::map<TraceType, uint64_t> type_accesses_;
+  std::map<TraceType, uint64_t> type_hits_;
+  std::map<BlockCacheLookupCaller, uint64_t> caller_accesses_;
+  std::map<BlockCacheLookupCaller, uint64_t> caller_hits_;
+  std::map<int, uint64_t> level_accesses_;
+  std::map<int, uint64_t> level_hits_;
+  // Size of every block looked up, by key
+  std::unordered_map<std::string, uint64_t> block_sizes_;
+};
+
+// The block_cache_trace_analyzer command line tool
+class BlockCacheTraceAnalyzerTool {
+ public:
+  int Run(int argc, char** argv);
+};
+
+}  // namespace rocksdb
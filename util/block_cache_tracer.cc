@@ -0,0 +1,196 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/block_cache_tracer.h"
+
+#include "util/coding.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+const std::string kBlockCacheTraceMagic = "rocksdb.block_cache_trace";
+
+namespace {
+const uint32_t kBlockCacheTraceFormatVersion = 1;
+
+bool IsBlockTraceType(TraceType type) {
+  return type == kBlockTraceIndexBlock || type == kBlockTraceFilterBlock ||
+         type == kBlockTraceDataBlock;
+}
+}  // namespace
+
+void BlockCacheTraceRecord::EncodeTo(Trace* trace) const {
+  trace->ts = access_timestamp;
+  trace->type = block_type;
+  trace->payload.clear();
+  PutLengthPrefixedSlice(&trace->payload, block_key);
+  PutVarint64(&trace->payload, block_size);
+  PutVarint32(&trace->payload, static_cast<uint32_t>(level + 1));
+  PutVarint64(&trace->payload, file_number);
+  trace->payload.push_back(static_cast<char>(caller));
+  trace->payload.push_back(is_cache_hit ? 1 : 0);
+  trace->payload.push_back(no_insert ? 1 : 0);
+}
+
+Status BlockCacheTraceRecord::DecodeFrom(const Trace& trace) {
+  if (!IsBlockTraceType(trace.type)) {
+    return Status::Corruption("not a block cache lookup");
+  }
+  Slice input = trace.payload;
+  Slice key;
+  uint32_t encoded_level;
+  if (!GetLengthPrefixedSlice(&input, &key) ||
+      !GetVarint64(&input, &block_size) ||
+      !GetVarint32(&input, &encoded_level) ||
+      !GetVarint64(&input, &file_number) || input.size() < 3) {
+    return Status::Corruption("truncated block cache lookup");
+  }
+  access_timestamp = trace.ts;
+  block_type = trace.type;
+  block_key.assign(key.data(), key.size());
+  level = static_cast<int>(encoded_level) - 1;
+  caller = static_cast<BlockCacheLookupCaller>(input[0]);
+  is_cache_hit = input[1] != 0;
+  no_insert = input[2] != 0;
+  return Status::OK();
+}
+
+BlockCacheTracer::BlockCacheTracer() : tracing_(false), env_(nullptr) {}
+
+BlockCacheTracer::~BlockCacheTracer() { EndTrace(); }
+
+Status BlockCacheTracer::StartTrace(
+    Env* env, const TraceOptions& trace_options,
+    std::unique_ptr<TraceWriter>&& trace_writer) {
+  MutexLock l(&mutex_);
+  if (trace_writer_ != nullptr) {
+    return Status::InvalidArgument("A block cache trace is already running");
+  }
+  Trace header;
+  header.ts = env->NowMicros();
+  header.type = kTraceBegin;
+  header.payload = kBlockCacheTraceMagic;
+  PutVarint32(&header.payload, kBlockCacheTraceFormatVersion);
+  PutVarint64(&header.payload, trace_options.sampling_frequency);
+  std::string record;
+  header.EncodeTo(&record);
+  Status s = trace_writer->Write(record);
+  if (s.ok()) {
+    env_ = env;
+    trace_options_ = trace_options;
+    trace_writer_ = std::move(trace_writer);
+    tracing_.store(true, std::memory_order_relaxed);
+  }
+  return s;
+}
+
+Status BlockCacheTracer::EndTrace() {
+  MutexLock l(&mutex_);
+  if (trace_writer_ == nullptr) {
+    return Status::InvalidArgument("No block cache trace is running");
+  }
+  tracing_.store(false, std::memory_order_relaxed);
+  Trace end;
+  end.ts = env_->NowMicros();
+  end.type = kTraceEnd;
+  std::string record;
+  end.EncodeTo(&record);
+  Status s = trace_writer_->Write(record);
+  Status close_status = trace_writer_->Close();
+  trace_writer_.reset();
+  return s.ok() ? close_status : s;
+}
+
+Status BlockCacheTracer::WriteBlockAccess(BlockCacheTraceRecord* record) {
+  MutexLock l(&mutex_);
+  if (trace_writer_ == nullptr ||
+      trace_writer_->GetFileSize() > trace_options_.max_trace_file_size) {
+    return Status::OK();
+  }
+  if (trace_options_.sampling_frequency > 1 &&
+      Hash(record->block_key.data(), record->block_key.size(), 0) %
+              trace_options_.sampling_frequency != 0) {
+    return Status::OK();
+  }
+  record->access_timestamp = env_->NowMicros();
+  Trace trace;
+  record->EncodeTo(&trace);
+  std::string encoded;
+  trace.EncodeTo(&encoded);
+  return trace_writer_->Write(encoded);
+}
+
+BlockCacheTraceReader::BlockCacheTraceReader(
+    std::unique_ptr<TraceReader>&& trace_reader)
+    : trace_reader_(std::move(trace_reader)) {}
+
+Status BlockCacheTraceReader::ReadHeader(uint64_t* sampling_frequency) {
+  std::string encoded;
+  Trace header;
+  Status s = trace_reader_->Read(&encoded);
+  if (s.ok()) {
+    s = header.DecodeFrom(encoded);
+  }
+  if (!s.ok()) {
+    return s.IsIncomplete() ? Status::Corruption("empty trace") : s;
+  }
+  Slice magic = header.payload;
+  uint32_t version;
+  if (header.type != kTraceBegin ||
+      !magic.starts_with(kBlockCacheTraceMagic)) {
+    return Status::Corruption("not a block cache trace");
+  }
+  magic.remove_prefix(kBlockCacheTraceMagic.size());
+  if (!GetVarint32(&magic, &version) ||
+      version > kBlockCacheTraceFormatVersion) {
+    return Status::NotSupported("unknown block cache trace format version");
+  }
+  if (!GetVarint64(&magic, sampling_frequency)) {
+    return Status::Corruption("truncated block cache trace header");
+  }
+  return Status::OK();
+}
+
+Status BlockCacheTraceReader::ReadAccess(BlockCacheTraceRecord* record) {
+  std::string encoded;
+  Trace trace;
+  Status s = trace_reader_->Read(&encoded);
+  if (s.ok()) {
+    s = trace.DecodeFrom(encoded);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (trace.type == kTraceEnd) {
+    return Status::Incomplete("end of trace");
+  }
+  return record->DecodeFrom(trace);
+}
+
+#ifndef IOS_CROSS_COMPILE
+
+__thread BlockCacheLookupContext* block_cache_lookup_context = nullptr;
+
+void BlockCacheLookupContext::RecordLookup(TraceType block_type,
+                                           const Slice& block_key,
+                                           uint64_t block_size,
+                                           bool is_cache_hit,
+                                           bool no_insert) {
+  BlockCacheTraceRecord record;
+  record.block_type = block_type;
+  record.block_key.assign(block_key.data(), block_key.size());
+  record.block_size = block_size;
+  record.level = level;
+  record.file_number = file_number;
+  record.caller = caller;
+  record.is_cache_hit = is_cache_hit;
+  record.no_insert = no_insert;
+  tracer->WriteBlockAccess(&record);
+}
+
+#endif
+
+}  // namespace rocksdb
@@ -0,0 +1,215 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/trace_reader_writer.h"
+#include "util/trace_replay.h"
+
+namespace rocksdb {
+
+extern const std::string kBlockCacheTraceMagic;
+
+// The request that looked up a block
+enum class BlockCacheLookupCaller : char {
+  kUnknown = 0,
+  kUserGet = 1,
+  kUserMultiGet = 2,
+  kUserIterator = 3,
+  kCompaction = 4,
+};
+
+// One lookup of a block in the block cache. Its Trace has the type of the
+// block: kBlockTraceIndexBlock, kBlockTraceFilterBlock or
+// kBlockTraceDataBlock, and the payload:
+//   length prefixed block key, varint64 block size, varint32 level + 1,
+//   varint64 file number, 1 byte caller, 1 byte is_cache_hit,
+//   1 byte no_insert
+struct BlockCacheTraceRecord {
+  uint64_t access_timestamp;  // Env::NowMicros() of the lookup
+  TraceType block_type;
+  // The key of the block in the block cache
+  std::string block_key;
+  // Memory the block takes, or would take, in the block cache
+  uint64_t block_size;
+  // Level and number of the table file the block belongs to, -1 and 0 if
+  // the caller does not know them
+  int level;
+  uint64_t file_number;
+  BlockCacheLookupCaller caller;
+  bool is_cache_hit;
+  // Whether the block was left out of the cache after a miss
+  bool no_insert;
+
+  BlockCacheTraceRecord()
+      : access_timestamp(0),
+        block_type(kBlockTraceDataBlock),
+        block_size(0),
+        level(-1),
+        file_number(0),
+        caller(BlockCacheLookupCaller::kUnknown),
+        is_cache_hit(false),
+        no_insert(false) {}
+
+  void EncodeTo(Trace* trace) const;
+  Status DecodeFrom(const Trace& trace);
+};
+
+// Records the block cache lookups of a DB into a trace. Thread safe.
+class BlockCacheTracer {
+ public:
+  BlockCacheTracer();
+  ~BlockCacheTracer();
+
+  // Blocks are sampled by key: one block key out of
+  // trace_options.sampling_frequency is traced, with all its lookups, so that
+  // the trace can be simulated against a cache that many times smaller.
+  // trace_options.record_values is ignored.
+  Status StartTrace(Env* env, const TraceOptions& trace_options,
+                    std::unique_ptr<TraceWriter>&& trace_writer);
+  Status EndTrace();
+
+  bool is_tracing_enabled() const {
+    return tracing_.load(std::memory_order_relaxed);
+  }
+
+  // Stamps the lookup with the current time and records it. Errors writing
+  // the trace are returned, but stop nothing.
+  Status WriteBlockAccess(BlockCacheTraceRecord* record);
+
+ private:
+  port::Mutex mutex_;
+  std::atomic<bool> tracing_;
+  Env* env_;
+  TraceOptions trace_options_;
+  std::unique_ptr<TraceWriter> trace_writer_;
+
+  // No copying allowed
+  BlockCacheTracer(const BlockCacheTracer&);
+  void operator=(const BlockCacheTracer&);
+};
+
+// Reads back the lookups recorded by a BlockCacheTracer
+class BlockCacheTraceReader {
+ public:
+  explicit BlockCacheTraceReader(std::unique_ptr<TraceReader>&& trace_reader);
+
+  // Checks the first record of the trace, and returns the sampling
+  // frequency the trace was recorded with
+  Status ReadHeader(uint64_t* sampling_frequency);
+  // Returns Status::Incomplete() once every lookup was read
+  Status ReadAccess(BlockCacheTraceRecord* record);
+
+ private:
+  std::unique_ptr<TraceReader> trace_reader_;
+};
+
+#ifdef IOS_CROSS_COMPILE
+
+#define BLOCK_CACHE_LOOKUP_GUARD(tracer, caller)
+#define BLOCK_CACHE_LOOKUP_TABLE_GUARD(level, file_number)
+
+#else
+
+// The request looking up blocks on this thread, set while its block cache
+// lookups are traced
+struct BlockCacheLookupContext {
+  BlockCacheTracer* tracer;
+  BlockCacheLookupCaller caller;
+  int level;
+  uint64_t file_number;
+
+  void RecordLookup(TraceType block_type, const Slice& block_key,
+                    uint64_t block_size, bool is_cache_hit, bool no_insert);
+};
+
+// nullptr unless the block cache lookups made on this thread are traced
+extern __thread BlockCacheLookupContext* block_cache_lookup_context;
+
+// Traces the block cache lookups made in its scope if "tracer" is recording
+// a trace. The lookups of nested requests are traced for the outer one.
+class BlockCacheLookupGuard {
+ public:
+  BlockCacheLookupGuard(BlockCacheTracer* tracer,
+                        BlockCacheLookupCaller caller)
+      : installed_(false) {
+    if (tracer != nullptr && tracer->is_tracing_enabled() &&
+        block_cache_lookup_context == nullptr) {
+      context_.tracer = tracer;
+      context_.caller = caller;
+      context_.level = -1;
+      context_.file_number = 0;
+      block_cache_lookup_context = &context_;
+      installed_ = true;
+    }
+  }
+
+  ~BlockCacheLookupGuard() {
+    if (installed_) {
+      block_cache_lookup_context = nullptr;
+    }
+  }
+
+ private:
+  BlockCacheLookupContext context_;
+  bool installed_;
+};
+
+// Ties the lookups made in its scope to a table file
+class BlockCacheLookupTableGuard {
+ public:
+  BlockCacheLookupTableGuard(int level, uint64_t file_number)
+      : context_(block_cache_lookup_context) {
+    if (context_ != nullptr) {
+      prev_level_ = context_->level;
+      prev_file_number_ = context_->file_number;
+      context_->level = level;
+      context_->file_number = file_number;
+    }
+  }
+
+  ~BlockCacheLookupTableGuard() {
+    if (context_ != nullptr) {
+      context_->level = prev_level_;
+      context_->file_number = prev_file_number_;
+    }
+  }
+
+ private:
+  BlockCacheLookupContext* const context_;
+  int prev_level_;
+  uint64_t prev_file_number_;
+};
+
+#define BLOCK_CACHE_LOOKUP_GUARD(tracer, caller) \
+  BlockCacheLookupGuard block_cache_lookup_guard((tracer), (caller));
+
+#define BLOCK_CACHE_LOOKUP_TABLE_GUARD(level, file_number) \
+  BlockCacheLookupTableGuard block_cache_lookup_table_guard((level),  \
+                                                            (file_number));
+
+#endif
+
+// Records a lookup of the block cache if lookups are traced on this thread
+inline void RecordBlockCacheLookup(TraceType block_type,
+                                   const Slice& block_key, uint64_t block_size,
+                                   bool is_cache_hit, bool no_insert) {
+#ifndef IOS_CROSS_COMPILE
+  if (block_cache_lookup_context != nullptr) {
+    block_cache_lookup_context->RecordLookup(block_type, block_key, block_size,
+                                             is_cache_hit, no_insert);
+  }
+#endif
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,129 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/cache_simulator.h"
+
+namespace rocksdb {
+
+namespace {
+void DeleteNothing(const Slice& key, void* value) {}
+
+bool IsIndexOrFilter(TraceType block_type) {
+  return block_type == kBlockTraceIndexBlock ||
+         block_type == kBlockTraceFilterBlock;
+}
+
+double Percentage(uint64_t misses, uint64_t accesses) {
+  return accesses == 0 ? 0.0 : 100.0 * misses / accesses;
+}
+}  // namespace
+
+CacheSimulator::CacheSimulator(std::shared_ptr<Cache> sim_cache)
+    : sim_cache_(sim_cache), num_accesses_(0), num_misses_(0) {
+  for (int i = 0; i < kNumBlockCacheLookupCallers; ++i) {
+    caller_accesses_[i] = 0;
+    caller_misses_[i] = 0;
+  }
+}
+
+void CacheSimulator::Access(const BlockCacheTraceRecord& access) {
+  bool is_cache_hit = Lookup(access);
+  if (!is_cache_hit && !access.no_insert) {
+    Insert(access);
+  }
+  UpdateMetrics(access, is_cache_hit);
+}
+
+double CacheSimulator::miss_ratio() const {
+  return Percentage(num_misses_, num_accesses_);
+}
+
+double CacheSimulator::miss_ratio(BlockCacheLookupCaller caller) const {
+  return Percentage(num_misses(caller), num_accesses(caller));
+}
+
+bool CacheSimulator::Lookup(const BlockCacheTraceRecord& access) {
+  Cache::Handle* handle = sim_cache_->Lookup(access.block_key);
+  if (handle == nullptr) {
+    return false;
+  }
+  sim_cache_->Release(handle);
+  return true;
+}
+
+void CacheSimulator::Insert(const BlockCacheTraceRecord& access) {
+  Cache::Handle* handle =
+      sim_cache_->Insert(access.block_key, nullptr,
+                         static_cast<size_t>(access.block_size),
+                         &DeleteNothing);
+  sim_cache_->Release(handle);
+}
+
+void CacheSimulator::UpdateMetrics(const BlockCacheTraceRecord& access,
+                                   bool is_cache_hit) {
+  int caller = static_cast<int>(access.caller);
+  if (caller < 0 || caller >= kNumBlockCacheLookupCallers) {
+    caller = static_cast<int>(BlockCacheLookupCaller::kUnknown);
+  }
+  ++num_accesses_;
+  ++caller_accesses_[caller];
+  if (!is_cache_hit) {
+    ++num_misses_;
+    ++caller_misses_[caller];
+  }
+}
+
+GhostCacheSimulator::GhostCacheSimulator(std::shared_ptr<Cache> sim_cache,
+                                         std::shared_ptr<Cache> ghost_cache,
+                                         bool admit_index_and_filter)
+    : CacheSimulator(sim_cache),
+      ghost_cache_(ghost_cache),
+      admit_index_and_filter_(admit_index_and_filter) {}
+
+void GhostCacheSimulator::Access(const BlockCacheTraceRecord& access) {
+  bool seen_recently = LookupGhost(access);
+  bool is_cache_hit = Lookup(access);
+  if (!is_cache_hit && !access.no_insert &&
+      (seen_recently ||
+       (admit_index_and_filter_ && IsIndexOrFilter(access.block_type)))) {
+    Insert(access);
+  }
+  UpdateMetrics(access, is_cache_hit);
+}
+
+bool GhostCacheSimulator::LookupGhost(const BlockCacheTraceRecord& access) {
+  Cache::Handle* handle = ghost_cache_->Lookup(access.block_key);
+  bool seen_recently = handle != nullptr;
+  if (handle == nullptr) {
+    // Charged the size of the key, not of the block, so that the ghost
+    // cache remembers far more blocks than the cache can hold
+    handle = ghost_cache_->Insert(access.block_key, nullptr,
+                                  access.block_key.size(), &DeleteNothing);
+  }
+  ghost_cache_->Release(handle);
+  return seen_recently;
+}
+
+Status NewCacheSimulator(const std::string& policy, uint64_t cache_size,
+                         int num_shard_bits,
+                         std::unique_ptr<CacheSimulator>* simulator) {
+  auto new_cache = [&]() {
+    return num_shard_bits < 0
+               ? NewLRUCache(static_cast<size_t>(cache_size))
+               : NewLRUCache(static_cast<size_t>(cache_size), num_shard_bits);
+  };
+  if (policy == "lru") {
+    simulator->reset(new CacheSimulator(new_cache()));
+  } else if (policy == "ghost_lru") {
+    simulator->reset(new GhostCacheSimulator(new_cache(), new_cache(), false));
+  } else if (policy == "ghost_lru_data") {
+    simulator->reset(new GhostCacheSimulator(new_cache(), new_cache(), true));
+  } else {
+    return Status::InvalidArgument("Unknown cache policy", policy);
+  }
+  return Status::OK();
+}
+
+}  // namespace rocksdb
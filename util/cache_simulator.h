@@ -0,0 +1,95 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/cache.h"
+#include "util/block_cache_tracer.h"
+
+namespace rocksdb {
+
+// Number of BlockCacheLookupCaller values
+const int kNumBlockCacheLookupCallers = 5;
+
+// Replays the lookups of a block cache trace against a simulated block
+// cache, and counts its misses. The simulated cache holds no data, only the
+// keys of the blocks, charged with their sizes.
+class CacheSimulator {
+ public:
+  explicit CacheSimulator(std::shared_ptr<Cache> sim_cache);
+  virtual ~CacheSimulator() {}
+
+  // Looks up the block of "access", and on a miss inserts it in the cache,
+  // unless the traced lookup did not insert it either
+  virtual void Access(const BlockCacheTraceRecord& access);
+
+  uint64_t num_accesses() const { return num_accesses_; }
+  uint64_t num_misses() const { return num_misses_; }
+  uint64_t num_accesses(BlockCacheLookupCaller caller) const {
+    return caller_accesses_[static_cast<int>(caller)];
+  }
+  uint64_t num_misses(BlockCacheLookupCaller caller) const {
+    return caller_misses_[static_cast<int>(caller)];
+  }
+
+  // Percentage of lookups that missed, 0 if there was none
+  double miss_ratio() const;
+  double miss_ratio(BlockCacheLookupCaller caller) const;
+
+ protected:
+  // Looks up "access" and returns whether it was a hit
+  bool Lookup(const BlockCacheTraceRecord& access);
+  void Insert(const BlockCacheTraceRecord& access);
+  void UpdateMetrics(const BlockCacheTraceRecord& access, bool is_cache_hit);
+
+  std::shared_ptr<Cache> sim_cache_;
+
+ private:
+  uint64_t num_accesses_;
+  uint64_t num_misses_;
+  uint64_t caller_accesses_[kNumBlockCacheLookupCallers];
+  uint64_t caller_misses_[kNumBlockCacheLookupCallers];
+};
+
+// Only inserts the blocks that were looked up recently: a block that
+// misses is inserted if it is in the ghost cache, which remembers the keys
+// of the last blocks looked up. Every key is charged its own size, so the
+// ghost cache remembers many more blocks than fit in the cache. Blocks
+// looked up once, as by scans, then do not evict the blocks that are
+// looked up again and again.
+class GhostCacheSimulator : public CacheSimulator {
+ public:
+  // With admit_index_and_filter, index and filter blocks are inserted on
+  // their first miss, and only data blocks go through the ghost cache
+  GhostCacheSimulator(std::shared_ptr<Cache> sim_cache,
+                      std::shared_ptr<Cache> ghost_cache,
+                      bool admit_index_and_filter);
+
+  virtual void Access(const BlockCacheTraceRecord& access) override;
+
+ private:
+  // Remembers the lookup, and returns whether the block was looked up
+  // recently
+  bool LookupGhost(const BlockCacheTraceRecord& access);
+
+  std::shared_ptr<Cache> ghost_cache_;
+  const bool admit_index_and_filter_;
+};
+
+// Returns a simulator for one of the policies:
+//   "lru":            the LRU block cache of RocksDB
+//   "ghost_lru":      LRU that admits blocks on their second recent lookup
+//   "ghost_lru_data": "ghost_lru" for data blocks only, index and filter
+//                     blocks are admitted on their first lookup
+// "num_shard_bits" is the one given to NewLRUCache(), or the default if
+// negative.
+extern Status NewCacheSimulator(const std::string& policy,
+                                uint64_t cache_size, int num_shard_bits,
+                                std::unique_ptr<CacheSimulator>* simulator);
+
+}  // namespace rocksdb
@@ -0,0 +1,196 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/cache_simulator.h"
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "util/block_cache_trace_analyzer.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class CacheSimulatorTest {
+ public:
+  CacheSimulatorTest() : env_(Env::Default()) {}
+
+  static BlockCacheTraceRecord Access(
+      const std::string& key, TraceType block_type = kBlockTraceDataBlock,
+      BlockCacheLookupCaller caller = BlockCacheLookupCaller::kUserGet) {
+    BlockCacheTraceRecord access;
+    access.block_key = key;
+    access.block_type = block_type;
+    access.block_size = 1;
+    access.level = 1;
+    access.file_number = 7;
+    access.caller = caller;
+    return access;
+  }
+
+  Env* env_;
+};
+
+TEST(CacheSimulatorTest, EncodeDecode) {
+  BlockCacheTraceRecord access = Access("block", kBlockTraceIndexBlock,
+                                        BlockCacheLookupCaller::kCompaction);
+  access.access_timestamp = 123;
+  access.block_size = 4096;
+  access.is_cache_hit = true;
+  Trace trace;
+  access.EncodeTo(&trace);
+  std::string encoded;
+  trace.EncodeTo(&encoded);
+
+  Trace decoded_trace;
+  ASSERT_OK(decoded_trace.DecodeFrom(encoded));
+  BlockCacheTraceRecord decoded;
+  ASSERT_OK(decoded.DecodeFrom(decoded_trace));
+  ASSERT_EQ(123U, decoded.access_timestamp);
+  ASSERT_EQ(kBlockTraceIndexBlock, decoded.block_type);
+  ASSERT_EQ("block", decoded.block_key);
+  ASSERT_EQ(4096U, decoded.block_size);
+  ASSERT_EQ(1, decoded.level);
+  ASSERT_EQ(7U, decoded.file_number);
+  ASSERT_TRUE(decoded.caller == BlockCacheLookupCaller::kCompaction);
+  ASSERT_TRUE(decoded.is_cache_hit);
+  ASSERT_TRUE(!decoded.no_insert);
+
+  // An unknown level survives the round trip
+  access.level = -1;
+  access.EncodeTo(&trace);
+  ASSERT_OK(decoded.DecodeFrom(trace));
+  ASSERT_EQ(-1, decoded.level);
+
+  trace.type = kTraceGet;
+  ASSERT_TRUE(decoded.DecodeFrom(trace).IsCorruption());
+}
+
+TEST(CacheSimulatorTest, LRU) {
+  std::unique_ptr<CacheSimulator> simulator;
+  ASSERT_OK(NewCacheSimulator("lru", 3, 0, &simulator));
+  for (auto key : {"a", "b", "c", "a", "d", "b"}) {
+    simulator->Access(Access(key));
+  }
+  // "b" was the least recently used block when "d" was inserted
+  ASSERT_EQ(6U, simulator->num_accesses());
+  ASSERT_EQ(5U, simulator->num_misses());
+
+  // Lookups that did not fill the cache do not fill the simulated one
+  BlockCacheTraceRecord scan = Access("e", kBlockTraceDataBlock,
+                                      BlockCacheLookupCaller::kCompaction);
+  scan.no_insert = true;
+  simulator->Access(scan);
+  simulator->Access(scan);
+  ASSERT_EQ(7U, simulator->num_misses());
+  ASSERT_EQ(2U, simulator->num_misses(BlockCacheLookupCaller::kCompaction));
+  ASSERT_EQ(100.0, simulator->miss_ratio(BlockCacheLookupCaller::kCompaction));
+  ASSERT_EQ(0.0, simulator->miss_ratio(BlockCacheLookupCaller::kUserIterator));
+
+  ASSERT_TRUE(
+      NewCacheSimulator("mru", 3, 0, &simulator).IsInvalidArgument());
+}
+
+TEST(CacheSimulatorTest, GhostLRU) {
+  std::unique_ptr<CacheSimulator> simulator;
+  ASSERT_OK(NewCacheSimulator("ghost_lru", 3, 0, &simulator));
+  // Admitted on the second lookup, a hit from the third on
+  for (int i = 0; i < 3; ++i) {
+    simulator->Access(Access("a"));
+  }
+  ASSERT_EQ(2U, simulator->num_misses());
+  // Blocks looked up once do not evict it
+  for (auto key : {"b", "c", "d", "e", "a"}) {
+    simulator->Access(Access(key));
+  }
+  ASSERT_EQ(6U, simulator->num_misses());
+
+  ASSERT_OK(NewCacheSimulator("ghost_lru", 3, 0, &simulator));
+  simulator->Access(Access("i", kBlockTraceIndexBlock));
+  simulator->Access(Access("i", kBlockTraceIndexBlock));
+  ASSERT_EQ(2U, simulator->num_misses());
+  // Index and filter blocks are admitted on their first lookup
+  ASSERT_OK(NewCacheSimulator("ghost_lru_data", 3, 0, &simulator));
+  simulator->Access(Access("i", kBlockTraceIndexBlock));
+  simulator->Access(Access("i", kBlockTraceIndexBlock));
+  simulator->Access(Access("a"));
+  simulator->Access(Access("a"));
+  ASSERT_EQ(3U, simulator->num_misses());
+}
+
+TEST(CacheSimulatorTest, GhostLRUScanResistance) {
+  // Room for 10 blocks of 4KB. Every lookup of a hot block is followed by
+  // lookups of blocks never seen again, so that 20 other blocks are looked
+  // up between two lookups of the same hot block
+  const uint64_t kBlockSize = 4096;
+  std::unique_ptr<CacheSimulator> lru;
+  std::unique_ptr<CacheSimulator> ghost_lru;
+  ASSERT_OK(NewCacheSimulator("lru", 10 * kBlockSize, 0, &lru));
+  ASSERT_OK(NewCacheSimulator("ghost_lru", 10 * kBlockSize, 0, &ghost_lru));
+  for (int round = 0; round < 500; ++round) {
+    std::vector<std::string> keys;
+    keys.push_back("hot" + std::to_string(round % 5));
+    for (int i = 0; i < 3; ++i) {
+      keys.push_back("scan" + std::to_string(round * 3 + i));
+    }
+    for (const auto& key : keys) {
+      BlockCacheTraceRecord access = Access(key);
+      access.block_size = kBlockSize;
+      lru->Access(access);
+      ghost_lru->Access(access);
+    }
+  }
+  // The scans evict the hot blocks from the LRU cache, but the ghost cache
+  // remembers them and keeps the scanned blocks out
+  ASSERT_EQ(2000U, lru->num_misses());
+  ASSERT_EQ(1500U + 10U, ghost_lru->num_misses());
+}
+
+TEST(CacheSimulatorTest, Analyzer) {
+  const std::string trace_file =
+      test::TmpDir(env_) + "/cache_simulator_test_trace";
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, EnvOptions(), trace_file,
+                               &trace_writer));
+  BlockCacheTracer tracer;
+  ASSERT_OK(tracer.StartTrace(env_, TraceOptions(), std::move(trace_writer)));
+  ASSERT_TRUE(tracer.is_tracing_enabled());
+  // Ten blocks looked up in a loop three times
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      BlockCacheTraceRecord access = Access(std::string(1, 'a' + i));
+      access.is_cache_hit = round > 0;
+      ASSERT_OK(tracer.WriteBlockAccess(&access));
+    }
+  }
+  ASSERT_OK(tracer.EndTrace());
+  ASSERT_TRUE(!tracer.is_tracing_enabled());
+  BlockCacheTraceRecord dropped = Access("z");
+  ASSERT_OK(tracer.WriteBlockAccess(&dropped));
+
+  BlockCacheTraceAnalyzer analyzer(env_, trace_file);
+  analyzer.AddSimulation("lru", 5, 0);
+  analyzer.AddSimulation("lru", 10, 0);
+  ASSERT_OK(analyzer.Analyze());
+  ASSERT_EQ(30U, analyzer.num_accesses());
+  ASSERT_EQ(20U, analyzer.num_cache_hits());
+  ASSERT_EQ(10U, analyzer.num_blocks());
+  ASSERT_EQ(1U, analyzer.sampling_frequency());
+  // A loop larger than an LRU cache always misses
+  ASSERT_EQ(30U, analyzer.simulations()[0].simulator->num_misses());
+  ASSERT_EQ(10U, analyzer.simulations()[1].simulator->num_misses());
+
+  BlockCacheTraceAnalyzer unknown_policy(env_, trace_file);
+  unknown_policy.AddSimulation("mru", 5, 0);
+  ASSERT_TRUE(unknown_policy.Analyze().IsInvalidArgument());
+  env_->DeleteFile(trace_file);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  return rocksdb::test::RunAllTests();
+}
@@ -42,6 +42,7 @@
 #include "util/random.h"
 #include "util/iostats_context_imp.h"
 #include "util/rate_limiter.h"
+#include "util/sync_point.h"
 #include "util/thread_status_updater.h"
 #include "util/thread_status_util.h"
 
@@ -649,6 +650,7 @@ class PosixWritableFile : public WritableFile {
   bool pending_fsync_;
   uint64_t last_sync_size_;
   uint64_t bytes_per_sync_;
+  const size_t page_size_;
 #ifdef ROCKSDB_FALLOCATE_PRESENT
   bool fallocate_with_keep_size_;
 #endif
@@ -667,6 +669,7 @@ class PosixWritableFile : public WritableFile {
         pending_fsync_(false),
         last_sync_size_(0),
         bytes_per_sync_(options.bytes_per_sync),
+        page_size_(getpagesize()),
         rate_limiter_(options.rate_limiter) {
 #ifdef ROCKSDB_FALLOCATE_PRESENT
     fallocate_with_keep_size_ = options.fallocate_with_keep_size;
@@ -795,10 +798,18 @@ class PosixWritableFile : public WritableFile {
     // TODO: give log file and sst file different options (log
     // files could be potentially cached in OS for their whole
     // life time, thus we might not want to flush at all).
+    // Only whole pages are synced: the last page may still be written to,
+    // and would have to be written back again.
     if (bytes_per_sync_ &&
         filesize_ - last_sync_size_ >= bytes_per_sync_) {
-      RangeSync(last_sync_size_, filesize_ - last_sync_size_);
-      last_sync_size_ = filesize_;
+      uint64_t sync_end = filesize_ - filesize_ % page_size_;
+      if (sync_end > last_sync_size_) {
+        std::pair<uint64_t, uint64_t> range(last_sync_size_,
+                                            sync_end - last_sync_size_);
+        TEST_SYNC_POINT_CALLBACK("PosixWritableFile::Flush:RangeSync", &range);
+        RangeSync(range.first, range.second);
+        last_sync_size_ = sync_end;
+      }
     }
 
     return Status::OK();
@@ -833,6 +844,22 @@ class PosixWritableFile : public WritableFile {
     return Status::OK();
   }
 
+  virtual bool IsSyncThreadSafe() const {
+    return true;
+  }
+
+  virtual Status SyncWithoutFlush(bool use_fsync) {
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    // pending_sync_/pending_fsync_ belong to the appending thread, so
+    // always issue the call
+    int ret = use_fsync ? fsync(fd_) : fdatasync(fd_);
+    if (ret < 0) {
+      return IOError(filename_, errno);
+    }
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    return Status::OK();
+  }
+
   virtual uint64_t GetFileSize() {
     return filesize_;
   }
@@ -1183,6 +1210,34 @@ class PosixEnv : public Env {
     return s;
   }
 
+  virtual Status ReuseWritableFile(const std::string& fname,
+                                   const std::string& old_fname,
+                                   unique_ptr<WritableFile>* result,
+                                   const EnvOptions& options) {
+    result->reset();
+    Status s = RenameFile(old_fname, fname);
+    if (!s.ok()) {
+      return s;
+    }
+    int fd = -1;
+    do {
+      // Keep the old contents (and their blocks) around; the caller
+      // overwrites them from the start of the file
+      fd = open(fname.c_str(), O_RDWR, 0644);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+      s = IOError(fname, errno);
+    } else {
+      SetFD_CLOEXEC(fd, &options);
+      // mmap writes assume the file starts out empty
+      EnvOptions no_mmap_writes_options = options;
+      no_mmap_writes_options.use_mmap_writes = false;
+      result->reset(
+          new PosixWritableFile(fname, fd, 65536, no_mmap_writes_options));
+    }
+    return s;
+  }
+
   virtual Status NewRandomRWFile(const std::string& fname,
                                  unique_ptr<RandomRWFile>* result,
                                  const EnvOptions& options) {
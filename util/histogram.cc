@@ -12,86 +12,69 @@
 #include <cassert>
 #include <math.h>
 #include <stdio.h>
+#include <algorithm>
 #include "port/port.h"
 
 namespace rocksdb {
 
-HistogramBucketMapper::HistogramBucketMapper()
-    :
-      // Add newer bucket index here.
-      // Should be alwyas added in sorted order.
-      // If you change this, you also need to change
-      // size of array buckets_ in HistogramImpl
-      bucketValues_(
-          {1,         2,         3,         4,         5,         6,
-           7,         8,         9,         10,        12,        14,
-           16,        18,        20,        25,        30,        35,
-           40,        45,        50,        60,        70,        80,
-           90,        100,       120,       140,       160,       180,
-           200,       250,       300,       350,       400,       450,
-           500,       600,       700,       800,       900,       1000,
-           1200,      1400,      1600,      1800,      2000,      2500,
-           3000,      3500,      4000,      4500,      5000,      6000,
-           7000,      8000,      9000,      10000,     12000,     14000,
-           16000,     18000,     20000,     25000,     30000,     35000,
-           40000,     45000,     50000,     60000,     70000,     80000,
-           90000,     100000,    120000,    140000,    160000,    180000,
-           200000,    250000,    300000,    350000,    400000,    450000,
-           500000,    600000,    700000,    800000,    900000,    1000000,
-           1200000,   1400000,   1600000,   1800000,   2000000,   2500000,
-           3000000,   3500000,   4000000,   4500000,   5000000,   6000000,
-           7000000,   8000000,   9000000,   10000000,  12000000,  14000000,
-           16000000,  18000000,  20000000,  25000000,  30000000,  35000000,
-           40000000,  45000000,  50000000,  60000000,  70000000,  80000000,
-           90000000,  100000000, 120000000, 140000000, 160000000, 180000000,
-           200000000, 250000000, 300000000, 350000000, 400000000, 450000000,
-           500000000, 600000000, 700000000, 800000000, 900000000, 1000000000}),
-      maxBucketValue_(bucketValues_.back()),
-      minBucketValue_(bucketValues_.front()) {
-  for (size_t i =0; i < bucketValues_.size(); ++i) {
-    valueIndexMap_[bucketValues_[i]] = i;
+HistogramBucketMapper::HistogramBucketMapper(int significant_digits)
+    : significant_digits_(std::min(std::max(significant_digits, 1), 3)) {
+  // Values below 2 * 10^digits each get a bucket, so that a bucket of the
+  // upper half of any power of two is narrower than 10^-digits of its values
+  uint64_t largest_exact = 2;
+  for (int i = 0; i < significant_digits_; i++) {
+    largest_exact *= 10;
   }
+  sub_bucket_magnitude_ = 0;
+  while ((1ull << sub_bucket_magnitude_) < largest_exact) {
+    sub_bucket_magnitude_++;
+  }
+  sub_bucket_mask_ = (1ull << sub_bucket_magnitude_) - 1;
+  bucket_count_ = IndexForValue(LastValue()) + 1;
 }
 
-size_t HistogramBucketMapper::IndexForValue(const uint64_t value) const {
-  if (value >= maxBucketValue_) {
-    return bucketValues_.size() - 1;
-  } else if ( value >= minBucketValue_ ) {
-    std::map<uint64_t, uint64_t>::const_iterator lowerBound =
-      valueIndexMap_.lower_bound(value);
-    if (lowerBound != valueIndexMap_.end()) {
-      return static_cast<size_t>(lowerBound->second);
-    } else {
-      return 0;
-    }
-  } else {
-    return 0;
+uint64_t HistogramBucketMapper::BucketStart(size_t bucket_number) const {
+  const size_t sub_bucket_count = size_t{1} << sub_bucket_magnitude_;
+  if (bucket_number < sub_bucket_count) {
+    return bucket_number;
   }
+  // Past the first range, every range of half as many buckets covers twice
+  // as many values as the previous one
+  const size_t half_count = sub_bucket_count / 2;
+  const size_t range = bucket_number / half_count - 1;
+  return static_cast<uint64_t>(bucket_number - range * half_count) << range;
 }
 
-namespace {
-  const HistogramBucketMapper bucketMapper;
+HistogramImpl::HistogramImpl(int significant_digits)
+    : mapper_(significant_digits) {
+  Clear();
 }
 
 void HistogramImpl::Clear() {
-  min_ = bucketMapper.LastValue();
+  min_ = static_cast<double>(mapper_.LastValue());
   max_ = 0;
   num_ = 0;
   sum_ = 0;
   sum_squares_ = 0;
-  memset(buckets_, 0, sizeof buckets_);
+  buckets_.clear();
 }
 
 bool HistogramImpl::Empty() { return sum_squares_ == 0; }
 
+void HistogramImpl::AddToBucket(size_t index, uint64_t count) {
+  if (buckets_.empty()) {
+    buckets_.resize(mapper_.BucketCount(), 0);
+  }
+  buckets_[index] += count;
+}
+
 void HistogramImpl::Add(uint64_t value) {
-  const size_t index = bucketMapper.IndexForValue(value);
-  buckets_[index] += 1;
+  AddToBucket(mapper_.IndexForValue(value), 1);
   if (min_ > value) min_ = value;
   if (max_ < value) max_ = value;
   num_++;
   sum_ += value;
-  sum_squares_ += (value * value);
+  sum_squares_ += static_cast<double>(value) * value;
 }
 
 void HistogramImpl::Merge(const HistogramImpl& other) {
@@ -100,9 +83,90 @@ void HistogramImpl::Merge(const HistogramImpl& other) {
   num_ += other.num_;
   sum_ += other.sum_;
   sum_squares_ += other.sum_squares_;
-  for (unsigned int b = 0; b < bucketMapper.BucketCount(); b++) {
-    buckets_[b] += other.buckets_[b];
+  for (size_t b = 0; b < other.buckets_.size(); b++) {
+    if (other.buckets_[b] == 0) {
+      continue;
+    }
+    if (other.mapper_.significant_digits() == mapper_.significant_digits()) {
+      AddToBucket(b, other.buckets_[b]);
+    } else {
+      AddToBucket(mapper_.IndexForValue(other.mapper_.BucketStart(b)),
+                  other.buckets_[b]);
+    }
+  }
+}
+
+void HistogramImpl::Merge(const SingleWriterHistogram& other) {
+  const uint64_t num = other.num_.load(std::memory_order_relaxed);
+  if (num == 0) {
+    return;
+  }
+  const uint64_t other_min = other.min_.load(std::memory_order_relaxed);
+  const uint64_t other_max = other.max_.load(std::memory_order_relaxed);
+  if (other_min < min_) min_ = other_min;
+  if (other_max > max_) max_ = other_max;
+  num_ += num;
+  sum_ += other.sum_.load(std::memory_order_relaxed);
+  sum_squares_ += other.sum_squares_.load(std::memory_order_relaxed);
+  const std::atomic<uint64_t>* other_buckets =
+      other.buckets_.load(std::memory_order_acquire);
+  if (other_buckets == nullptr) {
+    return;
+  }
+  const bool same_layout =
+      other.mapper_.significant_digits() == mapper_.significant_digits();
+  for (size_t b = 0; b < other.mapper_.BucketCount(); b++) {
+    uint64_t count = other_buckets[b].load(std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    AddToBucket(same_layout
+                    ? b
+                    : mapper_.IndexForValue(other.mapper_.BucketStart(b)),
+                count);
+  }
+}
+
+SingleWriterHistogram::SingleWriterHistogram(int significant_digits)
+    : mapper_(significant_digits),
+      min_(mapper_.LastValue()),
+      max_(0),
+      num_(0),
+      sum_(0),
+      sum_squares_(0),
+      buckets_(nullptr) {}
+
+SingleWriterHistogram::~SingleWriterHistogram() {
+  delete[] buckets_.load(std::memory_order_relaxed);
+}
+
+void SingleWriterHistogram::Add(uint64_t value) {
+  // There is only one writer, so loads and stores are enough
+  std::atomic<uint64_t>* buckets = buckets_.load(std::memory_order_relaxed);
+  if (buckets == nullptr) {
+    buckets = new std::atomic<uint64_t>[mapper_.BucketCount()];
+    for (size_t b = 0; b < mapper_.BucketCount(); b++) {
+      buckets[b].store(0, std::memory_order_relaxed);
+    }
+    // Publishes the zeroed buckets to the readers
+    buckets_.store(buckets, std::memory_order_release);
+  }
+  const size_t index = mapper_.IndexForValue(value);
+  buckets[index].store(buckets[index].load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+  if (min_.load(std::memory_order_relaxed) > value) {
+    min_.store(value, std::memory_order_relaxed);
+  }
+  if (max_.load(std::memory_order_relaxed) < value) {
+    max_.store(value, std::memory_order_relaxed);
   }
+  sum_.store(sum_.load(std::memory_order_relaxed) + value,
+             std::memory_order_relaxed);
+  sum_squares_.store(sum_squares_.load(std::memory_order_relaxed) +
+                         static_cast<double>(value) * value,
+                     std::memory_order_relaxed);
+  num_.store(num_.load(std::memory_order_relaxed) + 1,
+             std::memory_order_relaxed);
 }
 
 double HistogramImpl::Median() const {
@@ -112,12 +176,13 @@ double HistogramImpl::Median() const {
 double HistogramImpl::Percentile(double p) const {
   double threshold = num_ * (p / 100.0);
   double sum = 0;
-  for (unsigned int b = 0; b < bucketMapper.BucketCount(); b++) {
+  for (size_t b = 0; b < buckets_.size(); b++) {
     sum += buckets_[b];
     if (sum >= threshold) {
-      // Scale linearly within this bucket
-      double left_point = (b == 0) ? 0 : bucketMapper.BucketLimit(b-1);
-      double right_point = bucketMapper.BucketLimit(b);
+      // Scale linearly within this bucket, from its smallest to its largest
+      // value
+      double left_point = static_cast<double>(mapper_.BucketStart(b));
+      double right_point = static_cast<double>(mapper_.BucketLimit(b) - 1);
       double left_sum = sum - buckets_[b];
       double right_sum = sum;
       double pos = 0;
@@ -158,22 +223,22 @@ std::string HistogramImpl::ToString() const {
   r.append(buf);
   snprintf(buf, sizeof(buf),
            "Percentiles: "
-           "P50: %.2f P75: %.2f P99: %.2f P99.9: %.2f P99.99: %.2f\n",
-           Percentile(50), Percentile(75), Percentile(99), Percentile(99.9),
-           Percentile(99.99));
+           "P50: %.2f P75: %.2f P95: %.2f P99: %.2f P99.9: %.2f "
+           "P99.99: %.2f Max: %.2f\n",
+           Percentile(50), Percentile(75), Percentile(95), Percentile(99),
+           Percentile(99.9), Percentile(99.99), max_);
   r.append(buf);
   r.append("------------------------------------------------------\n");
   const double mult = 100.0 / num_;
   double sum = 0;
-  for (unsigned int b = 0; b < bucketMapper.BucketCount(); b++) {
+  for (size_t b = 0; b < buckets_.size(); b++) {
     if (buckets_[b] <= 0.0) continue;
     sum += buckets_[b];
     snprintf(buf, sizeof(buf),
              "[ %7lu, %7lu ) %8lu %7.3f%% %7.3f%% ",
-             // left
-             (unsigned long)((b == 0) ? 0 : bucketMapper.BucketLimit(b-1)),
-             (unsigned long)bucketMapper.BucketLimit(b), // right
-             (unsigned long)buckets_[b],                 // count
+             (unsigned long)mapper_.BucketStart(b),  // left
+             (unsigned long)mapper_.BucketLimit(b),  // right
+             (unsigned long)buckets_[b],             // count
              (mult * buckets_[b]),        // percentage
              (mult * sum));               // cumulative percentage
     r.append(buf);
@@ -193,6 +258,9 @@ void HistogramImpl::Data(HistogramData * const data) const {
   data->percentile99 = Percentile(99);
   data->average = Average();
   data->standard_deviation = StandardDeviation();
+  data->percentile999 = Percentile(99.9);
+  data->percentile9999 = Percentile(99.99);
+  data->max = Max();
 }
 
 } // namespace levedb
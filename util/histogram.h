@@ -10,72 +10,141 @@
 #pragma once
 #include "rocksdb/statistics.h"
 
+#include <atomic>
 #include <cassert>
 #include <string>
 #include <vector>
-#include <map>
 
 namespace rocksdb {
 
+// Significant decimal digits of the histograms of Statistics and, unless
+// told otherwise, of HistogramImpl
+const int kHistogramSignificantDigits = 2;
+
+// Maps values to the buckets of a log-linear (HDR) histogram. The values
+// below 2 * 10^significant_digits each have a bucket of their own; above,
+// every power of two is split into the same number of equal buckets. The
+// width of the bucket of a value is then below 10^-significant_digits of
+// the value, however large, instead of the ~20% of fixed 1-2-5 buckets.
+// Values from LastValue() on all fall into the last bucket.
 class HistogramBucketMapper {
  public:
-
-  HistogramBucketMapper();
+  // "significant_digits" is clamped to [1, 3]
+  explicit HistogramBucketMapper(int significant_digits);
 
   // converts a value to the bucket index.
-  size_t IndexForValue(const uint64_t value) const;
+  size_t IndexForValue(uint64_t value) const {
+    if (value > LastValue()) {
+      value = LastValue();
+    }
+    // Number of times the sub-bucket range is doubled to reach the value
+    int bucket = 64 - __builtin_clzll(value | sub_bucket_mask_) -
+                 sub_bucket_magnitude_;
+    return (static_cast<size_t>(bucket) << (sub_bucket_magnitude_ - 1)) +
+           static_cast<size_t>(value >> bucket);
+  }
+
   // number of buckets required.
+  size_t BucketCount() const { return bucket_count_; }
 
-  size_t BucketCount() const {
-    return bucketValues_.size();
-  }
+  // The largest value told apart from larger ones
+  uint64_t LastValue() const { return (1ull << kMaxValueMagnitude) - 1; }
 
-  uint64_t LastValue() const {
-    return maxBucketValue_;
-  }
+  uint64_t FirstValue() const { return 0; }
 
-  uint64_t FirstValue() const {
-    return minBucketValue_;
-  }
+  // Smallest value of the bucket
+  uint64_t BucketStart(size_t bucket_number) const;
 
-  uint64_t BucketLimit(const size_t bucketNumber) const {
-    assert(bucketNumber < BucketCount());
-    return bucketValues_[bucketNumber];
+  // Bucket "bucket_number" holds the values in
+  // [BucketStart(bucket_number), BucketLimit(bucket_number))
+  uint64_t BucketLimit(size_t bucket_number) const {
+    assert(bucket_number < BucketCount());
+    return BucketStart(bucket_number + 1);
   }
 
+  int significant_digits() const { return significant_digits_; }
+
  private:
-  const std::vector<uint64_t> bucketValues_;
-  const uint64_t maxBucketValue_;
-  const uint64_t minBucketValue_;
-  std::map<uint64_t, uint64_t> valueIndexMap_;
+  // Values are tracked up to 2^40, 12 days in microseconds
+  static const int kMaxValueMagnitude = 40;
+
+  int significant_digits_;
+  // log2 of the number of buckets of the values below 2^magnitude, which
+  // each have their own
+  int sub_bucket_magnitude_;
+  uint64_t sub_bucket_mask_;
+  size_t bucket_count_;
+};
+
+// A histogram that one thread adds to while others read it through
+// HistogramImpl::Merge(). It keeps no lock: the fields are updated one at
+// a time, so a concurrent reader may see a value counted in some of them
+// only.
+class SingleWriterHistogram {
+ public:
+  explicit SingleWriterHistogram(
+      int significant_digits = kHistogramSignificantDigits);
+  ~SingleWriterHistogram();
+
+  // REQUIRES: only called by the owning thread
+  void Add(uint64_t value);
+
+ private:
+  friend class HistogramImpl;
+
+  const HistogramBucketMapper mapper_;
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+  std::atomic<uint64_t> num_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<double> sum_squares_;
+  // Allocated by the first Add(): every thread has a histogram of each
+  // type, but records few of the types
+  std::atomic<std::atomic<uint64_t>*> buckets_;
+
+  // No copying allowed
+  SingleWriterHistogram(const SingleWriterHistogram&);
+  void operator=(const SingleWriterHistogram&);
 };
 
 class HistogramImpl {
  public:
+  explicit HistogramImpl(int significant_digits = kHistogramSignificantDigits);
+
   virtual void Clear();
   virtual bool Empty();
   virtual void Add(uint64_t value);
+  // "other" may have a different precision, its values are then counted
+  // at the start of their buckets
   void Merge(const HistogramImpl& other);
+  // Safe to call while "other" is being added to
+  void Merge(const SingleWriterHistogram& other);
 
+  // The count, average and standard deviation, min, max, the P50, P75, P95,
+  // P99, P99.9 and P99.99 and the non-empty buckets
   virtual std::string ToString() const;
 
   virtual double Median() const;
   virtual double Percentile(double p) const;
   virtual double Average() const;
   virtual double StandardDeviation() const;
+  virtual double Max() const { return max_; }
   virtual void Data(HistogramData * const data) const;
 
   virtual ~HistogramImpl() {}
 
  private:
-  // To be able to use HistogramImpl as thread local variable, its constructor
-  // has to be static. That's why we're using manually values from BucketMapper
-  double min_ = 1000000000;  // this is BucketMapper:LastValue()
-  double max_ = 0;
-  double num_ = 0;
-  double sum_ = 0;
-  double sum_squares_ = 0;
-  uint64_t buckets_[138] = {0};  // this is BucketMapper::BucketCount()
+  void AddToBucket(size_t index, uint64_t count);
+
+  HistogramBucketMapper mapper_;
+  double min_;
+  double max_;
+  double num_;
+  double sum_;
+  double sum_squares_;
+  // Empty until the first value is added, as a precise histogram has
+  // thousands of buckets
+  std::vector<uint64_t> buckets_;
 };
 
 }  // namespace rocksdb
@@ -5,6 +5,8 @@
 //
 #include "util/histogram.h"
 
+#include <math.h>
+
 #include "util/testharness.h"
 
 namespace rocksdb {
@@ -55,6 +57,63 @@ TEST(HistogramTest, ClearHistogram) {
   ASSERT_EQ(histogram.Average(), 0);
 }
 
+TEST(HistogramTest, BucketMapper) {
+  for (int digits = 1; digits <= 3; digits++) {
+    HistogramBucketMapper mapper(digits);
+    for (size_t b = 0; b < mapper.BucketCount(); b++) {
+      uint64_t start = mapper.BucketStart(b);
+      ASSERT_EQ(mapper.IndexForValue(start), b);
+      ASSERT_EQ(mapper.IndexForValue(mapper.BucketLimit(b) - 1), b);
+    }
+    ASSERT_EQ(mapper.IndexForValue(mapper.LastValue() + 1000),
+              mapper.BucketCount() - 1);
+  }
+}
+
+TEST(HistogramTest, TailPrecision) {
+  // Fast values and a slow tail: P99.9 and P99.99 must be within 1% of the
+  // exact ones, which fixed 1-2-5 buckets could not tell apart
+  HistogramImpl histogram;
+  for (uint64_t i = 0; i < 99850; i++) {
+    histogram.Add(100);
+  }
+  for (uint64_t i = 0; i < 150; i++) {
+    histogram.Add(130000 + i * 1000);
+  }
+  ASSERT_EQ(histogram.Median(), 100.0);
+  ASSERT_LT(fabs(histogram.Percentile(99.9) - 179000) / 179000, 0.01);
+  double p9999 = histogram.Percentile(99.99);
+  ASSERT_LT(fabs(p9999 - 269000) / 269000, 0.01);
+  ASSERT_EQ(histogram.Max(), 279000.0);
+
+  HistogramData data;
+  histogram.Data(&data);
+  ASSERT_EQ(data.percentile9999, p9999);
+  ASSERT_EQ(data.max, 279000.0);
+  ASSERT_NE(histogram.ToString().find("P99.99: "), std::string::npos);
+}
+
+TEST(HistogramTest, MergeSingleWriter) {
+  SingleWriterHistogram per_thread[2];
+  HistogramImpl expected;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    per_thread[i % 2].Add(i * 7);
+    expected.Add(i * 7);
+  }
+  HistogramImpl merged;
+  merged.Merge(per_thread[0]);
+  merged.Merge(per_thread[1]);
+  ASSERT_EQ(merged.ToString(), expected.ToString());
+
+  // Histograms of another precision merge at their bucket starts
+  HistogramImpl coarse(1);
+  coarse.Merge(expected);
+  ASSERT_EQ(coarse.Average(), expected.Average());
+  ASSERT_LT(fabs(coarse.Percentile(90) - expected.Percentile(90)) /
+                expected.Percentile(90),
+            0.1);
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
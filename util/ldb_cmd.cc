@@ -1403,7 +1403,15 @@ void DumpWalFile(std::string wal_file, bool print_header, bool print_values,
     }
   } else {
     StdErrReporter reporter;
-    log::Reader reader(move(file), &reporter, true, 0);
+    uint64_t log_number;
+    FileType type;
+    // The log number is only needed for recycled logs, whose trailing
+    // records from a previous log are not dumped
+    if (!ParseFileName(wal_file.substr(wal_file.find_last_of('/') + 1),
+                       &log_number, &type)) {
+      log_number = 0;
+    }
+    log::Reader reader(move(file), &reporter, true, 0, log_number);
     string scratch;
     WriteBatch batch;
     Slice record;
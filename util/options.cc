@@ -201,13 +201,16 @@ DBOptions::DBOptions()
       create_missing_column_families(false),
       error_if_exists(false),
       paranoid_checks(true),
+      wal_recovery_mode(kWALRecoveryModeSkipCorruptedRecords),
       env(Env::Default()),
       rate_limiter(nullptr),
       info_log(nullptr),
       info_log_level(INFO_LEVEL),
       max_open_files(5000),
+      max_file_opening_threads(16),
       max_total_wal_size(0),
       statistics(nullptr),
+      request_tracer(nullptr),
       disableDataSync(false),
       use_fsync(false),
       db_log_dir(""),
@@ -219,22 +222,30 @@ DBOptions::DBOptions()
       log_file_time_to_roll(0),
       keep_log_file_num(1000),
       max_manifest_file_size(std::numeric_limits<uint64_t>::max()),
+      write_file_stats_to_manifest(false),
       table_cache_numshardbits(4),
       table_cache_remove_scan_count_limit(16),
       WAL_ttl_seconds(0),
       WAL_size_limit_MB(0),
+      recycle_log_file_num(0),
+      wal_compression(kNoCompression),
       manifest_preallocation_size(4 * 1024 * 1024),
       allow_os_buffer(true),
       allow_mmap_reads(false),
       allow_mmap_writes(false),
       is_fd_close_on_exec(true),
       skip_log_error_on_recovery(false),
+      pipelined_wal_recovery(false),
       stats_dump_period_sec(3600),
+      stats_persist_period_sec(0),
+      stats_persist_max_file_size(64 << 20),
+      stats_persist_keep_file_num(10),
       advise_random_on_open(true),
       db_write_buffer_size(0),
       access_hint_on_compaction_start(NORMAL),
       use_adaptive_mutex(false),
       bytes_per_sync(0),
+      wal_bytes_per_sync(0),
       enable_thread_tracking(false) {}
 
 DBOptions::DBOptions(const Options& options)
@@ -242,13 +253,16 @@ DBOptions::DBOptions(const Options& options)
       create_missing_column_families(options.create_missing_column_families),
       error_if_exists(options.error_if_exists),
       paranoid_checks(options.paranoid_checks),
+      wal_recovery_mode(options.wal_recovery_mode),
       env(options.env),
       rate_limiter(options.rate_limiter),
       info_log(options.info_log),
       info_log_level(options.info_log_level),
       max_open_files(options.max_open_files),
+      max_file_opening_threads(options.max_file_opening_threads),
       max_total_wal_size(options.max_total_wal_size),
       statistics(options.statistics),
+      request_tracer(options.request_tracer),
       disableDataSync(options.disableDataSync),
       use_fsync(options.use_fsync),
       db_paths(options.db_paths),
@@ -262,23 +276,31 @@ DBOptions::DBOptions(const Options& options)
       log_file_time_to_roll(options.log_file_time_to_roll),
       keep_log_file_num(options.keep_log_file_num),
       max_manifest_file_size(options.max_manifest_file_size),
+      write_file_stats_to_manifest(options.write_file_stats_to_manifest),
       table_cache_numshardbits(options.table_cache_numshardbits),
       table_cache_remove_scan_count_limit(
           options.table_cache_remove_scan_count_limit),
       WAL_ttl_seconds(options.WAL_ttl_seconds),
       WAL_size_limit_MB(options.WAL_size_limit_MB),
+      recycle_log_file_num(options.recycle_log_file_num),
+      wal_compression(options.wal_compression),
       manifest_preallocation_size(options.manifest_preallocation_size),
       allow_os_buffer(options.allow_os_buffer),
       allow_mmap_reads(options.allow_mmap_reads),
       allow_mmap_writes(options.allow_mmap_writes),
       is_fd_close_on_exec(options.is_fd_close_on_exec),
       skip_log_error_on_recovery(options.skip_log_error_on_recovery),
+      pipelined_wal_recovery(options.pipelined_wal_recovery),
       stats_dump_period_sec(options.stats_dump_period_sec),
+      stats_persist_period_sec(options.stats_persist_period_sec),
+      stats_persist_max_file_size(options.stats_persist_max_file_size),
+      stats_persist_keep_file_num(options.stats_persist_keep_file_num),
       advise_random_on_open(options.advise_random_on_open),
       db_write_buffer_size(options.db_write_buffer_size),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
       use_adaptive_mutex(options.use_adaptive_mutex),
       bytes_per_sync(options.bytes_per_sync),
+      wal_bytes_per_sync(options.wal_bytes_per_sync),
       enable_thread_tracking(options.enable_thread_tracking) {}
 
 static const char* const access_hints[] = {
@@ -289,15 +311,19 @@ void DBOptions::Dump(Logger* log) const {
     Log(log,"         Options.error_if_exists: %d", error_if_exists);
     Log(log,"       Options.create_if_missing: %d", create_if_missing);
     Log(log,"         Options.paranoid_checks: %d", paranoid_checks);
+    Log(log,"       Options.wal_recovery_mode: %d", wal_recovery_mode);
     Log(log,"                     Options.env: %p", env);
     Log(log,"                Options.info_log: %p", info_log.get());
     Log(log,"          Options.max_open_files: %d", max_open_files);
+    Log(log,"Options.max_file_opening_threads: %d", max_file_opening_threads);
     Log(log,"      Options.max_total_wal_size: %" PRIu64, max_total_wal_size);
     Log(log, "       Options.disableDataSync: %d", disableDataSync);
     Log(log, "             Options.use_fsync: %d", use_fsync);
     Log(log, "     Options.max_log_file_size: %zu", max_log_file_size);
     Log(log, "Options.max_manifest_file_size: %" PRIu64,
         max_manifest_file_size);
+    Log(log, "Options.write_file_stats_to_manifest: %d",
+        write_file_stats_to_manifest);
     Log(log, "     Options.log_file_time_to_roll: %zu", log_file_time_to_roll);
     Log(log, "     Options.keep_log_file_num: %zu", keep_log_file_num);
     Log(log, "       Options.allow_os_buffer: %d", allow_os_buffer);
@@ -323,6 +349,10 @@ void DBOptions::Dump(Logger* log) const {
         WAL_ttl_seconds);
     Log(log, "                      Options.WAL_size_limit_MB: %" PRIu64,
         WAL_size_limit_MB);
+    Log(log, "                   Options.recycle_log_file_num: %zu",
+        recycle_log_file_num);
+    Log(log, "                        Options.wal_compression: %d",
+        wal_compression);
     Log(log, "            Options.manifest_preallocation_size: %zu",
         manifest_preallocation_size);
     Log(log, "                         Options.allow_os_buffer: %d",
@@ -333,8 +363,16 @@ void DBOptions::Dump(Logger* log) const {
         allow_mmap_writes);
     Log(log, "                     Options.is_fd_close_on_exec: %d",
         is_fd_close_on_exec);
+    Log(log, "                  Options.pipelined_wal_recovery: %d",
+        pipelined_wal_recovery);
     Log(log, "                   Options.stats_dump_period_sec: %u",
         stats_dump_period_sec);
+    Log(log, "                Options.stats_persist_period_sec: %u",
+        stats_persist_period_sec);
+    Log(log, "             Options.stats_persist_max_file_size: %zu",
+        stats_persist_max_file_size);
+    Log(log, "             Options.stats_persist_keep_file_num: %zu",
+        stats_persist_keep_file_num);
     Log(log, "                   Options.advise_random_on_open: %d",
         advise_random_on_open);
     Log(log, "                   Options.db_write_buffer_size: %zd",
@@ -347,6 +385,8 @@ void DBOptions::Dump(Logger* log) const {
         rate_limiter.get());
     Log(log, "                          Options.bytes_per_sync: %" PRIu64,
         bytes_per_sync);
+    Log(log, "                      Options.wal_bytes_per_sync: %" PRIu64,
+        wal_bytes_per_sync);
     Log(log, "                    enable_thread_tracking: %d",
         enable_thread_tracking);
 }  // DBOptions::Dump
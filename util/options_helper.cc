@@ -134,6 +134,17 @@ CompactionStyle ParseCompactionStyle(const std::string& type) {
   }
   return kCompactionStyleLevel;
 }
+
+WALRecoveryMode ParseWALRecoveryMode(const std::string& type) {
+  if (type == "kWALRecoveryModeSkipCorruptedRecords") {
+    return kWALRecoveryModeSkipCorruptedRecords;
+  } else if (type == "kWALRecoveryModePointInTime") {
+    return kWALRecoveryModePointInTime;
+  } else {
+    throw std::invalid_argument("unknown WAL recovery mode: " + type);
+  }
+  return kWALRecoveryModeSkipCorruptedRecords;
+}
 }  // anonymouse namespace
 
 template<typename OptionsType>
@@ -381,6 +392,14 @@ Status GetBlockBasedTableOptionsFromMap(
         new_table_options->block_size_deviation = ParseInt(o.second);
       } else if (o.first == "block_restart_interval") {
         new_table_options->block_restart_interval = ParseInt(o.second);
+      } else if (o.first == "max_auto_readahead_size") {
+        new_table_options->max_auto_readahead_size = ParseSizeT(o.second);
+      } else if (o.first == "fixed_key_seek_column") {
+        new_table_options->fixed_key_seek_column =
+          ParseBoolean(o.first, o.second);
+      } else if (o.first == "data_block_hash_index") {
+        new_table_options->data_block_hash_index =
+          ParseBoolean(o.first, o.second);
       } else if (o.first == "filter_policy") {
         // Expect the following format
         // bloomfilter:int:bool
@@ -558,8 +577,12 @@ Status GetDBOptionsFromMap(
         new_options->error_if_exists = ParseBoolean(o.first, o.second);
       } else if (o.first == "paranoid_checks") {
         new_options->paranoid_checks = ParseBoolean(o.first, o.second);
+      } else if (o.first == "wal_recovery_mode") {
+        new_options->wal_recovery_mode = ParseWALRecoveryMode(o.second);
       } else if (o.first == "max_open_files") {
         new_options->max_open_files = ParseInt(o.second);
+      } else if (o.first == "max_file_opening_threads") {
+        new_options->max_file_opening_threads = ParseInt(o.second);
       } else if (o.first == "max_total_wal_size") {
         new_options->max_total_wal_size = ParseUint64(o.second);
       } else if (o.first == "disable_data_sync") {
@@ -588,6 +611,9 @@ Status GetDBOptionsFromMap(
         new_options->keep_log_file_num = ParseSizeT(o.second);
       } else if (o.first == "max_manifest_file_size") {
         new_options->max_manifest_file_size = ParseUint64(o.second);
+      } else if (o.first == "write_file_stats_to_manifest") {
+        new_options->write_file_stats_to_manifest =
+            ParseBoolean(o.first, o.second);
       } else if (o.first == "table_cache_numshardbits") {
         new_options->table_cache_numshardbits = ParseInt(o.second);
       } else if (o.first == "table_cache_remove_scan_count_limit") {
@@ -596,6 +622,10 @@ Status GetDBOptionsFromMap(
         new_options->WAL_ttl_seconds = ParseUint64(o.second);
       } else if (o.first == "WAL_size_limit_MB") {
         new_options->WAL_size_limit_MB = ParseUint64(o.second);
+      } else if (o.first == "recycle_log_file_num") {
+        new_options->recycle_log_file_num = ParseSizeT(o.second);
+      } else if (o.first == "wal_compression") {
+        new_options->wal_compression = ParseCompressionType(o.second);
       } else if (o.first == "manifest_preallocation_size") {
         new_options->manifest_preallocation_size = ParseSizeT(o.second);
       } else if (o.first == "allow_os_buffer") {
@@ -609,8 +639,16 @@ Status GetDBOptionsFromMap(
       } else if (o.first == "skip_log_error_on_recovery") {
         new_options->skip_log_error_on_recovery =
           ParseBoolean(o.first, o.second);
+      } else if (o.first == "pipelined_wal_recovery") {
+        new_options->pipelined_wal_recovery = ParseBoolean(o.first, o.second);
       } else if (o.first == "stats_dump_period_sec") {
         new_options->stats_dump_period_sec = ParseUint32(o.second);
+      } else if (o.first == "stats_persist_period_sec") {
+        new_options->stats_persist_period_sec = ParseUint32(o.second);
+      } else if (o.first == "stats_persist_max_file_size") {
+        new_options->stats_persist_max_file_size = ParseSizeT(o.second);
+      } else if (o.first == "stats_persist_keep_file_num") {
+        new_options->stats_persist_keep_file_num = ParseSizeT(o.second);
       } else if (o.first == "advise_random_on_open") {
         new_options->advise_random_on_open = ParseBoolean(o.first, o.second);
       } else if (o.first == "db_write_buffer_size") {
@@ -619,6 +657,8 @@ Status GetDBOptionsFromMap(
         new_options->use_adaptive_mutex = ParseBoolean(o.first, o.second);
       } else if (o.first == "bytes_per_sync") {
         new_options->bytes_per_sync = ParseUint64(o.second);
+      } else if (o.first == "wal_bytes_per_sync") {
+        new_options->wal_bytes_per_sync = ParseUint64(o.second);
       } else {
         return Status::InvalidArgument("Unrecognized option: " + o.first);
       }
@@ -138,7 +138,9 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
     {"create_missing_column_families", "true"},
     {"error_if_exists", "false"},
     {"paranoid_checks", "true"},
+    {"wal_recovery_mode", "kWALRecoveryModePointInTime"},
     {"max_open_files", "32"},
+    {"max_file_opening_threads", "6"},
     {"max_total_wal_size", "33"},
     {"disable_data_sync", "false"},
     {"use_fsync", "true"},
@@ -151,10 +153,13 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
     {"log_file_time_to_roll", "38"},
     {"keep_log_file_num", "39"},
     {"max_manifest_file_size", "40"},
+    {"write_file_stats_to_manifest", "true"},
     {"table_cache_numshardbits", "41"},
     {"table_cache_remove_scan_count_limit", "42"},
     {"WAL_ttl_seconds", "43"},
     {"WAL_size_limit_MB", "44"},
+    {"recycle_log_file_num", "4"},
+    {"wal_compression", "kZlibCompression"},
     {"manifest_preallocation_size", "45"},
     {"allow_os_buffer", "false"},
     {"allow_mmap_reads", "true"},
@@ -162,9 +167,11 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
     {"is_fd_close_on_exec", "true"},
     {"skip_log_error_on_recovery", "false"},
     {"stats_dump_period_sec", "46"},
+    {"stats_persist_period_sec", "47"},
     {"advise_random_on_open", "true"},
     {"use_adaptive_mutex", "false"},
     {"bytes_per_sync", "47"},
+    {"wal_bytes_per_sync", "48"},
   };
 
   ColumnFamilyOptions base_cf_opt;
@@ -242,7 +249,9 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_db_opt.create_missing_column_families, true);
   ASSERT_EQ(new_db_opt.error_if_exists, false);
   ASSERT_EQ(new_db_opt.paranoid_checks, true);
+  ASSERT_EQ(new_db_opt.wal_recovery_mode, kWALRecoveryModePointInTime);
   ASSERT_EQ(new_db_opt.max_open_files, 32);
+  ASSERT_EQ(new_db_opt.max_file_opening_threads, 6);
   ASSERT_EQ(new_db_opt.max_total_wal_size, static_cast<uint64_t>(33));
   ASSERT_EQ(new_db_opt.disableDataSync, false);
   ASSERT_EQ(new_db_opt.use_fsync, true);
@@ -256,10 +265,13 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_db_opt.log_file_time_to_roll, 38U);
   ASSERT_EQ(new_db_opt.keep_log_file_num, 39U);
   ASSERT_EQ(new_db_opt.max_manifest_file_size, static_cast<uint64_t>(40));
+  ASSERT_EQ(new_db_opt.write_file_stats_to_manifest, true);
   ASSERT_EQ(new_db_opt.table_cache_numshardbits, 41);
   ASSERT_EQ(new_db_opt.table_cache_remove_scan_count_limit, 42);
   ASSERT_EQ(new_db_opt.WAL_ttl_seconds, static_cast<uint64_t>(43));
   ASSERT_EQ(new_db_opt.WAL_size_limit_MB, static_cast<uint64_t>(44));
+  ASSERT_EQ(new_db_opt.recycle_log_file_num, 4U);
+  ASSERT_EQ(new_db_opt.wal_compression, kZlibCompression);
   ASSERT_EQ(new_db_opt.manifest_preallocation_size, 45U);
   ASSERT_EQ(new_db_opt.allow_os_buffer, false);
   ASSERT_EQ(new_db_opt.allow_mmap_reads, true);
@@ -267,9 +279,11 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_db_opt.is_fd_close_on_exec, true);
   ASSERT_EQ(new_db_opt.skip_log_error_on_recovery, false);
   ASSERT_EQ(new_db_opt.stats_dump_period_sec, 46U);
+  ASSERT_EQ(new_db_opt.stats_persist_period_sec, 47U);
   ASSERT_EQ(new_db_opt.advise_random_on_open, true);
   ASSERT_EQ(new_db_opt.use_adaptive_mutex, false);
   ASSERT_EQ(new_db_opt.bytes_per_sync, static_cast<uint64_t>(47));
+  ASSERT_EQ(new_db_opt.wal_bytes_per_sync, static_cast<uint64_t>(48));
 }
 
 TEST(OptionsTest, GetOptionsFromStringTest) {
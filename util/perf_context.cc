@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 //
 
+#include <string.h>
 #include <sstream>
 #include "util/perf_context_imp.h"
 
@@ -51,6 +52,9 @@ void PerfContext::Reset() {
   find_next_user_entry_time = 0;
   write_pre_and_post_process_time = 0;
   write_memtable_time = 0;
+  bloom_filter_useful = 0;
+  bloom_filter_positive = 0;
+  memset(level_perf_context, 0, sizeof(level_perf_context));
 #endif
 }
 
@@ -82,7 +86,23 @@ std::string PerfContext::ToString() const {
      << OUTPUT(seek_internal_seek_time)
      << OUTPUT(find_next_user_entry_time)
      << OUTPUT(write_pre_and_post_process_time)
-     << OUTPUT(write_memtable_time);
+     << OUTPUT(write_memtable_time)
+     << OUTPUT(bloom_filter_useful)
+     << OUTPUT(bloom_filter_positive);
+  for (int level = 0; level < kPerfContextMaxLevels; level++) {
+    const PerfContextByLevel& l = level_perf_context[level];
+    if (l.get_files_probed == 0) {
+      continue;
+    }
+    ss << "level" << level << " = { "
+       << "get_files_probed = " << l.get_files_probed << ", "
+       << "get_hit_count = " << l.get_hit_count << ", "
+       << "bloom_filter_useful = " << l.bloom_filter_useful << ", "
+       << "bloom_filter_positive = " << l.bloom_filter_positive << ", "
+       << "bloom_filter_true_positive = " << l.bloom_filter_true_positive
+       << ", "
+       << "block_read_count = " << l.block_read_count << " }, ";
+  }
   return ss.str();
 #endif
 }
@@ -0,0 +1,111 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+
+#include "util/request_tracer_imp.h"
+
+#include "util/random.h"
+#include "util/thread_local.h"
+
+namespace rocksdb {
+
+RequestTracer::RequestTracer(uint32_t sample_rate)
+    : sample_rate_(sample_rate), sample_countdown_(new ThreadLocalPtr()) {}
+
+RequestTracer::~RequestTracer() {}
+
+#if !defined(NPERF_CONTEXT) && !defined(IOS_CROSS_COMPILE)
+
+__thread RequestTraceContext* request_trace_context = nullptr;
+
+namespace {
+// Spans reserved up front, enough for a Get() that probes a few files
+const size_t kInitialSpans = 16;
+
+__thread uint32_t request_trace_seed = 0;
+}  // namespace
+
+bool ShouldSampleRequest(RequestTracer* tracer) {
+  uint32_t sample_rate = tracer->sample_rate_;
+  if (sample_rate == 0) {
+    return false;
+  }
+  // The countdown is stored in the pointer itself; 0 if the thread has not
+  // issued any request to this tracer yet
+  ThreadLocalPtr* countdown_ptr = tracer->sample_countdown_.get();
+  uintptr_t countdown = reinterpret_cast<uintptr_t>(countdown_ptr->Get());
+  if (countdown > 1) {
+    countdown_ptr->Reset(reinterpret_cast<void*>(countdown - 1));
+    return false;
+  }
+  // Unless every request is traced, the first request of a thread is not
+  // sampled, so that threads that only issue a few requests are not all
+  // traced
+  bool sampled = countdown != 0 || sample_rate == 1;
+  if (request_trace_seed == 0) {
+    request_trace_seed = static_cast<uint32_t>(
+        Env::Default()->NowNanos() ^ reinterpret_cast<uintptr_t>(&sampled)) |
+        1;
+  }
+  Random rnd(request_trace_seed);
+  request_trace_seed = rnd.Next();
+  // Uniform in [1, 2 * sample_rate - 1], which averages sample_rate
+  uint64_t range = 2 * static_cast<uint64_t>(sample_rate) - 1;
+  countdown_ptr->Reset(
+      reinterpret_cast<void*>(static_cast<uintptr_t>(
+          1 + request_trace_seed % range)));
+  return sampled;
+}
+
+size_t RequestTraceContext::BeginSpan(TraceSpanType type) {
+  TraceSpan span;
+  span.type = type;
+  span.level = level;
+  span.file_number = file_number;
+  span.start_nanos = env->NowNanos() - start_nanos;
+  span.duration_nanos = 0;
+  span.value = 0;
+  trace.spans.push_back(span);
+  return trace.spans.size() - 1;
+}
+
+void RequestTraceContext::EndSpan(size_t index, TraceSpanType type,
+                                  uint64_t value) {
+  TraceSpan& span = trace.spans[index];
+  span.type = type;
+  span.duration_nanos = env->NowNanos() - start_nanos - span.start_nanos;
+  span.value = value;
+}
+
+void RequestTraceContext::AddEvent(TraceSpanType type, uint64_t value) {
+  size_t index = BeginSpan(type);
+  trace.spans[index].value = value;
+}
+
+void RequestTraceGuard::Start(RequestTracer* tracer,
+                              RequestTrace::Operation operation, Env* env) {
+  tracer_ = tracer;
+  context_.reset(new RequestTraceContext());
+  context_->env = env;
+  context_->level = -1;
+  context_->file_number = 0;
+  context_->trace.operation = operation;
+  context_->trace.start_micros = env->NowMicros();
+  context_->trace.duration_nanos = 0;
+  context_->trace.spans.reserve(kInitialSpans);
+  context_->start_nanos = env->NowNanos();
+  request_trace_context = context_.get();
+}
+
+void RequestTraceGuard::Finish() {
+  request_trace_context = nullptr;
+  context_->trace.duration_nanos = context_->env->NowNanos() -
+                                   context_->start_nanos;
+  tracer_->OnRequestTraced(context_->trace);
+}
+
+#endif
+
+}  // namespace rocksdb
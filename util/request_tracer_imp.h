@@ -0,0 +1,181 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+#pragma once
+#include <memory>
+#include <string>
+
+#include "rocksdb/env.h"
+#include "rocksdb/request_tracer.h"
+
+namespace rocksdb {
+
+#if defined(NPERF_CONTEXT) || defined(IOS_CROSS_COMPILE)
+
+#define TRACE_REQUEST_GUARD(tracer, force, operation, env)
+#define TRACE_REQUEST_SET_CF_NAME(name)
+#define TRACE_REQUEST_SET_STATUS(status)
+#define TRACE_SPAN_GUARD(name, type)
+#define TRACE_SPAN_SET_TYPE(name, type)
+#define TRACE_SPAN_SET_VALUE(name, value)
+#define TRACE_EVENT(type, value)
+#define TRACE_TABLE_GUARD(level, file_number)
+
+#else
+
+// The request being traced on this thread
+struct RequestTraceContext {
+  RequestTrace trace;
+  Env* env;
+  uint64_t start_nanos;
+  // Table file the current steps are taken for
+  int level;
+  uint64_t file_number;
+
+  // Adds a span that starts now, and returns its index in trace.spans
+  size_t BeginSpan(TraceSpanType type);
+  void EndSpan(size_t index, TraceSpanType type, uint64_t value);
+  // Adds a span that starts and ends now
+  void AddEvent(TraceSpanType type, uint64_t value);
+};
+
+// nullptr unless the request running on this thread is traced
+extern __thread RequestTraceContext* request_trace_context;
+
+// Returns whether "tracer" samples the current request of this thread.
+// Every tracer keeps its own countdown on each thread, so DBs that share a
+// thread do not skew each other's sampling.
+extern bool ShouldSampleRequest(RequestTracer* tracer);
+
+// Traces the enclosing request if it is sampled, and hands the trace to
+// the tracer when it goes out of scope. Requests issued while another one
+// is traced on the same thread are not traced on their own.
+class RequestTraceGuard {
+ public:
+  RequestTraceGuard(RequestTracer* tracer, bool force,
+                    RequestTrace::Operation operation, Env* env)
+      : tracer_(nullptr) {
+    if (tracer != nullptr && request_trace_context == nullptr &&
+        (force || ShouldSampleRequest(tracer))) {
+      Start(tracer, operation, env);
+    }
+  }
+
+  ~RequestTraceGuard() {
+    if (tracer_ != nullptr) {
+      Finish();
+    }
+  }
+
+  void SetCFName(const std::string& cf_name) {
+    if (tracer_ != nullptr) {
+      context_->trace.cf_name = cf_name;
+    }
+  }
+
+  void SetStatus(const Status& status) {
+    if (tracer_ != nullptr) {
+      context_->trace.status = status;
+    }
+  }
+
+ private:
+  void Start(RequestTracer* tracer, RequestTrace::Operation operation,
+             Env* env);
+  void Finish();
+
+  RequestTracer* tracer_;
+  std::unique_ptr<RequestTraceContext> context_;
+};
+
+// Records a span from its construction to its destruction if the request
+// is traced
+class TraceSpanGuard {
+ public:
+  explicit TraceSpanGuard(TraceSpanType type)
+      : context_(request_trace_context), type_(type), value_(0) {
+    if (context_ != nullptr) {
+      index_ = context_->BeginSpan(type);
+    }
+  }
+
+  ~TraceSpanGuard() {
+    if (context_ != nullptr) {
+      context_->EndSpan(index_, type_, value_);
+    }
+  }
+
+  void set_type(TraceSpanType type) { type_ = type; }
+  void set_value(uint64_t value) { value_ = value; }
+
+ private:
+  RequestTraceContext* const context_;
+  TraceSpanType type_;
+  uint64_t value_;
+  size_t index_;
+};
+
+// Records a kTableGet span, and ties the spans nested in it to the table
+// file
+class TraceTableGuard {
+ public:
+  TraceTableGuard(int level, uint64_t file_number)
+      : context_(request_trace_context) {
+    if (context_ != nullptr) {
+      prev_level_ = context_->level;
+      prev_file_number_ = context_->file_number;
+      context_->level = level;
+      context_->file_number = file_number;
+      index_ = context_->BeginSpan(TraceSpanType::kTableGet);
+    }
+  }
+
+  ~TraceTableGuard() {
+    if (context_ != nullptr) {
+      context_->EndSpan(index_, TraceSpanType::kTableGet, 0);
+      context_->level = prev_level_;
+      context_->file_number = prev_file_number_;
+    }
+  }
+
+ private:
+  RequestTraceContext* const context_;
+  int prev_level_;
+  uint64_t prev_file_number_;
+  size_t index_;
+};
+
+// Trace the enclosing request if it is sampled, or if "force" is true
+#define TRACE_REQUEST_GUARD(tracer, force, operation, env)                   \
+  RequestTraceGuard request_trace_guard((tracer), (force), (operation), (env));
+
+#define TRACE_REQUEST_SET_CF_NAME(name) \
+  request_trace_guard.SetCFName(name);
+
+#define TRACE_REQUEST_SET_STATUS(status) \
+  request_trace_guard.SetStatus(status);
+
+// Declare a span that lasts until the end of the scope
+#define TRACE_SPAN_GUARD(name, type) \
+  TraceSpanGuard trace_span_ ## name(type);
+
+#define TRACE_SPAN_SET_TYPE(name, type) \
+  trace_span_ ## name.set_type(type);
+
+#define TRACE_SPAN_SET_VALUE(name, value) \
+  trace_span_ ## name.set_value(value);
+
+// Record a step that takes no time
+#define TRACE_EVENT(type, value)                     \
+  if (request_trace_context != nullptr) {            \
+    request_trace_context->AddEvent((type), (value)); \
+  }
+
+#define TRACE_TABLE_GUARD(level, file_number) \
+  TraceTableGuard trace_table_guard((level), (file_number));
+
+#endif
+
+}  // namespace rocksdb
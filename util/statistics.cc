@@ -21,33 +21,101 @@ std::shared_ptr<Statistics> CreateDBStatistics() {
   return std::make_shared<StatisticsImpl>(nullptr, false);
 }
 
+StatisticsImpl::ThreadStats::ThreadStats(StatisticsImpl* stats)
+    : owner(stats) {
+  for (auto& ticker : tickers) {
+    ticker.store(0, std::memory_order_relaxed);
+  }
+}
+
 StatisticsImpl::StatisticsImpl(
     std::shared_ptr<Statistics> stats,
     bool enable_internal_stats)
   : stats_shared_(stats),
     stats_(stats.get()),
-    enable_internal_stats_(enable_internal_stats) {
+    enable_internal_stats_(enable_internal_stats),
+    thread_stats_(&StatisticsImpl::MergeExitedThread) {
+  for (auto& ticker : exited_tickers_) {
+    ticker = 0;
+  }
 }
 
 StatisticsImpl::~StatisticsImpl() {}
 
+StatisticsImpl::ThreadStats* StatisticsImpl::GetThreadStats() {
+  auto* thread_stats = static_cast<ThreadStats*>(thread_stats_.Get());
+  if (UNLIKELY(thread_stats == nullptr)) {
+    thread_stats = new ThreadStats(this);
+    thread_stats_.Reset(thread_stats);
+  }
+  return thread_stats;
+}
+
+void StatisticsImpl::MergeExitedThread(void* ptr) {
+  auto* thread_stats = static_cast<ThreadStats*>(ptr);
+  StatisticsImpl* stats = thread_stats->owner;
+  {
+    MutexLock l(&stats->exited_mutex_);
+    for (uint32_t i = 0; i < INTERNAL_TICKER_ENUM_MAX; ++i) {
+      stats->exited_tickers_[i] +=
+          thread_stats->tickers[i].load(std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < INTERNAL_HISTOGRAM_ENUM_MAX; ++i) {
+      stats->exited_histograms_[i].Merge(thread_stats->histograms[i]);
+    }
+  }
+  delete thread_stats;
+}
+
+namespace {
+
+struct TickerFold {
+  uint32_t type;
+  uint64_t sum;
+};
+
+struct HistogramFold {
+  uint32_t type;
+  HistogramImpl* histogram;
+};
+
+}  // namespace
+
 uint64_t StatisticsImpl::getTickerCount(uint32_t tickerType) const {
   assert(
     enable_internal_stats_ ?
       tickerType < INTERNAL_TICKER_ENUM_MAX :
       tickerType < TICKER_ENUM_MAX);
-  // Return its own ticker version
-  return tickers_[tickerType].value;
+  TickerFold fold = {tickerType, 0};
+  {
+    MutexLock l(&exited_mutex_);
+    fold.sum = exited_tickers_[tickerType];
+  }
+  thread_stats_.Fold([](void* ptr, void* res) {
+    auto* f = static_cast<TickerFold*>(res);
+    f->sum += static_cast<ThreadStats*>(ptr)->tickers[f->type].load(
+        std::memory_order_relaxed);
+  }, &fold);
+  return fold.sum;
 }
 
 void StatisticsImpl::histogramData(uint32_t histogramType,
                                    HistogramData* const data) const {
   assert(
     enable_internal_stats_ ?
-      histogramType < INTERNAL_TICKER_ENUM_MAX :
-      histogramType < TICKER_ENUM_MAX);
-  // Return its own ticker version
-  histograms_[histogramType].Data(data);
+      histogramType < INTERNAL_HISTOGRAM_ENUM_MAX :
+      histogramType < HISTOGRAM_ENUM_MAX);
+  HistogramImpl histogram;
+  {
+    MutexLock l(&exited_mutex_);
+    histogram.Merge(exited_histograms_[histogramType]);
+  }
+  HistogramFold fold = {histogramType, &histogram};
+  thread_stats_.Fold([](void* ptr, void* res) {
+    auto* f = static_cast<HistogramFold*>(res);
+    f->histogram->Merge(static_cast<ThreadStats*>(ptr)->histograms[f->type]);
+  }, &fold);
+  histogram.Data(data);
 }
 
 void StatisticsImpl::setTickerCount(uint32_t tickerType, uint64_t count) {
@@ -56,7 +124,13 @@ void StatisticsImpl::setTickerCount(uint32_t tickerType, uint64_t count) {
       tickerType < INTERNAL_TICKER_ENUM_MAX :
       tickerType < TICKER_ENUM_MAX);
   if (tickerType < TICKER_ENUM_MAX || enable_internal_stats_) {
-    tickers_[tickerType].value = count;
+    // Ticks that other threads record meanwhile may be lost
+    thread_stats_.Fold([](void* ptr, void* res) {
+      static_cast<ThreadStats*>(ptr)->tickers[*static_cast<uint32_t*>(res)]
+          .store(0, std::memory_order_relaxed);
+    }, &tickerType);
+    MutexLock l(&exited_mutex_);
+    exited_tickers_[tickerType] = count;
   }
   if (stats_ && tickerType < TICKER_ENUM_MAX) {
     stats_->setTickerCount(tickerType, count);
@@ -69,7 +143,8 @@ void StatisticsImpl::recordTick(uint32_t tickerType, uint64_t count) {
       tickerType < INTERNAL_TICKER_ENUM_MAX :
       tickerType < TICKER_ENUM_MAX);
   if (tickerType < TICKER_ENUM_MAX || enable_internal_stats_) {
-    tickers_[tickerType].value += count;
+    GetThreadStats()->tickers[tickerType].fetch_add(
+        count, std::memory_order_relaxed);
   }
   if (stats_ && tickerType < TICKER_ENUM_MAX) {
     stats_->recordTick(tickerType, count);
@@ -82,7 +157,7 @@ void StatisticsImpl::measureTime(uint32_t histogramType, uint64_t value) {
       histogramType < INTERNAL_HISTOGRAM_ENUM_MAX :
       histogramType < HISTOGRAM_ENUM_MAX);
   if (histogramType < HISTOGRAM_ENUM_MAX || enable_internal_stats_) {
-    histograms_[histogramType].Add(value);
+    GetThreadStats()->histograms[histogramType].Add(value);
   }
   if (stats_ && histogramType < HISTOGRAM_ENUM_MAX) {
     stats_->measureTime(histogramType, value);
@@ -92,7 +167,7 @@ void StatisticsImpl::measureTime(uint32_t histogramType, uint64_t value) {
 namespace {
 
 // a buffer size used for temp string buffers
-const int kBufferSize = 200;
+const int kBufferSize = 400;
 
 } // namespace
 
@@ -115,11 +190,15 @@ std::string StatisticsImpl::ToString() const {
       snprintf(
           buffer,
           kBufferSize,
-          "%s statistics Percentiles :=> 50 : %f 95 : %f 99 : %f\n",
+          "%s statistics Percentiles :=> 50 : %f 95 : %f 99 : %f 99.9 : %f "
+          "99.99 : %f max : %f\n",
           h.second.c_str(),
           hData.median,
           hData.percentile95,
-          hData.percentile99);
+          hData.percentile99,
+          hData.percentile999,
+          hData.percentile9999,
+          hData.max);
       res.append(buffer);
     }
   }
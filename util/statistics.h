@@ -12,6 +12,7 @@
 
 #include "util/histogram.h"
 #include "util/mutexlock.h"
+#include "util/thread_local.h"
 #include "port/likely.h"
 
 
@@ -28,6 +29,9 @@ enum HistogramsInternal : uint32_t {
 };
 
 
+// Every thread records its ticks and times in its own ThreadStats, so that
+// threads never write to the same cache lines. Readers fold the stats of
+// the live threads together with those of the threads that have exited.
 class StatisticsImpl : public Statistics {
  public:
   StatisticsImpl(std::shared_ptr<Statistics> stats,
@@ -50,25 +54,73 @@ class StatisticsImpl : public Statistics {
   Statistics* stats_;
   bool enable_internal_stats_;
 
-  struct Ticker {
-    Ticker() : value(uint_fast64_t()) {}
+  // The stats recorded by one thread
+  struct ThreadStats {
+    explicit ThreadStats(StatisticsImpl* stats);
 
-    std::atomic_uint_fast64_t value;
-    // Pad the structure to make it size of 64 bytes. A plain array of
-    // std::atomic_uint_fast64_t results in huge performance degradataion
-    // due to false sharing.
-    char padding[64 - sizeof(std::atomic_uint_fast64_t)];
+    StatisticsImpl* const owner;
+    std::atomic<uint64_t> tickers[INTERNAL_TICKER_ENUM_MAX];
+    SingleWriterHistogram histograms[INTERNAL_HISTOGRAM_ENUM_MAX];
   };
 
-  Ticker tickers_[INTERNAL_TICKER_ENUM_MAX] __attribute__((aligned(64)));
-  HistogramImpl histograms_[INTERNAL_HISTOGRAM_ENUM_MAX]
-      __attribute__((aligned(64)));
+  // Returns the stats of the current thread, creating them on first use
+  ThreadStats* GetThreadStats();
+
+  // Folds the stats of a thread into the exited_* ones when it exits (or
+  // when this object is destroyed)
+  static void MergeExitedThread(void* ptr);
+
+  // Protects the exited_* stats. Taken while the ThreadLocalPtr lock is
+  // held, never the other way around.
+  mutable port::Mutex exited_mutex_;
+  uint64_t exited_tickers_[INTERNAL_TICKER_ENUM_MAX];
+  HistogramImpl exited_histograms_[INTERNAL_HISTOGRAM_ENUM_MAX];
+
+  // Destroyed first, so that it merges the remaining threads' stats while
+  // the exited_* ones are still alive
+  mutable ThreadLocalPtr thread_stats_;
 };
 
+// Returns the lowest stats level that collects "histogram_type"
+inline StatsLevel MinStatsLevelFor(uint32_t histogram_type) {
+  switch (histogram_type) {
+    // Timers of steps done many times per operation
+    case READ_BLOCK_COMPACTION_MICROS:
+    case READ_BLOCK_GET_MICROS:
+    case WRITE_RAW_BLOCK_MICROS:
+      return kAll;
+    // Timers of whole operations
+    case DB_GET:
+    case DB_WRITE:
+    case COMPACTION_TIME:
+    case TABLE_SYNC_MICROS:
+    case COMPACTION_OUTFILE_SYNC_MICROS:
+    case WAL_FILE_SYNC_MICROS:
+    case MANIFEST_FILE_SYNC_MICROS:
+    case TABLE_OPEN_IO_MICROS:
+    case DB_MULTIGET:
+    case DB_SEEK:
+    case WRITE_STALL:
+    case DB_RECOVERY_MICROS:
+      return kExceptDetailedTimers;
+    default:
+      return kExceptTimers;
+  }
+}
+
 // Utility functions
+
+// Whether "statistics" collects "histogram_type". Callers check it before
+// reading the clock for the histogram.
+inline bool ShouldMeasure(Statistics* statistics, uint32_t histogram_type) {
+  return statistics != nullptr &&
+         statistics->get_stats_level() >= MinStatsLevelFor(histogram_type) &&
+         statistics->HistEnabledForType(histogram_type);
+}
+
 inline void MeasureTime(Statistics* statistics, uint32_t histogram_type,
                         uint64_t value) {
-  if (statistics) {
+  if (ShouldMeasure(statistics, histogram_type)) {
     statistics->measureTime(histogram_type, value);
   }
 }
@@ -10,7 +10,8 @@
 namespace rocksdb {
 // Auto-scoped.
 // Records the measure time into the corresponding histogram if statistics
-// is not nullptr. It is also saved into *elapsed if the pointer is not nullptr.
+// is not nullptr and its stats level collects the histogram. It is also
+// saved into *elapsed if the pointer is not nullptr.
 class StopWatch {
  public:
   StopWatch(Env * const env, Statistics* statistics,
@@ -20,7 +21,7 @@ class StopWatch {
       statistics_(statistics),
       hist_type_(hist_type),
       elapsed_(elapsed),
-      stats_enabled_(statistics && statistics->HistEnabledForType(hist_type)),
+      stats_enabled_(ShouldMeasure(statistics, hist_type)),
       start_time_((stats_enabled_ || elapsed != nullptr) ?
                   env->NowMicros() : 0) {
   }
@@ -47,11 +47,31 @@ void SyncPoint::ClearTrace() {
   cleared_points_.clear();
 }
 
-void SyncPoint::Process(const std::string& point) {
+void SyncPoint::SetCallBack(const std::string& point,
+                            std::function<void(void*)> callback) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  callbacks_[point] = callback;
+}
+
+void SyncPoint::ClearAllCallBacks() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  callbacks_.clear();
+}
+
+void SyncPoint::Process(const std::string& point, void* cb_arg) {
   std::unique_lock<std::mutex> lock(mutex_);
 
   if (!enabled_) return;
 
+  auto callback = callbacks_.find(point);
+  if (callback != callbacks_.end()) {
+    // The callback may run sync points itself
+    auto function = callback->second;
+    lock.unlock();
+    function(cb_arg);
+    lock.lock();
+  }
+
   while (!PredecessorsAllCleared(point)) {
     cv_.wait(lock);
   }
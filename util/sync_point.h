@@ -5,6 +5,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <unordered_set>
@@ -13,6 +14,7 @@
 
 #ifdef NDEBUG
 #define TEST_SYNC_POINT(x)
+#define TEST_SYNC_POINT_CALLBACK(x, y)
 #else
 
 namespace rocksdb {
@@ -47,9 +49,16 @@ class SyncPoint {
   // remove the execution trace of all sync points
   void ClearTrace();
 
+  // call "callback" with the argument of TEST_SYNC_POINT_CALLBACK whenever
+  // "point" is processed
+  void SetCallBack(const std::string& point,
+                   std::function<void(void*)> callback);
+  // remove all the callbacks
+  void ClearAllCallBacks();
+
   // triggered by TEST_SYNC_POINT, blocking execution until all predecessors
   // are executed.
-  void Process(const std::string& point);
+  void Process(const std::string& point, void* cb_arg = nullptr);
 
   // TODO: it might be useful to provide a function that blocks until all
   // sync points are cleared.
@@ -60,6 +69,7 @@ class SyncPoint {
   // successor/predecessor map loaded from LoadDependency
   std::unordered_map<std::string, std::vector<std::string>> successors_;
   std::unordered_map<std::string, std::vector<std::string>> predecessors_;
+  std::unordered_map<std::string, std::function<void(void*)>> callbacks_;
 
   std::mutex mutex_;
   std::condition_variable cv_;
@@ -77,4 +87,8 @@ class SyncPoint {
 // See TransactionLogIteratorRace in db_test.cc for an example use case.
 // TEST_SYNC_POINT is no op in release build.
 #define TEST_SYNC_POINT(x) rocksdb::SyncPoint::GetInstance()->Process(x)
+// TEST_SYNC_POINT_CALLBACK also passes "y" to the callback of the sync
+// point, see SyncPoint::SetCallBack
+#define TEST_SYNC_POINT_CALLBACK(x, y) \
+  rocksdb::SyncPoint::GetInstance()->Process(x, y)
 #endif  // NDEBUG
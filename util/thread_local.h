@@ -26,6 +26,10 @@ namespace rocksdb {
 // (2) a ThreadLocalPtr is destroyed
 typedef void (*UnrefHandler)(void* ptr);
 
+// Function called by ThreadLocalPtr::Fold() for the stored pointer of every
+// thread (if not NULL), with the "res" argument given to Fold().
+typedef void (*FoldFunc)(void* ptr, void* res);
+
 // ThreadLocalPtr stores only values of pointer type.  Different from
 // the usual thread-local-storage, ThreadLocalPtr has the ability to
 // distinguish data coming from different threads and different
@@ -59,6 +63,12 @@ class ThreadLocalPtr {
   // data for all existing threads
   void Scrape(autovector<void*>* ptrs, void* const replacement);
 
+  // Call func(ptr, res) for the non-nullptr data of every existing thread,
+  // without changing it. The threads keep running, so func has to cope
+  // with the data being updated concurrently. A thread's data is not
+  // released while func runs on it.
+  void Fold(FoldFunc func, void* res);
+
  protected:
   struct Entry {
     Entry() : ptr(nullptr) {}
@@ -113,6 +123,8 @@ class ThreadLocalPtr {
     // Reset all thread local data to replacement, and return non-nullptr
     // data for all existing threads
     void Scrape(uint32_t id, autovector<void*>* ptrs, void* const replacement);
+    // Call func for the non-nullptr data of every existing thread
+    void Fold(uint32_t id, FoldFunc func, void* res);
 
     // Register the UnrefHandler for id
     void SetHandler(uint32_t id, UnrefHandler handler);
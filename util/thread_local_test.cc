@@ -449,6 +449,56 @@ TEST(ThreadLocalTest, Scrape) {
   }
 }
 
+TEST(ThreadLocalTest, Fold) {
+  auto func = [](void* ptr) {
+    auto& p = *static_cast<Params*>(ptr);
+
+    p.mu->Lock();
+    // Each thread stores its own index, starting from 1
+    p.tls1.Reset(reinterpret_cast<void*>(static_cast<uintptr_t>(++p.started)));
+    ++(p.completed);
+    p.cv->SignalAll();
+
+    // Waiting for instruction to exit thread
+    while (p.completed != 0) {
+      p.cv->Wait();
+    }
+    p.mu->Unlock();
+  };
+
+  for (int th = 1; th <= 128; th += th) {
+    port::Mutex mu;
+    port::CondVar cv(&mu);
+    Params p(&mu, &cv, nullptr, th);
+
+    for (int i = 0; i < p.total; ++i) {
+      env_->StartThread(func, static_cast<void*>(&p));
+    }
+
+    mu.Lock();
+    while (p.completed != p.total) {
+      cv.Wait();
+    }
+    mu.Unlock();
+
+    // Fold sees the data of every thread, and leaves it in place
+    for (int round = 0; round < 2; ++round) {
+      uintptr_t sum = 0;
+      p.tls1.Fold([](void* ptr, void* res) {
+        *static_cast<uintptr_t*>(res) += reinterpret_cast<uintptr_t>(ptr);
+      }, &sum);
+      ASSERT_EQ(static_cast<uintptr_t>(th * (th + 1) / 2), sum);
+    }
+
+    // Signal to exit
+    mu.Lock();
+    p.completed = 0;
+    cv.SignalAll();
+    mu.Unlock();
+    env_->WaitForJoin();
+  }
+}
+
 TEST(ThreadLocalTest, CompareAndSwap) {
   ThreadLocalPtr tls;
   ASSERT_TRUE(tls.Swap(reinterpret_cast<void*>(1)) == nullptr);
@@ -69,10 +69,35 @@ void ThreadStatusUpdater::ClearThreadOperation() {
     assert(data->cf_key.load(std::memory_order_relaxed) == nullptr);
     return;
   }
+  for (int i = 0; i < ThreadStatus::kNumOperationProperties; ++i) {
+    data->op_properties[i].store(0, std::memory_order_relaxed);
+  }
   data->operation_type.store(
       ThreadStatus::OP_UNKNOWN, std::memory_order_relaxed);
 }
 
+void ThreadStatusUpdater::SetThreadOperationProperty(
+    int i, uint64_t value) {
+  auto* data = InitAndGet();
+  if (!data->enable_tracking) {
+    assert(data->cf_key.load(std::memory_order_relaxed) == nullptr);
+    return;
+  }
+  assert(i >= 0 && i < ThreadStatus::kNumOperationProperties);
+  data->op_properties[i].store(value, std::memory_order_relaxed);
+}
+
+void ThreadStatusUpdater::IncreaseThreadOperationProperty(
+    int i, uint64_t delta) {
+  auto* data = InitAndGet();
+  if (!data->enable_tracking) {
+    assert(data->cf_key.load(std::memory_order_relaxed) == nullptr);
+    return;
+  }
+  assert(i >= 0 && i < ThreadStatus::kNumOperationProperties);
+  data->op_properties[i].fetch_add(delta, std::memory_order_relaxed);
+}
+
 void ThreadStatusUpdater::SetThreadState(
     const ThreadStatus::StateType type) {
   auto* data = InitAndGet();
@@ -115,6 +140,7 @@ Status ThreadStatusUpdater::GetThreadList(
     const std::string* db_name = nullptr;
     const std::string* cf_name = nullptr;
     ThreadStatus::OperationType op_type = ThreadStatus::OP_UNKNOWN;
+    uint64_t op_props[ThreadStatus::kNumOperationProperties] = {0};
     ThreadStatus::StateType state_type = ThreadStatus::STATE_UNKNOWN;
     if (cf_info != nullptr) {
       db_name = &cf_info->db_name;
@@ -123,6 +149,10 @@ Status ThreadStatusUpdater::GetThreadList(
           std::memory_order_relaxed);
       // display lower-level info only when higher-level info is available.
       if (op_type != ThreadStatus::OP_UNKNOWN) {
+        for (int i = 0; i < ThreadStatus::kNumOperationProperties; ++i) {
+          op_props[i] = thread_data->op_properties[i].load(
+              std::memory_order_relaxed);
+        }
         state_type = thread_data->state_type.load(
             std::memory_order_relaxed);
       }
@@ -131,7 +161,7 @@ Status ThreadStatusUpdater::GetThreadList(
         thread_data->thread_id, thread_type,
         db_name ? *db_name : "",
         cf_name ? *cf_name : "",
-        op_type, state_type);
+        op_type, op_props, state_type);
   }
 
   return Status::OK();
@@ -228,6 +258,14 @@ void ThreadStatusUpdater::SetThreadOperation(
 void ThreadStatusUpdater::ClearThreadOperation() {
 }
 
+void ThreadStatusUpdater::SetThreadOperationProperty(
+    int i, uint64_t value) {
+}
+
+void ThreadStatusUpdater::IncreaseThreadOperationProperty(
+    int i, uint64_t delta) {
+}
+
 void ThreadStatusUpdater::SetThreadState(
     const ThreadStatus::StateType type) {
 }
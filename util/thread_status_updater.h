@@ -22,7 +22,8 @@
 //    should be ignored.
 //
 // The high to low level information would be:
-// thread_id > thread_type > db > cf > operation > state
+// thread_id > thread_type > db > cf > operation > operation properties >
+// state
 //
 // This means user might not always get full information, but whenever
 // returned by the GetThreadList() is guaranteed to be consistent.
@@ -68,6 +69,9 @@ struct ThreadStatusData {
     thread_type.store(ThreadStatus::USER);
     cf_key.store(nullptr);
     operation_type.store(ThreadStatus::OP_UNKNOWN);
+    for (int i = 0; i < ThreadStatus::kNumOperationProperties; ++i) {
+      op_properties[i].store(0);
+    }
     state_type.store(ThreadStatus::STATE_UNKNOWN);
   }
 
@@ -85,6 +89,7 @@ struct ThreadStatusData {
   std::atomic<ThreadStatus::ThreadType> thread_type;
   std::atomic<const void*> cf_key;
   std::atomic<ThreadStatus::OperationType> operation_type;
+  std::atomic<uint64_t> op_properties[ThreadStatus::kNumOperationProperties];
   std::atomic<ThreadStatus::StateType> state_type;
 #endif  // ROCKSDB_USING_THREAD_STATUS
 };
@@ -124,9 +129,15 @@ class ThreadStatusUpdater {
   // Update the thread operation of the current thread.
   void SetThreadOperation(const ThreadStatus::OperationType type);
 
-  // Clear thread operation of the current thread.
+  // Clear thread operation of the current thread, and its properties.
   void ClearThreadOperation();
 
+  // Set the i-th property of the current thread operation.
+  void SetThreadOperationProperty(int i, uint64_t value);
+
+  // Add "delta" to the i-th property of the current thread operation.
+  void IncreaseThreadOperationProperty(int i, uint64_t delta);
+
   // Update the thread state of the current thread.
   void SetThreadState(const ThreadStatus::StateType type);
 
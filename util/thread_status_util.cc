@@ -57,6 +57,27 @@ void ThreadStatusUtil::SetThreadOperation(ThreadStatus::OperationType op) {
   thread_updater_local_cache_->SetThreadOperation(op);
 }
 
+void ThreadStatusUtil::SetThreadOperationProperty(int i, uint64_t value) {
+  if (thread_updater_local_cache_ == nullptr) {
+    // thread_updater_local_cache_ must be set in SetColumnFamily
+    // or other ThreadStatusUtil functions.
+    return;
+  }
+
+  thread_updater_local_cache_->SetThreadOperationProperty(i, value);
+}
+
+void ThreadStatusUtil::IncreaseThreadOperationProperty(
+    int i, uint64_t delta) {
+  if (thread_updater_local_cache_ == nullptr) {
+    // thread_updater_local_cache_ must be set in SetColumnFamily
+    // or other ThreadStatusUtil functions.
+    return;
+  }
+
+  thread_updater_local_cache_->IncreaseThreadOperationProperty(i, delta);
+}
+
 void ThreadStatusUtil::SetThreadState(ThreadStatus::StateType state) {
   if (thread_updater_local_cache_ == nullptr) {
     // thread_updater_local_cache_ must be set in SetColumnFamily
@@ -124,6 +145,13 @@ void ThreadStatusUtil::SetColumnFamily(const ColumnFamilyData* cfd) {
 void ThreadStatusUtil::SetThreadOperation(ThreadStatus::OperationType op) {
 }
 
+void ThreadStatusUtil::SetThreadOperationProperty(int i, uint64_t value) {
+}
+
+void ThreadStatusUtil::IncreaseThreadOperationProperty(
+    int i, uint64_t delta) {
+}
+
 void ThreadStatusUtil::SetThreadState(ThreadStatus::StateType state) {
 }
 
@@ -55,6 +55,10 @@ class ThreadStatusUtil {
 
   static void SetThreadOperation(ThreadStatus::OperationType type);
 
+  static void SetThreadOperationProperty(int i, uint64_t value);
+
+  static void IncreaseThreadOperationProperty(int i, uint64_t delta);
+
   static void SetThreadState(ThreadStatus::StateType type);
 
   static void ResetThreadStatus();
@@ -0,0 +1,566 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/trace_replay.h"
+
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+#include "db/column_family.h"
+#include "db/write_batch_internal.h"
+#include "port/port.h"
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+const std::string kTraceMagic = "rocksdb.trace";
+
+namespace {
+
+// Bytes of a record header in a trace file: the fixed32 record size
+const size_t kTraceFileRecordHeaderSize = 4;
+
+// Requests read ahead of the replaying threads
+const size_t kMaxPendingReplays = 1024;
+
+class FileTraceWriter : public TraceWriter {
+ public:
+  explicit FileTraceWriter(unique_ptr<WritableFile>&& file)
+      : file_(std::move(file)), file_size_(0) {}
+
+  virtual ~FileTraceWriter() { Close(); }
+
+  virtual Status Write(const Slice& record) override {
+    std::string header;
+    PutFixed32(&header, static_cast<uint32_t>(record.size()));
+    Status s = file_->Append(header);
+    if (s.ok()) {
+      s = file_->Append(record);
+    }
+    if (s.ok()) {
+      file_size_ += header.size() + record.size();
+    }
+    return s;
+  }
+
+  virtual Status Close() override {
+    if (file_ == nullptr) {
+      return Status::OK();
+    }
+    Status s = file_->Close();
+    file_.reset();
+    return s;
+  }
+
+  virtual uint64_t GetFileSize() override { return file_size_; }
+
+ private:
+  unique_ptr<WritableFile> file_;
+  uint64_t file_size_;
+};
+
+class FileTraceReader : public TraceReader {
+ public:
+  FileTraceReader(unique_ptr<SequentialFile>&& file, uint64_t file_size)
+      : file_(std::move(file)), bytes_left_(file_size) {}
+
+  virtual Status Read(std::string* record) override {
+    char header_buf[kTraceFileRecordHeaderSize];
+    Slice header;
+    Status s = file_->Read(kTraceFileRecordHeaderSize, &header, header_buf);
+    if (!s.ok()) {
+      return s;
+    }
+    if (header.size() == 0) {
+      return Status::Incomplete("end of trace");
+    }
+    if (header.size() < kTraceFileRecordHeaderSize) {
+      return Status::Corruption("truncated trace record header");
+    }
+    bytes_left_ -= std::min<uint64_t>(bytes_left_, header.size());
+    // Checked before allocating, so that a corrupted size does not make us
+    // allocate up to 4GB
+    size_t size = DecodeFixed32(header.data());
+    if (size > bytes_left_) {
+      return Status::Corruption("trace record larger than the trace file");
+    }
+    bytes_left_ -= size;
+    record->resize(size);
+    Slice data;
+    s = file_->Read(size, &data, &(*record)[0]);
+    if (!s.ok()) {
+      return s;
+    }
+    if (data.size() < size) {
+      return Status::Corruption("truncated trace record");
+    }
+    if (data.data() != record->data()) {
+      record->assign(data.data(), data.size());
+    }
+    return s;
+  }
+
+  virtual Status Close() override {
+    file_.reset();
+    return Status::OK();
+  }
+
+ private:
+  unique_ptr<SequentialFile> file_;
+  // Bytes of the file, as of its opening, not read yet
+  uint64_t bytes_left_;
+};
+
+// Replaces every value of a batch by its size
+class ValueStripper : public WriteBatch::Handler {
+ public:
+  explicit ValueStripper(WriteBatch* batch) : batch_(batch) {}
+
+  virtual Status PutCF(uint32_t cf_id, const Slice& key,
+                       const Slice& value) override {
+    std::string size;
+    PutVarint64(&size, value.size());
+    WriteBatchInternal::Put(batch_, cf_id, key, size);
+    return Status::OK();
+  }
+
+  virtual Status MergeCF(uint32_t cf_id, const Slice& key,
+                         const Slice& value) override {
+    std::string size;
+    PutVarint64(&size, value.size());
+    WriteBatchInternal::Merge(batch_, cf_id, key, size);
+    return Status::OK();
+  }
+
+  virtual Status DeleteCF(uint32_t cf_id, const Slice& key) override {
+    WriteBatchInternal::Delete(batch_, cf_id, key);
+    return Status::OK();
+  }
+
+ private:
+  WriteBatch* batch_;
+};
+
+// Undoes ValueStripper, with values of the recorded sizes
+class ValueFiller : public WriteBatch::Handler {
+ public:
+  explicit ValueFiller(WriteBatch* batch) : batch_(batch) {}
+
+  virtual Status PutCF(uint32_t cf_id, const Slice& key,
+                       const Slice& value) override {
+    std::string filled;
+    Status s = Fill(value, &filled);
+    if (s.ok()) {
+      WriteBatchInternal::Put(batch_, cf_id, key, filled);
+    }
+    return s;
+  }
+
+  virtual Status MergeCF(uint32_t cf_id, const Slice& key,
+                         const Slice& value) override {
+    std::string filled;
+    Status s = Fill(value, &filled);
+    if (s.ok()) {
+      WriteBatchInternal::Merge(batch_, cf_id, key, filled);
+    }
+    return s;
+  }
+
+  virtual Status DeleteCF(uint32_t cf_id, const Slice& key) override {
+    WriteBatchInternal::Delete(batch_, cf_id, key);
+    return Status::OK();
+  }
+
+ private:
+  static Status Fill(Slice size_slice, std::string* filled) {
+    uint64_t size;
+    if (!GetVarint64(&size_slice, &size)) {
+      return Status::Corruption("bad value size in trace");
+    }
+    filled->assign(size, 'x');
+    return Status::OK();
+  }
+
+  WriteBatch* batch_;
+};
+
+}  // namespace
+
+void Trace::EncodeTo(std::string* dst) const {
+  PutFixed64(dst, ts);
+  dst->push_back(type);
+  dst->append(payload);
+}
+
+Status Trace::DecodeFrom(const Slice& record) {
+  Slice input = record;
+  if (!GetFixed64(&input, &ts) || input.empty()) {
+    return Status::Corruption("truncated trace record");
+  }
+  type = static_cast<TraceType>(input[0]);
+  input.remove_prefix(1);
+  payload.assign(input.data(), input.size());
+  return Status::OK();
+}
+
+Status NewFileTraceWriter(Env* env, const EnvOptions& env_options,
+                          const std::string& trace_filename,
+                          std::unique_ptr<TraceWriter>* trace_writer) {
+  unique_ptr<WritableFile> file;
+  Status s = env->NewWritableFile(trace_filename, &file, env_options);
+  if (s.ok()) {
+    trace_writer->reset(new FileTraceWriter(std::move(file)));
+  }
+  return s;
+}
+
+Status NewFileTraceReader(Env* env, const EnvOptions& env_options,
+                          const std::string& trace_filename,
+                          std::unique_ptr<TraceReader>* trace_reader) {
+  uint64_t file_size;
+  Status s = env->GetFileSize(trace_filename, &file_size);
+  unique_ptr<SequentialFile> file;
+  if (s.ok()) {
+    s = env->NewSequentialFile(trace_filename, &file, env_options);
+  }
+  if (s.ok()) {
+    trace_reader->reset(new FileTraceReader(std::move(file), file_size));
+  }
+  return s;
+}
+
+Tracer::Tracer(Env* env, const TraceOptions& trace_options,
+               std::unique_ptr<TraceWriter>&& trace_writer)
+    : env_(env),
+      trace_options_(trace_options),
+      trace_writer_(std::move(trace_writer)),
+      trace_request_count_(0),
+      closed_(false) {}
+
+Tracer::~Tracer() { Close(); }
+
+Status Tracer::Start() {
+  std::string payload = kTraceMagic;
+  PutVarint32(&payload, kTraceFormatVersion);
+  return WriteTrace(kTraceBegin, payload);
+}
+
+Status Tracer::Write(WriteBatch* write_batch) {
+  if (ShouldSkipTrace()) {
+    return Status::OK();
+  }
+  std::string payload;
+  if (trace_options_.record_values) {
+    payload.push_back(1);
+    payload.append(write_batch->Data());
+  } else {
+    WriteBatch stripped;
+    ValueStripper stripper(&stripped);
+    Status s = write_batch->Iterate(&stripper);
+    if (!s.ok()) {
+      return s;
+    }
+    payload.push_back(0);
+    payload.append(stripped.Data());
+  }
+  return WriteTrace(kTraceWrite, payload);
+}
+
+Status Tracer::Get(uint32_t cf_id, const Slice& key) {
+  if (ShouldSkipTrace()) {
+    return Status::OK();
+  }
+  std::string payload;
+  PutVarint32(&payload, cf_id);
+  PutLengthPrefixedSlice(&payload, key);
+  return WriteTrace(kTraceGet, payload);
+}
+
+Status Tracer::IteratorSeek(uint32_t cf_id, const Slice& key) {
+  if (ShouldSkipTrace()) {
+    return Status::OK();
+  }
+  std::string payload;
+  PutVarint32(&payload, cf_id);
+  PutLengthPrefixedSlice(&payload, key);
+  return WriteTrace(kTraceIteratorSeek, payload);
+}
+
+Status Tracer::MultiGet(const std::vector<uint32_t>& cf_ids,
+                        const std::vector<Slice>& keys) {
+  assert(cf_ids.size() == keys.size());
+  if (ShouldSkipTrace()) {
+    return Status::OK();
+  }
+  std::string payload;
+  PutVarint32(&payload, static_cast<uint32_t>(keys.size()));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    PutVarint32(&payload, cf_ids[i]);
+    PutLengthPrefixedSlice(&payload, keys[i]);
+  }
+  return WriteTrace(kTraceMultiGet, payload);
+}
+
+Status Tracer::Close() {
+  if (closed_) {
+    return Status::OK();
+  }
+  closed_ = true;
+  Status s = WriteTrace(kTraceEnd, "");
+  Status close_status = trace_writer_->Close();
+  return s.ok() ? close_status : s;
+}
+
+bool Tracer::ShouldSkipTrace() {
+  if (trace_writer_->GetFileSize() > trace_options_.max_trace_file_size) {
+    return true;
+  }
+  ++trace_request_count_;
+  if (trace_request_count_ < trace_options_.sampling_frequency) {
+    return true;
+  }
+  trace_request_count_ = 0;
+  return false;
+}
+
+Status Tracer::WriteTrace(TraceType type, const std::string& payload) {
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = type;
+  trace.payload = payload;
+  std::string record;
+  trace.EncodeTo(&record);
+  return trace_writer_->Write(record);
+}
+
+// Hands the requests read from the trace to the replaying threads
+class Replayer::WorkQueue {
+ public:
+  WorkQueue(Replayer* replayer, int num_threads)
+      : replayer_(replayer), cv_(&mu_), done_(false), num_replayed_(0) {
+    for (int i = 0; i < std::max(num_threads, 1); ++i) {
+      threads_.emplace_back(&WorkQueue::Run, this);
+    }
+  }
+
+  // Queues "trace", waiting if the threads are too far behind. Returns
+  // the first error met by the threads so far.
+  Status Add(Trace&& trace) {
+    MutexLock l(&mu_);
+    while (pending_.size() >= kMaxPendingReplays && status_.ok()) {
+      cv_.Wait();
+    }
+    pending_.push_back(std::move(trace));
+    cv_.SignalAll();
+    return status_;
+  }
+
+  // Waits until every queued request was replayed
+  Status Finish(uint64_t* num_replayed) {
+    {
+      MutexLock l(&mu_);
+      done_ = true;
+      cv_.SignalAll();
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    *num_replayed = num_replayed_;
+    return status_;
+  }
+
+ private:
+  void Run() {
+    MutexLock l(&mu_);
+    while (true) {
+      while (pending_.empty() && !done_) {
+        cv_.Wait();
+      }
+      if (pending_.empty()) {
+        return;
+      }
+      Trace trace = std::move(pending_.front());
+      pending_.pop_front();
+      cv_.SignalAll();
+      mu_.Unlock();
+      Status s = replayer_->Execute(trace);
+      mu_.Lock();
+      ++num_replayed_;
+      if (!s.ok() && status_.ok()) {
+        status_ = s;
+      }
+    }
+  }
+
+  Replayer* replayer_;
+  port::Mutex mu_;
+  port::CondVar cv_;
+  std::deque<Trace> pending_;
+  bool done_;
+  Status status_;
+  uint64_t num_replayed_;
+  std::vector<std::thread> threads_;
+};
+
+Replayer::Replayer(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
+                   std::unique_ptr<TraceReader>&& trace_reader)
+    : db_(db),
+      env_(db->GetEnv()),
+      trace_reader_(std::move(trace_reader)),
+      num_replayed_(0) {
+  for (ColumnFamilyHandle* handle : handles) {
+    cf_map_[reinterpret_cast<ColumnFamilyHandleImpl*>(handle)->GetID()] =
+        handle;
+  }
+}
+
+Status Replayer::Replay(int num_threads, double fast_forward) {
+  num_replayed_ = 0;
+  std::string record;
+  Status s = trace_reader_->Read(&record);
+  if (s.IsIncomplete()) {
+    return Status::Corruption("empty trace");
+  }
+  Trace header;
+  if (s.ok()) {
+    s = header.DecodeFrom(record);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  Slice magic = header.payload;
+  uint32_t version;
+  if (header.type != kTraceBegin || !magic.starts_with(kTraceMagic)) {
+    return Status::Corruption("not a trace");
+  }
+  magic.remove_prefix(kTraceMagic.size());
+  if (!GetVarint32(&magic, &version) || version > kTraceFormatVersion) {
+    return Status::NotSupported("unknown trace format version");
+  }
+
+  WorkQueue queue(this, num_threads);
+  const uint64_t replay_start = env_->NowMicros();
+  while (s.ok()) {
+    s = trace_reader_->Read(&record);
+    if (s.IsIncomplete()) {
+      // The trace was not closed, replay as much of it as was written
+      s = Status::OK();
+      break;
+    }
+    Trace trace;
+    if (s.ok()) {
+      s = trace.DecodeFrom(record);
+    }
+    if (!s.ok() || trace.type == kTraceEnd) {
+      break;
+    }
+    if (fast_forward > 0 && trace.ts > header.ts) {
+      uint64_t due = replay_start + static_cast<uint64_t>(
+                                        (trace.ts - header.ts) / fast_forward);
+      uint64_t now = env_->NowMicros();
+      if (due > now) {
+        env_->SleepForMicroseconds(static_cast<int>(due - now));
+      }
+    }
+    s = queue.Add(std::move(trace));
+  }
+  Status replay_status = queue.Finish(&num_replayed_);
+  return s.ok() ? replay_status : s;
+}
+
+Status Replayer::GetHandle(uint32_t cf_id, ColumnFamilyHandle** handle) {
+  auto iter = cf_map_.find(cf_id);
+  if (iter == cf_map_.end()) {
+    return Status::InvalidArgument("trace uses a column family not opened");
+  }
+  *handle = iter->second;
+  return Status::OK();
+}
+
+Status Replayer::Execute(const Trace& trace) {
+  Slice input = trace.payload;
+  switch (trace.type) {
+    case kTraceWrite: {
+      if (input.size() < 1 + WriteBatchInternal::kHeader) {
+        return Status::Corruption("bad write trace");
+      }
+      bool has_values = input[0] != 0;
+      input.remove_prefix(1);
+      WriteBatch batch;
+      WriteBatchInternal::SetContents(&batch, input);
+      if (has_values) {
+        return db_->Write(WriteOptions(), &batch);
+      }
+      WriteBatch filled;
+      ValueFiller filler(&filled);
+      Status s = batch.Iterate(&filler);
+      if (!s.ok()) {
+        return s;
+      }
+      return db_->Write(WriteOptions(), &filled);
+    }
+    case kTraceGet:
+    case kTraceIteratorSeek: {
+      uint32_t cf_id;
+      Slice key;
+      if (!GetVarint32(&input, &cf_id) ||
+          !GetLengthPrefixedSlice(&input, &key)) {
+        return Status::Corruption("bad read trace");
+      }
+      ColumnFamilyHandle* handle;
+      Status s = GetHandle(cf_id, &handle);
+      if (!s.ok()) {
+        return s;
+      }
+      if (trace.type == kTraceGet) {
+        std::string value;
+        s = db_->Get(ReadOptions(), handle, key, &value);
+      } else {
+        std::unique_ptr<Iterator> iter(
+            db_->NewIterator(ReadOptions(), handle));
+        iter->Seek(key);
+        s = iter->status();
+      }
+      return s.IsNotFound() ? Status::OK() : s;
+    }
+    case kTraceMultiGet: {
+      uint32_t num_keys;
+      if (!GetVarint32(&input, &num_keys)) {
+        return Status::Corruption("bad multiget trace");
+      }
+      std::vector<ColumnFamilyHandle*> handles(num_keys);
+      std::vector<Slice> keys(num_keys);
+      for (uint32_t i = 0; i < num_keys; ++i) {
+        uint32_t cf_id;
+        if (!GetVarint32(&input, &cf_id) ||
+            !GetLengthPrefixedSlice(&input, &keys[i])) {
+          return Status::Corruption("bad multiget trace");
+        }
+        Status s = GetHandle(cf_id, &handles[i]);
+        if (!s.ok()) {
+          return s;
+        }
+      }
+      std::vector<std::string> values;
+      std::vector<Status> statuses =
+          db_->MultiGet(ReadOptions(), handles, keys, &values);
+      for (const auto& s : statuses) {
+        if (!s.ok() && !s.IsNotFound()) {
+          return s;
+        }
+      }
+      return Status::OK();
+    }
+    default:
+      // Nothing to replay for the other records
+      return Status::OK();
+  }
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,125 @@
+//  Copyright (c) 2015, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/trace_reader_writer.h"
+
+namespace rocksdb {
+
+class ColumnFamilyHandle;
+class DB;
+class WriteBatch;
+
+extern const std::string kTraceMagic;
+const uint32_t kTraceFormatVersion = 1;
+
+enum TraceType : char {
+  kTraceBegin = 1,
+  kTraceEnd = 2,
+  kTraceWrite = 3,
+  kTraceGet = 4,
+  kTraceIteratorSeek = 5,
+  kTraceMultiGet = 6,
+  // Block cache lookups, see util/block_cache_tracer.h
+  kBlockTraceIndexBlock = 7,
+  kBlockTraceFilterBlock = 8,
+  kBlockTraceDataBlock = 9,
+};
+
+// One record of a trace. The payload depends on the type:
+//   kTraceBegin:        kTraceMagic, varint32 format version
+//   kTraceEnd:          empty
+//   kTraceWrite:        1 byte, 1 if the values are recorded,
+//                       followed by the contents of the WriteBatch. Without
+//                       the values, each value is replaced by its size as
+//                       a varint64.
+//   kTraceGet,
+//   kTraceIteratorSeek: varint32 column family ID, length prefixed key
+//   kTraceMultiGet:     varint32 number of keys, then a column family ID
+//                       and a key for each of them, as for kTraceGet
+struct Trace {
+  uint64_t ts;  // Env::NowMicros() when the request was issued
+  TraceType type;
+  std::string payload;
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(const Slice& record);
+};
+
+// Records requests into a trace. Not thread safe.
+class Tracer {
+ public:
+  Tracer(Env* env, const TraceOptions& trace_options,
+         std::unique_ptr<TraceWriter>&& trace_writer);
+  ~Tracer();
+
+  // Writes the kTraceBegin record
+  Status Start();
+
+  Status Write(WriteBatch* write_batch);
+  Status Get(uint32_t cf_id, const Slice& key);
+  Status IteratorSeek(uint32_t cf_id, const Slice& key);
+  Status MultiGet(const std::vector<uint32_t>& cf_ids,
+                  const std::vector<Slice>& keys);
+
+  // Writes the kTraceEnd record and closes the writer
+  Status Close();
+
+ private:
+  // Whether the next request is left out of the trace
+  bool ShouldSkipTrace();
+  Status WriteTrace(TraceType type, const std::string& payload);
+
+  Env* const env_;
+  const TraceOptions trace_options_;
+  std::unique_ptr<TraceWriter> trace_writer_;
+  uint64_t trace_request_count_;
+  bool closed_;
+
+  // No copying allowed
+  Tracer(const Tracer&);
+  void operator=(const Tracer&);
+};
+
+// Re-issues the requests of a trace against a DB
+class Replayer {
+ public:
+  // "handles" must hold a handle for every column family in the trace
+  Replayer(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
+           std::unique_ptr<TraceReader>&& trace_reader);
+
+  // Replays the trace with "num_threads" threads, "fast_forward" times as
+  // fast as it was recorded. A fast_forward of 0 replays the requests as
+  // fast as possible. Requests are dispatched in order, but requests
+  // handed to different threads may run out of order.
+  // Returns the first error met, not counting keys that are not found.
+  Status Replay(int num_threads, double fast_forward);
+
+  // Number of requests replayed by the last Replay()
+  uint64_t num_replayed() const { return num_replayed_; }
+
+ private:
+  class WorkQueue;
+
+  Status Execute(const Trace& trace);
+  Status GetHandle(uint32_t cf_id, ColumnFamilyHandle** handle);
+
+  DB* const db_;
+  Env* const env_;
+  std::unordered_map<uint32_t, ColumnFamilyHandle*> cf_map_;
+  std::unique_ptr<TraceReader> trace_reader_;
+  uint64_t num_replayed_;
+};
+
+}  // namespace rocksdb
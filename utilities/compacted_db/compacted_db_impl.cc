@@ -43,7 +43,18 @@ size_t CompactedDBImpl::FindFile(const Slice& key) {
 }
 
 Status CompactedDBImpl::Get(const ReadOptions& options,
-     ColumnFamilyHandle*, const Slice& key, std::string* value) {
+     ColumnFamilyHandle* column_family, const Slice& key, std::string* value) {
+  PinnableSlice pinnable_val(value);
+  auto s = Get(options, column_family, key, &pinnable_val);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }
+  return s;
+}
+
+Status CompactedDBImpl::Get(const ReadOptions& options,
+     ColumnFamilyHandle*, const Slice& key, PinnableSlice* value) {
+  value->Reset();
   GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
                          GetContext::kNotFound, key, value, nullptr, nullptr);
   LookupKey lkey(key, kMaxSequenceNumber);
@@ -74,12 +85,16 @@ std::vector<Status> CompactedDBImpl::MultiGet(const ReadOptions& options,
   int idx = 0;
   for (auto* r : reader_list) {
     if (r != nullptr) {
+      PinnableSlice pinnable_val(&(*values)[idx]);
       GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
-                             GetContext::kNotFound, keys[idx], &(*values)[idx],
+                             GetContext::kNotFound, keys[idx], &pinnable_val,
                              nullptr, nullptr);
       LookupKey lkey(keys[idx], kMaxSequenceNumber);
       r->Get(options, lkey.internal_key(), &get_context);
       if (get_context.State() == GetContext::kFound) {
+        if (pinnable_val.IsPinned()) {
+          (*values)[idx].assign(pinnable_val.data(), pinnable_val.size());
+        }
         statuses[idx] = Status::OK();
       }
     }
@@ -1008,6 +1008,15 @@ class DocumentDBImpl : public DocumentDB {
                      std::string* value) override {
     return Status::NotSupported("");
   }
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) override {
+    return Status::NotSupported("");
+  }
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     PinnableSlice* value) override {
+    return Status::NotSupported("");
+  }
   virtual Status Write(const WriteOptions& options,
                        WriteBatch* updates) override {
     return Status::NotSupported("");